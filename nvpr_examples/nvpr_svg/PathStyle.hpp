@@ -67,6 +67,22 @@ struct PathStyle {
         , dash_offset(0)
         , dash_phase(MOVETO_CONTINUES)
     {}
+
+    bool operator == (const PathStyle &other) const {
+        return do_fill == other.do_fill &&
+               fill_rule == other.fill_rule &&
+               do_stroke == other.do_stroke &&
+               stroke_width == other.stroke_width &&
+               line_cap == other.line_cap &&
+               line_join == other.line_join &&
+               miter_limit == other.miter_limit &&
+               dash_array == other.dash_array &&
+               dash_offset == other.dash_offset &&
+               dash_phase == other.dash_phase;
+    }
+    bool operator != (const PathStyle &other) const {
+        return !(*this == other);
+    }
 };
 
 #endif // __PathStyle_hpp__
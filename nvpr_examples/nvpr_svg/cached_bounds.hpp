@@ -0,0 +1,126 @@
+/* cached_bounds.hpp - bounding box cache with dirty propagation */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __cached_bounds_hpp__
+#define __cached_bounds_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include <set>
+
+#if __cplusplus >= 201103L  // supports C++11
+# include <memory>
+using std::shared_ptr;
+#else
+# include <boost/shared_ptr.hpp>
+using boost::shared_ptr;
+#endif
+
+#include <Cg/vector.hpp>
+
+// A bounding box computed on demand and kept until invalidateBounds(),
+// along with ink bounds that also cover whatever drawing reaches beyond
+// it, such as miter joins.  Scenes are fit to their bounds; culling and
+// damage need their ink bounds.
+//
+// Bounds computed from other CachedBounds objects (a group from its
+// children, a shape from its path) should fetch them with boundsOf() so
+// the dependency is recorded; invalidating a CachedBounds then dirties
+// every cache computed from it, all the way up to the scene root.  So a
+// valid cache implies everything it was computed from is valid, and a
+// query costs O(1) when nothing changed and O(depth) after a local edit.
+class CachedBounds {
+    // Dependents reference each other through a Link that outlives the
+    // CachedBounds, so a destroyed node just leaves a NULL link behind.
+    struct Link {
+        CachedBounds *owner;
+        Link(CachedBounds *o) : owner(o) {}
+    };
+    typedef shared_ptr<Link> LinkPtr;
+
+    LinkPtr self;
+    // A set since one node (say, a shared <use> subtree) can have
+    // thousands of dependents and each registers on every recompute.
+    std::set<LinkPtr> dependents;
+    bool bounds_valid;
+    Cg::float4 bounds, ink_bounds;
+
+    void validateBounds() {
+        if (!bounds_valid) {
+            bounds = computeBounds();
+            ink_bounds = computeInkBounds(bounds);
+            bounds_valid = true;
+        }
+    }
+
+public:
+    CachedBounds()
+        : self(new Link(this))
+        , bounds_valid(false)
+    {}
+    // Copies start out dirty with no dependents.
+    CachedBounds(const CachedBounds &src)
+        : self(new Link(this))
+        , bounds_valid(false)
+    {}
+    CachedBounds & operator = (const CachedBounds &src) {
+        invalidateBounds();
+        return *this;
+    }
+    virtual ~CachedBounds() {
+        self->owner = NULL;
+    }
+
+    // Returns the cached bounds, computing them if dirty.
+    Cg::float4 getBounds() {
+        validateBounds();
+        return bounds;
+    }
+    // Returns the cached ink bounds, computing them if dirty.
+    Cg::float4 getInkBounds() {
+        validateBounds();
+        return ink_bounds;
+    }
+
+    // Mark these bounds and all the bounds computed from them dirty.
+    void invalidateBounds() {
+        bounds_valid = false;
+        if (dependents.size() > 0) {
+            // Dependents re-register when they recompute their bounds.
+            std::set<LinkPtr> list;
+            list.swap(dependents);
+            for (std::set<LinkPtr>::const_iterator i = list.begin(); i != list.end(); ++i) {
+                CachedBounds *dependent = (*i)->owner;
+                // Already dirty dependents have already dirtied theirs.
+                if (dependent && dependent->bounds_valid) {
+                    dependent->invalidateBounds();
+                }
+            }
+        }
+    }
+
+    inline bool hasValidBounds() const { return bounds_valid; }
+
+protected:
+    virtual Cg::float4 computeBounds() = 0;
+    // Called just after computeBounds() with what it returned; by default
+    // the ink bounds are the bounds.
+    virtual Cg::float4 computeInkBounds(const Cg::float4 &bounds) { return bounds; }
+
+    // For use by computeBounds: get src's bounds and record that
+    // these bounds must be invalidated when src's are.
+    Cg::float4 boundsOf(CachedBounds &src) {
+        src.dependents.insert(self);
+        return src.getBounds();
+    }
+    // Likewise for computeInkBounds and src's ink bounds.
+    Cg::float4 inkBoundsOf(CachedBounds &src) {
+        src.dependents.insert(self);
+        return src.getInkBounds();
+    }
+};
+
+#endif // __cached_bounds_hpp__
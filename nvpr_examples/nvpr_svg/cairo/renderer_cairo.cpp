@@ -12,6 +12,10 @@
 
 #define _USE_MATH_DEFINES  // so <math.h> has M_PI
 
+#include <string.h>
+
+#include <algorithm>
+
 #include <Cg/vector/rgba.hpp>
 
 #include "renderer_cairo.hpp"
@@ -19,10 +23,10 @@
 #include "path.hpp"
 
 #include "scene_cairo.hpp"
+#include "renderer_cairo_path.hpp"
 
-//#include <Cg/lerp.hpp>  // This has problems with Visual Studio 2008
-#define lerp(a,b,t) ((a) + (t)*((b)-(a)))
 #include <Cg/length.hpp>
+#include <Cg/any.hpp>
 
 // Release builds shouldn't have verbose conditions.
 #ifdef NDEBUG
@@ -31,90 +35,6 @@
 extern int verbose;
 #endif
 
-struct CairoPathSegmentProcessor : PathSegmentProcessor {
-    cairo_t *cr;
-
-    CairoPathSegmentProcessor(cairo_t *cr_)
-        : cr(cr_)
-    {}
-
-    void beginPath(PathPtr p) { 
-    }
-    void moveTo(const float2 plist[2], size_t coord_index, char cmd) {
-        cairo_move_to(cr, plist[1].x, plist[1].y);
-    }
-    void lineTo(const float2 plist[2], size_t coord_index, char cmd) {
-        cairo_line_to(cr, plist[1].x, plist[1].y);
-    }
-    void quadraticCurveTo(const float2 plist[3], size_t coord_index, char cmd) {
-        float2 e0 = lerp(plist[0], plist[1], 2.0f/3),
-               e1 = lerp(plist[2], plist[1], 2.0f/3);
-        cairo_curve_to(cr,
-                       e0.x, e0.y,
-                       e1.x, e1.y,
-                       plist[2].x, plist[2].y);
-    }
-    void cubicCurveTo(const float2 plist[4], size_t coord_index, char cmd) {
-        cairo_curve_to(cr,
-                       plist[1].x, plist[1].y,
-                       plist[2].x, plist[2].y,
-                       plist[3].x, plist[3].y);
-    }
-    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
-        // Convert to a center point arc to be able to render the arc center.
-        CenterPointArc center_point_arc(arc);
-        switch (center_point_arc.form) {
-        case CenterPointArc::BEHAVED:
-            // Is the elliptical arc part of a circle?
-            if (center_point_arc.radii.x == center_point_arc.radii.y) {
-                // In the circle case, psi just rotates both angle1 and angle2.
-                const double angle1 = center_point_arc.theta1+center_point_arc.psi,
-                             angle2 = angle1+center_point_arc.delta_theta;
-                if (center_point_arc.delta_theta >= 0) {
-                    cairo_arc(cr,
-                        center_point_arc.center.x, center_point_arc.center.y,
-                        center_point_arc.radii.x,
-                        angle1, angle2);
-                } else {
-                    cairo_arc_negative(cr,
-                        center_point_arc.center.x, center_point_arc.center.y,
-                        center_point_arc.radii.x,
-                        angle1, angle2);
-                }
-            } else {
-                cairo_matrix_t m;
-
-                cairo_get_matrix(cr, &m);
-                cairo_translate(cr, 
-                    center_point_arc.center.x, center_point_arc.center.y);
-                cairo_rotate(cr, /*radians*/center_point_arc.psi);
-                cairo_scale(cr, center_point_arc.radii.x, center_point_arc.radii.y);
-                if (center_point_arc.delta_theta >= 0) {
-                    cairo_arc(cr, /*x,y*/0,0, /*radii*/1,
-                              center_point_arc.theta1, center_point_arc.theta1+center_point_arc.delta_theta);
-                } else {
-                    cairo_arc_negative(cr, /*x,y*/0,0, /*radii*/1,
-                                       center_point_arc.theta1, center_point_arc.theta1+center_point_arc.delta_theta);
-                }
-                cairo_set_matrix(cr, &m);
-            }
-            break;
-        case CenterPointArc::DEGENERATE_LINE:
-            cairo_line_to(cr, arc.p[1].x, arc.p[1].y);
-            break;
-        case CenterPointArc::DEGENERATE_POINT:
-            // Do nothing.
-            break;
-        default:
-            assert(!"bogus CenterPointArc form");
-            break;
-        }
-    }
-    void close(char cmd) {
-        cairo_close_path(cr);
-    }
-};
-
 static cairo_line_cap_t lineCapConverter(const PathStyle *style)
 {
     switch (style->line_cap) {
@@ -206,25 +126,7 @@ struct CairoPathDrawProcessor : CairoPathSegmentProcessor {
     {}
 
     void endPath(PathPtr p) {
-        drawPathHelper(cr, brush, pen, &p->style);
-    }
-};
-
-struct CairoPathCacheProcessor : CairoPathSegmentProcessor {
-    cairo_path_t* &path;
-
-    CairoPathCacheProcessor(cairo_t *cr_, cairo_path_t* &path_)
-        : CairoPathSegmentProcessor(cr_)
-        , path(path_)
-    {
-        cairo_new_path(cr);
-    }
-
-    void endPath(PathPtr p) {
-        if (path) {
-            cairo_path_destroy(path);
-        }
-        path = cairo_copy_path(cr);
+        drawPathHelper(cr, brush, pen, p->style.get());
     }
 };
 
@@ -260,6 +162,30 @@ void CairoRenderer::setFilter(cairo_filter_t mode)
     filter_mode = mode;
 }
 
+bool CairoRenderer::clipToRect(int x, int y, int width, int height)
+{
+    // Surface rows go bottom to top in the window so no flip is needed.
+    // Drawing can leave a path behind (clip paths are built on cr), and
+    // cairo_rectangle would add to it.
+    cairo_identity_matrix(cr);
+    cairo_new_path(cr);
+    cairo_rectangle(cr, x, y, width, height);
+    cairo_clip(cr);
+    return true;
+}
+
+bool CairoRenderer::scrollSurface(int dx, int dy)
+{
+    cairo_surface_flush(surface);
+    scrollPixels(cairo_image_surface_get_data(surface),
+                 cairo_image_surface_get_width(surface),
+                 cairo_image_surface_get_height(surface),
+                 cairo_image_surface_get_stride(surface),
+                 dx, dy);
+    cairo_surface_mark_dirty(surface);
+    return true;
+}
+
 void CairoRenderer::clear(float3 clear_color)
 {
     /* Set surface to opaque color (r, g, b) */
@@ -287,23 +213,172 @@ void CairoRenderer::setView(float4x4 view)
     cairo_transform(cr, &m);
 }
 
+void CairoRenderer::endDraw()
+{
+    cairo_reset_clip(cr);
+}
+
 VisitorPtr CairoRenderer::makeVisitor()
 {
     return VisitorPtr(new CairoVisitors::Draw(
-        dynamic_pointer_cast<CairoRenderer>(shared_from_this())));
+        dynamic_pointer_cast<CairoRenderer>(shared_from_this()), cr));
+}
+
+bool CairoRenderer::setTileThreads(int threads)
+{
+    if (threads < 0) {
+        threads = TilePool::processors();
+    }
+    if (threads == getTileThreads()) {
+        return true;
+    }
+    tile_pool = threads > 0 ? TilePoolPtr(new TilePool(threads)) : TilePoolPtr();
+    return true;
+}
+
+int CairoRenderer::getTileThreads()
+{
+    return tile_pool ? tile_pool->getThreadCount() : 0;
+}
+
+namespace {
+
+// What every tile of a frame draws.
+struct CairoTiles {
+    CairoRendererPtr renderer;
+    GroupPtr scene;
+    float4x4 scene_to_surface;
+    bool cull;
+    cairo_matrix_t view;
+    unsigned char *pixels;
+    int width, height, stride;
+    vector<TileRect> rects;
+};
+
+void drawCairoTile(void *data, int tile)
+{
+    const CairoTiles &tiles = *static_cast<CairoTiles*>(data);
+    const TileRect &rect = tiles.rects[tile];
+
+    // The tile is drawn into an image of its own as large as the surface,
+    // with the same origin and no clip, and only the tile's pixels are
+    // copied in and back.  Cairo clips paths to the image it draws into
+    // and steps their edges from where it cuts them, so drawing into a tile
+    // sized image or through a clip would not match an untiled frame; this
+    // way each tile gets the untiled frame's pixels.  The other pixels are
+    // never read back, so they needn't be initialized.
+    const size_t left = size_t(rect.x)*4,
+                 bytes = size_t(rect.width)*4;
+    unsigned char *scratch = new unsigned char[size_t(tiles.height)*tiles.stride];
+    for (int y=rect.y; y<rect.y+rect.height; y++) {
+        const size_t offset = size_t(y)*tiles.stride + left;
+        memcpy(scratch + offset, tiles.pixels + offset, bytes);
+    }
+
+    cairo_surface_t *surface = cairo_image_surface_create_for_data(scratch,
+        CAIRO_FORMAT_ARGB32, tiles.width, tiles.height, tiles.stride);
+    cairo_t *cr = cairo_create(surface);
+    cairo_set_antialias(cr, tiles.renderer->antialias_mode);
+    cairo_set_matrix(cr, &tiles.view);
+
+    VisitorPtr visitor(new CairoVisitors::Draw(tiles.renderer, cr, /*validated*/true));
+    if (tiles.cull) {
+        CullingTraversal traversal(tiles.scene_to_surface,
+            float4(rect.x, rect.y, rect.x+rect.width, rect.y+rect.height));
+        tiles.scene->traverse(visitor, traversal);
+    } else {
+        tiles.scene->traverse(visitor);
+    }
+
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+    for (int y=rect.y; y<rect.y+rect.height; y++) {
+        const size_t offset = size_t(y)*tiles.stride + left;
+        memcpy(tiles.pixels + offset, scratch + offset, bytes);
+    }
+    delete [] scratch;
+}
+
+} // namespace
+
+void CairoRenderer::drawTiles(GroupPtr scene, const float4x4 &scene_to_surface,
+                              const TileRect &area, bool cull)
+{
+    CairoRendererPtr self = dynamic_pointer_cast<CairoRenderer>(shared_from_this());
+    CairoTiles tiles;
+    tiles.renderer = self;
+    tiles.scene = scene;
+    tiles.scene_to_surface = scene_to_surface;
+    tiles.cull = cull;
+    cairo_get_matrix(cr, &tiles.view);
+
+    // Everything the tiles share must be ready before they start: the
+    // node bounds culling reads and the shapes' renderer states.
+    scene->getBounds();
+    VisitorPtr validate(new CairoVisitors::Validate(self));
+    if (cull) {
+        CullingTraversal traversal(scene_to_surface,
+            float4(area.x, area.y, area.x+area.width, area.y+area.height));
+        scene->traverse(validate, traversal);
+    } else {
+        scene->traverse(validate);
+    }
+    cairo_set_matrix(cr, &tiles.view);
+
+    cairo_surface_flush(surface);
+    tiles.pixels = cairo_image_surface_get_data(surface);
+    tiles.width = cairo_image_surface_get_width(surface);
+    tiles.height = cairo_image_surface_get_height(surface);
+    tiles.stride = cairo_image_surface_get_stride(surface);
+    if (tile_pool) {
+        tiles.rects = splitRect(area);
+        tile_pool->run(drawCairoTile, &tiles, int(tiles.rects.size()));
+    } else {
+        tiles.rects.push_back(area);
+        drawCairoTile(&tiles, 0);
+    }
+    cairo_surface_mark_dirty(surface);
+}
+
+void CairoRenderer::drawScene(GroupPtr scene, const float4x4 &scene_to_surface,
+                              const float4 &surface_rect, bool cull)
+{
+    if (!tile_pool) {
+        BlitRenderer::drawScene(scene, scene_to_surface, surface_rect, cull);
+        return;
+    }
+    TileRect area = { 0, 0,
+                      cairo_image_surface_get_width(surface),
+                      cairo_image_surface_get_height(surface) };
+    drawTiles(scene, scene_to_surface, area, cull);
 }
 
-void CairoRenderer::copyImageToWindow()
+void CairoRenderer::drawSceneRect(GroupPtr scene, const float4x4 &scene_to_surface,
+                                  int x, int y, int width, int height, bool cull)
 {
-    glWindowPos2f(0,0);
+    // Drawn as a tile, since the clip would change the pixels.
+    TileRect area = { x, y, width, height };
+    drawTiles(scene, scene_to_surface, area, cull);
+}
 
+bool CairoRenderer::readPixels(unsigned char *rgba)
+{
     const int w = cairo_image_surface_get_width(surface),
-              h = cairo_image_surface_get_height(surface);
+              h = cairo_image_surface_get_height(surface),
+              stride = cairo_image_surface_get_stride(surface);
 
+    cairo_surface_flush(surface);
     const unsigned char *pixels = cairo_image_surface_get_data(surface);
 
-    assert(cairo_image_surface_get_stride(surface) == w*4);
-    glDrawPixels(w, h, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pixels);
+    // CAIRO_FORMAT_ARGB32 is premultiplied, one native-endian word per pixel.
+    for (int y=0; y<h; y++) {
+        const unsigned int *row = reinterpret_cast<const unsigned int*>(pixels + (h-1-y)*stride);
+        for (int x=0; x<w; x++, rgba+=4) {
+            const unsigned int p = row[x];
+            storeUnpremultiplied(rgba, (p>>16)&0xFF, (p>>8)&0xFF, p&0xFF, p>>24);
+        }
+    }
+    return true;
 }
 
 const char *CairoRenderer::getWindowTitle()
@@ -367,22 +442,24 @@ void CairoPathRendererState::invalidate()
     valid = false;
 }
 
-void CairoSolidColorPaintRendererState::validate(float opacity)
+void CairoPaintRendererState::validate(float opacity)
 {
     if (valid && opacity == this->opacity) {
         return;
     }
+    cairo_pattern_destroy(pattern);
+    pattern = createPattern(opacity);
+    this->opacity = opacity;
+    valid = true;
+}
+
+cairo_pattern_t *CairoSolidColorPaintRendererState::createPattern(float opacity)
+{
     SolidColorPaint *paint = dynamic_cast<SolidColorPaint*>(owner);
     assert(paint);
-    if (paint) {
-        if (pattern) {
-            cairo_pattern_destroy(pattern);
-        }
-        float4 solid_color = paint->getColor();
-        pattern = cairo_pattern_create_rgba(solid_color.r, solid_color.g, solid_color.b,
-                                            solid_color.a * opacity);
-    }
-    valid = true;
+    float4 solid_color = paint->getColor();
+    return cairo_pattern_create_rgba(solid_color.r, solid_color.g, solid_color.b,
+                                     solid_color.a * opacity);
 }
 
 static cairo_extend_t convert_SVG_spread_method_to_cairo_extend(SpreadMethod v)
@@ -401,7 +478,7 @@ static cairo_extend_t convert_SVG_spread_method_to_cairo_extend(SpreadMethod v)
     }
 }
 
-void CairoGradientPaintRendererState::setGradientStops(const GradientPaint *paint, float opacity)
+void CairoGradientPaintRendererState::setGradientStops(cairo_pattern_t *pattern, const GradientPaint *paint, float opacity)
 {
     const std::vector<GradientStop>& stops = paint->getStopArray();
     for (vector<GradientStop>::const_iterator stop = stops.begin();
@@ -410,49 +487,32 @@ void CairoGradientPaintRendererState::setGradientStops(const GradientPaint *pain
             cairo_pattern_add_color_stop_rgba(pattern, stop->offset,
                 stop->color.r, stop->color.g, stop->color.b, stop->color.a * opacity);
     }
-
-    setOpacity(opacity);
 }
 
-void CairoGradientPaintRendererState::setGenericGradientPatternParameters(const GradientPaint *paint, float opacity)
+void CairoGradientPaintRendererState::setGenericGradientPatternParameters(cairo_pattern_t *pattern, const GradientPaint *paint, float opacity)
 {
-    setGradientStops(paint, opacity);
+    setGradientStops(pattern, paint, opacity);
 
     const cairo_extend_t extend = convert_SVG_spread_method_to_cairo_extend(paint->getSpreadMethod());
     cairo_pattern_set_extend(pattern, extend);
 }
 
-void CairoLinearGradientPaintRendererState::validate(float opacity)
+cairo_pattern_t *CairoLinearGradientPaintRendererState::createPattern(float opacity)
 {
-    if (valid && opacity == this->opacity) {
-        return;
-    }
-
     const LinearGradientPaint *paint = dynamic_cast<LinearGradientPaint*>(owner);
     assert(paint);
-    if (paint) {
-        if (pattern) {
-            cairo_pattern_destroy(pattern);
-        }
-        // http://www.cairographics.org/manual/cairo-pattern.html#cairo-pattern-create-linear
-        pattern = cairo_pattern_create_linear(paint->getV1().x, paint->getV1().y,
-                                              paint->getV2().x, paint->getV2().y);
+    // http://www.cairographics.org/manual/cairo-pattern.html#cairo-pattern-create-linear
+    cairo_pattern_t *pattern = cairo_pattern_create_linear(paint->getV1().x, paint->getV1().y,
+                                                           paint->getV2().x, paint->getV2().y);
 
-        setGenericGradientPatternParameters(paint, opacity);
-    }
-    valid = true;
+    setGenericGradientPatternParameters(pattern, paint, opacity);
+    return pattern;
 }
 
-void CairoRadialGradientPaintRendererState::validate(float opacity)
+cairo_pattern_t *CairoRadialGradientPaintRendererState::createPattern(float opacity)
 {
-    if (valid) {
-        return;
-    }
     const RadialGradientPaint *paint = dynamic_cast<RadialGradientPaint*>(owner);
     assert(paint);
-    if (pattern) {
-        cairo_pattern_destroy(pattern);
-    }
     // http://www.w3.org/TR/SVG/pservers.html#RadialGradients says
     // "If the point defined by fx and fy lies outside the circle
     // defined by cx, cy and r, then the user agent shall set the
@@ -471,14 +531,14 @@ void CairoRadialGradientPaintRendererState::validate(float opacity)
         focal_point = paint->getCenter() + sub_unity*paint->getRadius()*vector/len;
     }
     // http://www.cairographics.org/manual/cairo-pattern.html#cairo-pattern-create-radial
-    pattern = cairo_pattern_create_radial(focal_point.x, focal_point.y, 0,
+    cairo_pattern_t *pattern = cairo_pattern_create_radial(focal_point.x, focal_point.y, 0,
         paint->getCenter().x, paint->getCenter().y, paint->getRadius());
     cairo_pattern_set_filter(pattern, getRenderer()->filter_mode);
     // CAIRO_EXTEND_PAD pixels outside of the pattern copy the closest pixel from the source
     cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
 
-    setGenericGradientPatternParameters(paint, opacity);
-    valid = true;
+    setGenericGradientPatternParameters(pattern, paint, opacity);
+    return pattern;
 }
 
 // CairoImagePaintRendererState
@@ -516,141 +576,140 @@ CairoImagePaintRendererState::CairoImagePaintRendererState(RendererPtr renderer,
     cairo_surface_mark_dirty(surface);
 }
 
-void CairoImagePaintRendererState::validate(float opacity)
+cairo_pattern_t *CairoImagePaintRendererState::createPattern(float opacity)
 {
-    if (valid && opacity == this->opacity) {
-        return;
-    }
-    const ImagePaint *paint = dynamic_cast<ImagePaint*>(owner);
-    assert(paint);
-    if (paint) {
-        setOpacity(opacity);
-        // XXX should multiply image by opacity here??
-        if (pattern) {
-            cairo_pattern_destroy(pattern);
-        }
-        pattern = cairo_pattern_create_for_surface(surface);
-        cairo_pattern_set_filter(pattern, getRenderer()->filter_mode);
+    // XXX should multiply image by opacity here??
+    cairo_pattern_t *pattern = cairo_pattern_create_for_surface(surface);
+    cairo_pattern_set_filter(pattern, getRenderer()->filter_mode);
+    return pattern;
+}
+
+static CairoPaintRendererStatePtr getPaintRendererState(PaintPtr paint, RendererPtr renderer)
+{
+    if (!paint) {
+        return CairoPaintRendererStatePtr();
     }
-    valid = true;
+    PaintRendererStatePtr renderer_state = paint->getRendererState(renderer);
+    return dynamic_pointer_cast<CairoPaintRendererState>(renderer_state);
 }
 
-void CairoShapeRendererState::validate()
+bool CairoShapeRendererState::Brush::isCurrent(CairoPaintRendererStatePtr state)
 {
-    const Shape *shape = owner;
+    return state == paint_state && (!state || state->getSerial() == serial);
+}
 
-    PaintPtr fill_paint = shape->getFillPaint();
-    if (fill_paint) {
-        PaintRendererStatePtr renderer_state = fill_paint->getRendererState(getRenderer());
-        CairoPaintRendererStatePtr paint_renderer_state = dynamic_pointer_cast<CairoPaintRendererState>(renderer_state);
-        paint_renderer_state->validate(shape->net_fill_opacity);
+void CairoShapeRendererState::validate()
+{
+    CairoRendererPtr renderer = getRenderer();
+    const PaintPtr fill_paint = owner->getFillPaint(),
+                   stroke_paint = owner->getStrokePaint();
+    const float4 owner_bounds = owner->getBounds();
+
+    // Remake the brushes if a paint was invalidated or, since gradients
+    // and images are fit to them, the bounds moved.
+    if (!valid ||
+        !fill.isCurrent(getPaintRendererState(fill_paint, renderer)) ||
+        !stroke.isCurrent(getPaintRendererState(stroke_paint, renderer)) ||
+        any(owner_bounds != bounds)) {
+        bounds = owner_bounds;
+        setBrush(fill, fill_paint, owner->net_fill_opacity);
+        setBrush(stroke, stroke_paint, owner->net_stroke_opacity);
+        valid = true;
     }
 
-    const PaintPtr stroke_paint = shape->getStrokePaint();
-    if (stroke_paint) {
-        PaintRendererStatePtr renderer_state = stroke_paint->getRendererState(getRenderer());
-        CairoPaintRendererStatePtr paint_renderer_state = dynamic_pointer_cast<CairoPaintRendererState>(renderer_state);
-        paint_renderer_state->validate(shape->net_stroke_opacity);
+    if (renderer->cache_paths) {
+        getPathRendererState()->validate();
+    } else {
+        // Build the path's canonical form now so drawing only reads it.
+        owner->getPath()->getCanonicalPath();
     }
+}
 
-    if (valid) {
+void CairoShapeRendererState::setBrush(Brush &brush, PaintPtr paint, float opacity)
+{
+    cairo_pattern_destroy(brush.pattern);
+    brush.pattern = NULL;
+    brush.paint_state = getPaintRendererState(paint, getRenderer());
+    CairoPaintRendererStatePtr paint_renderer_state = brush.paint_state;
+    if (!paint_renderer_state) {
         return;
     }
-    // Nothing about the shape to actually validate.
-    valid = true;
-}
+    brush.serial = paint_renderer_state->getSerial();
 
-cairo_pattern_t *CairoShapeRendererState::getPattern(PaintPtr paint)
-{
-    if (paint) {
-        PaintRendererStatePtr renderer_state = paint->getRendererState(getRenderer());
-        CairoPaintRendererStatePtr paint_renderer_state = dynamic_pointer_cast<CairoPaintRendererState>(renderer_state);
-        if (paint_renderer_state) {
-            cairo_pattern_t *pattern = paint_renderer_state->getPattern();
-            assert(pattern);
-
-            if (paint_renderer_state->needsGradientMatrix()) {
-                GradientPaintPtr gradient = dynamic_pointer_cast<GradientPaint>(paint);
-
-                cairo_matrix_t m;
-                // The gradient transform is "an optional additional 
-                // transformation from the gradient coordinate system
-                // onto the target coordinate system".  So the transform
-                // takes "gradient space" coordinates and transform them
-                // to "path space".  Cairo' pattern matrix actually expects
-                // the reverse transformation so the inverse is used.
-                const float3x3 &inverse_gradient_transform = gradient->getInverseGradientTransform();
-                m.xx = inverse_gradient_transform[0][0];
-                m.xy = inverse_gradient_transform[0][1];
-                m.x0 = inverse_gradient_transform[0][2];
-                m.yx = inverse_gradient_transform[1][0];
-                m.yy = inverse_gradient_transform[1][1];
-                m.y0 = inverse_gradient_transform[1][2];
-                if (verbose) {
-                    std::cout << "gradient_transform = " << gradient->getGradientTransform() << std::endl;
-                    std::cout << "inverse_gradient_transform = " << gradient->getInverseGradientTransform() << std::endl;
-                }
-                if (gradient->getGradientUnits() == OBJECT_BOUNDING_BOX) {
-                    float4 bounds = owner->getBounds();
-                    float2 p1 = bounds.xy,
-                           p2 = bounds.zw,
-                           diff = p2-p1,
-                           sum = p2+p1;
-
-                    // Construct 2D orthographic matrix
-                    cairo_matrix_t b, combo;
-                    b.xx = 1/diff.x;
-                    b.xy = 0;
-                    b.x0 = -0.5*sum.x/diff.x+0.5;
-                    b.yx = 0;
-                    b.yy = 1/diff.y;
-                    b.y0 = -0.5*sum.y/diff.y+0.5;
-
-                    cairo_matrix_multiply(&combo, &b, &m);
-                    // http://cairographics.org/manual/cairo-pattern.html#cairo-pattern-set-matrix
-                    cairo_pattern_set_matrix(pattern, &combo);
-                } else {
-                    assert(gradient->getGradientUnits() == USER_SPACE_ON_USE);
-                    cairo_pattern_set_matrix(pattern, &m);
-                }
-            } else {
-                ImagePaintPtr image = dynamic_pointer_cast<ImagePaint>(paint);
-                if (image) {
-                    CairoImagePaintRendererStatePtr image_state =
-                        dynamic_pointer_cast<CairoImagePaintRendererState>(paint_renderer_state);
-
-                    float w = image->image->width,
-                          h = image->image->height;
-
-                    float4 bounds = owner->getBounds();
-                    float2 p1 = bounds.xy,
-                           p2 = bounds.zw,
-                           diff = p2-p1,
-                           sum = p2+p1;
-
-                    cairo_matrix_t b;
-                    b.xx = w/diff.x;
-                    b.xy = 0;
-                    b.x0 = -0.5*sum.x/diff.x+0.5;
-                    b.yx = 0;
-                    b.yy = h/diff.y;
-                    b.y0 = -0.5*sum.y/diff.y+0.5;
-                    cairo_pattern_set_matrix(pattern, &b);
-                }
-            }
-            return pattern;
+    ImagePaintPtr image = dynamic_pointer_cast<ImagePaint>(paint);
+    cairo_pattern_t *pattern;
+    if (paint_renderer_state->needsGradientMatrix() || image) {
+        // The shape's matrix goes in its own pattern.
+        pattern = paint_renderer_state->createPattern(opacity);
+    } else {
+        // Solid colors are shared; once made they never change.
+        paint_renderer_state->validate(opacity);
+        pattern = cairo_pattern_reference(paint_renderer_state->getPattern());
+    }
+    assert(pattern);
+
+    if (paint_renderer_state->needsGradientMatrix()) {
+        GradientPaintPtr gradient = dynamic_pointer_cast<GradientPaint>(paint);
+
+        cairo_matrix_t m;
+        // The gradient transform is "an optional additional 
+        // transformation from the gradient coordinate system
+        // onto the target coordinate system".  So the transform
+        // takes "gradient space" coordinates and transform them
+        // to "path space".  Cairo' pattern matrix actually expects
+        // the reverse transformation so the inverse is used.
+        const float3x3 &inverse_gradient_transform = gradient->getInverseGradientTransform();
+        m.xx = inverse_gradient_transform[0][0];
+        m.xy = inverse_gradient_transform[0][1];
+        m.x0 = inverse_gradient_transform[0][2];
+        m.yx = inverse_gradient_transform[1][0];
+        m.yy = inverse_gradient_transform[1][1];
+        m.y0 = inverse_gradient_transform[1][2];
+        if (verbose) {
+            std::cout << "gradient_transform = " << gradient->getGradientTransform() << std::endl;
+            std::cout << "inverse_gradient_transform = " << gradient->getInverseGradientTransform() << std::endl;
         }
-    }
-    return NULL;
-}
+        if (gradient->getGradientUnits() == OBJECT_BOUNDING_BOX) {
+            float2 p1 = bounds.xy,
+                   p2 = bounds.zw,
+                   diff = p2-p1,
+                   sum = p2+p1;
+
+            // Construct 2D orthographic matrix
+            cairo_matrix_t b, combo;
+            b.xx = 1/diff.x;
+            b.xy = 0;
+            b.x0 = -0.5*sum.x/diff.x+0.5;
+            b.yx = 0;
+            b.yy = 1/diff.y;
+            b.y0 = -0.5*sum.y/diff.y+0.5;
+
+            cairo_matrix_multiply(&combo, &b, &m);
+            // http://cairographics.org/manual/cairo-pattern.html#cairo-pattern-set-matrix
+            cairo_pattern_set_matrix(pattern, &combo);
+        } else {
+            assert(gradient->getGradientUnits() == USER_SPACE_ON_USE);
+            cairo_pattern_set_matrix(pattern, &m);
+        }
+    } else if (image) {
+        float w = image->image->width,
+              h = image->image->height;
 
-void CairoShapeRendererState::getPatterns(cairo_pattern_t *&fill_pattern, cairo_pattern_t *&stroke_pattern)
-{
-    assert(owner);
-    validate();
+        float2 p1 = bounds.xy,
+               p2 = bounds.zw,
+               diff = p2-p1,
+               sum = p2+p1;
 
-    fill_pattern = getPattern(owner->getFillPaint());
-    stroke_pattern = getPattern(owner->getStrokePaint());
+        cairo_matrix_t b;
+        b.xx = w/diff.x;
+        b.xy = 0;
+        b.x0 = -0.5*sum.x/diff.x+0.5;
+        b.yx = 0;
+        b.yy = h/diff.y;
+        b.y0 = -0.5*sum.y/diff.y+0.5;
+        cairo_pattern_set_matrix(pattern, &b);
+    }
+    brush.pattern = pattern;
 }
 
 void CairoShapeRendererState::invalidate()
@@ -661,25 +720,23 @@ void CairoShapeRendererState::invalidate()
 void CairoPaintRendererState::invalidate()
 {
     valid = false;
+    serial++;
 }
 
-void CairoShapeRendererState::draw()
+void CairoShapeRendererState::draw(cairo_t *cr)
 {
     CairoRendererPtr renderer = getRenderer();
 
-    cairo_pattern_t *fill_pattern, *stroke_pattern;
-    getPatterns(fill_pattern, stroke_pattern);
-
     if (renderer->cache_paths) {
         // validate the path
         CairoPathRendererStatePtr cairo_prs = getPathRendererState();
         cairo_prs->validate();
 
-        cairo_new_path(renderer->cr);
-        cairo_append_path(renderer->cr, cairo_prs->path);
-        drawPathHelper(renderer->cr, fill_pattern, stroke_pattern, &owner->getPath()->style);
+        cairo_new_path(cr);
+        cairo_append_path(cr, cairo_prs->path);
+        drawPathHelper(cr, fill.pattern, stroke.pattern, owner->getPath()->style.get());
     } else {
-        CairoPathDrawProcessor processor(renderer->cr, fill_pattern, stroke_pattern);
+        CairoPathDrawProcessor processor(cr, fill.pattern, stroke.pattern);
         owner->getPath()->processSegments(processor);
     }
 }
@@ -15,6 +15,7 @@
 #include "path.hpp"
 #include "scene.hpp"
 #include "renderer.hpp"
+#include "tile_pool.hpp"
 
 // Cairo graphics library
 #include <cairo.h>
@@ -40,6 +41,9 @@ struct CairoRenderer : GLBlitRenderer{
     cairo_filter_t filter_mode;
     cairo_antialias_t antialias_mode;
 
+    // Draws tiles in parallel when it has more than one thread.
+    TilePoolPtr tile_pool;
+
     CairoRenderer()
         : cr(NULL)
         , surface(NULL)
@@ -57,10 +61,23 @@ struct CairoRenderer : GLBlitRenderer{
         cache_paths = caching;
     }
 
+    bool clipToRect(int x, int y, int width, int height);
+    bool scrollSurface(int dx, int dy);
     void clear(float3 clear_color);
     void setView(float4x4 view);
+    void endDraw();
     VisitorPtr makeVisitor();
+    void drawScene(GroupPtr scene, const float4x4 &scene_to_surface,
+                   const float4 &surface_rect, bool cull);
+    void drawSceneRect(GroupPtr scene, const float4x4 &scene_to_surface,
+                       int x, int y, int width, int height, bool cull);
+    // Draws the area of the surface in tiles, on the tile threads if any.
+    void drawTiles(GroupPtr scene, const float4x4 &scene_to_surface,
+                   const TileRect &area, bool cull);
+    bool setTileThreads(int threads);
+    int getTileThreads();
     void copyImageToWindow();
+    bool readPixels(unsigned char *rgba);
     const char *getWindowTitle();
     const char *getName();
 
@@ -77,7 +94,34 @@ struct CairoRendererState : SpecificRendererState<T,CairoRenderer> {
     {}
 };
 
+typedef shared_ptr<struct CairoPaintRendererState> CairoPaintRendererStatePtr;
+
 struct CairoShapeRendererState : CairoRendererState<Shape> {
+protected:
+    // A fill or stroke pattern and the paint state it was made from.  The
+    // shape owns its gradient and image patterns, whose matrices depend on
+    // its bounds, so drawing never changes a pattern other shapes share
+    // and tiles can draw the shape at once.
+    struct Brush {
+        cairo_pattern_t *pattern;  // referenced
+        CairoPaintRendererStatePtr paint_state;
+        unsigned int serial;  // of paint_state when pattern was made
+
+        Brush()
+            : pattern(NULL)
+            , serial(0)
+        {}
+        ~Brush() {
+            cairo_pattern_destroy(pattern);
+        }
+        bool isCurrent(CairoPaintRendererStatePtr state);
+    };
+    Brush fill, stroke;
+    float4 bounds;  // the owner's when the brushes were made
+
+    void setBrush(Brush &brush, PaintPtr paint, float opacity);
+
+public:
     bool valid;
 
     CairoShapeRendererState(RendererPtr renderer, Shape *shape)
@@ -94,20 +138,22 @@ struct CairoShapeRendererState : CairoRendererState<Shape> {
         return cairo_path_state;
     }
 
-    void draw();
+    // Draws with cr, which must have been set up like the renderer's
+    // context; call validate() first.
+    void draw(cairo_t *cr);
     void getPaths(vector<cairo_path_t*>& paths);
+    // Makes the brushes and, when caching paths, the path.  Drawing then
+    // changes nothing shared, so tiles may draw a validated shape at once.
     void validate();
     void invalidate();
-    cairo_pattern_t *getPattern(PaintPtr paint);
-    void getPatterns(cairo_pattern_t *&brush, cairo_pattern_t *&pen);
 };
 
-typedef shared_ptr<struct CairoPaintRendererState> CairoPaintRendererStatePtr;
 struct CairoPaintRendererState : CairoRendererState<Paint> {
 protected:
     cairo_pattern_t *pattern;
     bool valid;
     float opacity;
+    unsigned int serial;  // counts invalidations
     const bool needs_gradient_matrix;
 
 public:
@@ -116,6 +162,7 @@ public:
         , pattern(NULL)
         , valid(false)
         , opacity(1.0)
+        , serial(0)
         , needs_gradient_matrix(is_gradient)
     {}
 
@@ -123,18 +170,18 @@ public:
         cairo_pattern_destroy(pattern);
     }
 
-    virtual void validate(float opacity) = 0;
+    // Returns a new pattern for the paint at opacity, with an identity
+    // matrix; release it with cairo_pattern_destroy.
+    virtual cairo_pattern_t *createPattern(float opacity) = 0;
+    // Makes getPattern() the paint's pattern at opacity.
+    void validate(float opacity);
     void invalidate();
 
     cairo_pattern_t *getPattern() {
         return pattern;
     }
-    void setOpacity(float new_opacity)
-    {
-        if (opacity != new_opacity) {
-            opacity = new_opacity;
-            valid = false;
-        }
+    inline unsigned int getSerial() const {
+        return serial;
     }
     inline bool needsGradientMatrix() {
         return needs_gradient_matrix;
@@ -146,7 +193,7 @@ struct CairoSolidColorPaintRendererState : CairoPaintRendererState {
         : CairoPaintRendererState(renderer, paint, false/*not gradient*/)
     {}
 
-    void validate(float opacity);
+    cairo_pattern_t *createPattern(float opacity);
 };
 
 typedef shared_ptr<struct CairoGradientPaintRendererState> CairoGradientPaintRendererStatePtr;
@@ -156,8 +203,8 @@ protected:
         : CairoPaintRendererState(renderer, paint, /*is gradient*/true)
     {}
 
-    void setGradientStops(const GradientPaint *paint, float opacity);
-    void setGenericGradientPatternParameters(const GradientPaint *paint, float opacity);
+    void setGradientStops(cairo_pattern_t *pattern, const GradientPaint *paint, float opacity);
+    void setGenericGradientPatternParameters(cairo_pattern_t *pattern, const GradientPaint *paint, float opacity);
 };
 
 struct CairoLinearGradientPaintRendererState : CairoGradientPaintRendererState {
@@ -165,7 +212,7 @@ struct CairoLinearGradientPaintRendererState : CairoGradientPaintRendererState {
         : CairoGradientPaintRendererState(renderer, paint)
     {}
 
-    void validate(float opacity);
+    cairo_pattern_t *createPattern(float opacity);
 };
 
 struct CairoRadialGradientPaintRendererState : CairoGradientPaintRendererState {
@@ -173,14 +220,14 @@ struct CairoRadialGradientPaintRendererState : CairoGradientPaintRendererState {
         : CairoGradientPaintRendererState(renderer, paint)
     {}
 
-    void validate(float opacity);
+    cairo_pattern_t *createPattern(float opacity);
 };
 
 struct CairoImagePaintRendererState : CairoPaintRendererState {
     cairo_surface_t *surface;  // cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
 
     CairoImagePaintRendererState(RendererPtr renderer, ImagePaint *paint);
-    void validate(float opacity);
+    cairo_pattern_t *createPattern(float opacity);
     ~CairoImagePaintRendererState() {
         cairo_surface_destroy(surface);
     }
@@ -0,0 +1,29 @@
+/* renderer_cairo_gl.cpp - show the Cairo surface in the GL window */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+// Kept apart from renderer_cairo.cpp so programs without a GL window,
+// like svg_render, link the Cairo renderer without OpenGL.
+
+#include "nvpr_svg_config.h"  // configure path renderers to use
+
+#if USE_CAIRO
+
+#include <assert.h>
+
+#include "renderer_cairo.hpp"
+
+void CairoRenderer::copyImageToWindow()
+{
+    glWindowPos2f(0,0);
+
+    const int w = cairo_image_surface_get_width(surface),
+              h = cairo_image_surface_get_height(surface);
+
+    const unsigned char *pixels = cairo_image_surface_get_data(surface);
+
+    assert(cairo_image_surface_get_stride(surface) == w*4);
+    glDrawPixels(w, h, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pixels);
+}
+
+#endif // USE_CAIRO
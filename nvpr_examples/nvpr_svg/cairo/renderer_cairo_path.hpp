@@ -0,0 +1,131 @@
+/* renderer_cairo_path.hpp - converts paths to Cairo paths */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __renderer_cairo_path_hpp__
+#define __renderer_cairo_path_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include "nvpr_svg_config.h"  // configure path renderers to use
+
+#if USE_CAIRO
+
+#include <assert.h>
+
+#include "path.hpp"
+
+// Cairo graphics library
+#include <cairo.h>
+
+// Statically dispatched processors for Path::processSegments.
+
+// Adds a path's segments to the current Cairo path.
+struct CairoPathSegmentProcessor {
+    cairo_t *cr;
+
+    CairoPathSegmentProcessor(cairo_t *cr_)
+        : cr(cr_)
+    {}
+
+    void beginPath(PathPtr p) { 
+    }
+    void moveTo(const float2 plist[2], size_t coord_index, char cmd) {
+        cairo_move_to(cr, plist[1].x, plist[1].y);
+    }
+    void lineTo(const float2 plist[2], size_t coord_index, char cmd) {
+        cairo_line_to(cr, plist[1].x, plist[1].y);
+    }
+    void quadraticCurveTo(const float2 plist[3], size_t coord_index, char cmd) {
+        float2 e0 = plist[0] + (2.0f/3)*(plist[1]-plist[0]),
+               e1 = plist[2] + (2.0f/3)*(plist[1]-plist[2]);
+        cairo_curve_to(cr,
+                       e0.x, e0.y,
+                       e1.x, e1.y,
+                       plist[2].x, plist[2].y);
+    }
+    void cubicCurveTo(const float2 plist[4], size_t coord_index, char cmd) {
+        cairo_curve_to(cr,
+                       plist[1].x, plist[1].y,
+                       plist[2].x, plist[2].y,
+                       plist[3].x, plist[3].y);
+    }
+    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
+        // Convert to a center point arc to be able to render the arc center.
+        CenterPointArc center_point_arc(arc);
+        switch (center_point_arc.form) {
+        case CenterPointArc::BEHAVED:
+            // Is the elliptical arc part of a circle?
+            if (center_point_arc.radii.x == center_point_arc.radii.y) {
+                // In the circle case, psi just rotates both angle1 and angle2.
+                const double angle1 = center_point_arc.theta1+center_point_arc.psi,
+                             angle2 = angle1+center_point_arc.delta_theta;
+                if (center_point_arc.delta_theta >= 0) {
+                    cairo_arc(cr,
+                        center_point_arc.center.x, center_point_arc.center.y,
+                        center_point_arc.radii.x,
+                        angle1, angle2);
+                } else {
+                    cairo_arc_negative(cr,
+                        center_point_arc.center.x, center_point_arc.center.y,
+                        center_point_arc.radii.x,
+                        angle1, angle2);
+                }
+            } else {
+                cairo_matrix_t m;
+
+                cairo_get_matrix(cr, &m);
+                cairo_translate(cr, 
+                    center_point_arc.center.x, center_point_arc.center.y);
+                cairo_rotate(cr, /*radians*/center_point_arc.psi);
+                cairo_scale(cr, center_point_arc.radii.x, center_point_arc.radii.y);
+                if (center_point_arc.delta_theta >= 0) {
+                    cairo_arc(cr, /*x,y*/0,0, /*radii*/1,
+                              center_point_arc.theta1, center_point_arc.theta1+center_point_arc.delta_theta);
+                } else {
+                    cairo_arc_negative(cr, /*x,y*/0,0, /*radii*/1,
+                                       center_point_arc.theta1, center_point_arc.theta1+center_point_arc.delta_theta);
+                }
+                cairo_set_matrix(cr, &m);
+            }
+            break;
+        case CenterPointArc::DEGENERATE_LINE:
+            cairo_line_to(cr, arc.p[1].x, arc.p[1].y);
+            break;
+        case CenterPointArc::DEGENERATE_POINT:
+            // Do nothing.
+            break;
+        default:
+            assert(!"bogus CenterPointArc form");
+            break;
+        }
+    }
+    void close(char cmd) {
+        cairo_close_path(cr);
+    }
+};
+
+// Leaves a copy of a path's Cairo path in path.
+struct CairoPathCacheProcessor : CairoPathSegmentProcessor {
+    cairo_path_t* &path;
+
+    CairoPathCacheProcessor(cairo_t *cr_, cairo_path_t* &path_)
+        : CairoPathSegmentProcessor(cr_)
+        , path(path_)
+    {
+        cairo_new_path(cr);
+    }
+
+    void endPath(PathPtr p) {
+        if (path) {
+            cairo_path_destroy(path);
+        }
+        path = cairo_copy_path(cr);
+    }
+};
+
+#endif // USE_CAIRO
+
+#endif // __renderer_cairo_path_hpp__
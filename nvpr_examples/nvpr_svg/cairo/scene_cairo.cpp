@@ -61,10 +61,13 @@ void ClipMask::apply()
 
 ///////////////////////////////////////////////////////////////////////////////
 // Draw
-Draw::Draw(CairoRendererPtr renderer_) : renderer(renderer_) 
+Draw::Draw(CairoRendererPtr renderer_, cairo_t *cr_, bool validated_)
+    : renderer(renderer_)
+    , cr(cr_)
+    , validated(validated_)
 { 
     cairo_matrix_t m;
-    cairo_get_matrix(renderer->cr, &m);
+    cairo_get_matrix(cr, &m);
     matrix_stack.pop();
     matrix_stack.push(cairo2gl(m));
     clip_stack.push(ClipPath(ClipMaskPtr(), m));
@@ -75,18 +78,21 @@ void Draw::visit(ShapePtr shape)
     ShapeRendererStatePtr renderer_state = shape->getRendererState(renderer);
     CairoShapeRendererStatePtr shape_renderer = dynamic_pointer_cast<CairoShapeRendererState>(renderer_state);
     
+    if (!validated) {
+        shape_renderer->validate();
+    }
     if (clip_stack.top().mask) {
-        cairo_push_group_with_content(renderer->cr, CAIRO_CONTENT_COLOR_ALPHA);
+        cairo_push_group_with_content(cr, CAIRO_CONTENT_COLOR_ALPHA);
     }
     
-    shape_renderer->draw();
+    shape_renderer->draw(cr);
 
     if (clip_stack.top().mask) {
-        cairo_pop_group_to_source(renderer->cr);
-        cairo_set_matrix(renderer->cr, &clip_stack.top().matrix);
+        cairo_pop_group_to_source(cr);
+        cairo_set_matrix(cr, &clip_stack.top().matrix);
         clip_stack.top().mask->apply();
         cairo_matrix_t m = gl2cairo(matrix_stack.top());
-        cairo_set_matrix(renderer->cr, &m);
+        cairo_set_matrix(cr, &m);
     }
 }
 
@@ -94,20 +100,20 @@ void Draw::apply(TransformPtr transform)
 {
     MatrixSaveVisitor::apply(transform);
     cairo_matrix_t m = gl2cairo(matrix_stack.top());
-    cairo_set_matrix(renderer->cr, &m);
+    cairo_set_matrix(cr, &m);
 }
 
 void Draw::unapply(TransformPtr transform)
 {
     MatrixSaveVisitor::unapply(transform);
     cairo_matrix_t m = gl2cairo(matrix_stack.top());
-    cairo_set_matrix(renderer->cr, &m);
+    cairo_set_matrix(cr, &m);
 }
 
 void Draw::apply(ClipPtr clip)
 {
-    cairo_save(renderer->cr);
-    ClipVisitorPtr clip_visitor(new ClipVisitor(renderer));
+    cairo_save(cr);
+    ClipVisitorPtr clip_visitor(new ClipVisitor(renderer, cr));
     clip->path->traverse(clip_visitor);
     ClipMaskPtr mask = clip_visitor->startClipping(clip->clip_merge);
     
@@ -124,7 +130,7 @@ void Draw::apply(ClipPtr clip)
 void Draw::unapply(ClipPtr clip)
 {
     clip_stack.pop();
-    cairo_restore(renderer->cr);
+    cairo_restore(cr);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -138,15 +144,14 @@ ClipVisitor::~ClipVisitor()
 
 void ClipVisitor::visit(ShapePtr shape)
 {
-    cairo_t *cr = renderer->cr;
     ShapeRendererStatePtr renderer_state = shape->getRendererState(renderer);
     CairoShapeRendererStatePtr shape_renderer = dynamic_pointer_cast<CairoShapeRendererState>(renderer_state);
     vector<cairo_path_t*> temp_paths;
     shape_renderer->getPaths(temp_paths);
 
     for (size_t i = 0; i < temp_paths.size(); i++) {
-        cairo_new_path(renderer->cr);
-        cairo_append_path(renderer->cr, temp_paths[i]);
+        cairo_new_path(cr);
+        cairo_append_path(cr, temp_paths[i]);
         cairo_path_t *path = cairo_copy_path(cr);
         transformCairoPath(path, matrix_stack.top());
         paths.push_back(path);
@@ -156,7 +161,7 @@ void ClipVisitor::visit(ShapePtr shape)
 void ClipVisitor::apply(ClipPtr clip)
 {
     assert(!child_mask);
-    ClipVisitorPtr clip_visitor(new ClipVisitor(renderer));
+    ClipVisitorPtr clip_visitor(new ClipVisitor(renderer, cr));
     clip->path->traverse(clip_visitor);
     child_mask = clip_visitor->startClipping(clip->clip_merge);
 }
@@ -169,34 +174,84 @@ void ClipVisitor::unapply(ClipPtr clip)
 ClipMaskPtr ClipVisitor::startClipping(ClipMerge clip_merge)
 {
     if (clip_merge == CLIP_COVERAGE_UNION && paths.size() > 1) {
-        cairo_push_group_with_content(renderer->cr, CAIRO_CONTENT_ALPHA);
-        cairo_set_source_rgba(renderer->cr, 1, 1, 1, 1);
+        cairo_push_group_with_content(cr, CAIRO_CONTENT_ALPHA);
+        cairo_set_source_rgba(cr, 1, 1, 1, 1);
         for (size_t i = 0; i < paths.size(); i++) {
-            cairo_new_path(renderer->cr);
-            cairo_append_path(renderer->cr, paths[i]);
-            cairo_fill(renderer->cr);
+            cairo_new_path(cr);
+            cairo_append_path(cr, paths[i]);
+            cairo_fill(cr);
         }
 
-        ClipMaskPtr mask(new ClipMask(renderer->cr, cairo_pop_group(renderer->cr)));
+        ClipMaskPtr mask(new ClipMask(cr, cairo_pop_group(cr)));
         if (child_mask) {
             mask->intersectWith(child_mask);
         }
         return mask;
     } else {
-        cairo_new_path(renderer->cr);
+        cairo_new_path(cr);
         for (size_t i = 0; i < paths.size(); i++) {
-            cairo_append_path(renderer->cr, paths[i]);
+            cairo_append_path(cr, paths[i]);
         }
 
-        cairo_set_fill_rule(renderer->cr, 
+        cairo_set_fill_rule(cr, 
             clip_merge == SUM_WINDING_NUMBERS_MOD_2 ? 
                             CAIRO_FILL_RULE_EVEN_ODD : 
                             CAIRO_FILL_RULE_WINDING);
-        cairo_clip(renderer->cr);
+        cairo_clip(cr);
         return child_mask;
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Validate
+Validate::Validate(CairoRendererPtr renderer_) : renderer(renderer_)
+{
+    cairo_matrix_t m;
+    cairo_get_matrix(renderer->cr, &m);
+    matrix_stack.pop();
+    matrix_stack.push(cairo2gl(m));
+}
+
+void Validate::visit(ShapePtr shape)
+{
+    ShapeRendererStatePtr renderer_state = shape->getRendererState(renderer);
+    CairoShapeRendererStatePtr shape_renderer = dynamic_pointer_cast<CairoShapeRendererState>(renderer_state);
+    shape_renderer->validate();
+}
+
+void Validate::apply(TransformPtr transform)
+{
+    MatrixSaveVisitor::apply(transform);
+    cairo_matrix_t m = gl2cairo(matrix_stack.top());
+    cairo_set_matrix(renderer->cr, &m);
+}
+
+void Validate::unapply(TransformPtr transform)
+{
+    MatrixSaveVisitor::unapply(transform);
+    cairo_matrix_t m = gl2cairo(matrix_stack.top());
+    cairo_set_matrix(renderer->cr, &m);
+}
+
+void Validate::apply(ClipPtr clip)
+{
+    clip->path->traverse(VisitorPtr(new ValidateClip(renderer)));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ValidateClip
+void ValidateClip::visit(ShapePtr shape)
+{
+    ShapeRendererStatePtr renderer_state = shape->getRendererState(renderer);
+    CairoShapeRendererStatePtr shape_renderer = dynamic_pointer_cast<CairoShapeRendererState>(renderer_state);
+    shape_renderer->getPathRendererState()->validate();
+}
+
+void ValidateClip::apply(ClipPtr clip)
+{
+    clip->path->traverse(VisitorPtr(new ValidateClip(renderer)));
+}
+
 
 };
 
@@ -35,10 +35,12 @@ namespace CairoVisitors {
         cairo_pattern_t *pattern;
     };
 
+    // Draws with cr, which starts with the view matrix.  Tiles draw
+    // shapes Validate has already validated, so they pass validated.
     class Draw : public MatrixSaveVisitor
     {
     public:
-        Draw(CairoRendererPtr renderer_);
+        Draw(CairoRendererPtr renderer_, cairo_t *cr_, bool validated_ = false);
 
         void visit(ShapePtr shape);
 
@@ -50,6 +52,8 @@ namespace CairoVisitors {
 
     protected:
         CairoRendererPtr renderer;
+        cairo_t *cr;
+        const bool validated;
 
         struct ClipPath {
             ClipMaskPtr mask;
@@ -64,8 +68,8 @@ namespace CairoVisitors {
     class ClipVisitor : public MatrixSaveVisitor
     {
     public:
-        ClipVisitor(CairoRendererPtr renderer_) 
-            : renderer(renderer_), child_mask(ClipMaskPtr()) { }
+        ClipVisitor(CairoRendererPtr renderer_, cairo_t *cr_) 
+            : renderer(renderer_), cr(cr_), child_mask(ClipMaskPtr()) { }
         ~ClipVisitor();
 
         void visit(ShapePtr shape);
@@ -77,11 +81,47 @@ namespace CairoVisitors {
 
     protected:
         CairoRendererPtr renderer;
+        cairo_t *cr;
         vector<cairo_path_t*> paths;
         ClipMaskPtr child_mask;
     };
     typedef shared_ptr<ClipVisitor> ClipVisitorPtr;
 
+    // Validates every shape Draw would visit, in the same order and with
+    // the renderer's context set to the same matrices (cached paths are
+    // built through it), so the tiles drawn next share only read-only
+    // renderer states.
+    class Validate : public MatrixSaveVisitor
+    {
+    public:
+        Validate(CairoRendererPtr renderer_);
+
+        void visit(ShapePtr shape);
+
+        void apply(TransformPtr transform);
+        void unapply(TransformPtr transform);
+
+        void apply(ClipPtr clip);
+
+    protected:
+        CairoRendererPtr renderer;
+    };
+
+    // Validates the paths a ClipVisitor would get, leaving the matrix
+    // alone as ClipVisitor does.
+    class ValidateClip : public Visitor
+    {
+    public:
+        ValidateClip(CairoRendererPtr renderer_) : renderer(renderer_) { }
+
+        void visit(ShapePtr shape);
+
+        void apply(ClipPtr clip);
+
+    protected:
+        CairoRendererPtr renderer;
+    };
+
 
 };
 
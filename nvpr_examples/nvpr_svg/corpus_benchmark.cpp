@@ -0,0 +1,488 @@
+/* corpus_benchmark.cpp - CPU benchmarks over the SVG file corpus */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+// These benchmarks don't render anything; they time the CPU-side work
+// (parsing, path processing, loading) that every renderer depends on,
+// run over every file in the svg_files list.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>  // showfps.h needs GL types
+
+#include "tinyxml.h"
+
+#include "showfps.h"  // for getElapsedTime
+#include "svg_files.hpp"
+#include "path_parse_svg.h"
+#include "path.hpp"
+#include "svg_loader.hpp"
+#include "scene_cache.hpp"
+#include "svg_loader_pool.hpp"
+#include "image_cache.hpp"
+#include "path_bounds.hpp"
+#include "nvpr/renderer_nvpr_path.hpp"
+#include "cairo/renderer_cairo_path.hpp"
+#include "corpus_benchmark.hpp"
+
+using std::string;
+using std::vector;
+
+// Visit every file in the svg_files list.
+template <typename Func>
+static void forEachSVGFile(Func &func)
+{
+    int ndx = 0;
+    do {
+        func(getSVGFileName(ndx));
+        ndx = advanceSVGFile(ndx);
+    } while (ndx != 0);
+}
+
+// Collects the d= attribute of every <path> element in a file.
+struct GatherPathStrings {
+    vector<string> path_strings;
+    size_t total_bytes;
+
+    GatherPathStrings() : total_bytes(0) {}
+
+    void gather(TiXmlElement *elem) {
+        for (; elem; elem = elem->NextSiblingElement()) {
+            if (!strcmp(elem->Value(), "path")) {
+                const char *d = elem->Attribute("d");
+                if (d) {
+                    path_strings.push_back(d);
+                    total_bytes += path_strings.back().length();
+                }
+            }
+            gather(elem->FirstChildElement());
+        }
+    }
+
+    void operator () (const char *filename) {
+        TiXmlDocument doc(filename);
+        if (doc.LoadFile()) {
+            gather(doc.FirstChildElement());
+        } else {
+            printf("%s: failed to load\n", filename);
+        }
+    }
+};
+
+typedef int (*PathParserFunc)(const char *input, vector<char> &c, vector<float> &v);
+
+static double timePathParser(PathParserFunc parser, const vector<string> &path_strings, int passes)
+{
+    double startTime = getElapsedTime();
+    for (int pass=0; pass<passes; pass++) {
+        for (size_t i=0; i<path_strings.size(); i++) {
+            // Fresh vectors for each parse, just as constructing a Path does.
+            vector<char> c;
+            vector<float> v;
+            parser(path_strings[i].c_str(), c, v);
+        }
+    }
+    return getElapsedTime() - startTime;
+}
+
+static bool sameParse(const vector<char> &c1, const vector<float> &v1,
+                      const vector<char> &c2, const vector<float> &v2)
+{
+    if (c1 != c2 || v1.size() != v2.size()) {
+        return false;
+    }
+    // Bit-identical, so compare the bytes (not the float values).
+    return v1.size() == 0 || !memcmp(&v1[0], &v2[0], v1.size()*sizeof(float));
+}
+
+void benchmarkPathParsing()
+{
+    GatherPathStrings gatherer;
+
+    printf("gathering path strings from SVG files...\n");
+    forEachSVGFile(gatherer);
+    const vector<string> &path_strings = gatherer.path_strings;
+    const double megabytes = gatherer.total_bytes / (1024.0*1024.0);
+    printf("%d paths, %.2f MB of path data\n", int(path_strings.size()), megabytes);
+
+    // The fast parser must reproduce the recursive descent parser's output exactly.
+    // Malformed paths (which the fast parser hands to the recursive descent parser)
+    // are left out of the timings.
+    vector<string> well_formed;
+    int fast_accepted = 0, mismatches = 0;
+    for (size_t i=0; i<path_strings.size(); i++) {
+        vector<char> fast_c, rd_c;
+        vector<float> fast_v, rd_v;
+        bool rd_ok = svg_path_parser(path_strings[i].c_str(), rd_c, rd_v) != 0;
+        if (rd_ok) {
+            well_formed.push_back(path_strings[i]);
+        }
+        if (fast_svg_path_parser(path_strings[i].c_str(), fast_c, fast_v)) {
+            fast_accepted++;
+            if (!rd_ok || !sameParse(fast_c, fast_v, rd_c, rd_v)) {
+                mismatches++;
+                printf("MISMATCH: <%.60s...>\n", path_strings[i].c_str());
+            }
+        }
+    }
+    printf("%d well-formed paths, fast parser accepted %d, %d mismatches\n",
+        int(well_formed.size()), fast_accepted, mismatches);
+
+    size_t well_formed_bytes = 0;
+    for (size_t i=0; i<well_formed.size(); i++) {
+        well_formed_bytes += well_formed[i].length();
+    }
+    const double well_formed_megabytes = well_formed_bytes / (1024.0*1024.0);
+
+    static const struct {
+        const char *name;
+        PathParserFunc parser;
+        int passes;
+    } parsers[] = {
+        { "fast",              fast_svg_path_parser,   10 },
+        { "recursive descent", svg_path_parser,        10 },
+        { "Boost Spirit",      spirit_svg_path_parser, 2 },
+        { "parse_svg_path",    parse_svg_path,         10 },
+    };
+    for (size_t i=0; i<sizeof(parsers)/sizeof(parsers[0]); i++) {
+        double seconds = timePathParser(parsers[i].parser, well_formed, parsers[i].passes);
+        printf("%-20s %8.1f MB/s  (%.3f seconds for %d passes)\n",
+            parsers[i].name, parsers[i].passes*well_formed_megabytes/seconds, seconds, parsers[i].passes);
+    }
+}
+
+// Segment processor drivers: run one processor over each path.  With
+// virtual_dispatch, segments go through the PathSegmentProcessor
+// interface as every processor did before processSegments was templated.
+
+// Stores the bounds so their computation isn't optimized away.
+static volatile float bounds_sink;
+
+static void runBounds(const vector<PathPtr> &paths, bool virtual_dispatch)
+{
+    float4 bbox(FLT_MAX,FLT_MAX,-FLT_MAX,-FLT_MAX);
+
+    for (size_t i=0; i<paths.size(); i++) {
+        GetBoundsPathSegmentProcessor bounder;
+
+        if (virtual_dispatch) {
+            PathSegmentProcessorAdapter<GetBoundsPathSegmentProcessor> adapter(bounder);
+            paths[i]->processSegments(static_cast<PathSegmentProcessor&>(adapter));
+        } else {
+            paths[i]->processSegments(bounder);
+        }
+        bbox.xy = min(bbox.xy, bounder.bbox.xy);
+        bbox.zw = max(bbox.zw, bounder.bbox.zw);
+    }
+    bounds_sink = bbox.x + bbox.y + bbox.z + bbox.w;
+}
+
+#if USE_NVPR
+static void runNVprPathCache(const vector<PathPtr> &paths, bool virtual_dispatch)
+{
+    GLuint path = 0;
+    GLenum fill_rule;
+
+    for (size_t i=0; i<paths.size(); i++) {
+        NVprPathCacheProcessor processor(paths[i].get(), path, fill_rule);
+
+        if (virtual_dispatch) {
+            PathSegmentProcessorAdapter<NVprPathCacheProcessor> adapter(processor);
+            paths[i]->processSegments(static_cast<PathSegmentProcessor&>(adapter));
+        } else {
+            paths[i]->processSegments(processor);
+        }
+    }
+    if (path) {
+        glDeletePathsNV(path, 1);
+    }
+}
+#endif
+
+#if USE_CAIRO
+static void runCairoPathCache(const vector<PathPtr> &paths, bool virtual_dispatch)
+{
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    cairo_t *cr = cairo_create(surface);
+    cairo_path_t *path = NULL;
+
+    for (size_t i=0; i<paths.size(); i++) {
+        CairoPathCacheProcessor processor(cr, path);
+
+        if (virtual_dispatch) {
+            PathSegmentProcessorAdapter<CairoPathCacheProcessor> adapter(processor);
+            paths[i]->processSegments(static_cast<PathSegmentProcessor&>(adapter));
+        } else {
+            paths[i]->processSegments(processor);
+        }
+    }
+    if (path) {
+        cairo_path_destroy(path);
+    }
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+}
+#endif
+
+// Runs every segment processor driver over the paths, first with static
+// dispatch, then through the PathSegmentProcessor virtual interface, and
+// finally through the virtual interface with each path's canonical form
+// rebuilt (the per-call work processSegments did before it was cached).
+void benchmarkSegmentProcessing()
+{
+    GatherPathStrings gatherer;
+
+    printf("gathering path strings from SVG files...\n");
+    forEachSVGFile(gatherer);
+    vector<PathPtr> paths;
+    size_t segments = 0;
+    for (size_t i=0; i<gatherer.path_strings.size(); i++) {
+        PathPtr path(new Path(gatherer.path_strings[i].c_str()));
+        segments += path->countSegments();  // also builds the canonical form
+        paths.push_back(path);
+    }
+    printf("%d paths, %d segments\n", int(paths.size()), int(segments));
+
+    static const struct {
+        const char *name;
+        void (*run)(const vector<PathPtr> &paths, bool virtual_dispatch);
+    } processors[] = {
+        { "bounds",           runBounds },
+#if USE_NVPR
+        { "NVpr path cache",  runNVprPathCache },
+#endif
+#if USE_CAIRO
+        { "Cairo path cache", runCairoPathCache },
+#endif
+    };
+    const int passes = 5;
+    for (size_t i=0; i<sizeof(processors)/sizeof(processors[0]); i++) {
+        double seconds[3];
+        for (int mode=0; mode<3; mode++) {
+            const bool virtual_dispatch = mode > 0,
+                       rebuild = mode > 1;
+            seconds[mode] = 0;
+            for (int pass=0; pass<passes; pass++) {
+                if (rebuild) {
+                    for (size_t j=0; j<paths.size(); j++) {
+                        paths[j]->invalidate();
+                    }
+                }
+                double startTime = getElapsedTime();
+                processors[i].run(paths, virtual_dispatch);
+                seconds[mode] += getElapsedTime() - startTime;
+            }
+        }
+        printf("%-17s static %7.1f, virtual %7.1f, virtual+rebuild %7.1f Msegments/s\n",
+            processors[i].name,
+            passes*segments/seconds[0]/1e6,
+            passes*segments/seconds[1]/1e6,
+            passes*segments/seconds[2]/1e6);
+    }
+}
+
+struct ConvertToSceneCache {
+    int converted, failed;
+
+    ConvertToSceneCache() : converted(0), failed(0) {}
+
+    void operator () (const char *filename) {
+        SvgScenePtr scene = svg_loader(filename);
+        if (scene && saveSceneCache(scene, filename)) {
+            converted++;
+        } else {
+            printf("%s: not converted\n", filename);
+            failed++;
+        }
+    }
+};
+
+void convertSVGCorpus()
+{
+    ConvertToSceneCache converter;
+    forEachSVGFile(converter);
+    printf("wrote %d scene caches, %d files failed\n", converter.converted, converter.failed);
+}
+
+struct TimeSceneLoading {
+    double svg_seconds, stream_seconds, cache_seconds;
+    int files;
+
+    TimeSceneLoading() : svg_seconds(0), stream_seconds(0), cache_seconds(0), files(0) {}
+
+    void operator () (const char *filename) {
+        const string cache_name = sceneCacheName(filename);
+        if (!sceneCacheIsCurrent(filename)) {
+            SvgScenePtr scene = svg_loader(filename);
+            if (!scene || !saveSceneCache(scene, filename)) {
+                return;
+            }
+        }
+        double startTime = getElapsedTime();
+        SvgScenePtr svg_scene = svg_loader(filename);
+        double svgTime = getElapsedTime();
+        SvgScenePtr streamed_scene = svg_stream_loader(filename);
+        double streamTime = getElapsedTime();
+        SvgScenePtr cached_scene = loadSceneCache(cache_name.c_str());
+        double endTime = getElapsedTime();
+        if (svg_scene && streamed_scene && cached_scene) {
+            svg_seconds += svgTime - startTime;
+            stream_seconds += streamTime - svgTime;
+            cache_seconds += endTime - streamTime;
+            files++;
+        }
+    }
+};
+
+// Finds the files Inkscape wrote, which put nearly every property in
+// style= attributes, and totals those attributes.
+struct GatherInkscapeFiles {
+    vector<string> filenames;
+    int style_attributes;
+    size_t style_bytes;
+
+    GatherInkscapeFiles() : style_attributes(0), style_bytes(0) {}
+
+    void gather(TiXmlElement *elem) {
+        for (; elem; elem = elem->NextSiblingElement()) {
+            const char *style = elem->Attribute("style");
+            if (style) {
+                style_attributes++;
+                style_bytes += strlen(style);
+            }
+            gather(elem->FirstChildElement());
+        }
+    }
+
+    void operator () (const char *filename) {
+        TiXmlDocument doc(filename);
+        if (doc.LoadFile()) {
+            TiXmlElement *svg = doc.FirstChildElement("svg");
+            if (svg && svg->Attribute("xmlns:inkscape")) {
+                filenames.push_back(filename);
+                gather(svg);
+            }
+        }
+    }
+};
+
+void benchmarkStyleLoading()
+{
+    GatherInkscapeFiles gatherer;
+    forEachSVGFile(gatherer);
+    printf("%d Inkscape files, %d style attributes (%.1f KB)\n",
+        int(gatherer.filenames.size()), gatherer.style_attributes, gatherer.style_bytes/1024.0);
+
+    const int passes = 5;
+    double startTime = getElapsedTime();
+    for (int pass=0; pass<passes; pass++) {
+        for (size_t i=0; i<gatherer.filenames.size(); i++) {
+            SvgScenePtr scene = svg_loader(gatherer.filenames[i].c_str());
+        }
+    }
+    double seconds = (getElapsedTime() - startTime) / passes;
+    printf("svg_loader %.3f seconds per pass (%d passes)\n", seconds, passes);
+}
+
+// Collects the files with <image> elements, and counts those elements.
+struct GatherImageFiles {
+    vector<string> filenames;
+    int images;
+
+    GatherImageFiles() : images(0) {}
+
+    int count(TiXmlElement *elem) {
+        int n = 0;
+        for (; elem; elem = elem->NextSiblingElement()) {
+            if (!strcmp(elem->Value(), "image")) {
+                n++;
+            }
+            n += count(elem->FirstChildElement());
+        }
+        return n;
+    }
+
+    void operator () (const char *filename) {
+        TiXmlDocument doc(filename);
+        if (doc.LoadFile()) {
+            int n = count(doc.FirstChildElement());
+            if (n > 0) {
+                filenames.push_back(filename);
+                images += n;
+            }
+        }
+    }
+};
+
+static double timeImageLoading(const vector<string> &filenames, int passes)
+{
+    double startTime = getElapsedTime();
+    for (int pass=0; pass<passes; pass++) {
+        for (size_t i=0; i<filenames.size(); i++) {
+            SvgScenePtr scene = svg_loader(filenames[i].c_str());
+        }
+    }
+    return (getElapsedTime() - startTime) / passes;
+}
+
+void benchmarkImageLoading()
+{
+    GatherImageFiles gatherer;
+    forEachSVGFile(gatherer);
+    printf("%d files with %d <image> elements\n", int(gatherer.filenames.size()), gatherer.images);
+
+    const int passes = 5;
+    const size_t limit = getRasterImageCacheStats().limit;
+    setRasterImageCacheLimit(0);
+    const double uncached_seconds = timeImageLoading(gatherer.filenames, passes);
+    setRasterImageCacheLimit(limit);
+    const RasterImageCacheStats before = getRasterImageCacheStats();
+    const double cached_seconds = timeImageLoading(gatherer.filenames, passes);
+    const RasterImageCacheStats after = getRasterImageCacheStats();
+    printf("svg_loader %.3f seconds per pass without the image cache, %.3f seconds with it (%.1fx)\n",
+        uncached_seconds, cached_seconds, uncached_seconds/cached_seconds);
+    printf("image cache: %d hits, %d misses, holding %d images (%.1f MB of %.1f MB)\n",
+        int(after.hits - before.hits), int(after.misses - before.misses),
+        int(after.images), after.bytes/1048576.0, after.limit/1048576.0);
+}
+
+// Walks the list as the regression and seeding modes do, taking each file
+// from a loader pool that keeps working on the files after it.
+static double timePooledLoading(int threads, int &pool_threads)
+{
+    SvgLoaderPool pool(svg_loader, pixels_per_millimeter, threads);
+    pool_threads = pool.getThreadCount();
+    const double startTime = getElapsedTime();
+    int ndx = 0;
+    do {
+        SvgScenePtr scene = pool.take(getSVGFileName(ndx));
+        ndx = advanceSVGFile(ndx);
+        vector<string> upcoming;
+        for (int i=0, next=ndx; i<2*pool_threads && next != 0; i++) {
+            upcoming.push_back(getSVGFileName(next));
+            next = advanceSVGFile(next);
+        }
+        pool.prefetch(upcoming);
+    } while (ndx != 0);
+    return getElapsedTime() - startTime;
+}
+
+void benchmarkSceneLoading()
+{
+    TimeSceneLoading timer;
+    forEachSVGFile(timer);
+    printf("%d files: svg_loader %.3f seconds, svg_stream_loader %.3f seconds, scene cache %.3f seconds (%.1fx)\n",
+        timer.files, timer.svg_seconds, timer.stream_seconds, timer.cache_seconds,
+        timer.svg_seconds/timer.cache_seconds);
+
+    int one_thread, all_threads;
+    const double one_seconds = timePooledLoading(1, one_thread),
+                 all_seconds = timePooledLoading(0, all_threads);
+    printf("svg_loader pool: %d thread %.3f seconds, %d threads %.3f seconds (%.1fx)\n",
+        one_thread, one_seconds, all_threads, all_seconds, one_seconds/all_seconds);
+}
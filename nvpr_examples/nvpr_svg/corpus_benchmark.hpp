@@ -0,0 +1,43 @@
+/* corpus_benchmark.hpp - CPU benchmarks over the SVG file corpus */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#pragma once
+#ifndef __corpus_benchmark_hpp__
+#define __corpus_benchmark_hpp__
+
+#include "nvpr_svg_config.h"
+
+#include <vector>
+
+#include "path.hpp"
+
+// Times each SVG path data parser over every path in the svg_files list and reports MB/s.
+extern void benchmarkPathParsing();
+
+// Times the bounds and path cache segment processors over every path in the
+// svg_files list with static and with virtual segment dispatch.  Needs a
+// current OpenGL context supporting NV_path_rendering.
+extern void benchmarkSegmentProcessing();
+
+// Writes a scene cache (see scene_cache.hpp) for every file in the
+// svg_files list.  Needs pixels_per_millimeter set.
+extern void convertSVGCorpus();
+
+// Times loading every file in the svg_files list with svg_loader,
+// svg_stream_loader and from its scene cache, writing any missing or stale
+// caches first, then walking the list with an SvgLoaderPool of one thread
+// and of every spare processor.  Needs pixels_per_millimeter set.
+extern void benchmarkSceneLoading();
+
+// Times loading the Inkscape-written files in the svg_files list, whose
+// properties are nearly all in style= attributes.  Needs
+// pixels_per_millimeter set.
+extern void benchmarkStyleLoading();
+
+// Times loading the files in the svg_files list with <image> elements,
+// without and then with the raster image cache (see image_cache.hpp).
+// Needs pixels_per_millimeter set.
+extern void benchmarkImageLoading();
+
+#endif // __corpus_benchmark_hpp__
@@ -68,7 +68,7 @@ struct D2DPathSegmentProcessor : PathSegmentProcessor {
     void beginPath(PathPtr p) { 
         assert(m_pPath && !m_pSink);
 
-        m_fillMode = (p->style.fill_rule == PathStyle::NON_ZERO)
+        m_fillMode = (p->style->fill_rule == PathStyle::NON_ZERO)
                      ? D2D1_FILL_MODE_WINDING
                      : D2D1_FILL_MODE_ALTERNATE;
 
@@ -133,13 +133,17 @@ static void drawPathHelper(D2DRendererPtr pRenderer,
                            ID2D1Brush *pBrush,
                            ID2D1Brush *pPen, 
                            ID2D1StrokeStyle *pStrokeStyle,
-                           PathStyle *style)
+                           const PathStyle *style,
+                           float fill_opacity,
+                           float stroke_opacity)
 {
     extern bool doFilling, doStroking;
     if (style->do_stroke && doStroking) {
         if (pBrush && doFilling) {
+            pBrush->SetOpacity(fill_opacity);
             pRenderer->m_pRenderTarget->FillGeometry(pPath, pBrush);
         }
+        pPen->SetOpacity(stroke_opacity);
         pRenderer->m_pRenderTarget->DrawGeometry(pPath, pPen, style->stroke_width, pStrokeStyle);
     } else if (style->do_fill && doFilling) {
 
@@ -148,6 +152,7 @@ static void drawPathHelper(D2DRendererPtr pRenderer,
         pPath->GetFactory(&pFactory1);
         pBrush->GetFactory(&pFactory2);
 
+        pBrush->SetOpacity(fill_opacity);
         pRenderer->m_pRenderTarget->FillGeometry(pPath, pBrush);
     }
 }
@@ -411,7 +416,8 @@ void D2DPathRendererState::validate(D2DRendererPtr renderer)
     }
     HRESULT hr = renderer->m_pFactory->CreatePathGeometry(&path);
 
-    owner->processSegments(D2DPathSegmentProcessor(path));
+    D2DPathSegmentProcessor processor(path);
+    owner->processSegments(processor);
     valid = true;
 
     // gather tessellation info
@@ -498,7 +504,7 @@ void D2DShapeRendererState::validate()
     if (fill_paint) {
         PaintRendererStatePtr renderer_state = fill_paint->getRendererState(getRenderer());
         D2DPaintRendererStatePtr paint_renderer_state = dynamic_pointer_cast<D2DPaintRendererState>(renderer_state);
-        paint_renderer_state->validate(shape, owner->net_fill_opacity);
+        paint_renderer_state->validate(shape);
         brush = paint_renderer_state->getPattern();
     }
 
@@ -506,12 +512,12 @@ void D2DShapeRendererState::validate()
     if (stroke_paint) {
         PaintRendererStatePtr renderer_state = stroke_paint->getRendererState(getRenderer());
         D2DPaintRendererStatePtr paint_renderer_state = dynamic_pointer_cast<D2DPaintRendererState>(renderer_state);
-        paint_renderer_state->validate(shape, owner->net_stroke_opacity);
+        paint_renderer_state->validate(shape);
         pen = paint_renderer_state->getPattern();
     }
 
     if (strokeStyle == NULL) {
-        PathStyle* style = &owner->getPath()->style;
+        const PathStyle* style = owner->getPath()->style.get();
         std::vector<float> dashes;
         
         if (style->dash_array.size()) {
@@ -584,7 +590,8 @@ void D2DShapeRendererState::draw()
     }
     
     d2d_prs->validate(renderer);
-    drawPathHelper(renderer, d2d_prs->path, brush, pen, strokeStyle, &owner->getPath()->style);
+    drawPathHelper(renderer, d2d_prs->path, brush, pen, strokeStyle, owner->getPath()->style.get(),
+                   owner->net_fill_opacity, owner->net_stroke_opacity);
 }
 
 void D2DShapeRendererState::getGeometry(vector<ID2D1Geometry*>* geometryArray)
@@ -677,7 +684,7 @@ void D2DPaintRendererState::invalidate()
     }
 }
 
-void D2DSolidColorPaintRendererState::validate(const Shape* shape, float opacity)
+void D2DSolidColorPaintRendererState::validate(const Shape* shape)
 {
     if (!brush) {
         SolidColorPaint *solid_paint = dynamic_cast<SolidColorPaint*>(owner);
@@ -686,38 +693,40 @@ void D2DSolidColorPaintRendererState::validate(const Shape* shape, float opacity
         getRenderer()->m_pRenderTarget->CreateSolidColorBrush(
             D2D1::ColorF(color.r, color.g,
                          color.b, color.a),
-            D2D1::BrushProperties(opacity),
+            D2D1::BrushProperties(),
             (ID2D1SolidColorBrush**)&brush);
     }
 }
 
-void D2DLinearGradientPaintRendererState::validate(const Shape* shape, float opacity)
+void D2DLinearGradientPaintRendererState::validate(const Shape* shape)
 {
+    LinearGradientPaint *linear_paint = dynamic_cast<LinearGradientPaint*>(owner);
+    assert(linear_paint);
     if (!brush) {
-        LinearGradientPaint *linear_paint = dynamic_cast<LinearGradientPaint*>(owner);
-        assert(linear_paint);
-
         ID2D1GradientStopCollection *pGradientStops = CreateGradientStops(linear_paint, getRenderer()->m_pRenderTarget);
         if (pGradientStops) {
             getRenderer()->m_pRenderTarget->CreateLinearGradientBrush(
                 D2D1::LinearGradientBrushProperties(
                     D2D1::Point2F(linear_paint->getV1().x, linear_paint->getV1().y),
                     D2D1::Point2F(linear_paint->getV2().x, linear_paint->getV2().y)),
-                D2D1::BrushProperties(opacity, D2DGradientTransform(shape, linear_paint)),
+                D2D1::BrushProperties(),
                 pGradientStops,
                 (ID2D1LinearGradientBrush**)&brush);
 
             pGradientStops->Release();
         }
     }
+    // Shapes sharing the paint have their own bounding boxes.
+    if (brush) {
+        brush->SetTransform(D2DGradientTransform(shape, linear_paint));
+    }
 }
 
-void D2DRadialGradientPaintRendererState::validate(const Shape* shape, float opacity)
+void D2DRadialGradientPaintRendererState::validate(const Shape* shape)
 {
+    RadialGradientPaint *radial_paint = dynamic_cast<RadialGradientPaint*>(owner);
+    assert(radial_paint);
     if (!brush) {
-        RadialGradientPaint *radial_paint = dynamic_cast<RadialGradientPaint*>(owner);
-        assert(radial_paint);
-
         ID2D1GradientStopCollection *pGradientStops = CreateGradientStops(radial_paint, getRenderer()->m_pRenderTarget);
         if (pGradientStops) {
             float2 originOffset = radial_paint->getFocalPoint() - radial_paint->getCenter();
@@ -735,13 +744,16 @@ void D2DRadialGradientPaintRendererState::validate(const Shape* shape, float opa
                     D2D1::Point2F(radial_paint->getCenter().x, radial_paint->getCenter().y), 
                     D2D1::Point2F(originOffset.x, originOffset.y),
                     radius, radius),
-                D2D1::BrushProperties(opacity, D2DGradientTransform(shape, radial_paint)),
+                D2D1::BrushProperties(),
                 pGradientStops,
                 (ID2D1RadialGradientBrush**)&brush);
 
             pGradientStops->Release();
         }
     }
+    if (brush) {
+        brush->SetTransform(D2DGradientTransform(shape, radial_paint));
+    }
 }
 
 #endif // USE_D2D
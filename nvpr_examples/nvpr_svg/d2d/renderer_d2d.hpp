@@ -170,7 +170,8 @@ public:
         }
     }
 
-    virtual void validate(const Shape* shape, float opacity) = 0;
+    // Shapes may share paints, so the shape's opacity is applied as it's drawn.
+    virtual void validate(const Shape* shape) = 0;
     void invalidate();
 
     ID2D1Brush *getPattern() {
@@ -184,7 +185,7 @@ struct D2DSolidColorPaintRendererState : D2DPaintRendererState {
         : D2DPaintRendererState(renderer, paint)
     {}
 
-    void validate(const Shape* shape, float opacity);
+    void validate(const Shape* shape);
 };
 
 typedef shared_ptr<struct D2DLinearGradientPaintRendererState> D2DLinearGradientPaintRendererStatePtr;
@@ -193,7 +194,7 @@ struct D2DLinearGradientPaintRendererState : D2DPaintRendererState {
         : D2DPaintRendererState(renderer, paint)
     {}
 
-    void validate(const Shape* shape, float opacity);
+    void validate(const Shape* shape);
 };
 
 typedef shared_ptr<struct D2DRadialGradientPaintRendererState> D2DRadialGradientPaintRendererStatePtr;
@@ -202,7 +203,7 @@ struct D2DRadialGradientPaintRendererState : D2DPaintRendererState {
         : D2DPaintRendererState(renderer, paint)
     {}
 
-    void validate(const Shape* shape, float opacity);
+    void validate(const Shape* shape);
 };
 
 #endif // USE_D2D
@@ -0,0 +1,227 @@
+/* gradient_ramp.cpp - color ramps sampled from gradient stops */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#include <assert.h>
+
+#include "gradient_ramp.hpp"
+#include "sRGB_math.h"
+#include "sRGB_vector.hpp"
+
+// Lerps four color components at a time with SSE2 where available.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define GRADIENT_RAMP_SSE2 1
+# include <emmintrin.h>
+#else
+# define GRADIENT_RAMP_SSE2 0
+#endif
+
+namespace {
+
+// Encodes linear RGB components as sRGB by interpolating a table of the
+// sRGB curve, which is within 2e-5 of calling powf per component.
+struct LinearToSRGBTable {
+    enum { STEPS = 4096 };
+    float srgb[STEPS+1];
+
+    LinearToSRGBTable() {
+        for (int i=0; i<=STEPS; i++) {
+            srgb[i] = convertLinearColorComponentToSRGBf(float(i)/STEPS);
+        }
+    }
+
+    inline float encode(float linear) const {
+        if (!(linear > 0)) {  // also NaN
+            return 0;
+        }
+        if (linear >= 1) {
+            return 1;
+        }
+        float x = linear*STEPS;
+        int i = int(x);
+        return srgb[i] + (x-i)*(srgb[i+1]-srgb[i]);
+    }
+};
+const LinearToSRGBTable srgb_table;
+
+inline unsigned char toUB(float v)
+{
+    if (!(v > 0)) {
+        return 0;
+    }
+    if (v >= 1) {
+        return 255;
+    }
+    return (unsigned char)(v*255 + 0.5f);
+}
+
+// Sets the count texels of rgba to color.
+void fillTexels(float *rgba, int count, const float4 &color)
+{
+    for (int i=0; i<count; i++, rgba+=4) {
+        rgba[0] = color.r;
+        rgba[1] = color.g;
+        rgba[2] = color.b;
+        rgba[3] = color.a;
+    }
+}
+
+// Lerps from color1 at offset1 to color2 at offset2 into texels first
+// to end of a ramp whose texel i is at offset i*texel_step.
+void lerpTexels(float *ramp, int first, int end, float texel_step,
+                float offset1, const float4 &color1,
+                float offset2, const float4 &color2)
+{
+    const float scale = texel_step/(offset2-offset1),
+                bias = -offset1/(offset2-offset1);
+#if GRADIENT_RAMP_SSE2
+    const __m128 c1 = _mm_setr_ps(color1.r, color1.g, color1.b, color1.a),
+                 delta = _mm_sub_ps(_mm_setr_ps(color2.r, color2.g, color2.b, color2.a), c1);
+    for (int i=first; i<end; i++) {
+        __m128 weight = _mm_set1_ps(i*scale + bias);
+        _mm_storeu_ps(ramp + 4*i, _mm_add_ps(c1, _mm_mul_ps(weight, delta)));
+    }
+#else
+    const float4 delta = color2 - color1;
+    for (int i=first; i<end; i++) {
+        float weight = i*scale + bias;
+        float *texel = ramp + 4*i;
+        texel[0] = color1.r + weight*delta.r;
+        texel[1] = color1.g + weight*delta.g;
+        texel[2] = color1.b + weight*delta.b;
+        texel[3] = color1.a + weight*delta.a;
+    }
+#endif
+}
+
+// Averages pairs of the width texels of src into the width/2 of dst.
+void halveTexels(const float *src, float *dst, int width)
+{
+    const int half_width = width >> 1;
+#if GRADIENT_RAMP_SSE2
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (int i=0; i<half_width; i++) {
+        __m128 a = _mm_loadu_ps(src + 8*i),
+               b = _mm_loadu_ps(src + 8*i + 4);
+        _mm_storeu_ps(dst + 4*i, _mm_mul_ps(_mm_add_ps(a, b), half));
+    }
+#else
+    for (int i=0; i<4*half_width; i++) {
+        int j = (i>>2)*8 + (i&3);
+        dst[i] = 0.5f*(src[j] + src[j+4]);
+    }
+#endif
+}
+
+// Samples the stops like the SVG specification says at size offsets,
+// into linear RGB when sRGB.
+void sampleStops(const vector<GradientStop> &stop_array, bool sRGB,
+                 float *ramp, int size)
+{
+    const int last = size-1;
+    const float texel_step = last > 0 ? 1.0f/last : 0;
+
+    vector<GradientStop>::const_iterator stop = stop_array.begin();
+    float offset1 = stop->offset;
+    float4 color1 = sRGB ? srgb2linear(stop->color) : stop->color;
+
+    // Texels up to the first stop get its color.
+    int i = 0;
+    while (i < last && float(i)/last <= offset1) {
+        i++;
+    }
+    fillTexels(ramp, i, color1);
+
+    for (stop++; stop != stop_array.end(); stop++) {
+        // "Each gradient offset value is required to be equal to
+        // or greater than the previous gradient stop's offset
+        // value. If a given gradient stop's offset value is not
+        // equal to or greater than all previous offset values,
+        // then the offset value is adjusted to be equal to the
+        // largest of all previous offset values."
+        float offset2 = max(stop->offset, offset1);
+        float4 color2 = sRGB ? srgb2linear(stop->color) : stop->color;
+
+        int end = i;
+        while (end < last && float(end)/last <= offset2) {
+            end++;
+        }
+        // Texels past offset1 and up to offset2 are strictly between
+        // coincident stops, so there are none when they coincide.
+        if (end > i) {
+            lerpTexels(ramp, i, end, texel_step, offset1, color1, offset2, color2);
+        }
+        i = end;
+        color1 = color2;
+        offset1 = offset2;
+    }
+    // Texels past the last stop get its color, and the last texel is
+    // exactly its color.
+    fillTexels(ramp + 4*i, size-i, color1);
+}
+
+GradientRampPtr makeGradientRamp(const vector<GradientStop> &stop_array,
+                                 int size, bool sRGB)
+{
+    GradientRampPtr ramp(new GradientRamp);
+    ramp->size = size;
+    ramp->sRGB = sRGB;
+    ramp->opaque = true;
+    for (size_t i=0; i<stop_array.size(); i++) {
+        if (stop_array[i].color.a != 1) {
+            ramp->opaque = false;
+        }
+    }
+
+    ramp->level_start.push_back(0);
+    for (int width = size; ; width >>= 1) {
+        ramp->level_start.push_back(ramp->level_start.back() + width);
+        if (width == 1) {
+            break;
+        }
+    }
+    ramp->levels = int(ramp->level_start.size()) - 1;
+    const int texel_count = ramp->level_start.back();
+    ramp->texels.resize(4*texel_count);
+    ramp->texels_ub.resize(4*texel_count);
+
+    // Interpolate and average mipmaps in linear RGB for sRGB, then encode.
+    float *texels = &ramp->texels[0];
+    sampleStops(stop_array, sRGB, texels, size);
+    for (int level=0; level+1<ramp->levels; level++) {
+        halveTexels(texels + 4*ramp->level_start[level],
+                    texels + 4*ramp->level_start[level+1],
+                    ramp->getWidth(level));
+    }
+    unsigned char *texels_ub = &ramp->texels_ub[0];
+    for (int i=0; i<4*texel_count; i+=4) {
+        if (sRGB) {
+            texels[i+0] = srgb_table.encode(texels[i+0]);
+            texels[i+1] = srgb_table.encode(texels[i+1]);
+            texels[i+2] = srgb_table.encode(texels[i+2]);
+        }
+        texels_ub[i+0] = toUB(texels[i+0]);
+        texels_ub[i+1] = toUB(texels[i+1]);
+        texels_ub[i+2] = toUB(texels[i+2]);
+        texels_ub[i+3] = toUB(texels[i+3]);
+    }
+    return ramp;
+}
+
+} // namespace
+
+GradientRampPtr getGradientRamp(GradientStopsPtr stops, int size, bool sRGB)
+{
+    assert(stops);
+    assert(stops->stop_array.size() >= 1);
+    assert(size >= 1);
+    vector<GradientRampPtr> &ramps = stops->ramps;
+    for (size_t i=0; i<ramps.size(); i++) {
+        if (ramps[i]->size == size && ramps[i]->sRGB == sRGB) {
+            return ramps[i];
+        }
+    }
+    GradientRampPtr ramp = makeGradientRamp(stops->stop_array, size, sRGB);
+    ramps.push_back(ramp);
+    return ramp;
+}
@@ -0,0 +1,50 @@
+/* gradient_ramp.hpp - color ramps sampled from gradient stops */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __gradient_ramp_hpp__
+#define __gradient_ramp_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include "scene.hpp"
+
+// A gradient's stops sampled at size evenly spaced offsets from 0 to 1,
+// with the mipmap chain below, ready for any renderer to upload as a 1D
+// texture.  Texels are non-premultiplied RGBA.  An sRGB ramp is
+// interpolated (and its mipmaps averaged) in linear RGB and its texels
+// are sRGB encoded, for an sRGB texture.
+//
+// Ramps don't depend on the spread method, which is the texture's wrap
+// mode, so paints spreading the same stops differently share one.
+struct GradientRamp {
+    int size;
+    bool sRGB;
+    bool opaque;   // every stop has an alpha of 1
+    int levels;    // level i is getWidth(i) texels; the last is 1 texel
+
+    vector<float> texels;             // 4 floats per texel, all levels
+    vector<unsigned char> texels_ub;  // the same rounded to bytes
+    vector<int> level_start;          // texel index of each level
+
+    inline int getWidth(int level) const {
+        return level_start[level+1] - level_start[level];
+    }
+    inline const float *getTexels(int level) const {
+        return &texels[4*level_start[level]];
+    }
+    inline const unsigned char *getTexelsUB(int level) const {
+        return &texels_ub[4*level_start[level]];
+    }
+};
+typedef shared_ptr<GradientRamp> GradientRampPtr;
+
+// Returns the size texel ramp of stops, made on first use and then kept
+// with the stops.  The stops need at least one stop.
+//
+// Not safe to call from several threads at once.
+extern GradientRampPtr getGradientRamp(GradientStopsPtr stops, int size, bool sRGB);
+
+#endif // __gradient_ramp_hpp__
@@ -0,0 +1,81 @@
+/* headless_stubs.cpp - stand-ins for the window code svg_render doesn't link */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+// Programs without a window, like svg_render, link this instead of
+// renderer_gl.cpp, the back ends' *_gl.cpp files and showfps.c so they
+// need no OpenGL, GLUT, GLEW or Cg libraries.  There's no window to show
+// a surface in or swap, so those methods do nothing.
+
+#include "nvpr_svg_config.h"  // configure path renderers to use
+
+#ifdef _WIN32
+# include <windows.h>  // for QueryPerformanceCounter
+#else
+# include <sys/time.h>  // for gettimeofday
+#endif
+
+#include "scene.hpp"
+#include "renderer.hpp"
+#include "showfps.h"
+
+#if USE_SKIA
+#include "skia/renderer_skia.hpp"
+#endif
+#if USE_CAIRO
+#include "cairo/renderer_cairo.hpp"
+#endif
+#if USE_OPENVG
+#include "openvg/renderer_openvg.hpp"
+#endif
+
+void GLBlitRenderer::swapBuffers()
+{
+}
+
+void GLBlitRenderer::reportFPS()
+{
+}
+
+#if USE_SKIA
+void SkiaRenderer::copyImageToWindow()
+{
+}
+#endif
+
+#if USE_CAIRO
+void CairoRenderer::copyImageToWindow()
+{
+}
+#endif
+
+#if USE_OPENVG
+void VGRenderer::copyImageToWindow()
+{
+}
+#endif
+
+// Seconds since the first call, as showfps.c measures them.
+double getElapsedTime()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq, start;
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (!freq.QuadPart) {
+        QueryPerformanceFrequency(&freq);
+        start = now;
+    }
+    return double(now.QuadPart - start.QuadPart) / double(freq.QuadPart);
+#else
+    static struct timeval start;
+    static bool started = false;
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    if (!started) {
+        start = now;
+        started = true;
+    }
+    return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec)/1000000.0;
+#endif
+}
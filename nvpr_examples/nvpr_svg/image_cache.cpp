@@ -0,0 +1,146 @@
+/* image_cache.cpp - process-wide cache of decoded raster images */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <pthread.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <list>
+#include <map>
+
+#include "image_cache.hpp"
+
+using std::string;
+
+namespace {
+
+#ifdef _WIN32
+struct Mutex {
+    CRITICAL_SECTION cs;
+    Mutex() { InitializeCriticalSection(&cs); }
+    ~Mutex() { DeleteCriticalSection(&cs); }
+    void lock() { EnterCriticalSection(&cs); }
+    void unlock() { LeaveCriticalSection(&cs); }
+};
+#else
+struct Mutex {
+    pthread_mutex_t mutex;
+    Mutex() { pthread_mutex_init(&mutex, NULL); }
+    ~Mutex() { pthread_mutex_destroy(&mutex); }
+    void lock() { pthread_mutex_lock(&mutex); }
+    void unlock() { pthread_mutex_unlock(&mutex); }
+};
+#endif
+
+struct Lock {
+    Mutex &mutex;
+    Lock(Mutex &m) : mutex(m) { mutex.lock(); }
+    ~Lock() { mutex.unlock(); }
+};
+
+struct Entry {
+    string key;
+    RasterImagePtr image;
+    size_t bytes;
+};
+typedef std::list<Entry> EntryList;  // most recently used first
+typedef std::map<string,EntryList::iterator> EntryMap;
+
+Mutex mutex;
+EntryList entries;
+EntryMap key_index;
+RasterImageCacheStats stats = { 0, 0, 0, 0, 128 << 20 };
+
+size_t imageBytes(const RasterImage &image)
+{
+    return size_t(image.width)*image.height*sizeof(RasterImage::Pixel);
+}
+
+// Drops least recently used images until the cache fits in bytes.
+void evictTo(size_t bytes)
+{
+    while (stats.bytes > bytes) {
+        const Entry &victim = entries.back();
+        stats.bytes -= victim.bytes;
+        stats.images--;
+        key_index.erase(victim.key);
+        entries.pop_back();
+    }
+}
+
+} // namespace
+
+string rasterImageFileKey(const char *filename)
+{
+    struct stat file_stat;
+    if (stat(filename, &file_stat)) {
+        return string();
+    }
+    char suffix[64];
+    sprintf(suffix, "|%lu|%lu", (unsigned long)file_stat.st_size, (unsigned long)file_stat.st_mtime);
+    return string("file:") + filename + suffix;
+}
+
+string rasterImageDataKey(const char *uri)
+{
+    // 64-bit FNV-1a; the length makes an accidental match even less likely.
+    unsigned long long hash = 14695981039346656037ULL;
+    size_t length = 0;
+    for (const unsigned char *s = (const unsigned char *)uri; *s; s++) {
+        hash = (hash ^ *s) * 1099511628211ULL;
+        length++;
+    }
+    char key[64];
+    sprintf(key, "data:%lu|%08x%08x", (unsigned long)length,
+        unsigned(hash >> 32), unsigned(hash & 0xffffffff));
+    return key;
+}
+
+RasterImagePtr findRasterImage(const string &key)
+{
+    Lock lock(mutex);
+    EntryMap::iterator iter = key_index.find(key);
+    if (iter == key_index.end()) {
+        stats.misses++;
+        return RasterImagePtr();
+    }
+    stats.hits++;
+    // Move to the front.
+    entries.splice(entries.begin(), entries, iter->second);
+    return iter->second->image;
+}
+
+void cacheRasterImage(const string &key, RasterImagePtr image)
+{
+    const size_t bytes = imageBytes(*image);
+    Lock lock(mutex);
+    if (bytes > stats.limit || key_index.find(key) != key_index.end()) {
+        // Too big, or another thread decoded it at the same time.
+        return;
+    }
+    evictTo(stats.limit - bytes);
+    Entry entry = { key, image, bytes };
+    entries.push_front(entry);
+    key_index[key] = entries.begin();
+    stats.images++;
+    stats.bytes += bytes;
+}
+
+void setRasterImageCacheLimit(size_t bytes)
+{
+    Lock lock(mutex);
+    stats.limit = bytes;
+    evictTo(bytes);
+}
+
+RasterImageCacheStats getRasterImageCacheStats()
+{
+    Lock lock(mutex);
+    return stats;
+}
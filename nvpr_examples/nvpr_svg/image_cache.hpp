@@ -0,0 +1,47 @@
+/* image_cache.hpp - process-wide cache of decoded raster images */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __image_cache_hpp__
+#define __image_cache_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include <string>
+
+#include "scene.hpp"
+
+// Decoding an <image> (base64, then stb_image) costs far more than the
+// rest of loading it, and documents often refer to one bitmap many times
+// and are reloaded.  This least recently used cache, bounded by pixel
+// bytes, keeps decoded images so every <image> and reload after the first
+// shares one RasterImage.  Cached images must not be modified.  Evicting
+// an image only drops the cache's reference to it.
+//
+// Safe to use from several loader threads at once.
+
+// Key for an image file: its name, size and modification time, so an
+// edited file misses.  Empty if the file doesn't exist.
+extern std::string rasterImageFileKey(const char *filename);
+
+// Key for a data: URI: its length and a hash of its contents.
+extern std::string rasterImageDataKey(const char *uri);
+
+// Returns NULL if the key isn't cached.
+extern RasterImagePtr findRasterImage(const std::string &key);
+extern void cacheRasterImage(const std::string &key, RasterImagePtr image);
+
+// Evicts images until the cache holds no more than bytes of pixels;
+// 0 disables caching.
+extern void setRasterImageCacheLimit(size_t bytes);
+
+struct RasterImageCacheStats {
+    size_t hits, misses;
+    size_t images, bytes;  // currently cached
+    size_t limit;
+};
+extern RasterImageCacheStats getRasterImageCacheStats();
+
+#endif // __image_cache_hpp__
@@ -0,0 +1,510 @@
+/* image_diff.cpp - compare rendered RGB images for regressions */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "image_diff.hpp"
+#include "tile_pool.hpp"
+
+// Row tests use SSE2 on 16 bytes at a time when the compiler targets it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define IMAGE_DIFF_SSE2 1
+# include <emmintrin.h>
+#else
+# define IMAGE_DIFF_SSE2 0
+#endif
+
+using std::string;
+using std::vector;
+
+namespace {
+
+const int rows_per_tile = 16;
+
+// dst = src/3 for each byte, dimming the pixels that match.
+void dimRow(unsigned char *dst, const unsigned char *src, int bytes)
+{
+    int i = 0;
+#if IMAGE_DIFF_SSE2
+    // x/3 == (x*0xAAAB) >> 17 for any byte x.
+    const __m128i zero = _mm_setzero_si128(),
+                  third = _mm_set1_epi16(short(0xAAAB));
+    for (; i+16 <= bytes; i+=16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+        const __m128i lo = _mm_srli_epi16(_mm_mulhi_epu16(_mm_unpacklo_epi8(v, zero), third), 1),
+                      hi = _mm_srli_epi16(_mm_mulhi_epu16(_mm_unpackhi_epi8(v, zero), third), 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i<bytes; i++) {
+        dst[i] = src[i]/3;
+    }
+}
+
+// ok[i] = 0xFF where |a[i]-c[i]| <= limit, otherwise 0.
+void withinRow(unsigned char *ok, const unsigned char *a, const unsigned char *c,
+               int bytes, unsigned char limit)
+{
+    int i = 0;
+#if IMAGE_DIFF_SSE2
+    const __m128i zero = _mm_setzero_si128(),
+                  lim = _mm_set1_epi8(char(limit));
+    for (; i+16 <= bytes; i+=16) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+i)),
+                      vc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c+i));
+        const __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vc), _mm_subs_epu8(vc, va));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ok+i),
+                         _mm_cmpeq_epi8(_mm_subs_epu8(diff, lim), zero));
+    }
+#endif
+    for (; i<bytes; i++) {
+        const int diff = a[i] > c[i] ? a[i]-c[i] : c[i]-a[i];
+        ok[i] = diff <= limit ? 0xFF : 0;
+    }
+}
+
+// Like withinRow but against (b[i]+c[i])/2, rounded down.
+void withinAverageRow(unsigned char *ok, const unsigned char *a,
+                      const unsigned char *b, const unsigned char *c,
+                      int bytes, unsigned char limit)
+{
+    int i = 0;
+#if IMAGE_DIFF_SSE2
+    const __m128i zero = _mm_setzero_si128(),
+                  one = _mm_set1_epi8(1),
+                  lim = _mm_set1_epi8(char(limit));
+    for (; i+16 <= bytes; i+=16) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+i)),
+                      vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b+i)),
+                      vc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c+i));
+        // _mm_avg_epu8 rounds up; take back the half it added.
+        const __m128i avg = _mm_sub_epi8(_mm_avg_epu8(vb, vc),
+                                         _mm_and_si128(_mm_xor_si128(vb, vc), one));
+        const __m128i diff = _mm_or_si128(_mm_subs_epu8(va, avg), _mm_subs_epu8(avg, va));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ok+i),
+                         _mm_cmpeq_epi8(_mm_subs_epu8(diff, lim), zero));
+    }
+#endif
+    for (; i<bytes; i++) {
+        const int avg = (b[i]+c[i])/2;
+        const int diff = a[i] > avg ? a[i]-avg : avg-a[i];
+        ok[i] = diff <= limit ? 0xFF : 0;
+    }
+}
+
+// near[x] is set if all three channels of pixel x are ok.
+void markNear(vector<char> &near, const vector<unsigned char> &ok)
+{
+    for (size_t x=0; x<near.size(); x++) {
+        near[x] |= ok[3*x] & ok[3*x+1] & ok[3*x+2] & 1;
+    }
+}
+
+// Whether pixel x of a's row y is close to b's neighborhood, one neighbor
+// at a time, for rows with few differences.
+bool isNear(const unsigned char *a, const unsigned char *b, int w, int h,
+            int x, int y, const ImageDiffSettings &settings)
+{
+    const int n = settings.neighborhood,
+              limit = settings.max_difference;
+    const unsigned char *apix = a + 3*(size_t(y)*w + x),
+                        *bpix = b + 3*(size_t(y)*w + x);
+    for (int dy=-n; dy<=n; dy++) {
+        const int cy = std::max(0, std::min(h-1, y+dy));
+        for (int dx=-n; dx<=n; dx++) {
+            const int cx = std::max(0, std::min(w-1, x+dx));
+            const unsigned char *cpix = b + 3*(size_t(cy)*w + cx);
+            int diff = 0;
+            for (int i=0; i<3; i++) {
+                diff = std::max(diff, abs(apix[i] - cpix[i]));
+            }
+            if (diff < limit) {
+                return true;
+            }
+            if (settings.adjacent_average) {
+                diff = 0;
+                for (int i=0; i<3; i++) {
+                    diff = std::max(diff, abs(apix[i] - (bpix[i] + cpix[i])/2));
+                }
+                if (diff < limit) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+struct DiffJob {
+    const unsigned char *a, *b;
+    unsigned char *diff;
+    int width, height;
+    ImageDiffSettings settings;
+
+    // For each tile, counted by the thread that drew it.
+    vector<int> different_pixels, close_pixels;
+    vector<char> unequal;
+};
+
+void diffTile(void *data, int tile)
+{
+    DiffJob &job = *static_cast<DiffJob*>(data);
+    const ImageDiffSettings &settings = job.settings;
+    const int w = job.width,
+              h = job.height,
+              bytes = 3*w,
+              n = settings.neighborhood;
+    const int first = tile*rows_per_tile,
+              last = std::min(h, first+rows_per_tile);
+
+    int different_pixels = 0,
+        close_pixels = 0;
+    bool unequal = false;
+    vector<unsigned char> padded, ok;
+    vector<char> near;
+    vector<int> unequal_x;
+
+    for (int y=first; y<last; y++) {
+        const unsigned char *arow = job.a + size_t(y)*bytes,
+                            *brow = job.b + size_t(y)*bytes;
+        unsigned char *drow = job.diff + size_t(y)*bytes;
+
+        if (!memcmp(arow, brow, bytes)) {
+            dimRow(drow, arow, bytes);
+            continue;
+        }
+        unequal = true;
+
+        unequal_x.clear();
+        for (int x=0; x<w; x++) {
+            if (memcmp(arow + 3*x, brow + 3*x, 3)) {
+                unequal_x.push_back(x);
+            }
+        }
+
+        // Find the pixels close to some pixel of b's neighborhood: one by
+        // one if there are few, else a whole row and neighbor offset at a
+        // time.
+        near.assign(w, 0);
+        const bool sparse = int(unequal_x.size()) * (2*n+1) * (2*n+1) < w;
+        if (!settings.exact && n >= 0 && sparse) {
+            for (size_t i=0; i<unequal_x.size(); i++) {
+                near[unequal_x[i]] = isNear(job.a, job.b, w, h, unequal_x[i], y, settings);
+            }
+        } else if (!settings.exact && n >= 0) {
+            if (settings.max_difference > 255) {
+                near.assign(w, 1);
+            } else if (settings.max_difference > 0) {
+                const unsigned char limit = (unsigned char) (settings.max_difference-1);
+                padded.resize(3*size_t(w+2*n));
+                ok.resize(bytes);
+                for (int dy=-n; dy<=n; dy++) {
+                    const int cy = std::max(0, std::min(h-1, y+dy));
+                    const unsigned char *crow = job.b + size_t(cy)*bytes;
+                    // The row with its end pixels repeated n times beyond each
+                    // end, so every offset reads the clamped neighbor.
+                    for (int x=0; x<n; x++) {
+                        memcpy(&padded[3*x], crow, 3);
+                        memcpy(&padded[3*(n+w+x)], crow + 3*(w-1), 3);
+                    }
+                    memcpy(&padded[3*n], crow, bytes);
+                    for (int dx=-n; dx<=n; dx++) {
+                        const unsigned char *c = &padded[3*(n+dx)];
+                        withinRow(&ok[0], arow, c, bytes, limit);
+                        markNear(near, ok);
+                        if (settings.adjacent_average) {
+                            withinAverageRow(&ok[0], arow, brow, c, bytes, limit);
+                            markNear(near, ok);
+                        }
+                    }
+                }
+            }
+        }
+
+        dimRow(drow, arow, bytes);
+        for (size_t i=0; i<unequal_x.size(); i++) {
+            const int x = unequal_x[i];
+            const unsigned char *apix = arow + 3*x,
+                                *bpix = brow + 3*x;
+            unsigned char *dpix = drow + 3*x;
+            if (near[x]) {
+                dimRow(dpix, apix, 3);
+                close_pixels++;
+            } else {
+                for (int c=0; c<3; c++) {
+                    dpix[c] = (unsigned char) ((apix[c] - bpix[c] + 255)/4 + 128);
+                }
+                different_pixels++;
+            }
+        }
+    }
+
+    job.different_pixels[tile] = different_pixels;
+    job.close_pixels[tile] = close_pixels;
+    job.unequal[tile] = unequal;
+}
+
+TilePool &diffPool()
+{
+    static TilePoolPtr pool;
+    if (!pool) {
+        pool = TilePoolPtr(new TilePool(-1));
+    }
+    return *pool;
+}
+
+} // namespace
+
+ImageDiffMatch diffImages(const unsigned char *a, const unsigned char *b,
+                          unsigned char *diff, int width, int height,
+                          const ImageDiffSettings &settings,
+                          int &different_pixels, int &close_pixels)
+{
+    different_pixels = 0;
+    close_pixels = 0;
+    if (width <= 0 || height <= 0) {
+        return IMAGES_SAME;
+    }
+
+    DiffJob job;
+    job.a = a;
+    job.b = b;
+    job.diff = diff;
+    job.width = width;
+    job.height = height;
+    job.settings = settings;
+    const int tiles = (height + rows_per_tile-1) / rows_per_tile;
+    job.different_pixels.resize(tiles);
+    job.close_pixels.resize(tiles);
+    job.unequal.resize(tiles);
+    diffPool().run(diffTile, &job, tiles);
+
+    bool unequal = false;
+    for (int i=0; i<tiles; i++) {
+        different_pixels += job.different_pixels[i];
+        close_pixels += job.close_pixels[i];
+        unequal = unequal || job.unequal[i];
+    }
+    if (different_pixels > 0) {
+        return IMAGES_DIFFERENT;
+    }
+    return unequal ? IMAGES_APPROXIMATELY_SAME : IMAGES_SAME;
+}
+
+namespace {
+
+const int ssim_tile = 8;  // SSIM tiles are square; measureImages' bands are a tile tall
+const int edge_threshold = 24;
+
+// Rec. 601 luma in 8.8 fixed point.
+inline int luma(const unsigned char *pixel)
+{
+    return (77*pixel[0] + 150*pixel[1] + 29*pixel[2] + 128) >> 8;
+}
+
+// 0 for 0, else the number of bits in difference.
+inline int bucket(int difference)
+{
+    int i = 0;
+    for (; difference; difference >>= 1) {
+        i++;
+    }
+    return i;
+}
+
+double tileSSIM(double n, double sum_a, double sum_b,
+                double sum_aa, double sum_bb, double sum_ab)
+{
+    const double c1 = (0.01*255)*(0.01*255),
+                 c2 = (0.03*255)*(0.03*255);
+    const double mean_a = sum_a/n,
+                 mean_b = sum_b/n,
+                 var_a = sum_aa/n - mean_a*mean_a,
+                 var_b = sum_bb/n - mean_b*mean_b,
+                 cov = sum_ab/n - mean_a*mean_b;
+    return ((2*mean_a*mean_b + c1) * (2*cov + c2)) /
+           ((mean_a*mean_a + mean_b*mean_b + c1) * (var_a + var_b + c2));
+}
+
+struct MeasureJob {
+    const unsigned char *a, *b;
+    int width, height;
+
+    // For each band, summed once all are done so the totals don't depend
+    // on which thread measured what.
+    vector<double> squared_error, ssim_sum, min_ssim;
+    vector<int> ssim_tiles;
+    vector<unsigned int> edge_pixels;
+    vector<unsigned int> histograms;  // edge then flat buckets for each band
+};
+
+void measureBand(void *data, int band)
+{
+    MeasureJob &job = *static_cast<MeasureJob*>(data);
+    const int w = job.width,
+              h = job.height,
+              bytes = 3*w;
+    const int first = band*ssim_tile,
+              last = std::min(h, first+ssim_tile),
+              rows = last-first;
+
+    // Luma of b's rows from one before the band to one after, clamped, for
+    // finding edges, and of a's rows in the band.
+    vector<int> b_luma(size_t(rows+2)*w), a_luma(size_t(rows)*w);
+    for (int r=0; r<rows+2; r++) {
+        const int y = std::max(0, std::min(h-1, first-1+r));
+        const unsigned char *brow = job.b + size_t(y)*bytes;
+        for (int x=0; x<w; x++) {
+            b_luma[size_t(r)*w+x] = luma(brow + 3*x);
+        }
+    }
+
+    double squared_error = 0;
+    unsigned int edge_pixels = 0;
+    unsigned int *edge_histogram = &job.histograms[2*IMAGE_DIFF_BUCKETS*band],
+                 *flat_histogram = edge_histogram + IMAGE_DIFF_BUCKETS;
+    for (int r=0; r<rows; r++) {
+        const unsigned char *arow = job.a + size_t(first+r)*bytes,
+                            *brow = job.b + size_t(first+r)*bytes;
+        for (int x=0; x<w; x++) {
+            const unsigned char *apix = arow + 3*x,
+                                *bpix = brow + 3*x;
+            a_luma[size_t(r)*w+x] = luma(apix);
+
+            int difference = 0;
+            for (int c=0; c<3; c++) {
+                const int d = abs(apix[c] - bpix[c]);
+                difference = std::max(difference, d);
+                squared_error += d*d;
+            }
+
+            int lo = 255, hi = 0;
+            for (int dy=0; dy<3; dy++) {
+                const int *row = &b_luma[size_t(r+dy)*w];
+                for (int dx=-1; dx<=1; dx++) {
+                    const int v = row[std::max(0, std::min(w-1, x+dx))];
+                    lo = std::min(lo, v);
+                    hi = std::max(hi, v);
+                }
+            }
+            if (hi - lo > edge_threshold) {
+                edge_pixels++;
+                edge_histogram[bucket(difference)]++;
+            } else {
+                flat_histogram[bucket(difference)]++;
+            }
+        }
+    }
+
+    double ssim_sum = 0,
+           min_ssim = 1;
+    int tiles = 0;
+    for (int tx=0; tx<w; tx+=ssim_tile) {
+        const int tw = std::min(ssim_tile, w-tx);
+        double sum_a = 0, sum_b = 0, sum_aa = 0, sum_bb = 0, sum_ab = 0;
+        for (int r=0; r<rows; r++) {
+            const int *arow = &a_luma[size_t(r)*w],
+                      *brow = &b_luma[size_t(r+1)*w];
+            for (int x=tx; x<tx+tw; x++) {
+                const double ya = arow[x],
+                             yb = brow[x];
+                sum_a += ya;
+                sum_b += yb;
+                sum_aa += ya*ya;
+                sum_bb += yb*yb;
+                sum_ab += ya*yb;
+            }
+        }
+        const double ssim = tileSSIM(double(tw*rows), sum_a, sum_b, sum_aa, sum_bb, sum_ab);
+        ssim_sum += ssim;
+        min_ssim = std::min(min_ssim, ssim);
+        tiles++;
+    }
+
+    job.squared_error[band] = squared_error;
+    job.ssim_sum[band] = ssim_sum;
+    job.min_ssim[band] = min_ssim;
+    job.ssim_tiles[band] = tiles;
+    job.edge_pixels[band] = edge_pixels;
+}
+
+} // namespace
+
+void measureImages(const unsigned char *a, const unsigned char *b,
+                   int width, int height, ImageDiffMetrics &metrics)
+{
+    memset(&metrics, 0, sizeof(metrics));
+    metrics.ssim = 1;
+    metrics.min_ssim = 1;
+    metrics.psnr = HUGE_VAL;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    MeasureJob job;
+    job.a = a;
+    job.b = b;
+    job.width = width;
+    job.height = height;
+    const int bands = (height + ssim_tile-1) / ssim_tile;
+    job.squared_error.resize(bands);
+    job.ssim_sum.resize(bands);
+    job.min_ssim.resize(bands);
+    job.ssim_tiles.resize(bands);
+    job.edge_pixels.resize(bands);
+    job.histograms.resize(2*IMAGE_DIFF_BUCKETS*size_t(bands));
+    diffPool().run(measureBand, &job, bands);
+
+    double squared_error = 0,
+           ssim_sum = 0;
+    int tiles = 0;
+    for (int i=0; i<bands; i++) {
+        squared_error += job.squared_error[i];
+        ssim_sum += job.ssim_sum[i];
+        tiles += job.ssim_tiles[i];
+        metrics.min_ssim = std::min(metrics.min_ssim, job.min_ssim[i]);
+        metrics.edge_pixels += job.edge_pixels[i];
+        for (int j=0; j<IMAGE_DIFF_BUCKETS; j++) {
+            metrics.edge_histogram[j] += job.histograms[(2*i)*IMAGE_DIFF_BUCKETS + j];
+            metrics.flat_histogram[j] += job.histograms[(2*i+1)*IMAGE_DIFF_BUCKETS + j];
+        }
+    }
+    metrics.mse = squared_error / (3.0*width*height);
+    if (metrics.mse > 0) {
+        metrics.psnr = 10*log10(255.0*255.0/metrics.mse);
+    }
+    metrics.ssim = ssim_sum / tiles;
+}
+
+static string histogramJSON(const unsigned int histogram[IMAGE_DIFF_BUCKETS])
+{
+    string json = "[";
+    for (int i=0; i<IMAGE_DIFF_BUCKETS; i++) {
+        char buf[32];
+        sprintf(buf, i ? ", %u" : "%u", histogram[i]);
+        json += buf;
+    }
+    return json + "]";
+}
+
+string imageDiffMetricsJSON(const ImageDiffMetrics &metrics)
+{
+    char buf[400];
+    char psnr[32] = "null";  // JSON has no infinity
+    if (metrics.mse > 0) {
+        sprintf(psnr, "%.3f", metrics.psnr);
+    }
+    sprintf(buf, "\"mse\": %.6g, \"psnr\": %s, \"ssim\": %.6f, \"min_ssim\": %.6f, "
+                 "\"edge_pixels\": %u, ",
+        metrics.mse, psnr, metrics.ssim, metrics.min_ssim, metrics.edge_pixels);
+    return string(buf) +
+           "\"edge_histogram\": " + histogramJSON(metrics.edge_histogram) + ", " +
+           "\"flat_histogram\": " + histogramJSON(metrics.flat_histogram);
+}
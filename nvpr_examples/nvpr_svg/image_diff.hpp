@@ -0,0 +1,72 @@
+/* image_diff.hpp - compare rendered RGB images for regressions */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __image_diff_hpp__
+#define __image_diff_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include <string>
+
+// How diffImages judges the pixels of a that differ from b.
+struct ImageDiffSettings {
+    // Any difference makes a pixel wrong.
+    bool exact;
+    // Otherwise a pixel is close if every channel is within max_difference
+    // (exclusive) of some pixel of b up to neighborhood pixels away, or,
+    // with adjacent_average, of the average of that pixel and b's own.
+    int neighborhood;
+    int max_difference;
+    bool adjacent_average;
+};
+
+enum ImageDiffMatch {
+    IMAGES_DIFFERENT,            // some pixel is wrong
+    IMAGES_APPROXIMATELY_SAME,   // some pixels differ, all close
+    IMAGES_SAME
+};
+
+// Compares width by height images of packed RGB bytes, rows bottom to top.
+// diff gets a's pixels at a third of their brightness where they are the
+// same or close, and 128 plus a quarter of a-b where wrong.  Rows with no
+// difference are found with memcmp and the rest are tested a row at a time
+// (with SSE2 where available), rows split among one thread per processor.
+//
+// Not safe to call from several threads at once.
+extern ImageDiffMatch diffImages(const unsigned char *a, const unsigned char *b,
+                                 unsigned char *diff, int width, int height,
+                                 const ImageDiffSettings &settings,
+                                 int &different_pixels, int &close_pixels);
+
+// Statistics of how a differs from b for gating regressions on thresholds
+// rather than on the pixel verdicts above.
+enum { IMAGE_DIFF_BUCKETS = 9 };
+
+struct ImageDiffMetrics {
+    double mse;       // mean squared channel difference
+    double psnr;      // peak signal to noise ratio in dB; infinite if mse is 0
+    double ssim;      // mean structural similarity of luma over 8x8 tiles
+    double min_ssim;  // of the least similar tile
+    // Pixels by their largest channel difference: bucket 0 counts those
+    // that are the same and bucket i those differing by [2^(i-1),2^i).
+    // Antialiasing shows up as coverage differences along edges, so pixels
+    // where b's luma varies by more than 24 across the 3x3 neighborhood
+    // are counted apart from the flat ones.
+    unsigned int edge_pixels;
+    unsigned int edge_histogram[IMAGE_DIFF_BUCKETS];
+    unsigned int flat_histogram[IMAGE_DIFF_BUCKETS];
+};
+
+// Measures images laid out as for diffImages in one pass of 8-row bands,
+// split among the same threads.
+extern void measureImages(const unsigned char *a, const unsigned char *b,
+                          int width, int height, ImageDiffMetrics &metrics);
+
+// The metrics as the members of a JSON object, without braces, so callers
+// can add their own.  An infinite psnr is written as null.
+extern std::string imageDiffMetricsJSON(const ImageDiffMetrics &metrics);
+
+#endif // __image_diff_hpp__
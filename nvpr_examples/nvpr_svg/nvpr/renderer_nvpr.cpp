@@ -28,6 +28,7 @@
 #include "path.hpp"
 
 #include "sRGB_vector.hpp"
+#include "gradient_ramp.hpp"
 
 #include "dsa_emulate.h"
 
@@ -244,145 +245,23 @@ void NVprGradientPaintRendererState::validateGenericGradientState(GradientPaint
 {
     const bool use_sRGB = getRenderer()->render_sRGB;
 
-    vector<float4> ramp(getRenderer()->color_ramp_size);
-    const size_t ramp_size_minus_one = ramp.size()-1;
-
-    const vector<GradientStop> &stop_array = paint->getStopArray();
-    assert(stop_array.size() >= 2);
-    vector<GradientStop>::const_iterator stop = stop_array.begin();
-
-    fullyOpaqueGradient = true;
-    float offset1 = stop->offset;
-    float4 color1 = stop->color;
-    if (color1.a != 1.0) {
-        fullyOpaqueGradient = false;
-    }
-
-    size_t i;
-    for (i=0; i<ramp_size_minus_one; i++) {
-        float texel_offset = float(i)/ramp_size_minus_one;
-
-        if (texel_offset <= offset1) {
-            ramp[i] = color1;
-        } else {
-            break;
-        }
-    }
-    stop++;
-    float4 color2;
-    if (use_sRGB) {
-        float4 lin_color1 = srgb2linear(color1), lin_color2;
-
-        while (stop != stop_array.end()) {
-            assert(stop != stop_array.end());
-            // "Each gradient offset value is required to be equal to 
-            // or greater than the previous gradient stop's offset 
-            // value. If a given gradient stop's offset value is not 
-            // equal to or greater than all previous offset values,
-            // then the offset value is adjusted to be equal to the 
-            // largest of all previous offset values."
-            float offset2 = max(stop->offset, offset1);
-            color2 = stop->color;
-            lin_color2 = srgb2linear(color2);
-            if (color2.a != 1.0) {
-                fullyOpaqueGradient = false;
-            }
-            
-            for (; i<ramp_size_minus_one; i++) {
-                float texel_offset = float(i)/ramp_size_minus_one;
-                float weight = (texel_offset-offset1)/(offset2-offset1);
-                float4 weighted_color;
-                if (weight >= 0 && weight <= 1) {
-                    // Blend linear colors and converted result to sRGB.
-                    weighted_color = linear2srgb(lerp(lin_color1, lin_color2, weight));
-                } else {
-                    weighted_color = color2;
-                }
-
-                if (texel_offset <= offset2) {
-                    ramp[i] = weighted_color;
-                } else {
-                    break;
-                }
-            }
-            color1 = color2;
-            lin_color1 = lin_color2;
-            offset1 = offset2;
-            stop++;
-        }
-    } else {
-        while (stop != stop_array.end()) {
-            assert(stop != stop_array.end());
-            // "Each gradient offset value is required to be equal to 
-            // or greater than the previous gradient stop's offset 
-            // value. If a given gradient stop's offset value is not 
-            // equal to or greater than all previous offset values,
-            // then the offset value is adjusted to be equal to the 
-            // largest of all previous offset values."
-            float offset2 = max(stop->offset, offset1);
-            color2 = stop->color;
-            if (color2.a != 1.0) {
-                fullyOpaqueGradient = false;
-            }
-            for (; i<ramp_size_minus_one; i++) {
-                float texel_offset = float(i)/ramp_size_minus_one;
-                float weight = (texel_offset-offset1)/(offset2-offset1);
-                float4 weighted_color;
-                if (weight >= 0 && weight <= 1) {
-                    weighted_color = lerp(color1, color2, weight);
-                } else {
-                    weighted_color = color2;
-                }
-
-                if (texel_offset <= offset2) {
-                    ramp[i] = weighted_color;
-                } else {
-                    break;
-                }
-            }
-            color1 = color2;
-            offset1 = offset2;
-            stop++;
-        }
-    }
-    for (; i<ramp_size_minus_one; i++) {
-        ramp[i] = color2;
-    }
-    ramp[ramp_size_minus_one] = stop_array.back().color;
+    // Paints sharing stops share one ramp, mipmaps included, made once.
+    GradientRampPtr ramp = getGradientRamp(paint->getGradientStops(),
+                                           getRenderer()->color_ramp_size,
+                                           use_sRGB);
+    fullyOpaqueGradient = ramp->opaque;
 
     if (texobj == 0) {
         glGenTextures(1, &texobj);
         assert(texobj != 0);
     }
     glBindTexture(GL_TEXTURE_1D, texobj);
-    // Are we rendering in sRGB mode?
-    if (use_sRGB) {
-        // Yes, so generate the color ramp mipmaps with linear RGB color averaging.
-        GLsizei width = GLsizei(ramp.size());
-        GLint lod = 0;
-    
-        assert(getRenderer()->has_EXT_texture_sRGB);
-        glTexImage1D(GL_TEXTURE_1D, lod, GL_SRGB8_ALPHA8, width, 0, GL_RGBA, GL_FLOAT, &ramp[0]);
-        // Until all the mipmap levels are created...
-        while (width > 1) {
-            int half_width = width >> 1;  // integer divide rounds down
-            assert(half_width > 0);
-            // Downsample the 1D texture "in place".
-            for (int i=0; i<half_width; i++) {
-                // Convert adjacent color pairs to linear RGB.
-                float4 a = srgb2linear(ramp[2*i+0]);
-                float4 b = srgb2linear(ramp[2*i+1]);
-                // Average the linear pairs and convert back to sRGB.
-                ramp[i] = linear2srgb(0.5f*(a+b));
-            }
-            lod += 1;
-            width = half_width;
-            glTexImage1D(GL_TEXTURE_1D, lod, GL_SRGB8_ALPHA8, width, 0, GL_RGBA, GL_FLOAT, &ramp[0]);
-        }
-    } else {
-        // Let the driver generate the mipmaps.
-        glTexParameteri(GL_TEXTURE_1D, GL_GENERATE_MIPMAP, GL_TRUE);
-        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, GLsizei(ramp.size()), 0, GL_RGBA, GL_FLOAT, &ramp[0]);
+    // In sRGB mode the ramp's mipmaps were averaged in linear RGB.
+    assert(!use_sRGB || getRenderer()->has_EXT_texture_sRGB);
+    const GLenum internal_format = use_sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    for (int lod=0; lod<ramp->levels; lod++) {
+        glTexImage1D(GL_TEXTURE_1D, lod, internal_format, ramp->getWidth(lod), 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, ramp->getTexelsUB(lod));
     }
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, getRenderer()->min_filter);
     glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, getRenderer()->mag_filter);
@@ -11,102 +11,11 @@
 #include "nvpr_init.h"
 
 #include "renderer_nvpr.hpp"
-
-struct NVprPathCacheProcessor : PathSegmentProcessor {
-    Path *p;
-
-    GLuint &path;
-    GLenum &fill_rule;
-
-    vector<GLubyte> cmds;
-    vector<GLfloat> coords;
-
-    NVprPathCacheProcessor(Path *p_, GLuint &path_, GLenum &fill_rule_)
-        : p(p_)
-        , path(path_)
-        , fill_rule(fill_rule_)
-        , cmds(p->cmd.size())
-        , coords(p->coord.size())
-    {
-        cmds.clear();
-        coords.clear();
-    }
-
-    void beginPath(PathPtr p) {
-        switch (p->style.fill_rule) {
-        case PathStyle::EVEN_ODD:
-            fill_rule = GL_INVERT;
-            break;
-        default:
-            assert(!"bogus style.fill_rule");
-            break;
-        case PathStyle::NON_ZERO:
-            fill_rule = GL_COUNT_UP_NV;
-            break;
-        }
-    }
-    void moveTo(const float2 plist[2], size_t coord_index, char cmd) {
-        cmds.push_back(GL_MOVE_TO_NV);
-        coords.push_back(plist[1].x);
-        coords.push_back(plist[1].y);
-    }
-    void lineTo(const float2 plist[2], size_t coord_index, char cmd) {
-        cmds.push_back(GL_LINE_TO_NV);
-        coords.push_back(plist[1].x);
-        coords.push_back(plist[1].y);
-    }
-    void quadraticCurveTo(const float2 plist[3], size_t coord_index, char cmd) {
-        cmds.push_back(GL_QUADRATIC_CURVE_TO_NV);
-        coords.push_back(plist[1].x);
-        coords.push_back(plist[1].y);
-        coords.push_back(plist[2].x);
-        coords.push_back(plist[2].y);
-    }
-    void cubicCurveTo(const float2 plist[4], size_t coord_index, char cmd) {
-        cmds.push_back(GL_CUBIC_CURVE_TO_NV);
-        coords.push_back(plist[1].x);
-        coords.push_back(plist[1].y);
-        coords.push_back(plist[2].x);
-        coords.push_back(plist[2].y);
-        coords.push_back(plist[3].x);
-        coords.push_back(plist[3].y);
-    }
-    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
-        if (arc.large_arc_flag) {
-            if (arc.sweep_flag) {
-                cmds.push_back(GL_LARGE_CCW_ARC_TO_NV);
-            } else {
-                cmds.push_back(GL_LARGE_CW_ARC_TO_NV);
-            }
-        } else {
-            if (arc.sweep_flag) {
-                cmds.push_back(GL_SMALL_CCW_ARC_TO_NV);
-            } else {
-                cmds.push_back(GL_SMALL_CW_ARC_TO_NV);
-            }
-        }
-        coords.push_back(arc.radii.x);
-        coords.push_back(arc.radii.y);
-        coords.push_back(arc.x_axis_rotation);
-        coords.push_back(arc.p[1].x);
-        coords.push_back(arc.p[1].y);
-    }
-    void close(char cmd) {
-        cmds.push_back(GL_CLOSE_PATH_NV);
-    }
-    void endPath(PathPtr p) {
-        if (!path) {
-            path = glGenPathsNV(1);
-        }
-        glPathCommandsNV(path,
-                         GLsizei(cmds.size()), &cmds[0],
-                         GLsizei(coords.size()), GL_FLOAT, &coords[0]);
-    }
-};
+#include "renderer_nvpr_path.hpp"
 
 static GLenum lineCapConverter(const Path *path)
 {
-    switch (path->style.line_cap) {
+    switch (path->style->line_cap) {
     default:
         assert(!"bad line_cap");
     case PathStyle::BUTT_CAP:
@@ -122,7 +31,7 @@ static GLenum lineCapConverter(const Path *path)
 
 static GLenum lineJoinConverter(const Path *path)
 {
-    switch (path->style.line_join) {
+    switch (path->style->line_join) {
     default:
         assert(!"bad line_join");
     case PathStyle::MITER_TRUNCATE_JOIN:
@@ -146,16 +55,16 @@ void NVprPathRendererState::validate()
 
     NVprPathCacheProcessor processor(owner, path, fill_rule);
     owner->processSegments(processor);
-    if (owner->style.do_stroke) {
+    if (owner->style->do_stroke) {
         glPathParameteriNV(path, GL_PATH_JOIN_STYLE_NV, lineJoinConverter(owner));
         glPathParameteriNV(path, GL_PATH_END_CAPS_NV, lineCapConverter(owner));
-        glPathParameterfNV(path, GL_PATH_STROKE_WIDTH_NV, owner->style.stroke_width);
-        glPathParameterfNV(path, GL_PATH_MITER_LIMIT_NV, owner->style.miter_limit);
-        if (owner->style.dash_array.size()) {
-            glPathDashArrayNV(path, GLsizei(owner->style.dash_array.size()), &owner->style.dash_array[0]);
+        glPathParameterfNV(path, GL_PATH_STROKE_WIDTH_NV, owner->style->stroke_width);
+        glPathParameterfNV(path, GL_PATH_MITER_LIMIT_NV, owner->style->miter_limit);
+        if (owner->style->dash_array.size()) {
+            glPathDashArrayNV(path, GLsizei(owner->style->dash_array.size()), &owner->style->dash_array[0]);
             glPathParameteriNV(path, GL_PATH_DASH_CAPS_NV, lineCapConverter(owner));
-            glPathParameterfNV(path, GL_PATH_DASH_OFFSET_NV, owner->style.dash_offset);
-            GLenum dash_offset_reset = (owner->style.dash_phase == PathStyle::MOVETO_RESETS)
+            glPathParameterfNV(path, GL_PATH_DASH_OFFSET_NV, owner->style->dash_offset);
+            GLenum dash_offset_reset = (owner->style->dash_phase == PathStyle::MOVETO_RESETS)
                 ? GL_MOVE_TO_RESETS_NV
                 : GL_MOVE_TO_CONTINUES_NV;
             glPathParameteriNV(path, GL_PATH_DASH_OFFSET_RESET_NV, dash_offset_reset);
@@ -0,0 +1,120 @@
+/* renderer_nvpr_path.hpp - converts paths to NV_path_rendering path objects */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __renderer_nvpr_path_hpp__
+#define __renderer_nvpr_path_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include "nvpr_svg_config.h"  // configure path renderers to use
+
+#if USE_NVPR
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "path.hpp"
+
+using std::vector;
+
+// Statically dispatched processor for Path::processSegments that
+// (re)specifies an NV_path_rendering path object from a path.
+struct NVprPathCacheProcessor {
+    Path *p;
+
+    GLuint &path;
+    GLenum &fill_rule;
+
+    vector<GLubyte> cmds;
+    vector<GLfloat> coords;
+
+    NVprPathCacheProcessor(Path *p_, GLuint &path_, GLenum &fill_rule_)
+        : p(p_)
+        , path(path_)
+        , fill_rule(fill_rule_)
+        , cmds(p->cmd.size())
+        , coords(p->coord.size())
+    {
+        cmds.clear();
+        coords.clear();
+    }
+
+    void beginPath(PathPtr p) {
+        switch (p->style->fill_rule) {
+        case PathStyle::EVEN_ODD:
+            fill_rule = GL_INVERT;
+            break;
+        default:
+            assert(!"bogus style.fill_rule");
+            break;
+        case PathStyle::NON_ZERO:
+            fill_rule = GL_COUNT_UP_NV;
+            break;
+        }
+    }
+    void moveTo(const float2 plist[2], size_t coord_index, char cmd) {
+        cmds.push_back(GL_MOVE_TO_NV);
+        coords.push_back(plist[1].x);
+        coords.push_back(plist[1].y);
+    }
+    void lineTo(const float2 plist[2], size_t coord_index, char cmd) {
+        cmds.push_back(GL_LINE_TO_NV);
+        coords.push_back(plist[1].x);
+        coords.push_back(plist[1].y);
+    }
+    void quadraticCurveTo(const float2 plist[3], size_t coord_index, char cmd) {
+        cmds.push_back(GL_QUADRATIC_CURVE_TO_NV);
+        coords.push_back(plist[1].x);
+        coords.push_back(plist[1].y);
+        coords.push_back(plist[2].x);
+        coords.push_back(plist[2].y);
+    }
+    void cubicCurveTo(const float2 plist[4], size_t coord_index, char cmd) {
+        cmds.push_back(GL_CUBIC_CURVE_TO_NV);
+        coords.push_back(plist[1].x);
+        coords.push_back(plist[1].y);
+        coords.push_back(plist[2].x);
+        coords.push_back(plist[2].y);
+        coords.push_back(plist[3].x);
+        coords.push_back(plist[3].y);
+    }
+    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
+        if (arc.large_arc_flag) {
+            if (arc.sweep_flag) {
+                cmds.push_back(GL_LARGE_CCW_ARC_TO_NV);
+            } else {
+                cmds.push_back(GL_LARGE_CW_ARC_TO_NV);
+            }
+        } else {
+            if (arc.sweep_flag) {
+                cmds.push_back(GL_SMALL_CCW_ARC_TO_NV);
+            } else {
+                cmds.push_back(GL_SMALL_CW_ARC_TO_NV);
+            }
+        }
+        coords.push_back(arc.radii.x);
+        coords.push_back(arc.radii.y);
+        coords.push_back(arc.x_axis_rotation);
+        coords.push_back(arc.p[1].x);
+        coords.push_back(arc.p[1].y);
+    }
+    void close(char cmd) {
+        cmds.push_back(GL_CLOSE_PATH_NV);
+    }
+    void endPath(PathPtr p) {
+        if (!path) {
+            path = glGenPathsNV(1);
+        }
+        glPathCommandsNV(path,
+                         GLsizei(cmds.size()), &cmds[0],
+                         GLsizei(coords.size()), GL_FLOAT, &coords[0]);
+    }
+};
+
+#endif // USE_NVPR
+
+#endif // __renderer_nvpr_path_hpp__
@@ -55,9 +55,16 @@
 #include "glmatrix.hpp"
 #include "countof.h"
 #include "svg_files.hpp"
+#include "corpus_benchmark.hpp"
 #include "sRGB_vector.hpp"
 
 #include "path.hpp"
+#include "scene_bvh.hpp"
+#include "scene_cache.hpp"
+#include "svg_loader_pool.hpp"
+#include "tile_pool.hpp"
+#include "image_cache.hpp"
+#include "image_diff.hpp"
 
 #define STBI_HEADER_FILE_ONLY
 #include "stb/stb_image.h"
@@ -122,6 +129,7 @@ int angleRotateRate = 0;
 bool have_dlist = false;  // when true, don't call glGet
 bool use_dlist = false;
 bool makingDlist = false;
+bool cull_to_view = true;  // skip scene nodes outside the window
 bool render_top_to_bottom;
 bool force_stencil_clear = false;
 bool only_necessary_stencil_clears;
@@ -144,6 +152,18 @@ bool showSamplePattern = false;
 float accumulationSpread;
 static bool noDSA = false;  // true means force DSA emulation
 static int extended_benchmark_requested = 0;
+static bool segment_benchmark_requested = false;
+static bool load_benchmark_requested = false;
+static bool style_benchmark_requested = false;
+static bool image_benchmark_requested = false;
+static bool convert_svg_requested = false;
+static bool use_scene_cache = true;  // load SVG files from current scene caches
+static bool use_stream_loader = false;  // parse SVG files while reading them
+static int loader_threads = -1;  // SvgLoaderPool workers; -1 for automatic, 0 for no pool
+static SvgLoaderPoolPtr loader_pool;  // loads upcoming SVG files in corpus walks
+static int tile_threads = 0;  // software renderer tile threads; 0 for untiled, -1 for one per processor
+static FILE *diff_json = NULL;  // gets a line of image difference metrics for each regression test
+static bool use_pan_cache = true;  // scroll the software window's image when the view only pans
 static int allowSoftwareWindow = true;
 static int extended_benchmark_res  = 0;
 static int extended_benchmark_file = 0;
@@ -166,6 +186,10 @@ int window_x, window_y;
 int gl_window_width = 500, gl_window_height = 500;
 static float2 wh;
 bool software_window_valid = false;
+bool software_window_damaged = false;  // valid except for scene_bvh's damage
+bool software_window_view_changed = false;  // valid except for a new view
+static bool scene_unshared = false;  // by unshareSceneForEditing
+static float4x4 software_window_transform;  // scene to window when last drawn
 bool request_software_window = false;
 bool request_gold_window = false;
 bool request_diff_window = false;
@@ -246,6 +270,7 @@ static void benchmarkReport(int v);
 static void benchmarkSoftwareRendering(float &drawing_fps, float &raw_fps, bool printResults = true);
 #if USE_D2D || USE_CAIRO || USE_QT || USE_OPENVG || USE_SKIA
 static void benchmarkSoftwareRendering(float &raw_fps, BlitRendererPtr blit_renderer);
+static void benchmarkTileThreads(BlitRendererPtr blit_renderer);
 #endif
 static void benchmarkGLRendering(float &drawing_fps, bool printResults = true);
 static void extendedBenchmarkSoftwareRendering();
@@ -408,16 +433,16 @@ struct RenderResult {
         assert(col < width);
         assert(row >= 0);
         assert(row < height);
-        return img[col*height+row];
+        return img[row*width+col];
     }
     void setPixel(int col, int row, int r, int g, int b) {
         assert(col >= 0);
         assert(col < width);
         assert(row >= 0);
         assert(row < height);
-        img[col*height+row].r = r;
-        img[col*height+row].g = g;
-        img[col*height+row].b = b;
+        img[row*width+col].r = r;
+        img[row*width+col].g = g;
+        img[row*width+col].b = b;
     }
 };
 
@@ -460,75 +485,23 @@ struct RenderResultDifference : RenderResult {
                 width = w;
                 height = h;
             }
-            for (int i=0; i<w; i++) {
-                for (int j=0; j<h; j++) {
-                    RGB apix = a->getPixel(i,j),
-                        bpix = b->getPixel(i,j);
-                    if (apix != bpix) {
-                        if (compare_exact) {
-                            result = DIFFERENT;
-                            int r = (apix.r - bpix.r + 255)/4 + 128,
-                                g = (apix.g - bpix.g + 255)/4 + 128,
-                                b = (apix.b - bpix.b + 255)/4 + 128;
-                            setPixel(i, j, r,g,b);
-                            different_pixels++;
-                        } else {
-                            bool different = true;
-                            int min_diff = 255*3;
-                            int max_diff = 0;
-                            for (int y=-diff_neighborhood; y<=diff_neighborhood && different; y++) {
-                                for (int x=-diff_neighborhood; x<=diff_neighborhood; x++) {
-                                    int ii = clamp(i+y,0,h-1),
-                                        jj = clamp(j+x,0,w-1);
-
-                                    RGB cpix = b->getPixel(ii, jj);
-                                    int diff;
-                                    diff =           abs(apix.r-cpix.r);
-                                    diff = max(diff, abs(apix.g-cpix.g));
-                                    diff = max(diff, abs(apix.b-cpix.b));
-                                    if (diff < max_difference) {
-                                        different = false;
-                                        break;
-                                    }
-                                    min_diff = min(min_diff, diff);
-                                    max_diff = max(max_diff, diff);
-
-                                    if (adj_average) {
-                                        int3 iapix = apix.convertToInt3();
-                                        int3 ibpix = bpix.convertToInt3();
-                                        int3 icpix = cpix.convertToInt3();
-                                        int3 idpix = (ibpix + icpix) / 2;
-                                        int3 diff_pix = abs(iapix-idpix);
-
-                                        diff = max(diff_pix.r, max(diff_pix.g, diff_pix.b));
-                                        if (diff < max_difference) {
-                                            different = false;
-                                            break;
-                                        }
-                                        min_diff = min(min_diff, diff);
-                                        max_diff = max(max_diff, diff);
-                                    }
-                                }
-                            }
-                            if (different) {
-                                different_pixels++;
-                                result = DIFFERENT;
-                                int r = (apix.r - bpix.r + 255)/4 + 128,
-                                    g = (apix.g - bpix.g + 255)/4 + 128,
-                                    b = (apix.b - bpix.b + 255)/4 + 128;
-                                setPixel(i, j, r,g,b);
-                            } else {
-                                if (result != DIFFERENT && min_diff > 0) {
-                                    result = APPROXIMATELY_SAME;
-                                }
-                                setPixel(i, j, apix.r/3,apix.g/3,apix.b/3);
-                                close_pixels++;
-                            }
-                        }
-                    } else {
-                        setPixel(i, j, apix.r/3,apix.g/3,apix.b/3);
-                    }
-                }
+            // RGB is three packed bytes.
+            ImageDiffSettings settings;
+            settings.exact = compare_exact != 0;
+            settings.neighborhood = diff_neighborhood;
+            settings.max_difference = max_difference;
+            settings.adjacent_average = adj_average != 0;
+            switch (diffImages(&a->img[0].r, &b->img[0].r, &img[0].r, w, h, settings,
+                               different_pixels, close_pixels)) {
+            case IMAGES_DIFFERENT:
+                result = DIFFERENT;
+                break;
+            case IMAGES_APPROXIMATELY_SAME:
+                result = APPROXIMATELY_SAME;
+                break;
+            case IMAGES_SAME:
+                result = SAME;
+                break;
             }
             return result;
         }
@@ -665,6 +638,7 @@ void set_clear_color(float4 color)
 static void setFontScene(unsigned int font_index);
 #endif
 static void setPathScene(PathInfo &pathInfo);
+static SvgScenePtr loadSVGFile(const char *svg_filename, float pixels_per_millimeter);
 static void setSVGScene(const char *svg_filename);
 static void setClipObject(PathInfo &pathInfo);
 static void reloadScene();
@@ -838,6 +812,10 @@ int main(int argc, char **argv)
             printf("will never use DSA (EXT_direct_state_access), emulates DSA instead\n");
             noDSA = true;
         } else
+        if (!stricmp("-noCull", argv[i])) {
+            printf("DON'T cull scene nodes outside the window\n");
+            cull_to_view = false;
+        } else
         if (!stricmp("-noStroking", argv[i])) {
             printf("SKIP stroking in content (use 'x' to toggle back on)\n");
             doStroking = false;
@@ -910,6 +888,65 @@ int main(int argc, char **argv)
         if (!stricmp("-xbenchmark", argv[i])) {  // Musawir's extended benchmark mode
             extended_benchmark_requested = 1;
         } else
+        if (!stricmp("-benchmarkParse", argv[i])) {
+            benchmarkPathParsing();
+            exit(0);
+        } else
+        if (!stricmp("-benchmarkSegments", argv[i])) {
+            // Needs NV_path_rendering so run once the OpenGL window exists.
+            segment_benchmark_requested = true;
+        } else
+        if (!stricmp("-benchmarkLoad", argv[i])) {
+            // svg_loader needs pixels_per_millimeter so run once the window exists.
+            load_benchmark_requested = true;
+        } else
+        if (!stricmp("-benchmarkStyle", argv[i])) {
+            // svg_loader needs pixels_per_millimeter so run once the window exists.
+            style_benchmark_requested = true;
+        } else
+        if (!stricmp("-benchmarkImages", argv[i])) {
+            // svg_loader needs pixels_per_millimeter so run once the window exists.
+            image_benchmark_requested = true;
+        } else
+        if (!stricmp("-imageCacheMB", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-imageCacheMB expects integer argument\n");
+              exit(1);
+            } else {
+              setRasterImageCacheLimit(size_t(atoi(argv[i])) << 20);
+            }
+        } else
+        if (!stricmp("-convertSVG", argv[i])) {
+            convert_svg_requested = true;
+        } else
+        if (!stricmp("-noSceneCache", argv[i])) {
+            use_scene_cache = false;
+        } else
+        if (!stricmp("-streamSVG", argv[i])) {
+            use_stream_loader = true;
+        } else
+        if (!stricmp("-loaderThreads", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-loaderThreads expects integer argument\n");
+              exit(1);
+            } else {
+              loader_threads = atoi(argv[i]);
+            }
+        } else
+        if (!stricmp("-tileThreads", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-tileThreads expects integer argument\n");
+              exit(1);
+            } else {
+              tile_threads = atoi(argv[i]);
+            }
+        } else
+        if (!stricmp("-noPanCache", argv[i])) {
+            use_pan_cache = false;
+        } else
         if (!stricmp("-noSW", argv[i])) {
             allowSoftwareWindow = false;
         } else
@@ -965,6 +1002,19 @@ int main(int argc, char **argv)
         if (!stricmp("-regress", argv[i])) {
             request_regress = true;
         } else
+        if (!stricmp("-diffJSON", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-diffJSON expects filename argument\n");
+              exit(1);
+            } else {
+              diff_json = fopen(argv[i], "w");
+              if (!diff_json) {
+                printf("could not open %s\n", argv[i]);
+                exit(1);
+              }
+            }
+        } else
         if (!stricmp("-seed", argv[i])) {
             request_seed = true;
         } else
@@ -1122,6 +1172,33 @@ int main(int argc, char **argv)
 
     configureWindowForGL();
 
+    if (segment_benchmark_requested) {
+        benchmarkSegmentProcessing();
+        exit(0);
+    }
+    if (convert_svg_requested) {
+        convertSVGCorpus();
+        exit(0);
+    }
+    if (load_benchmark_requested) {
+        benchmarkSceneLoading();
+        exit(0);
+    }
+    if (style_benchmark_requested) {
+        benchmarkStyleLoading();
+        exit(0);
+    }
+    if (image_benchmark_requested) {
+        benchmarkImageLoading();
+        exit(0);
+    }
+    if (loader_threads != 0) {
+        loader_pool = SvgLoaderPoolPtr(new SvgLoaderPool(loadSVGFile, pixels_per_millimeter, loader_threads));
+        if (verbose) {
+            printf("loading SVG files with %d worker threads\n", loader_pool->getThreadCount());
+        }
+    }
+
     setClipObject(path_objects[current_clip_object]);
     reloadScene();
 
@@ -1310,6 +1387,7 @@ static void sceneChanged()
     updateSceneCoverModes(scene);
     software_window_valid = false;
     force_stencil_clear = true;
+    scene_unshared = false;
 
     CountNonOpaqueObjectsPtr counter(new CountNonOpaqueObjects);
     scene->traverse(counter);
@@ -1429,6 +1507,14 @@ static void setPathScene(PathInfo &pathInfo)
     sceneChanged();
 }
 
+// Called on SvgLoaderPool worker threads too, so only reads settings.
+static SvgScenePtr loadSVGFile(const char *svg_filename, float pixels_per_millimeter)
+{
+    return use_scene_cache ? svg_loader_cached(svg_filename, pixels_per_millimeter, use_stream_loader)
+         : use_stream_loader ? svg_stream_loader(svg_filename, pixels_per_millimeter, NULL)
+                             : svg_loader(svg_filename, pixels_per_millimeter);
+}
+
 static void setSVGScene(const char *svg_filename)
 {
     bool printStuff = !extended_benchmark_requested || verbose;
@@ -1438,38 +1524,10 @@ static void setSVGScene(const char *svg_filename)
     }
     fflush(stdout);
     glutSetWindow(gl_window);
-    SvgScenePtr svg_scene = svg_loader(svg_filename);
+    SvgScenePtr svg_scene = loader_pool ? loader_pool->take(svg_filename)
+                                        : loadSVGFile(svg_filename, pixels_per_millimeter);
     if (svg_scene) {
-
-        const float4 svg_scene_bounds = svg_scene->getBounds();
-        float l = svg_scene_bounds.x,
-              r = svg_scene_bounds.z,
-              t = svg_scene_bounds.y,
-              b = svg_scene_bounds.w;
-        scene_ratio = abs(b-t)/abs(r-l);
-        // Wind "from" vertices in counter-clockwise order from lower-left
-        const float2 from[4] = {float2(l,b),float2(r,b),float2(r,t),float2(l,t)};
-        float xscale = 1,
-              yscale = 1;
-        if (abs(r-l) > abs(b-t)) {
-            yscale = abs(b-t)/abs(r-l);
-            if (verbose) {
-                printf("wide %f\n", scene_ratio);
-            }
-        } else {
-            xscale = abs(r-l)/abs(b-t);
-            if (verbose) {
-                printf("tall %f\n", scene_ratio);
-            }
-        }
-        // Wind "to" vertices in counter-clockwise order from lower-left
-        static const float2 to[4] = {float2(-1,-1),float2(1,-1),float2(1,1),float2(-1,1)};
-        // Scale down by 90% to better fit frame
-        float shrinkage = 0.9;
-        WarpTransformPtr normalizedScene(new WarpTransform(svg_scene, to, from,
-            shrinkage*float2(xscale, yscale)));
-        scene = GroupPtr(new Group);
-        scene->push_back(normalizedScene);
+        scene = fitSceneToClip(svg_scene, scene_ratio);
         sceneChanged();
         if (printStuff) {
             printf(" ok\n");
@@ -1961,14 +2019,32 @@ static void clear(bool clearDepth = false)
     glClear(clearBuffers);
 }
 
+// Traversal skipping nodes outside the GL window for the current view.
+static CullingTraversal glCullingTraversal(bool reverse_order)
+{
+    const float4x4 scene_to_window = mul(nvpr_renderer->surface_to_window, view_to_surface);
+    const float4 window = float4(0, 0, gl_window_width, gl_window_height);
+    return CullingTraversal(scene_to_window, window, reverse_order);
+}
+
 static void drawScene()
 {
+    // Display lists get replayed for any view so can't be culled.
+    const bool cull = cull_to_view && !makingDlist;
+
     if (render_top_to_bottom) {
         glDisable(GL_BLEND);
-        ReverseTraversal traversal;
-        scene->traverse(
-            VisitorPtr(new StCVisitors::ReversePainter(nvpr_renderer, 0x80, view_to_surface)),
-            traversal);
+        if (cull) {
+            CullingTraversal traversal = glCullingTraversal(true);
+            scene->traverse(
+                VisitorPtr(new StCVisitors::ReversePainter(nvpr_renderer, 0x80, view_to_surface)),
+                traversal);
+        } else {
+            ReverseTraversal traversal;
+            scene->traverse(
+                VisitorPtr(new StCVisitors::ReversePainter(nvpr_renderer, 0x80, view_to_surface)),
+                traversal);
+        }
         if (non_opaque_objects>0 && any(clear_color != float4(0))) {
             // We need to "under" blend the actual background color into the scene
             // since top-to-bottom order (Reverse Painter's algorithm) requires the
@@ -1995,15 +2071,18 @@ static void drawScene()
         }
         glDisable(GL_BLEND);
     } else {
+        GenericTraversal generic_traversal;
+        CullingTraversal culling_traversal = glCullingTraversal(false);
+        Traversal &traversal = cull ? static_cast<Traversal&>(culling_traversal) : generic_traversal;
         if (xsteps > 1 || ysteps > 1) {
             glMatrixPushEXT(GL_MODELVIEW); {
                 scene->traverse(VisitorPtr(new StCVisitors::DrawDilated(
                     nvpr_renderer, 0x80, view_to_surface, xsteps, ysteps, 
-                    stipple, spread)));
+                    stipple, spread)), traversal);
             } glMatrixPopEXT(GL_MODELVIEW);
         } else {
             float4x4 m = makingDlist ? identity4x4() : view_to_surface;
-            scene->traverse(VisitorPtr(new StCVisitors::Draw(nvpr_renderer, 0x80, m)));
+            scene->traverse(VisitorPtr(new StCVisitors::Draw(nvpr_renderer, 0x80, m)), traversal);
         }
     }
 }
@@ -2358,8 +2437,8 @@ static void updateTransform()
     view_to_surface = view;  // should update view_to_surface directly!
     glMatrixLoadTransposefEXT(GL_MODELVIEW, &view_to_surface[0][0]);
 
-    // Force cairo redraw
-    software_window_valid = false;
+    // Force a software redraw; a pan may just scroll the old image.
+    software_window_view_changed = true;
 
     // Multi-pass mode will computed different dilated convex hulls.
     if (xsteps*ysteps > 1) {
@@ -2509,15 +2588,114 @@ static D2DRendererPtr d2d_renderer;
 static D2DRendererPtr d2dWARP_renderer;
 #endif
 
+// Built on demand for picking and damage tracking; rebuilt whenever the
+// scene root changes.
+static ShapeBVHPtr scene_bvh;
+
+static ShapeBVHPtr getSceneBVH()
+{
+    if (!scene_bvh || scene_bvh->getRoot() != scene) {
+        scene_bvh = ShapeBVHPtr(new ShapeBVH(scene));
+    }
+    return scene_bvh;
+}
+
+// The loaders share <use>d subtrees and paths between instances, so
+// before the first edit of a scene give each instance its own copies;
+// then dragging a control point moves only the instance picked.  Scenes
+// that are only viewed keep the sharing.
+static void unshareSceneForEditing()
+{
+    if (!scene_unshared) {
+        unshareScene(scene);
+        scene_bvh.reset();  // its shapes are the shared ones
+        have_dlist = false;
+        scene_unshared = true;
+    }
+}
+
+// When the view has only panned by whole window pixels since the image
+// was drawn, scrolls the image along and draws just the strips scrolled
+// in.  Returns false if the view did more (zoom, rotation, a fraction of
+// a pixel), in which case the whole window must be redrawn.
+static bool swScroll(BlitRendererPtr renderer, const float4x4 &scene_to_window)
+{
+    const float4x4 &old = software_window_transform;
+    if (scene_to_window[0][0] != old[0][0] || scene_to_window[0][1] != old[0][1] ||
+        scene_to_window[1][0] != old[1][0] || scene_to_window[1][1] != old[1][1] ||
+        scene_to_window[3][0] != 0 || scene_to_window[3][1] != 0 ||
+        scene_to_window[3][3] != 1 || old[3][0] != 0 || old[3][1] != 0 || old[3][3] != 1) {
+        return false;  // more than a translation
+    }
+    const float2 delta = float2(scene_to_window[0][3] - old[0][3],
+                                scene_to_window[1][3] - old[1][3]);
+    const int dx = int(floor(delta.x + 0.5f)),
+              dy = int(floor(delta.y + 0.5f));
+    // Antialiasing differs with the pixel phase, so pixels are only reused
+    // for whole pixel moves.  Even then Cairo and Skia can round a few of
+    // them differently than a whole frame of the panned view would; the
+    // strips drawn match it exactly.
+    const float tolerance = 1.0f/256;
+    if (fabs(delta.x - dx) > tolerance || fabs(delta.y - dy) > tolerance) {
+        return false;
+    }
+    return scrollSurfaceScene(renderer, scene, view, scene_to_window, clear_color.rgb,
+                              sw_window_width, sw_window_height, dx, dy);
+}
+
 void swRender(BlitRendererPtr renderer)
 {
-    renderer->beginDraw();
-    renderer->clear(clear_color.rgb);
-    renderer->setView(view);
-    scene->traverse(renderer->makeVisitor());
-    renderer->endDraw();
+    const float4x4 scene_to_window =
+        mul(surfaceToWindow(sw_window_width, sw_window_height, scene_ratio), view);
+    const float4 window = float4(0, 0, sw_window_width, sw_window_height);
+
+    // When the prior image is only damaged, redraw just the damaged
+    // window rectangle and the shapes touching it, as a whole frame would
+    // draw them.  The damage is made of the shapes' ink bounds, so it
+    // takes in miter joins; the dilation is for antialiasing.
+    bool partial = false;
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    if (scene_bvh && scene_bvh->getRoot() == scene) {
+        // Always take the damage so it doesn't build up over full renders.
+        RectBounds damage = scene_bvh->takeDamage();
+        if (software_window_valid && software_window_damaged && !software_window_view_changed) {
+            if (!damage.isValid()) {
+                software_window_damaged = false;
+                return;  // nothing moved
+            }
+            damage = damage.transform(scene_to_window);
+            damage = damage.dilate(2) & window;  // allow for antialiasing
+            if (!damage.isValid() || damage.x >= damage.z || damage.y >= damage.w) {
+                software_window_damaged = false;
+                return;  // damage is out of view
+            }
+            x0 = int(floor(damage.x));
+            y0 = int(floor(damage.y));
+            x1 = int(ceil(damage.z));
+            y1 = int(ceil(damage.w));
+            partial = true;
+        }
+    }
+
+    // When the prior image is whole but the view has panned, scroll it.
+    const bool scrolled = use_pan_cache &&
+                          software_window_valid && software_window_view_changed &&
+                          !software_window_damaged &&
+                          swScroll(renderer, scene_to_window);
+
+    if (!scrolled && !(partial && redrawSurfaceRect(renderer, scene, view, scene_to_window,
+                                                    clear_color.rgb, x0, y0, x1, y1))) {
+        renderer->beginDraw();
+        renderer->clear(clear_color.rgb);
+        renderer->setView(view);
+        renderer->drawScene(scene, scene_to_window, window, cull_to_view);
+        renderer->endDraw();
+    }
 
     software_window_valid = true;
+    software_window_damaged = false;
+    software_window_view_changed = false;
+    software_window_transform = scene_to_window;
 }
 
 void swPresent(BlitRendererPtr blit_renderer)
@@ -2527,7 +2705,7 @@ void swPresent(BlitRendererPtr blit_renderer)
 
 static void swDisplay()
 {
-    if (!software_window_valid) {
+    if (!software_window_valid || software_window_damaged || software_window_view_changed) {
         swRender(blit_renderer);
     }
 
@@ -2598,6 +2776,7 @@ void swInit(int width, int height, BlitRendererPtr blit_renderer)
         const char *title = blit_renderer->getWindowTitle();
         glutSetWindowTitle(title);
         blit_renderer->configureSurface(width, height);
+        blit_renderer->setTileThreads(tile_threads);
     }
 }
 
@@ -2843,6 +3022,9 @@ static void benchmarkIdle()
             if (load_svg) {
                 
                 setSVGScene(benchmarkFiles[extended_benchmark_file]);
+                if (loader_pool && extended_benchmark_file+1 < numBenchmarkFiles) {
+                    loader_pool->prefetch(vector<string>(1, benchmarkFiles[extended_benchmark_file+1]));
+                }
                 have_dlist = false;
                 software_window_valid = false;
                 load_svg = false;
@@ -2968,24 +3150,28 @@ static void benchmarkIdle()
 
 static void toggleGoldWindow();
 
-bool makeImageFilenameString(string &result, bool gold)
+// The file, path data or font drawn now; empty if the mode is bogus.
+static string currentSceneName()
 {
-    string filename;
-
     switch (draw_mode) {
     case DRAW_PATH_DATA:
-        filename = string("path_data/") + path_objects[current_path_object].name;
-        break;
+        return string("path_data/") + path_objects[current_path_object].name;
     case DRAW_SVG_FILE:
-        filename = getSVGFileName(current_svg_filename);
-        break;
+        return getSVGFileName(current_svg_filename);
 #if USE_FREETYPE2
     case DRAW_FREETYPE2_FONT:
-        filename = string("fonts/") + string(font_name(font_index));
-        break;
+        return string("fonts/") + string(font_name(font_index));
 #endif
     default:
         assert(!"bogus DrawMode");
+        return string();
+    }
+}
+
+bool makeImageFilenameString(string &result, bool gold)
+{
+    string filename = currentSceneName();
+    if (filename.empty()) {
         result = "bogus.tga";
         return false;
     }
@@ -3110,6 +3296,45 @@ void possiblyTerminateRegressScenes(const char *msg)
     }
 }
 
+static string jsonString(const string &s)
+{
+    string json = "\"";
+    for (size_t i=0; i<s.size(); i++) {
+        const unsigned char c = s[i];
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (c < 0x20) {
+            char buf[8];
+            sprintf(buf, "\\u%04x", c);
+            json += buf;
+        } else {
+            json += c;
+        }
+    }
+    return json + "\"";
+}
+
+// Writes one JSON object with the scene's verdict and difference metrics
+// to diff_json's line, so scripts can gate on thresholds.
+static void writeDiffJSON(RenderResultDifference::MatchType match,
+                          int different_pixels, int close_pixels,
+                          const RenderResultPtr a, const RenderResultPtr b)
+{
+    static const char *match_names[] = {
+        "inconsistent", "different", "approximately_same", "same"
+    };
+    ImageDiffMetrics metrics;
+    measureImages(&a->img[0].r, &b->img[0].r, a->width, a->height, metrics);
+    fprintf(diff_json, "{\"scene\": %s, \"compared_to\": \"%s\", "
+                       "\"width\": %d, \"height\": %d, \"match\": \"%s\", "
+                       "\"different_pixels\": %d, \"close_pixels\": %d, %s}\n",
+        jsonString(currentSceneName()).c_str(), compareTo ? "software" : "gold",
+        a->width, a->height, match_names[match],
+        different_pixels, close_pixels, imageDiffMetricsJSON(metrics).c_str());
+    fflush(diff_json);
+}
+
 void diffDisplay()
 {
     glClear(GL_COLOR_BUFFER_BIT);
@@ -3127,6 +3352,9 @@ void diffDisplay()
     int close_pixels = 0;
     RenderResultDifference::MatchType match = last_diff->compare(last_render, 
         diff_with, different_pixels, close_pixels);
+    if (diff_json && request_regress && match != RenderResultDifference::INCONSISTENT) {
+        writeDiffJSON(match, different_pixels, close_pixels, last_render, diff_with);
+    }
 
     if (last_render && last_gold) {
         last_diff->drawPixels();
@@ -3459,6 +3687,34 @@ static void benchmarkSoftwareRendering(float &raw_fps, BlitRendererPtr blit_rend
         printf("%s: seconds = %f, iterations = %d\n", blit_renderer->getWindowTitle(), seconds, iterations);
     }
 }
+
+// Reports how raw rendering speed with the renderer's tile threads,
+// doubling them from one up to one per processor, compares to untiled.
+static void benchmarkTileThreads(BlitRendererPtr blit_renderer)
+{
+    const int saved_threads = blit_renderer->getTileThreads();
+    if (!blit_renderer->setTileThreads(1)) {
+        return;  // draws untiled only
+    }
+    float untiled_fps;
+    blit_renderer->setTileThreads(0);
+    benchmarkSoftwareRendering(untiled_fps, blit_renderer);
+    printf("%s untiled: %.1f frames/second\n", blit_renderer->getName(), untiled_fps);
+
+    const int processors = TilePool::processors();
+    for (int threads = 1; ; threads = std::min(2*threads, processors)) {
+        float raw_fps;
+        blit_renderer->setTileThreads(threads);
+        benchmarkSoftwareRendering(raw_fps, blit_renderer);
+        printf("%s with %d tile thread%s: %.1f frames/second, %.2fx speed-up\n",
+            blit_renderer->getName(), threads, threads == 1 ? "" : "s",
+            raw_fps, raw_fps/untiled_fps);
+        if (threads >= processors) {
+            break;
+        }
+    }
+    blit_renderer->setTileThreads(saved_threads);
+}
 #endif
 
 static void benchmarkSoftwareRendering(float &drawing_fps, float &raw_fps, bool printResults)
@@ -3525,6 +3781,9 @@ static void benchmarkSoftwareRendering(float &drawing_fps, float &raw_fps, bool
     if (printResults) {
         printf("\nResult WITHOUT glDrawPixels: %.1f frames/second (%d iterations for %.2f sec)\n",
             raw_fps, iterations, seconds);
+#if USE_D2D || USE_CAIRO || USE_QT || USE_OPENVG || USE_SKIA
+        benchmarkTileThreads(blit_renderer);
+#endif
     }
 }
 
@@ -3643,6 +3902,19 @@ void idleExtendedBenchmarkSoftwareRendering()
     }
 }
 
+// Keeps the loader pool's workers busy with the files after ndx.
+static void prefetchAfterSVGFile(int ndx)
+{
+    if (loader_pool) {
+        vector<string> upcoming;
+        for (int i=0; i<2*loader_pool->getThreadCount(); i++) {
+            ndx = advanceSVGFile(ndx);
+            upcoming.push_back(getSVGFileName(ndx));
+        }
+        loader_pool->prefetch(upcoming);
+    }
+}
+
 void advanceScene()
 {
     current_svg_filename = advanceSVGFile(current_svg_filename);
@@ -3669,6 +3941,7 @@ void advanceScene()
         }
     }
     setSVGScene(getSVGFileName(current_svg_filename));
+    prefetchAfterSVGFile(current_svg_filename);
 }
 
 void startSceneRegressions()
@@ -3994,10 +4267,24 @@ static void keyboard(unsigned char c, int x, int y)
             PathStats total, max;
 
             ForEachShapeTraversal traversal;
-            scene->traverse(VisitorPtr(new StCVisitors::GatherStats(nvpr_renderer, total, max)), traversal);
+            shared_ptr<StCVisitors::GatherStats> gather(new StCVisitors::GatherStats(nvpr_renderer, total, max));
+            scene->traverse(gather, traversal);
             printf("  num_paths = %d\n", int(total.num_paths));
             printf("  num_cmds = %d\n", int(total.num_cmds));
             printf("  num_coords = %d\n", int(total.num_coords));
+            printf("  num_paints = %d unique of %d\n",
+                int(gather->getUniquePaints()), int(gather->getTotalPaints()));
+            printf("  num_path_styles = %d unique of %d\n",
+                int(gather->getUniquePathStyles()), int(gather->getTotalPathStyles()));
+
+            CountSegmentsPtr all_segments(new CountSegments),
+                             visible_segments(new CountSegments);
+            scene->traverse(all_segments);
+            CullingTraversal culling_traversal = glCullingTraversal(false);
+            scene->traverse(visible_segments, culling_traversal);
+            printf("  num_segments = %d (%d in view, %d nodes culled)\n",
+                all_segments->getCount(), visible_segments->getCount(),
+                culling_traversal.getCulledCount());
 
             printf("Window resolution: %dx%d pixels, %d samples/pixel\n",
                 gl_window_width, gl_window_height, nvpr_renderer->num_samples);
@@ -4429,6 +4716,31 @@ protected:
     ActiveControlPoint &hit;
 };
 
+// Only paths whose bounds (control points included) overlap the square
+// within closeness of the mouse need to be tested.
+static void findActiveControlPoint(ActiveControlPoint &hit)
+{
+    const float4x4 scene_to_mouse = hit.current_transform;
+    RectBounds pick = RectBounds(hit.mouse_xy - hit.closeness,
+                                 hit.mouse_xy + hit.closeness);
+    pick = pick.transform(inverse(scene_to_mouse));
+    if (pick.isValid()) {
+        vector<ShapeBVH::Hit> shapes;
+        getSceneBVH()->shapesIn(pick, shapes);
+        for (size_t i=0; i<shapes.size(); i++) {
+            hit.current_transform = mul(scene_to_mouse, shapes[i].matrix);
+            shapes[i].shape->getPath()->findNearerControlPoint(hit);
+        }
+        hit.current_transform = scene_to_mouse;
+    } else {
+        // Pick square doesn't map back to the scene; test every path.
+        ForEachShapeTraversal traversal;
+        scene->traverse(
+            VisitorPtr(new GetActiveControlPoint(hit)),
+            traversal);
+    }
+}
+
 ActiveWarpPoint active_warp_point;
 class GetActiveWarpPoint : public MatrixSaveVisitor
 {
@@ -4527,6 +4839,7 @@ mouse(int button, int state, int mouse_space_x, int mouse_space_y)
                     VisitorPtr(new GetActiveWarpPoint(active_warp_point)),
                     transform_traversal);
                 if (active_warp_point.transform) {
+                    getSceneBVH();  // so the warp's damage gets tracked
                     return;
                 }
             }
@@ -4565,10 +4878,8 @@ mouse(int button, int state, int mouse_space_x, int mouse_space_y)
                 active_control_point = ActiveControlPoint(mousespace_xy,
                                                           mul(clip_to_mouse, mul(surface_to_clip, view_to_surface)),
                                                           done_update_mask, 10);
-                ForEachShapeTraversal traversal;
-                scene->traverse(
-                    VisitorPtr(new GetActiveControlPoint(active_control_point)),
-                    traversal);
+                unshareSceneForEditing();
+                findActiveControlPoint(active_control_point);
                 if (active_control_point.path) {
                     printf("mouse point=%d (%d,%d)",
                         int(active_control_point.coord_index), mouse_space_x, mouse_space_y);
@@ -4647,14 +4958,14 @@ motion(int mouse_space_x, int mouse_space_y)
         float2 mousespace_xy = float2(mouse_space_x, mouse_space_y);
         active_control_point.set(mousespace_xy);
         have_dlist = false;
-        software_window_valid = false;
+        software_window_damaged = true;
         do_redisplay(active_control_point.update_mask);
     }
     if (active_warp_point.transform) {
         float2 mousespace_xy = float2(mouse_space_x, mouse_space_y);
         active_warp_point.set(mousespace_xy);
         have_dlist = false;
-        software_window_valid = false;
+        software_window_damaged = true;
         do_redisplay(active_warp_point.update_mask);
     }
     if (zooming || rotating) {
@@ -4725,7 +5036,6 @@ motion(int mouse_space_x, int mouse_space_y)
             std::cout << "view = " << view << std::endl;
         }
         updateTransform();
-        software_window_valid = false;
         do_redisplay(update_mask);
     }
 }
@@ -12,6 +12,7 @@
 #include "path.hpp"
 
 #include "scene_openvg.hpp"
+#include "showfps.h"  // for getElapsedTime
 
 #include <GL/glut.h>
 
@@ -34,7 +35,7 @@ struct VGPathCacheProcessor : PathSegmentProcessor {
     }
 
     void beginPath(PathPtr p) {
-        switch (p->style.fill_rule) {
+        switch (p->style->fill_rule) {
         case PathStyle::EVEN_ODD:
             fill_rule = VG_EVEN_ODD;
             break;
@@ -111,6 +112,7 @@ VGRenderer::VGRenderer()
     , eglcontext(0)
     , width(0)
     , height(0)
+    , offscreen(false)
 {
     static const EGLint config_attribs[] =
     {
@@ -119,7 +121,7 @@ VGRenderer::VGRenderer()
         EGL_BLUE_SIZE,      8,
         EGL_ALPHA_SIZE,     8,
         EGL_LUMINANCE_SIZE, EGL_DONT_CARE,          //EGL_DONT_CARE
-        EGL_SURFACE_TYPE,   EGL_WINDOW_BIT,
+        EGL_SURFACE_TYPE,   EGL_WINDOW_BIT | EGL_PBUFFER_BIT,
         EGL_NONE
     };
     EGLint numconfigs;
@@ -139,8 +141,6 @@ VGRenderer::VGRenderer()
 
 void VGRenderer::configureSurface(int w, int h)
 {
-    int glut_window_id = glutGetWindow();
-
 #if 0
     int winWidth = glutGet(GLUT_WINDOW_WIDTH),
         winHeight = glutGet(GLUT_WINDOW_HEIGHT);
@@ -152,7 +152,17 @@ void VGRenderer::configureSurface(int w, int h)
     width = w;
     height = h;
     
-    eglsurface = eglCreateWindowSurface(egldisplay, eglconfig, (void*)(size_t)glut_window_id, NULL);
+    if (offscreen) {
+        const EGLint pbuffer_attribs[] = {
+            EGL_WIDTH,  w,
+            EGL_HEIGHT, h,
+            EGL_NONE
+        };
+        eglsurface = eglCreatePbufferSurface(egldisplay, eglconfig, pbuffer_attribs);
+    } else {
+        int glut_window_id = glutGetWindow();
+        eglsurface = eglCreateWindowSurface(egldisplay, eglconfig, (void*)(size_t)glut_window_id, NULL);
+    }
     assert(eglGetError() == EGL_SUCCESS);
     eglcontext = eglCreateContext(egldisplay, eglconfig, NULL, NULL);
     assert(eglGetError() == EGL_SUCCESS);
@@ -185,7 +195,16 @@ void VGRenderer::beginDraw()
 {
     printf("OpenVG rendering...");
     fflush(stdout);
-    start_time = glutGet(GLUT_ELAPSED_TIME);
+    start_time = getElapsedTime();
+}
+
+bool VGRenderer::clipToRect(int x, int y, int width, int height)
+{
+    // vgClear honors scissoring too.
+    VGint rect[4] = { x, y, width, height };
+    vgSetiv(VG_SCISSOR_RECTS, 4, rect);
+    vgSeti(VG_SCISSORING, VG_TRUE);
+    return true;
 }
 
 void VGRenderer::clear(float3 clear_color)
@@ -231,24 +250,27 @@ VisitorPtr VGRenderer::makeVisitor()
 
 void VGRenderer::endDraw()
 {
-    float seconds = (glutGet(GLUT_ELAPSED_TIME) - start_time) / 1000.0;
+    vgSeti(VG_SCISSORING, VG_FALSE);
+    double seconds = getElapsedTime() - start_time;
     printf("done in %f seconds.\n", seconds);
 }
 
-void VGRenderer::copyImageToWindow()
+bool VGRenderer::readPixels(unsigned char *rgba)
 {
-    glWindowPos2f(0,0);
-    try {
-        unsigned int* tmp = new unsigned int[width*height]; //throws bad_alloc
-        //NOTE: we assume here that the display is always sRGBA
-        vgReadPixels(tmp, width*sizeof(unsigned int), VG_sRGBA_8888, 0, 0, width, height);
-        glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, tmp);
-        delete [] tmp;
-    }
-    catch(std::bad_alloc)
-    {
-        assert(!"copyImageToGL tmp buffer allocation failed");
+    vector<unsigned int> tmp(width*height);
+    // Unpremultiplied, red in the most significant byte; rows go bottom to top.
+    vgReadPixels(&tmp[0], width*sizeof(unsigned int), VG_sRGBA_8888, 0, 0, width, height);
+    for (int y=0; y<height; y++) {
+        const unsigned int *row = &tmp[(height-1-y)*width];
+        for (int x=0; x<width; x++, rgba+=4) {
+            const unsigned int p = row[x];
+            rgba[0] = (unsigned char) (p>>24);
+            rgba[1] = (unsigned char) (p>>16);
+            rgba[2] = (unsigned char) (p>>8);
+            rgba[3] = (unsigned char) p;
+        }
     }
+    return true;
 }
 
 const char *VGRenderer::getWindowTitle()
@@ -545,7 +567,7 @@ void VGShapeRendererState::draw()
     extern bool doFilling, doStroking;
     PathPtr p = owner->getPath();
     VGPath path = path_state->path;
-    if (p->style.do_fill && doFilling) {
+    if (p->style->do_fill && doFilling) {
         // configure filling
         VGPathRendererStatePtr prs = getPathRendererState();
         vgSeti(VG_FILL_RULE, prs->fill_rule);
@@ -556,17 +578,17 @@ void VGShapeRendererState::draw()
             assert(!"not really right");
             vgLoadMatrix(fill_transform);
         }
-        if (p->style.do_stroke && doStroking) {
+        if (p->style->do_stroke && doStroking) {
             // configure stroking too
-            setStrokeParameters(p->style);
+            setStrokeParameters(*p->style);
             vgSetPaint(stroke_paint, VG_STROKE_PATH);
             paint_modes |= VG_STROKE_PATH;
         }
         vgDrawPath(path, paint_modes);
     } else {
-        if (p->style.do_stroke && doStroking) {
+        if (p->style->do_stroke && doStroking) {
             // just stroke
-            setStrokeParameters(p->style);
+            setStrokeParameters(*p->style);
             vgSetPaint(stroke_paint, VG_STROKE_PATH);
             vgDrawPath(path, VG_STROKE_PATH);
         }
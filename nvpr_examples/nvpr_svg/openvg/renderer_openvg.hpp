@@ -32,19 +32,26 @@ struct VGRenderer : GLBlitRenderer {
     EGLSurface eglsurface;
     EGLContext eglcontext;
     int width, height;
-    int start_time;
+    double start_time;
+    bool offscreen;  // render to a pbuffer rather than the GLUT window
 
     VGRenderer();
 
+    void setOffscreen(bool offscreen_) {
+        offscreen = offscreen_;
+    }
+
     void configureSurface(int width, int height);
     void shutdown();
 
     void beginDraw();
+    bool clipToRect(int x, int y, int width, int height);
     void clear(float3 clear_color);
     void setView(float4x4 view);
     VisitorPtr makeVisitor();
     void endDraw();
     void copyImageToWindow();
+    bool readPixels(unsigned char *rgba);
     const char *getWindowTitle();
     const char *getName();
 
@@ -0,0 +1,34 @@
+/* renderer_openvg_gl.cpp - show the OpenVG surface in the GL window */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+// Kept apart from renderer_openvg.cpp so programs without a GL window,
+// like svg_render, link the OpenVG renderer without OpenGL.
+
+#include "nvpr_svg_config.h"  // configure path renderers to use
+
+#if USE_OPENVG
+
+#include <assert.h>
+
+#include <new>
+
+#include "renderer_openvg.hpp"
+
+void VGRenderer::copyImageToWindow()
+{
+    glWindowPos2f(0,0);
+    try {
+        unsigned int* tmp = new unsigned int[width*height]; //throws bad_alloc
+        //NOTE: we assume here that the display is always sRGBA
+        vgReadPixels(tmp, width*sizeof(unsigned int), VG_sRGBA_8888, 0, 0, width, height);
+        glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, tmp);
+        delete [] tmp;
+    }
+    catch(std::bad_alloc)
+    {
+        assert(!"copyImageToGL tmp buffer allocation failed");
+    }
+}
+
+#endif // USE_OPENVG
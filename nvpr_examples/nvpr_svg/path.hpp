@@ -47,6 +47,7 @@ using boost::lexical_cast;
 
 #include "path_stats.hpp"
 #include "path_process.hpp"
+#include "cached_bounds.hpp"
 
 #if defined(_MSC_VER)
 # pragma warning(disable: 4355) /* 'this' : used in base member initializer list */
@@ -76,22 +77,32 @@ typedef shared_ptr<struct Node> NodePtr;
 #include "ActiveControlPoint.hpp"
 #include "PathStyle.hpp"
 
+// Path styles are immutable once made so loaders can share equal ones
+// between paths (see SceneInterner).
+typedef shared_ptr<const PathStyle> PathStylePtr;
+
 typedef shared_ptr<RendererState<Path> > PathRendererStatePtr;
 
-struct Path : enable_shared_from_this<Path>, HasRendererState<Path> {
+struct Path : enable_shared_from_this<Path>, HasRendererState<Path>, CachedBounds {
 private:
     bool has_logical_bbox;
     float4 logical_bbox;
 
+    // Lazily built by getCanonicalPath, discarded by invalidate.
+    bool has_canonical_path;
+    CanonicalPath canonical_path;
+
 public:
     // Path data
     vector<char> cmd;
     vector<float> coord;
 
-    PathStyle style;
+    // Never NULL; replace rather than modify it.
+    PathStylePtr style;
 
     Path(const PathStyle &style, const char *string);
     Path(const PathStyle &style, const vector<char> &cmds, const vector<float> &coords);
+    Path(PathStylePtr style, const vector<char> &cmds, const vector<float> &coords);
     Path(const char *string);
     Path(const vector<char> &cmds, const vector<float> &coords);
 
@@ -108,6 +119,9 @@ public:
             this->has_logical_bbox = src.has_logical_bbox;
             this->logical_bbox = src.logical_bbox;
 
+            this->has_canonical_path = false;
+            this->canonical_path = CanonicalPath();
+
             // Empty the renderer_state array
             this->renderer_states = vector<RendererStatePtr>();
         }
@@ -116,10 +130,10 @@ public:
 
     bool isEmpty();
     bool isFillable() {
-        return style.do_fill;
+        return style->do_fill;
     }
     bool isStrokable() {
-        return style.do_stroke;
+        return style->do_stroke;
     }
 
     string convert_to_svg_path(const float4x4 &transform);
@@ -139,7 +153,8 @@ public:
 
     float4 getActualFillBounds();   // computes bounding box for filled region of path
     float4 getDilatedFillBounds();  // dilates actual fill bounds by stroke width, if stroking
-    float4 getBounds();             // substitute logical bounds, if specified, for dilated fill bounds
+    // getBounds() (from CachedBounds) substitutes logical bounds, if specified, for dilated fill bounds;
+    // getInkBounds() dilates those further to cover miter joins
     void gatherStats(PathStats &stats);
 
     void setLogicalBounds(const float4 &bbox);
@@ -147,13 +162,72 @@ public:
 
     // Iterate over all the path's segments, determining the
     // segment data, and calling the appropriate segment processor
-    // virtual function for the segment type (moveto, lineto, etc.).
+    // method for the segment type (moveto, lineto, etc.).
+    // Processor is any type with PathSegmentProcessor's method names;
+    // calls are statically dispatched so they can be inlined.
+    template <typename Processor>
+    void processSegments(Processor &processor);
+    // Virtual dispatch version, for processors only known through
+    // the PathSegmentProcessor interface.
     void processSegments(PathSegmentProcessor &processor);
 
+    // Absolute, reflection-free form of cmd and coord; rebuilt on
+    // demand after invalidate() so call invalidate() after modifying
+    // cmd or coord.
+    const CanonicalPath &getCanonicalPath();
+    // Installs (by swapping) a canonical form previously built from the
+    // current cmd and coord, as when loading a scene cache.
+    void setCanonicalPath(CanonicalPath &canonical);
+
+protected:
+    float4 computeBounds();
+    float4 computeInkBounds(const float4 &bounds);
+
 private:
     void validate();
     void fillValidate();
     void strokeValidate();
 } ;
 
+template <typename Processor>
+void Path::processSegments(Processor &processor)
+{
+    const CanonicalPath &canonical = getCanonicalPath();
+    const size_t n = canonical.segment.size();
+    const float2 *plist = &canonical.point[0];  // current point, then new points
+    size_t arc_ndx = 0;
+
+    processor.beginPath(shared_from_this());
+    for (size_t i=0; i<n; i++) {
+        const CanonicalPath::Segment &s = canonical.segment[i];
+        switch (s.type) {
+        case 'M':
+            processor.moveTo(plist, s.coord_index, s.cmd);
+            break;
+        case 'L':
+            // Lines closing a subpath are reported as an 'L' command.
+            processor.lineTo(plist, s.coord_index, s.cmd == 'Z' ? 'L' : s.cmd);
+            break;
+        case 'Q':
+            processor.quadraticCurveTo(plist, s.coord_index, s.cmd);
+            break;
+        case 'C':
+            processor.cubicCurveTo(plist, s.coord_index, s.cmd);
+            break;
+        case 'A':
+            processor.arcTo(canonical.arc(plist, arc_ndx), s.coord_index, s.cmd);
+            arc_ndx++;
+            break;
+        case 'Z':
+            processor.close(s.cmd);
+            break;
+        default:
+            assert(!"bad segment type");
+            break;
+        }
+        plist += CanonicalPath::pointCount(s.type);
+    }
+    processor.endPath(shared_from_this());
+}
+
 #endif // __path_hpp__
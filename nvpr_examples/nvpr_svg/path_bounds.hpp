@@ -0,0 +1,311 @@
+/* path_bounds.hpp - segment processor computing a path's exact bounds */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __path_bounds_hpp__
+#define __path_bounds_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#define _USE_MATH_DEFINES  // so <math.h> has M_PI
+#include <math.h>
+#include <float.h>
+
+#include "path.hpp"
+
+#include <Cg/max.hpp>
+#include <Cg/min.hpp>
+#include <Cg/sqrt.hpp>
+
+// Grumble, Microsoft (and probably others) define these as macros
+#undef min
+#undef max
+
+// Statically dispatched processor for Path::processSegments; it's in a
+// header so Path::getActualFillBounds and -benchmarkSegments both inline it.
+// Solve the quadratic equation in form x^2 + b*x + c = 0
+template <typename REAL>
+inline int quadratic(REAL b, REAL c, REAL rts[2])
+{
+   int solutions = 0;
+   rts[0] = 0;
+   rts[1] = 0;
+
+   REAL discriminant = b*b - 4*c;
+   if (b == 0) {
+      if (c == 0) {
+         solutions = 2;
+      } else {
+         if (c < 0) {
+            solutions = 2;
+            rts[0] = sqrt(-c);
+            rts[1] = -rts[0];
+         } else {
+            solutions = 0;
+         }         
+      }
+   } else if (c == 0) {
+      solutions = 2;
+      rts[0] = -b;
+   } else if (discriminant >= 0) {
+      solutions = 2 ;
+      REAL discriminant_sqrt = sqrt(discriminant);
+      if (b > 0) {
+         rts[0] = (-b - discriminant_sqrt)*(1/REAL(2));
+      } else {
+         rts[0] = (-b + discriminant_sqrt)*(1/REAL(2));
+      }
+      if (rts[0] == 0) {
+         rts[1] = -b;
+      } else {
+         rts[1] = c/rts[0];
+      }
+   }
+   return solutions;
+}
+
+struct GetBoundsPathSegmentProcessor {
+    float4 bbox;
+
+    GetBoundsPathSegmentProcessor()
+        : bbox(FLT_MAX,FLT_MAX,-FLT_MAX,-FLT_MAX)
+    {}
+
+    void addPointToBounds(const float2 &p) {
+        bbox.xy = min(bbox.xy, p);
+        bbox.zw = max(bbox.zw, p);
+    }
+    void addXToBounds(const float x) {
+        bbox.x = min(bbox.x, x);
+        bbox.z = max(bbox.z, x);
+    }
+    void addYToBounds(const float y) {
+        bbox.y = min(bbox.y, y);
+        bbox.w = max(bbox.w, y);
+    }
+    void addComponentToBounds(int c, const float v) {
+        bbox[c+0] = min(bbox[c+0], v);
+        bbox[c+2] = max(bbox[c+2], v);
+    }
+
+    void beginPath(PathPtr p) { 
+    }
+    void moveTo(const float2 plist[2], size_t coord_index, char cmd) {
+    }
+    void lineTo(const float2 plist[2], size_t coord_index, char cmd) {
+        addPointToBounds(plist[0]);
+        addPointToBounds(plist[1]);
+    }
+    void quadraticCurveTo(const float2 plist[3], size_t coord_index, char cmd) {
+        const double2 P0 = double2(plist[0]),
+                      P1 = double2(plist[1]),
+                      P2 = double2(plist[2]);
+
+        // Quadratic Bezier parametric equation:
+        // > Qeq:=P0*(1-t)^2+2*P1*(1-t)*t+P2*t^2;
+        // One-half derivative of quadratic bezier parametric equation:
+        // > Qteq:=diff(Qeq/2,t);
+        //   Qteq:=-P0*(1-t)-P1*t+P1*(1-t)+P2*t
+        // Collect coefficients of t terms:
+        // > collect(Qteq/2,t);
+        //   (P0-2*P1+P2)*t-P0+P1
+        double2 a = P0 - 2 * P1 + P2,
+                b = P1 - P0;
+
+        // For X (j=0) and Y (j=1) components...
+        for (int j=0; j<2; j++) {
+            if (a[j] == 0) {
+                // Constant equation.  End-points will suffice as bounds.
+            } else {
+                // Linear equation.
+                double t = -b[j]/a[j];
+                // Is t in parametric [0,1] range of the segment?
+                if (t > 0 && t < 1) {
+                    double v = (a[j]*t+2*b[j])*t+P0[j];
+                    addComponentToBounds(j, float(v));
+                }
+            }
+        }
+
+        addPointToBounds(plist[0]);
+        addPointToBounds(plist[2]);
+    }
+    void cubicCurveTo(const float2 plist[4], size_t coord_index, char cmd)
+    {
+        // Cubic bezier segment control points:
+        const double2 P0 = double2(plist[0]),
+                      P1 = double2(plist[1]),
+                      P2 = double2(plist[2]),
+                      P3 = double2(plist[3]);
+
+        // Cubic Bezier parametric equation:
+        // > Ceq:=P0*(1-t)^3+3*P1*(1-t)^2*t+3*P2*t^2*(1-t)+P3*t^3;
+        // One-third derivative of cubic bezier parametric equation:
+        // > Cteq:=diff(Ceq/3,t);
+        //   Cteq := -P0*(1-t)^2-2*P1*(1-t)*t+P1*(1-t)^2+2*P2*t*(1-t)-P2*t^2+P3*t^2
+        // Collect coefficients of t terms:
+        // > collect(Cteq/3,t);
+        //   (P3-3*P2+3*P1-P0)*t^2+(-4*P1+2*P2+2*P0)*t+P1-P0
+        const double2 a = P3 - 3*P2 + 3*P1 - P0,
+                      b = 2*P2 - 4*P1 + 2*P0,
+                      c = P1 - P0;
+
+        // For X (j=0) and Y (j=1) components...
+        for (int j=0; j<2; j++) {
+            // Solve for "t=0" for Cteq
+            if (a[j] == 0) {
+                // Not quadratic.
+                if (b[j] == 0) {
+                    // Constant equation.  End-points will suffice as bounds.
+                } else {
+                    // Is linear equation.
+                    const double t = -c[j]/b[j];
+                    // Is t in parametric [0,1] range of the segment?
+                    if (t > 0 && t < 1) {
+                        // Form original cubic equation in Horner form and evaluate:
+                        const double v = P0[j]+(-3*P0[j]+3*P1[j]+(3*P0[j]+3*P2[j]-6*P1[j]+(3*P1[j]-P0[j]-3*P2[j]+P3[j])*t)*t)*t;
+                        addComponentToBounds(j, float(v));
+                    }
+                }
+            } else {
+                // Need the quadratic equation.
+                double t_array[2];
+                const int solutions = quadratic(b[j]/a[j], c[j]/a[j], t_array);
+                // For each quadratic equation solution...
+                for (int i=0; i<solutions; i++) {
+                    const double t = t_array[i];
+                    // Is t in parametric [0,1] range of the segment?
+                    if (t > 0 && t < 1) {
+                        // Form original cubic equation in Horner form and evaluate:
+                        const double v = P0[j]+(-3*P0[j]+3*P1[j]+(3*P0[j]+3*P2[j]-6*P1[j]+(3*P1[j]-P0[j]-3*P2[j]+P3[j])*t)*t)*t;
+                        addComponentToBounds(j, float(v));
+                    }
+                }
+            }
+        }
+
+        // Add initial and terminal points of cubic Bezier segment.
+        addPointToBounds(plist[0]);
+        addPointToBounds(plist[3]);
+    }
+    inline double wrapAngle(double theta) {
+        if (::isfinite(theta) && fabs(theta) < 4 * 2*M_PI) {
+            // XXX fmod is slow, but it may already to this optimization
+            // we may want to do a perf test and see if this is worth it ...
+            while (theta >= 2*M_PI) {
+                theta -= 2*M_PI;
+            }
+            while (theta < 0) {
+                theta += 2*M_PI;
+            }
+        } else {
+            theta = fmod(theta, 2*M_PI);
+        }
+
+        return theta;
+    }
+    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
+        // Convert to a center point arc to be able to render the arc center.
+        CenterPointArc center_point_arc(arc);
+
+        // Add the arc's two end points to the bounding box.
+        addPointToBounds(arc.p[0]);
+        addPointToBounds(arc.p[1]);
+
+        if (center_point_arc.form == CenterPointArc::BEHAVED) {
+            double tan_psi = tan(center_point_arc.psi),
+                   rx = center_point_arc.radii.x,
+                   ry = center_point_arc.radii.y,
+                   theta1 = wrapAngle(center_point_arc.theta1),
+                   theta2 = wrapAngle(theta1 + center_point_arc.delta_theta);
+
+            if (center_point_arc.delta_theta < 0) {
+                double tmp = theta1;
+                theta1 = theta2;
+                theta2 = tmp;
+            }
+
+            // Use the partial elliptical arc segment center point parametric form...
+            //
+            // Solve for where gradient is zero in the interval [theta1,theta2].
+            //
+            // Ax:=cos(phi)*rx*cos(theta) - sin(phi)*ry*sin(theta) + cx;
+            // diff(Ax,theta);
+            //   -cos(phi)*rx*sin(theta)-sin(phi)*ry*cos(theta)
+            // Ay:=sin(phi)*rx*cos(theta) + cos(phi)*ry*sin(theta) + cy;
+            // diff(Ay,theta);
+            //   -sin(phi)*rx*sin(theta)+cos(phi)*ry*cos(theta)
+            // solve(diff(Ax,theta)=0,theta);
+            //   -arctan(tan(phi)*ry/rx)
+            // solve(diff(Ay,theta)=0,theta);
+            //   arctan(ry/(tan(phi)*rx))
+            double theta_x = wrapAngle(-atan2(tan_psi*ry, rx)),
+                   theta_y = wrapAngle(atan2(ry, tan_psi*rx));
+
+            // Here we have two scenarios: theta1 < theta2, and theta1 > theta2 
+            // (if they're equal the ellipse is degenerate). Conceptually, an angle is
+            // within the partial arc if it falls within the set of angles passed over by
+            // moving from theta1 to theta2 in the direction of positive angles.
+
+            // This can be accoomplish by saying
+            // if (theta1 > theta2)
+            //    on_path = theta1 <= angle <= theta2
+            // else
+            //    on_path = angle >= theta1 && angle <= theta2
+
+            // If we swap theta1 and theta2 when theta2 > theta1, then a simple
+            // if ((theta1 < theta_x && theta_x < theta2) == not_swapped)
+            // can also do the job because there's no need to worry about </<= boundaries -
+            // we already called addPointToBounds() before for the points at theta1 and theta2
+
+            bool not_swapped = true;
+            if (theta1 > theta2) {
+                not_swapped = false;
+                double tmp = theta1;
+                theta1 = theta2;
+                theta2 = tmp;
+            }
+
+            // Is theta_x in [theta1,theta2] range?
+            if ((theta1 < theta_x && theta_x < theta2) == not_swapped) {
+                float2 v = center_point_arc.eval(theta_x);
+                addXToBounds(v.x);
+            }
+            // Is theta_y in [theta1,theta2] range?
+            if ((theta1 < theta_y && theta_y < theta2) == not_swapped) {
+                float2 v = center_point_arc.eval(theta_y);
+                addYToBounds(v.y);
+            }
+            theta_x = wrapAngle(theta_x + M_PI);
+            theta_y = wrapAngle(theta_y + M_PI);
+            // Is theta_x in [theta1,theta2] range?
+            if ((theta1 < theta_x && theta_x < theta2) == not_swapped) {
+                float2 v = center_point_arc.eval(theta_x);
+                addXToBounds(v.x);
+            }
+            // Is theta_y in [theta1,theta2] range?
+            if ((theta1 < theta_y && theta_y < theta2) == not_swapped) {
+                float2 v = center_point_arc.eval(theta_y);
+                addYToBounds(v.y);
+            }
+        } else {
+            // In degenerate cases, end points are enough.
+            switch (center_point_arc.form) {
+            case CenterPointArc::DEGENERATE_LINE:
+            case CenterPointArc::DEGENERATE_POINT:
+                // Do nothing.
+                break;
+            default:
+                assert(!"bogus CenterPointArc form");
+                break;
+            }
+        }
+    }
+    void close(char cmd) {
+    }
+    void endPath(PathPtr p) {}
+};
+
+#endif // __path_bounds_hpp__
@@ -16,6 +16,7 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <string.h>
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
 
@@ -1403,6 +1404,469 @@ public:
 };
 
 
+// Whitespace-skipping uses SSE2 to scan long runs of whitespace 16 characters at a time.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define FAST_SVG_PATH_SSE2 1
+# include <emmintrin.h>
+#else
+# define FAST_SVG_PATH_SSE2 0
+#endif
+
+// Fast parser for the SVG 1.1 path grammar.
+//
+// FastSVGPathParser accepts a subset of the strings SVGPathParser accepts
+// and, for every string it accepts, produces bit-identical cmd and coord
+// arrays.  Strings it rejects are handed to SVGPathParser so malformed
+// paths still get the same result and the same error report.
+//
+// Rather than back-tracking character-by-character, it scans the string
+// twice: the first pass just counts commands and coordinates so the
+// output arrays get sized exactly once; the second pass converts the
+// numbers and writes them straight into the arrays.  Numbers are converted
+// with exactly the same double-precision arithmetic SVGPathParser uses
+// (not strtod, so the C locale doesn't matter).
+class FastSVGPathParser {
+    const char *const input;
+    const char *const end;  // *end is the string's null terminator
+    char *cmd_out;
+    float *coord_out;
+    size_t num_cmds, num_coords;
+
+    //wsp:
+    //    (#x20 | #x9 | #xD | #xA)
+    static inline bool isWsp(char c) {
+        return c == 0x20 || c == 0x9 || c == 0xD || c == 0xA;
+    }
+    static inline bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+    // Can the character begin a number (or an arc flag)?
+    static inline bool isNumberStart(char c) {
+        return isDigit(c) || c == '.' || c == '-' || c == '+';
+    }
+
+#if FAST_SVG_PATH_SSE2
+    static inline int countTrailingZeros(unsigned int mask) {
+        assert(mask != 0);
+# ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return int(index);
+# else
+        return __builtin_ctz(mask);
+# endif
+    }
+#endif
+
+    // wsp*
+    inline const char *skipWsp(const char *s) const {
+        // Most separators are zero or one characters so test the first character before vectorizing.
+        if (!isWsp(*s)) {
+            return s;
+        }
+        s++;
+#if FAST_SVG_PATH_SSE2
+        const __m128i space = _mm_set1_epi8(0x20),
+                      tab = _mm_set1_epi8(0x9),
+                      cr = _mm_set1_epi8(0xD),
+                      lf = _mm_set1_epi8(0xA);
+        while (end - s >= 16) {
+            const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+            const __m128i wsp = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, space),
+                                                          _mm_cmpeq_epi8(chars, tab)),
+                                             _mm_or_si128(_mm_cmpeq_epi8(chars, cr),
+                                                          _mm_cmpeq_epi8(chars, lf)));
+            const unsigned int not_wsp_mask = ~unsigned(_mm_movemask_epi8(wsp)) & 0xFFFF;
+            if (not_wsp_mask) {
+                return s + countTrailingZeros(not_wsp_mask);
+            }
+            s += 16;
+        }
+#endif
+        while (isWsp(*s)) {
+            s++;
+        }
+        return s;
+    }
+
+    // comma-wsp?
+    //     (wsp+ comma? wsp*) | (comma wsp*)
+    // which is the same as wsp* comma? wsp*
+    inline const char *skipCommaWsp(const char *s, bool &saw_comma) const {
+        s = skipWsp(s);
+        saw_comma = (*s == ',');
+        if (saw_comma) {
+            s = skipWsp(s+1);
+        }
+        return s;
+    }
+
+    // Powers of ten through 10^22 are exact doubles so these match pow(10,n) bit-for-bit.
+    static inline double powerOfTen(int n) {
+        static const double exact[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+            1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+            1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        if (n >= 0 && n < int(countof(exact))) {
+            return exact[n];
+        }
+        return pow(10.0, n);
+    }
+    static inline double powerOfTen(double n) {
+        if (n >= 0 && n <= 22) {
+            return powerOfTen(int(n));
+        }
+        return pow(10, n);
+    }
+
+    // number:
+    //     sign? integer-constant
+    //     | sign? floating-point-constant
+    // or, when signed is false,
+    // nonnegative-number:
+    //     integer-constant
+    //     | floating-point-constant
+    //
+    // Mirrors the arithmetic of SVGPathParser::number and its helpers exactly.
+    template <bool STORE>
+    inline bool number(const char *&s, bool is_signed, float &result) const {
+        const char *p = s;
+        bool negative = false;
+        if (is_signed) {
+            if (*p == '-') {
+                negative = true;
+                p++;
+            } else if (*p == '+') {
+                p++;
+            }
+        }
+        double value = 0;
+        bool has_integer_digits = isDigit(*p);
+        if (has_integer_digits) {
+            if (STORE) {
+                // Accumulating a digit-sequence in doubles is exact until the value
+                // exceeds 2^53 so the first 15 digits can accumulate as an integer.
+                unsigned long long integer = 0;
+                for (int digits = 0; digits < 15 && isDigit(*p); digits++) {
+                    integer = integer*10 + (*p++ - '0');
+                }
+                value = double(integer);
+                while (isDigit(*p)) {
+                    value *= 10;
+                    value += *p++ - '0';
+                }
+            } else {
+                while (isDigit(*p)) {
+                    p++;
+                }
+            }
+        }
+        if (*p == '.') {
+            if (isDigit(p[1])) {
+                p++;
+                if (!STORE) {
+                    while (isDigit(*p)) {
+                        p++;
+                    }
+                } else {
+                    // Use this when the digit-sequence is for a fractional value...
+                    int digit_value = *p++ - '0';
+                    int digits = 1, effective_digits = 1;
+                    unsigned long long integer_fraction = digit_value,
+                                       integer_effective_fraction = integer_fraction;
+                    while (digits < 15 && isDigit(*p)) {
+                        digit_value = *p++ - '0';
+                        integer_fraction = integer_fraction*10 + digit_value;
+                        digits++;
+                        if (digit_value > 0) {
+                            // To ignore trailing zeros.
+                            effective_digits = digits;
+                            integer_effective_fraction = integer_fraction;
+                        }
+                    }
+                    double fraction = double(integer_fraction),
+                           effective_fraction = double(integer_effective_fraction);
+                    while (isDigit(*p)) {
+                        digit_value = *p++ - '0';
+                        fraction *= 10;
+                        fraction += digit_value;
+                        digits++;
+                        if (digit_value > 0) {
+                            effective_digits = digits;
+                            effective_fraction = fraction;
+                        }
+                    }
+                    value += effective_fraction/powerOfTen(effective_digits);
+                }
+            } else if (has_integer_digits) {
+                p++;  // digit-sequence "."
+            } else {
+                return false;
+            }
+        } else if (!has_integer_digits) {
+            return false;
+        }
+        // exponent:
+        //     ( "e" | "E" ) sign? digit-sequence
+        if (*p == 'e' || *p == 'E') {
+            const char *q = p+1;
+            int exponent_sign = 1;
+            if (*q == '-') {
+                exponent_sign = -1;
+                q++;
+            } else if (*q == '+') {
+                q++;
+            }
+            if (isDigit(*q)) {
+                double exponent_value = *q++ - '0';
+                while (isDigit(*q)) {
+                    exponent_value *= 10;
+                    exponent_value += *q++ - '0';
+                }
+                if (STORE) {
+                    exponent_value *= exponent_sign;
+                    value *= powerOfTen(exponent_value);
+                }
+                p = q;
+            }
+        }
+        if (STORE) {
+            result = float(negative ? -value : value);
+        }
+        s = p;
+        return true;
+    }
+
+    // flag:
+    //     "0" | "1"
+    static inline bool flag(const char *&s, float &result) {
+        if (*s == '0' || *s == '1') {
+            result = float(*s++ - '0');
+            return true;
+        }
+        return false;
+    }
+
+    // elliptical-arc-argument:
+    //     nonnegative-number comma-wsp? nonnegative-number comma-wsp?
+    //         number comma-wsp flag comma-wsp? flag comma-wsp? coordinate-pair
+    template <bool STORE>
+    inline bool ellipticalArcArgument(const char *&s, float v[7]) const {
+        bool saw_comma;
+        if (!number<STORE>(s, false, v[0])) {
+            return false;
+        }
+        s = skipCommaWsp(s, saw_comma);
+        if (!number<STORE>(s, false, v[1])) {
+            return false;
+        }
+        s = skipCommaWsp(s, saw_comma);
+        if (!number<STORE>(s, true, v[2])) {
+            return false;
+        }
+        s = skipCommaWsp(s, saw_comma);
+        if (!flag(s, v[3])) {
+            return false;
+        }
+        s = skipCommaWsp(s, saw_comma);
+        if (!flag(s, v[4])) {
+            return false;
+        }
+        s = skipCommaWsp(s, saw_comma);
+        if (!number<STORE>(s, true, v[5])) {
+            return false;
+        }
+        s = skipCommaWsp(s, saw_comma);
+        return number<STORE>(s, true, v[6]);
+    }
+
+    // <count> numbers, each optionally separated by comma-wsp.
+    template <bool STORE>
+    inline bool numberArguments(const char *&s, int count, float v[6]) const {
+        bool saw_comma;
+        if (!number<STORE>(s, true, v[0])) {
+            return false;
+        }
+        for (int i=1; i<count; i++) {
+            s = skipCommaWsp(s, saw_comma);
+            if (!number<STORE>(s, true, v[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Parse one argument for the command (a coordinate pair for lineto, six
+    // numbers for curveto, etc.) and emit the command with its coordinates.
+    template <bool STORE>
+    inline bool argument(const char *&s, char c) {
+        float v[7];
+        int count;
+        bool ok;
+        switch (c) {
+        case 'H':
+        case 'h':
+        case 'V':
+        case 'v':
+            count = 1;
+            ok = numberArguments<STORE>(s, count, v);
+            break;
+        case 'M':
+        case 'm':
+        case 'L':
+        case 'l':
+        case 'T':
+        case 't':
+            count = 2;
+            ok = numberArguments<STORE>(s, count, v);
+            break;
+        case 'Q':
+        case 'q':
+        case 'S':
+        case 's':
+            count = 4;
+            ok = numberArguments<STORE>(s, count, v);
+            break;
+        case 'C':
+        case 'c':
+            count = 6;
+            ok = numberArguments<STORE>(s, count, v);
+            break;
+        case 'A':
+        case 'a':
+            count = 7;
+            ok = ellipticalArcArgument<STORE>(s, v);
+            break;
+        default:
+            assert(!"unexpected command");
+            return false;
+        }
+        if (!ok) {
+            return false;
+        }
+        if (STORE) {
+            *cmd_out++ = c;
+            for (int i=0; i<count; i++) {
+                *coord_out++ = v[i];
+            }
+        }
+        num_cmds++;
+        num_coords += count;
+        return true;
+    }
+
+    // svg-path:
+    //     wsp* moveto-drawto-command-groups? wsp*
+    template <bool STORE>
+    bool svgPath() {
+        num_cmds = 0;
+        num_coords = 0;
+        const char *s = skipWsp(input);
+        // The first command must be a moveto.
+        if (s != end && *s != 'M' && *s != 'm') {
+            return false;
+        }
+        while (s != end) {
+            char c = *s++;
+            switch (c) {
+            case 'Z':
+            case 'z':
+                // closepath:
+                //     ("Z" | "z")
+                if (STORE) {
+                    *cmd_out++ = c;
+                }
+                num_cmds++;
+                s = skipWsp(s);
+                continue;
+            case 'M': case 'm':
+            case 'L': case 'l':
+            case 'H': case 'h':
+            case 'V': case 'v':
+            case 'C': case 'c':
+            case 'S': case 's':
+            case 'Q': case 'q':
+            case 'T': case 't':
+            case 'A': case 'a':
+                break;
+            default:  // unrecognized command (or a number without a command)
+                return false;
+            }
+            s = skipWsp(s);
+            if (!argument<STORE>(s, c)) {
+                return false;
+            }
+            /* SVG 1.1 2nd Ed. "If a moveto is followed by multiple pairs of coordinates,
+               the subsequent pairs are treated as implicit lineto commands.
+               Hence, implicit lineto commands will be relative if the moveto
+               is relative, and absolute if the moveto is absolute. */
+            if (c == 'M') {
+                c = 'L';
+            } else if (c == 'm') {
+                c = 'l';
+            }
+            // Repeated arguments imply a repeat of the command.
+            for (;;) {
+                bool saw_comma;
+                s = skipCommaWsp(s, saw_comma);
+                if (isNumberStart(*s)) {
+                    if (!argument<STORE>(s, c)) {
+                        return false;
+                    }
+                } else if (saw_comma) {
+                    // A comma can't separate commands.
+                    return false;
+                } else {
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    FastSVGPathParser(const char *input_)
+        : input(input_)
+        , end(input_+strlen(input_))
+        , cmd_out(NULL)
+        , coord_out(NULL)
+        , num_cmds(0)
+        , num_coords(0)
+    { }
+
+public:
+
+    // Returns false (with cmd and coord in an unspecified state) if the
+    // string isn't a path this parser handles.
+    static bool parse(const char *input, vector<char> &cmd, vector<float> &coord) {
+        FastSVGPathParser parser(input);
+        // Counting pass.
+        if (!parser.svgPath<false>()) {
+            return false;
+        }
+        const size_t num_cmds = parser.num_cmds,
+                     num_coords = parser.num_coords;
+        cmd.resize(num_cmds);
+        coord.resize(num_coords);
+        if (num_cmds == 0) {
+            return true;
+        }
+        // Converting pass writes directly into the exactly sized arrays.
+        parser.cmd_out = &cmd[0];
+        parser.coord_out = num_coords > 0 ? &coord[0] : NULL;
+        bool ok = parser.svgPath<true>();
+        assert(ok);
+        assert(parser.num_cmds == num_cmds);
+        assert(parser.num_coords == num_coords);
+        return ok;
+    }
+};
+
+int fast_svg_path_parser(const char *input, vector<char> &c, vector<float> &v)
+{
+    return FastSVGPathParser::parse(input, c, v);
+}
+
 int svg_path_parser(const char *input, vector<char> &c, vector<float> &v)
 {
     int error_position;
@@ -1435,7 +1899,29 @@ int parse_svg_path(const char *input, vector<char> &c, vector<float> &v)
     return spirit_svg_path_parser(input, c, v);
 #else
 
-    int status = svg_path_parser(input, c, v);
+    int status = fast_svg_path_parser(input, c, v);
+    if (!status) {
+        // The fast parser only handles well-formed paths; let the recursive
+        // descent parser produce its partial result and report the error.
+        status = svg_path_parser(input, c, v);
+    }
+
+#if 0
+    // compare with the recursive descent parser's parse (must be bit-identical)...
+    vector<char> rd_c;
+    vector<float> rd_v;
+
+    int rd_status = svg_path_parser(input, rd_c, rd_v);
+
+    if (rd_status != status) {
+        printf("status mismatch: got %d, recursive descent got %d\n", status, rd_status);
+    } else if (rd_c != c) {
+        printf("command list mismatch: <%s>\n", input);
+    } else if (rd_v.size() != v.size() ||
+               (v.size() > 0 && memcmp(&rd_v[0], &v[0], v.size()*sizeof(float)))) {
+        printf("coord list mismatch: <%s>\n", input);
+    }
+#endif
 
 #if 0
     // compare with boost spirit's parse...
@@ -8,3 +8,8 @@
 
 int parse_svg_path(const char *input, std::vector<char> &c, std::vector<float> &v);
 
+// Specific parser implementations (parse_svg_path picks among these), exposed for benchmarking.
+int fast_svg_path_parser(const char *input, std::vector<char> &c, std::vector<float> &v);
+int svg_path_parser(const char *input, std::vector<char> &c, std::vector<float> &v);
+int spirit_svg_path_parser(const char *input, std::vector<char> &c, std::vector<float> &v);
+
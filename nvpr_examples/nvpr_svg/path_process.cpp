@@ -33,6 +33,7 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <ctype.h>  // for toupper
 
 using namespace Cg;
 
@@ -240,35 +241,6 @@ static inline bool isQuadraticCommand(char c)
     }
 }
 
-struct PathSegmentCount {
-    int count;
-
-    PathSegmentCount() : count(0) { }
-};
-
-struct SegmentCountProcessor : PathSegmentProcessor {
-    PathSegmentCount &state;
-
-    SegmentCountProcessor(PathSegmentCount &count) : state(count) {}
-
-    void beginPath(PathPtr p) {}
-    void moveTo(const float2 p[2], size_t coord_index, char cmd) { };
-    void lineTo(const float2 p[2], size_t coord_index, char cmd) {
-        state.count++;
-    }
-    void quadraticCurveTo(const float2 p[3], size_t coord_index, char cmd) {
-        state.count++;
-    }
-    void cubicCurveTo(const float2 p[4], size_t coord_index, char cmd) {
-        state.count++;
-    }
-    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
-        state.count++;
-    }
-    void close(char cmd) { }
-    void endPath(PathPtr p) {}
-};
-
 struct ControlPointHitProcessor : PathSegmentProcessor {
     ActiveControlPoint &state;
     PathPtr path;
@@ -407,14 +379,10 @@ void Path::findNearerControlPoint(ActiveControlPoint &hit)
 
 int Path::countSegments()
 {
-    PathSegmentCount count;
-
-    SegmentCountProcessor counter(count);
-    processSegments(counter);
-    return count.count;
+    return int(getCanonicalPath().num_drawing_segments);
 }
 
-void Path::processSegments(PathSegmentProcessor &processor)
+void CanonicalPath::build(const vector<char> &cmd, const vector<float> &coord)
 {
     float2 current = float2(0,0),
            initial_point = float2(0,0),
@@ -422,159 +390,160 @@ void Path::processSegments(PathSegmentProcessor &processor)
     char last_c = 0, c;
     const size_t n = cmd.size();
 
-    processor.beginPath(shared_from_this());
+    segment.clear();
+    point.clear();
+    arc_param.clear();
+    subpath.clear();
+    num_drawing_segments = 0;
+
+    // Each command makes one segment (two for a closepath that needs a
+    // line) and at most three points, so reserve the worst case.
+    segment.reserve(2*n);
+    point.reserve(1 + coord.size()/2 + n);
+    point.push_back(current);
+
     for (size_t i=0, j=0; i<n; i++, last_c = c) {
         c = cmd[i];
+        Segment s;
+        s.type = char(toupper(c));
+        s.cmd = c;
+        s.coord_index = (unsigned int)j;
         switch (c) {
         case 'M':
         case 'm':
             {
-                float2 plist[] = {
-                    current,
-                    float2(coord[j+0], coord[j+1]),
-                };
+                float2 p = float2(coord[j+0], coord[j+1]);
                 if (c == 'm') {  // relative
-                    plist[1] += current;
+                    p += current;
                 }
-                processor.moveTo(plist, j, c);
-                current = plist[1];
-                initial_point = plist[1];
+                Subpath sp = { segment.size(), point.size() };
+                subpath.push_back(sp);
+                point.push_back(p);
+                current = p;
+                initial_point = p;
                 j += 2;
             }
             break;
         case 'H':
         case 'h':
             {
-                float2 plist[] = {
-                    current,
-                    float2(coord[j+0], current.y),
-                };
+                float2 p = float2(coord[j+0], current.y);
                 if (c == 'h') {  // relative
-                    plist[1].x += current.x;
+                    p.x += current.x;
                 }
-                processor.lineTo(plist, j, c);
-                current = plist[1];
+                s.type = 'L';
+                point.push_back(p);
+                current = p;
                 j += 1;
             }
             break;
         case 'V':
         case 'v':
             {
-                float2 plist[] = {
-                    current,
-                    float2(current.x, coord[j+0]),
-                };
+                float2 p = float2(current.x, coord[j+0]);
                 if (c == 'v') {  // relative
-                    plist[1].y += current.y;
+                    p.y += current.y;
                 }
-                processor.lineTo(plist, j, c);
-                current = plist[1];
+                s.type = 'L';
+                point.push_back(p);
+                current = p;
                 j += 1;
             }
             break;
         case 'L':
         case 'l':
             {
-                float2 plist[] = {
-                    current,
-                    float2(coord[j+0], coord[j+1]),
-                };
+                float2 p = float2(coord[j+0], coord[j+1]);
                 if (c == 'l') {  // relative
-                    plist[1] += current;
+                    p += current;
                 }
-                processor.lineTo(plist, j, c);
-                current = plist[1];
+                point.push_back(p);
+                current = p;
                 j += 2;
             }
             break;
         case 'Q':
         case 'q':
             {
-                float2 plist[] = {
-                    current,
-                    float2(coord[j+0], coord[j+1]),
-                    float2(coord[j+2], coord[j+3]),
-                };
+                float2 p1 = float2(coord[j+0], coord[j+1]),
+                       p2 = float2(coord[j+2], coord[j+3]);
                 if (c == 'q') {  // relative
-                    plist[1] += current;
-                    plist[2] += current;
+                    p1 += current;
+                    p2 += current;
                 }
-                processor.quadraticCurveTo(plist, j, c);
-                prior_curve_point = plist[1];
-                current = plist[2];
+                point.push_back(p1);
+                point.push_back(p2);
+                prior_curve_point = p1;
+                current = p2;
                 j += 2*2;
             }
             break;
         case 'T':
         case 't':
             {
-                float2 plist[] = {
-                    current,
-                    // "The control point is assumed to be the reflection of the control
-                    // point on the previous command relative to the current point. (If 
-                    // there is no previous command or if the previous command was not a Q,
-                    // q, T or t, assume the control point is coincident with the current point.)
-                    isQuadraticCommand(last_c) ? 2*current - prior_curve_point : current,
-                    float2(coord[j+0], coord[j+1]),
-                };
+                // "The control point is assumed to be the reflection of the control
+                // point on the previous command relative to the current point. (If 
+                // there is no previous command or if the previous command was not a Q,
+                // q, T or t, assume the control point is coincident with the current point.)
+                float2 p1 = isQuadraticCommand(last_c) ? 2*current - prior_curve_point : current,
+                       p2 = float2(coord[j+0], coord[j+1]);
                 if (c == 't') {  // relative
-                    plist[2] += current;
+                    p2 += current;
                 }
-                processor.quadraticCurveTo(plist, j, c);
-                prior_curve_point = plist[1];
-                current = plist[2];
+                s.type = 'Q';
+                point.push_back(p1);
+                point.push_back(p2);
+                prior_curve_point = p1;
+                current = p2;
                 j += 2*1;
             }
             break;
         case 'C':
         case 'c':
             {
-                float2 plist[] = {
-                    current,
-                    float2(coord[j+0], coord[j+1]),
-                    float2(coord[j+2], coord[j+3]),
-                    float2(coord[j+4], coord[j+5]),
-                };
+                float2 p1 = float2(coord[j+0], coord[j+1]),
+                       p2 = float2(coord[j+2], coord[j+3]),
+                       p3 = float2(coord[j+4], coord[j+5]);
                 if (c == 'c') {  // relative
-                    plist[1] += current;
-                    plist[2] += current;
-                    plist[3] += current;
+                    p1 += current;
+                    p2 += current;
+                    p3 += current;
                 }
-                processor.cubicCurveTo(plist, j, c);
-                prior_curve_point = plist[2];
-                current = plist[3];
+                point.push_back(p1);
+                point.push_back(p2);
+                point.push_back(p3);
+                prior_curve_point = p2;
+                current = p3;
                 j += 2*3;
             }
             break;
         case 'S':
         case 's':
             {
-                float2 plist[] = {
-                    current,
-                    // "The first control point is assumed to be the reflection
-                    // of the second control point on the previous command relative
-                    // to the current point. (If there is no previous command or if
-                    // the previous command was not an C, c, S or s, assume the first
-                    // control point is coincident with the current point.)"
-                    isCubicCommand(last_c) ? 2*current - prior_curve_point : current,
-                    float2(coord[j+0], coord[j+1]),
-                    float2(coord[j+2], coord[j+3]),
-                };
+                // "The first control point is assumed to be the reflection
+                // of the second control point on the previous command relative
+                // to the current point. (If there is no previous command or if
+                // the previous command was not an C, c, S or s, assume the first
+                // control point is coincident with the current point.)"
+                float2 p1 = isCubicCommand(last_c) ? 2*current - prior_curve_point : current,
+                       p2 = float2(coord[j+0], coord[j+1]),
+                       p3 = float2(coord[j+2], coord[j+3]);
                 if (c == 's') {  // relative
-                    plist[2] += current;
-                    plist[3] += current;
+                    p2 += current;
+                    p3 += current;
                 }
-                processor.cubicCurveTo(plist, j, c);
-                prior_curve_point = plist[2];
-                current = plist[3];
+                s.type = 'C';
+                point.push_back(p1);
+                point.push_back(p2);
+                point.push_back(p3);
+                prior_curve_point = p2;
+                current = p3;
                 j += 2*2;
             }
             break;
         case 'A':
         case 'a':
             {
-                EndPointArc arc;
-
                 // 0: rx -- ellipse X radius
                 // 1: ry -- ellipse Y radius
                 // 2: x-axis-rotation
@@ -582,17 +551,13 @@ void Path::processSegments(PathSegmentProcessor &processor)
                 // 4: sweep-flag
                 // 5: x -- X of to-point
                 // 6: y -- Y of to-point
-                arc.p[0] = current;
-                arc.radii = float2(coord[j+0], coord[j+1]);
-                arc.x_axis_rotation = coord[j+2];
-                arc.large_arc_flag = coord[j+3] != 0;
-                arc.sweep_flag = coord[j+4] != 0;
-                arc.p[1] = float2(coord[j+5], coord[j+6]);
+                float2 p = float2(coord[j+5], coord[j+6]);
                 if (c == 'a') {
-                    arc.p[1] += current;
+                    p += current;
                 }
-                current = arc.p[1];
-                processor.arcTo(arc, j, c);
+                arc_param.insert(arc_param.end(), coord.begin()+j, coord.begin()+j+5);
+                point.push_back(p);
+                current = p;
                 j += 7;
             }
             break;
@@ -604,206 +569,53 @@ void Path::processSegments(PathSegmentProcessor &processor)
                 // NOTE:  This optimization isn't legal for a stroked path because
                 // closing the path eliminates end-caps.
                 if (any(initial_point != current)) {
-                    float2 plist[] = {
-                        current,
-                        initial_point,
-                    };
                     // "The "closepath" (Z or z) ends the current subpath and causes
                     // an automatic straight line to be drawn from the current point
                     // to the initial point of the current subpath."
-                    processor.lineTo(plist, j, 'L');
+                    Segment line = s;
+                    line.type = 'L';
+                    line.cmd = 'Z';
+                    segment.push_back(line);
+                    num_drawing_segments++;
+                    point.push_back(initial_point);
                     // "If a "closepath" is followed immediately by any other command,
                     // then the next subpath starts at the same initial point as the
                     // current subpath."
                     current = initial_point;
                 }
-                processor.close(c);
             }
             break;
         default:
             assert(!"bad command");
-            break;
+            continue;
         }
-    }
-    processor.endPath(shared_from_this());
-}
-
-struct DrawControlPointProcessor : PathSegmentProcessor {
-    void beginPath(PathPtr p) { }
-    void moveTo(const float2 p[2], size_t coord_index, char cmd) {
-        glColor3f(1,1,0.66f);  // ???
-        glVertex2f(p[1].x, p[1].y);
-    };
-    void lineTo(const float2 p[2], size_t coord_index, char cmd) {
-        glColor3f(0,0,1);  // blue
-        glVertex2f(p[1].x, p[1].y);
-    }
-    void quadraticCurveTo(const float2 p[3], size_t coord_index, char cmd) {
-        glColor3f(0,1,1);  // cyan
-        glVertex2f(p[1].x, p[1].y);
-        glColor3f(1,0,1); // magenta
-        glVertex2f(p[2].x, p[2].y);
-    }
-    void cubicCurveTo(const float2 p[4], size_t coord_index, char cmd) {
-        glColor3f(1,0.5,0.5);  // red
-        glVertex2f(p[1].x, p[1].y);
-        glColor3f(1,0.5,0.5); // red
-        glVertex2f(p[2].x, p[2].y);
-        glColor3f(0.5,1,0.5); // green
-        glVertex2f(p[3].x, p[3].y);
-    }
-    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
-        // Convert to a center point arc to be able to render the arc center.
-        CenterPointArc center_point_arc(arc);
-        if (center_point_arc.form == CenterPointArc::BEHAVED) {
-            glColor3f(0.33f,0,0);
-            glVertex2f(center_point_arc.p[1].x, center_point_arc.p[1].y);
-            glColor3f(0.66f,0,0);
-        } else {
-            glColor3f(0.66f,0,1);  // hint the control point is for a degenerate arc
+        segment.push_back(s);
+        if (s.type != 'M' && s.type != 'Z') {
+            num_drawing_segments++;
         }
-        glVertex2f(center_point_arc.center.x, center_point_arc.center.y);
     }
-    void close(char cmd) { }
-    void endPath(PathPtr p) {}
-};
-
-void Path::drawControlPoints()
-{
-    glPointSize(5.0);
-    glBegin(GL_POINTS); {
-        DrawControlPointProcessor processor;
-        processSegments(processor);
-    } glEnd();
 }
 
-// This version also draws tangent offset curve points
-static void draw_cubic_reference_points(const float2 b[4], const int steps)
+const CanonicalPath &Path::getCanonicalPath()
 {
-    const float2 P0 = b[0],
-                 P1 = b[1],
-                 P2 = b[2],
-                 P3 = b[3];
-
-    for (int i=0; i<=steps; i++) {
-        const float t = float(i) / steps;
-
-        const float2 p = (1-t)*(1-t)*(1-t)*P0 + 3*(1-t)*(1-t)*t*P1 + 3*(1-t)*t*t*P2+ t*t*t*P3;
-
-        glColor3f(1,1,1);
-        glVertex2f(p.x, p.y);
-
-#if 0  // add offset curve points (for stroking)
-        const float2 dpdt = -3*(1-t)*(1-t)*P0-6*(1-t)*t*P1+3*(1-t)*(1-t)*P1-3*t*t*P2+6*(1-t)*t*P2+3*t*t*P3;
-        const float2 tangent = normalize(dpdt);
-        const float2 normal = 30*float2(-tangent.y, tangent.x);
-        glColor3f(1,0,0);
-        glVertex2f(p.x + normal.x, p.y + normal.y);
-        glColor3f(0,1,0);
-        glVertex2f(p.x - normal.x, p.y - normal.y);
-        glColor3f(0,0,1);
-        glVertex2f(p.x + 6*tangent.x, p.y + 6*tangent.y);
-#endif
+    if (!has_canonical_path) {
+        canonical_path.build(cmd, coord);
+        has_canonical_path = true;
     }
+    return canonical_path;
 }
 
-static void draw_quadratic_reference_points(const float2 b[3], const int steps)
+void Path::setCanonicalPath(CanonicalPath &canonical)
 {
-    glColor3f(1,1,1);
-    for (int i=0; i<=steps; i++) {
-        float t = float(i) / steps;
-
-        float2 pa = lerp(b[0], b[1], t),
-               pb = lerp(b[1], b[2], t),
-               p  = lerp(pa, pb, t);
-
-        glVertex2f(p.x, p.y);
-    }
-}
-
-static void draw_line_reference_points(const float2 b[2], const int steps)
-{
-    glColor3f(1,1,1);
-    for (int i=0; i<=steps; i++) {
-        float t = float(i) / steps;
-
-        float2 p = lerp(b[0], b[1], t);
-
-        glVertex2f(p.x, p.y);
-    }
+    canonical_path.segment.swap(canonical.segment);
+    canonical_path.point.swap(canonical.point);
+    canonical_path.arc_param.swap(canonical.arc_param);
+    canonical_path.subpath.swap(canonical.subpath);
+    canonical_path.num_drawing_segments = canonical.num_drawing_segments;
+    has_canonical_path = true;
 }
 
-static void draw_arc_reference_points(CenterPointArc center_point_arc, const int steps)
-{
-    // "If the endpoints (x1, y1) and (x2, y2) are identical, then this
-    // is equivalent to omitting the elliptical arc segment entirely."
-    if (center_point_arc.form == CenterPointArc::DEGENERATE_POINT) {
-        return;
-    }
-
-    // "If rX = 0 or rY  = 0 then this arc is treated as a straight
-    // line segment (a "lineto") joining the endpoints."
-    if (center_point_arc.form == CenterPointArc::DEGENERATE_LINE) {
-        glColor3f(1,0,0); // red
-        for (int i=1; i<steps; i++) {
-            float t = float(i) / steps;
-
-            float2 p = lerp(center_point_arc.p[0],
-                            center_point_arc.p[1], t);
-
-            glVertex2f(p.x, p.y);
-        }
-        return;
-    }
-
-    const float &theta1 = center_point_arc.theta1,
-                &delta_theta = center_point_arc.delta_theta,
-                theta2 = theta1 + delta_theta,
-                theta_step = delta_theta / steps,
-                &psi = center_point_arc.psi;
-    const float2 &radii = center_point_arc.radii,
-                 &center = center_point_arc.center;
-
-    glColor3ub(255, 140, 0); // dark orange
-    const float2x2 rotate = float2x2(cos(psi), -sin(psi),
-                                     sin(psi), cos(psi));
-    for (int i=0; i<steps; i++) {
-        const float theta = theta1 + i*theta_step;
-        const float2 scale = radii * float2(cos(theta), sin(theta));
-
-        const float2 p = mul(rotate, scale) + center;
-        glVertex2f(p.x, p.y);
-    }
-    const float2 scale = radii * float2(cos(theta2), sin(theta2));
-    const float2 p = mul(rotate, scale) + center;
-    glVertex2f(p.x, p.y);
-}
-
-struct DrawReferencePointProcessor : PathSegmentProcessor {
-    void beginPath(PathPtr p) {}
-    void moveTo(const float2 p[2], size_t coord_index, char cmd) { };
-    void lineTo(const float2 p[2], size_t coord_index, char cmd) {
-        draw_line_reference_points(p, 5);
-    }
-    void quadraticCurveTo(const float2 p[3], size_t coord_index, char cmd) {
-        draw_quadratic_reference_points(p, 8);
-    }
-    void cubicCurveTo(const float2 p[4], size_t coord_index, char cmd) {
-        draw_cubic_reference_points(p, 20);
-    }
-    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
-        CenterPointArc center_point_arc(arc);
-        draw_arc_reference_points(center_point_arc, 12);
-    }
-    void close(char cmd) { }
-    void endPath(PathPtr p) {}
-};
-
-void Path::drawReferencePoints()
+void Path::processSegments(PathSegmentProcessor &processor)
 {
-    glPointSize(3.0);
-    glBegin(GL_POINTS); {
-        DrawReferencePointProcessor processor;
-        processSegments(processor);
-    } glEnd();
+    processSegments<PathSegmentProcessor>(processor);
 }
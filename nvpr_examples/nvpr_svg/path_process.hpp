@@ -10,6 +10,8 @@
 # pragma once
 #endif
 
+#include <vector>
+
 #include <Cg/vector.hpp>
 
 #include <Cg/cos.hpp>
@@ -58,4 +60,96 @@ struct PathSegmentProcessor {
     virtual ~PathSegmentProcessor() {}
 };
 
+// Exposes a processor with statically dispatched segment methods
+// through the virtual PathSegmentProcessor interface.
+template <typename Processor>
+struct PathSegmentProcessorAdapter : PathSegmentProcessor {
+    Processor &processor;
+
+    PathSegmentProcessorAdapter(Processor &p) : processor(p) {}
+
+    void beginPath(PathPtr p) {
+        processor.beginPath(p);
+    }
+    void moveTo(const float2 p[2], size_t coord_index, char cmd) {
+        processor.moveTo(p, coord_index, cmd);
+    }
+    void lineTo(const float2 p[2], size_t coord_index, char cmd) {
+        processor.lineTo(p, coord_index, cmd);
+    }
+    void quadraticCurveTo(const float2 p[3], size_t coord_index, char cmd) {
+        processor.quadraticCurveTo(p, coord_index, cmd);
+    }
+    void cubicCurveTo(const float2 p[4], size_t coord_index, char cmd) {
+        processor.cubicCurveTo(p, coord_index, cmd);
+    }
+    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
+        processor.arcTo(arc, coord_index, cmd);
+    }
+    void close(char cmd) {
+        processor.close(cmd);
+    }
+    void endPath(PathPtr p) {
+        processor.endPath(p);
+    }
+};
+
+// Canonical absolute form of a path's SVG-style commands.
+//
+// Relative commands are resolved, H/V become L, and the smooth S/T
+// reflections are expanded into C/Q so iterating the canonical form
+// needs no current point bookkeeping.  Control points live in one
+// contiguous float2 array that begins with the initial (0,0) current
+// point; each segment appends its new points so the points of segment
+// k, current point included, are contiguous starting at one point
+// before its first new point.  Implicit closepath lines get their own
+// explicit L segment (with cmd 'Z') so the points stay contiguous.
+struct CanonicalPath {
+    struct Segment {
+        char type;           // one of 'M', 'L', 'Q', 'C', 'A', or 'Z'
+        char cmd;            // original command (or 'Z' for a closepath line)
+        unsigned int coord_index;  // index into original coord array
+    };
+    struct Subpath {
+        size_t first_segment;  // index of the subpath's moveto segment
+        size_t first_point;    // index of the moveto's point
+    };
+
+    std::vector<Segment> segment;
+    std::vector<float2> point;
+    std::vector<float> arc_param;  // rx, ry, x-axis-rotation, large-arc, sweep per arc
+    std::vector<Subpath> subpath;
+    size_t num_drawing_segments;   // segments that are not M or Z
+
+    CanonicalPath() : num_drawing_segments(0) { }
+
+    void build(const std::vector<char> &cmd, const std::vector<float> &coord);
+
+    static int pointCount(char type) {
+        switch (type) {
+        case 'M':
+        case 'L':
+        case 'A':
+            return 1;
+        case 'Q':
+            return 2;
+        case 'C':
+            return 3;
+        default:
+            return 0;
+        }
+    }
+    EndPointArc arc(const float2 plist[2], size_t arc_ndx) const {
+        EndPointArc a;
+        const float *param = &arc_param[5*arc_ndx];
+        a.p[0] = plist[0];
+        a.p[1] = plist[1];
+        a.radii = float2(param[0], param[1]);
+        a.x_axis_rotation = param[2];
+        a.large_arc_flag = param[3] != 0;
+        a.sweep_flag = param[4] != 0;
+        return a;
+    }
+};
+
 #endif // __path_process_hpp__
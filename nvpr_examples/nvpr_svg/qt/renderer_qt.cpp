@@ -190,7 +190,7 @@ struct QtPathCacheProcessor : PathSegmentProcessor {
 
     void beginPath(PathPtr p) {
         path = QPainterPath();  // reset the path
-        switch (p->style.fill_rule) {
+        switch (p->style->fill_rule) {
         case PathStyle::EVEN_ODD:
             assert(path.fillRule() == Qt::OddEvenFill);
             break;
@@ -454,7 +454,7 @@ void QtShapeRendererState::validate()
     brush = fill_brush;
 
     pen.setBrush(stroke_brush);
-    const PathStyle *style = &owner->getPath()->style;
+    const PathStyle *style = owner->getPath()->style.get();
     pen.setWidthF(style->stroke_width);
     pen.setCapStyle(lineCapConverter(style));
     pen.setJoinStyle(lineJoinConverter(style));
@@ -505,7 +505,7 @@ void QtShapeRendererState::draw()
     path_state->validate();
 
     extern bool doFilling, doStroking;
-    const PathStyle &style = owner->getPath()->style;
+    const PathStyle &style = *owner->getPath()->style;
     if (style.do_fill && doFilling) {
         renderer->painter->fillPath(path_state->path, brush);
     }
@@ -3,18 +3,119 @@
 
 // Copyright (c) NVIDIA Corporation. All rights reserved.
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "scene.hpp"
 #include "renderer.hpp"
 
-#include "showfps.h"
+void BlitRenderer::drawScene(GroupPtr scene, const float4x4 &scene_to_surface,
+                             const float4 &surface_rect, bool cull)
+{
+    if (cull) {
+        CullingTraversal traversal(scene_to_surface, surface_rect);
+        scene->traverse(makeVisitor(), traversal);
+    } else {
+        scene->traverse(makeVisitor());
+    }
+}
+
+void BlitRenderer::drawSceneRect(GroupPtr scene, const float4x4 &scene_to_surface,
+                                 int x, int y, int width, int height, bool cull)
+{
+    BlitRenderer::drawScene(scene, scene_to_surface,
+                            float4(x, y, x+width, y+height), cull);
+}
+
+static inline unsigned char unpremultiply(unsigned int c, unsigned int a)
+{
+    // Round to nearest; clamp in case a color exceeds its alpha.
+    const unsigned int v = (c*255 + a/2) / a;
+    return (unsigned char) (v > 255 ? 255 : v);
+}
+
+void storeUnpremultiplied(unsigned char rgba[4],
+                          unsigned int r, unsigned int g, unsigned int b, unsigned int a)
+{
+    if (a == 0) {
+        rgba[0] = rgba[1] = rgba[2] = rgba[3] = 0;
+    } else if (a == 255) {
+        rgba[0] = (unsigned char) r;
+        rgba[1] = (unsigned char) g;
+        rgba[2] = (unsigned char) b;
+        rgba[3] = 255;
+    } else {
+        rgba[0] = unpremultiply(r, a);
+        rgba[1] = unpremultiply(g, a);
+        rgba[2] = unpremultiply(b, a);
+        rgba[3] = (unsigned char) a;
+    }
+}
+
+void scrollPixels(unsigned char *pixels, int width, int height, int stride,
+                  int dx, int dy)
+{
+    if (dx <= -width || dx >= width || dy <= -height || dy >= height) {
+        return;  // nothing stays in view
+    }
+    const int src_x = dx < 0 ? -dx : 0,
+              dst_x = dx > 0 ? dx : 0;
+    const size_t bytes = 4*size_t(width - src_x - dst_x);
+    // Visit rows so none is read after it's overwritten.
+    const int rows = height - (dy < 0 ? -dy : dy),
+              first = dy > 0 ? height-1 : 0,
+              step = dy > 0 ? -1 : 1;
+    for (int i=0, y=first; i<rows; i++, y+=step) {
+        const unsigned char *src = pixels + size_t(y-dy)*stride + 4*src_x;
+        unsigned char *dst = pixels + size_t(y)*stride + 4*dst_x;
+        memmove(dst, src, bytes);
+    }
+}
 
-void GLBlitRenderer::swapBuffers()
+bool redrawSurfaceRect(BlitRendererPtr renderer, GroupPtr scene, const float4x4 &view,
+                       const float4x4 &scene_to_surface, const float3 &clear_color,
+                       int x0, int y0, int x1, int y1)
 {
-    glutSwapBuffers();
+    renderer->beginDraw();
+    if (!renderer->clipToRect(x0, y0, x1-x0, y1-y0)) {
+        renderer->endDraw();
+        return false;
+    }
+    renderer->clear(clear_color);
+    renderer->setView(view);
+    renderer->drawSceneRect(scene, scene_to_surface, x0, y0, x1-x0, y1-y0, true);
+    renderer->endDraw();
+    return true;
 }
 
-void GLBlitRenderer::reportFPS()
+bool scrollSurfaceScene(BlitRendererPtr renderer, GroupPtr scene, const float4x4 &view,
+                        const float4x4 &scene_to_surface, const float3 &clear_color,
+                        int width, int height, int dx, int dy)
 {
-    extern FPScontext gl_fps_context;
-    double thisFPS = handleFPS(&gl_fps_context);
-    thisFPS = thisFPS; // force used
+    if (abs(dx) >= width || abs(dy) >= height) {
+        return false;  // nothing stays in view
+    }
+    if ((dx || dy) && !renderer->scrollSurface(dx, dy)) {
+        return false;
+    }
+    // The rows scrolled in, then the columns scrolled in beside the rows kept.
+    const int ky0 = dy > 0 ? dy : 0,
+              ky1 = dy < 0 ? height+dy : height;
+    if (dy > 0 && !redrawSurfaceRect(renderer, scene, view, scene_to_surface, clear_color,
+                                     0, 0, width, dy)) {
+        return false;
+    }
+    if (dy < 0 && !redrawSurfaceRect(renderer, scene, view, scene_to_surface, clear_color,
+                                     0, height+dy, width, height)) {
+        return false;
+    }
+    if (dx > 0 && !redrawSurfaceRect(renderer, scene, view, scene_to_surface, clear_color,
+                                     0, ky0, dx, ky1)) {
+        return false;
+    }
+    if (dx < 0 && !redrawSurfaceRect(renderer, scene, view, scene_to_surface, clear_color,
+                                     width+dx, ky0, width, ky1)) {
+        return false;
+    }
+    return true;
 }
@@ -77,15 +77,73 @@ typedef shared_ptr<class Visitor> VisitorPtr;
 struct BlitRenderer : Renderer {
     virtual void configureSurface(int width, int height) = 0;
     virtual void beginDraw() { }
+    // Limit drawing, clears included, to a surface rectangle (lower-left
+    // origin, like the GL window) until endDraw.  Returns false if the
+    // renderer can't, in which case the whole surface must be redrawn.
+    virtual bool clipToRect(int x, int y, int width, int height) { return false; }
+    // Moves the surface image dx,dy pixels (lower-left origin) so a pan
+    // redraws only the strips it exposes, which are left stale.  Returns
+    // false if the renderer can't, in which case the whole surface must be
+    // redrawn.
+    virtual bool scrollSurface(int dx, int dy) { return false; }
     virtual void clear(Cg::float3 clear_color) = 0;
     virtual void setView(Cg::float4x4 view) = 0;
     virtual VisitorPtr makeVisitor() = 0;
+    // Traverses the scene with makeVisitor() after setView, skipping nodes
+    // that scene_to_surface puts outside surface_rect when cull is true.
+    // Renderers able to draw tiles on several threads override this.
+    virtual void drawScene(GroupPtr scene, const Cg::float4x4 &scene_to_surface,
+                           const Cg::float4 &surface_rect, bool cull);
+    // Draws the x,y,width,height surface rectangle (lower-left origin),
+    // already clipped to with clipToRect and cleared, after setView, with
+    // the same pixels drawScene gives it in a whole frame.  Culls to the
+    // rectangle when cull is true.  By default draws through the clip,
+    // which suits renderers whose clip doesn't change the pixels inside it;
+    // renderers that rasterize differently under a clip override this.
+    virtual void drawSceneRect(GroupPtr scene, const Cg::float4x4 &scene_to_surface,
+                               int x, int y, int width, int height, bool cull);
+    // How many threads drawScene draws tiles on, the calling one included;
+    // 0 draws the whole surface in one pass and -1 means one per processor.
+    // Tiled images match untiled ones pixel for pixel.  Returns false if the
+    // renderer can't draw in tiles.
+    virtual bool setTileThreads(int threads) { return threads == 0; }
+    virtual int getTileThreads() { return 0; }
     virtual void endDraw() { }
     //virtual void draw(GroupPtr scene, RendererPtr renderer) = 0;
     virtual void copyImageToWindow() = 0;
+    // Copies the surface into rgba as 4 unpremultiplied bytes per pixel,
+    // top row first as image files want.  Returns false if the renderer
+    // can't read its surface back without a window.
+    virtual bool readPixels(unsigned char *rgba) { return false; }
     virtual void shutdown() = 0;
 };
 
+// Stores a premultiplied pixel as unpremultiplied RGBA bytes for readPixels.
+extern void storeUnpremultiplied(unsigned char rgba[4],
+                                 unsigned int r, unsigned int g, unsigned int b, unsigned int a);
+
+// Moves a surface of 4-byte pixels, rows bottom to top, dx,dy pixels for
+// scrollSurface; the pixels scrolled in keep what they had.
+extern void scrollPixels(unsigned char *pixels, int width, int height, int stride,
+                         int dx, int dy);
+
+// Clears the x0,y0 to x1,y1 surface rectangle (lower-left origin) and
+// draws the scene into it with view through drawSceneRect, so it gets the
+// pixels a whole frame would.  Returns false if the renderer can't limit
+// drawing to it, in which case the whole surface must be redrawn.
+extern bool redrawSurfaceRect(BlitRendererPtr renderer, GroupPtr scene,
+                              const Cg::float4x4 &view, const Cg::float4x4 &scene_to_surface,
+                              const Cg::float3 &clear_color, int x0, int y0, int x1, int y1);
+
+// Pans a width by height surface image by whole pixels: scrolls it dx,dy
+// pixels and redraws the strips scrolled in with redrawSurfaceRect, given
+// the panned view.  Returns false if nothing would stay in view or the
+// renderer can't, in which case the whole surface must be redrawn.
+extern bool scrollSurfaceScene(BlitRendererPtr renderer, GroupPtr scene,
+                               const Cg::float4x4 &view, const Cg::float4x4 &scene_to_surface,
+                               const Cg::float3 &clear_color, int width, int height,
+                               int dx, int dy);
+
 struct GLBlitRenderer : BlitRenderer {
     void reportFPS();
     void swapBuffers();
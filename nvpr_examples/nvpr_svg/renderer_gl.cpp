@@ -0,0 +1,23 @@
+/* renderer_gl.cpp - GLUT window parts of the generic renderer back-end */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+// Kept apart from renderer.cpp so programs without a GL window, like
+// svg_render, link the renderers without GLUT (see headless_stubs.cpp).
+
+#include "scene.hpp"
+#include "renderer.hpp"
+
+#include "showfps.h"
+
+void GLBlitRenderer::swapBuffers()
+{
+    glutSwapBuffers();
+}
+
+void GLBlitRenderer::reportFPS()
+{
+    extern FPScontext gl_fps_context;
+    double thisFPS = handleFPS(&gl_fps_context);
+    thisFPS = thisFPS; // force used
+}
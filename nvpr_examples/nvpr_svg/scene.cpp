@@ -9,6 +9,10 @@
 #include "scene.hpp"
 #include "glmatrix.hpp"
 
+#include <Cg/abs.hpp>
+
+#include <set>
+
 // Grumble, Microsoft (and probably others) define these as macros
 #undef min
 #undef max
@@ -80,16 +84,6 @@ int Shape::countSegments()
     return path->countSegments();
 }
 
-void Shape::drawControlPoints()
-{
-    path->drawControlPoints();
-}
-
-void Shape::drawReferencePoints()
-{
-    path->drawReferencePoints();
-}
-
 static string floatToString(float v)
 {
     string s = lexical_cast<string>(v);
@@ -178,18 +172,18 @@ void Shape::dumpSVGHelper(FILE *file, const float4x4 &transform)
 {
     string svg_path = path->convert_to_svg_path(transform);
     string svg_fill_color = " fill=\"none\"";
-    if (path->style.do_fill && fill_paint) {
+    if (path->style->do_fill && fill_paint) {
         svg_fill_color = fill_paint->toSVG("fill");
     }
     string svg_stroke_color = " stroke=\"none\"";
-    if (path->style.do_stroke && stroke_paint) {
+    if (path->style->do_stroke && stroke_paint) {
         svg_stroke_color = stroke_paint->toSVG("stroke");
     }
     fprintf(file, "  <path style=\"fill-rule:%s\"%s%s%s d=\"%s\" transform=\"matrix(%f,%f,%f,%f,%f,%f)\" />\n",
-        path->style.fill_rule==PathStyle::NON_ZERO ? "nonzero" : "evenodd",
+        path->style->fill_rule==PathStyle::NON_ZERO ? "nonzero" : "evenodd",
         svg_fill_color.c_str(),
         svg_stroke_color.c_str(),
-        strokeProperties(path->style).c_str(),
+        strokeProperties(*path->style).c_str(),
         svg_path.c_str(),
         transform[0][0], transform[1][0],
         transform[0][1], transform[1][1],
@@ -252,12 +246,21 @@ void Transform::setMatrix(const float4x4 &transform)
 {
     matrix = transform;
     inverse_matrix = inverse(transform);
+    invalidateBounds();
 }
 
-float4 Transform::getBounds()
+float4 Transform::computeBounds()
 {
-    float4 bounds = node->getBounds();
+    return transformBounds(boundsOf(*node));
+}
 
+float4 Transform::computeInkBounds(const float4 &bounds)
+{
+    return transformBounds(inkBoundsOf(*node));
+}
+
+float4 Transform::transformBounds(float4 bounds)
+{
     if (bounds.x <= bounds.z && bounds.y <= bounds.w)
     {
         // Transform the 4 extreme points of the points box by the matrix
@@ -321,24 +324,6 @@ void WarpTransform::findNearerControlPoint(ActiveWarpPoint &hit)
     }
 }
 
-void WarpTransform::drawWarpPoints() {
-    glEnable(GL_LINE_STIPPLE);
-    glColor3f(1,1,0);
-    glBegin(GL_LINE_LOOP); {
-        for (int i=0; i<4; i++) {
-            glVertex2f(from[i].x, from[i].y);
-        }
-    } glEnd();
-    glDisable(GL_LINE_STIPPLE);
-    glColor3f(1,0,1);
-    glPointSize(7);
-    glBegin(GL_POINTS); {
-        for (int i=0; i<4; i++) {
-            glVertex2f(from[i].x, from[i].y);
-        }
-    } glEnd();
-}
-
 void WarpTransform::setWarpPoint(int ndx, const float2 &xy) {
     assert(ndx >= 0);
     assert(ndx < 4);
@@ -357,12 +342,22 @@ void Group::dumpSVGHelper(FILE *file, const float4x4 &transform)
     }
 }
 
-float4 Group::getBounds()
+float4 Group::computeBounds()
 {
-    float4 group_bounds = Node::getBounds();
+    return unionOfChildren(false);
+}
+
+float4 Group::computeInkBounds(const float4 &bounds)
+{
+    return unionOfChildren(true);
+}
+
+float4 Group::unionOfChildren(bool ink)
+{
+    float4 group_bounds = Node::computeBounds();
 
     for (size_t i=0; i<list.size(); i++) {
-        float4 node_bounds = list[i]->getBounds();
+        float4 node_bounds = ink ? inkBoundsOf(*list[i]) : boundsOf(*list[i]);
         if (node_bounds.x <= node_bounds.z &&
             node_bounds.y <= node_bounds.w) {
             if (group_bounds.x <= group_bounds.z &&
@@ -611,6 +606,78 @@ void ForEachShapeTraversal::traverse(ClipPtr clip, VisitorPtr visitor)
     visitor->unapply(clip);
 }
 
+CullingTraversal::CullingTraversal(const float4x4 &scene_to_surface,
+                                   const float4 &surface_rect,
+                                   bool reverse_order_)
+    : matrices(scene_to_surface)
+    , surface(RectBounds(surface_rect).dilate(2))  // allow for antialiasing
+    , reverse_order(reverse_order_)
+    , culled(0)
+{
+}
+
+bool CullingTraversal::isCulled(Node &node)
+{
+    return isCulled(node.getInkBounds());
+}
+
+bool CullingTraversal::isCulled(const float4 &bounds)
+{
+    if (bounds.x > bounds.z || bounds.y > bounds.w) {
+        // Bogus bounds mean there's nothing to cull.
+        return false;
+    }
+    RectBounds on_surface = RectBounds(bounds).transform(matrices.getMatrix());
+    if (on_surface.isValid() &&
+        (on_surface.z < surface.x || on_surface.x > surface.z ||
+         on_surface.w < surface.y || on_surface.y > surface.w)) {
+        culled++;
+        return true;
+    }
+    return false;
+}
+
+void CullingTraversal::traverse(ShapePtr shape, VisitorPtr visitor)
+{
+    if (!isCulled(*shape)) {
+        visitor->visit(shape);
+    }
+}
+
+void CullingTraversal::traverse(TransformPtr transform, VisitorPtr visitor)
+{
+    if (!isCulled(*transform)) {
+        matrices.apply(transform);
+        visitor->apply(transform);
+        transform->node->traverse(visitor, *this);
+        visitor->unapply(transform);
+        matrices.unapply(transform);
+    }
+}
+
+void CullingTraversal::traverse(ClipPtr clip, VisitorPtr visitor)
+{
+    // Nothing shows outside the clip path either.
+    if (!isCulled(*clip) && !isCulled(clip->getClipBounds())) {
+        GenericTraversal::traverse(clip, visitor);
+    }
+}
+
+void CullingTraversal::traverse(GroupPtr group, VisitorPtr visitor)
+{
+    if (!isCulled(*group)) {
+        visitor->apply(group);
+        if (reverse_order) {
+            for (size_t i = group->list.size(); i; i--)
+                group->list[i-1]->traverse(visitor, *this);
+        } else {
+            for (size_t i = 0; i < group->list.size(); i++)
+                group->list[i]->traverse(visitor, *this);
+        }
+        visitor->unapply(group);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Visitor implementations
 MatrixSaveVisitor::MatrixSaveVisitor()
@@ -618,6 +685,11 @@ MatrixSaveVisitor::MatrixSaveVisitor()
     matrix_stack.push(float4x4(1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1));
 }
 
+MatrixSaveVisitor::MatrixSaveVisitor(const float4x4 &initial)
+{
+    matrix_stack.push(initial);
+}
+
 MatrixSaveVisitor::~MatrixSaveVisitor()
 {
     matrix_stack.pop();
@@ -760,3 +832,133 @@ float4x4 surfaceToClip(float w, float h, float scene_ratio)
                                         0,0,0,1);
     return surface_to_clip;
 }
+
+// Maps to window coordinates, [0..w,0..h], like the software renderers' setView.
+float4x4 surfaceToWindow(float w, float h, float scene_ratio)
+{
+    float4x4 clip_to_window = float4x4(w/2, 0, 0, w/2,
+                                       0, h/2, 0, h/2,
+                                       0, 0, 1, 0,
+                                       0, 0, 0, 1);
+    return mul(clip_to_window, surfaceToClip(w, h, scene_ratio));
+}
+
+GroupPtr fitSceneToClip(SvgScenePtr svg_scene, float &scene_ratio)
+{
+    const float4 svg_scene_bounds = svg_scene->getBounds();
+    float l = svg_scene_bounds.x,
+          r = svg_scene_bounds.z,
+          t = svg_scene_bounds.y,
+          b = svg_scene_bounds.w;
+    scene_ratio = abs(b-t)/abs(r-l);
+    // Wind "from" vertices in counter-clockwise order from lower-left
+    const float2 from[4] = {float2(l,b),float2(r,b),float2(r,t),float2(l,t)};
+    float xscale = 1,
+          yscale = 1;
+    if (abs(r-l) > abs(b-t)) {
+        yscale = abs(b-t)/abs(r-l);
+        if (verbose) {
+            printf("wide %f\n", scene_ratio);
+        }
+    } else {
+        xscale = abs(r-l)/abs(b-t);
+        if (verbose) {
+            printf("tall %f\n", scene_ratio);
+        }
+    }
+    // Wind "to" vertices in counter-clockwise order from lower-left
+    static const float2 to[4] = {float2(-1,-1),float2(1,-1),float2(1,1),float2(-1,1)};
+    // Scale down by 90% to better fit frame
+    float shrinkage = 0.9;
+    WarpTransformPtr normalizedScene(new WarpTransform(svg_scene, to, from,
+        shrinkage*float2(xscale, yscale)));
+    GroupPtr scene(new Group);
+    scene->push_back(normalizedScene);
+    return scene;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Unsharing
+
+// Copies just the node; the copy refers to the same children.
+static NodePtr copyNode(NodePtr node)
+{
+    if (WarpTransformPtr warp = dynamic_pointer_cast<WarpTransform>(node)) {
+        return WarpTransformPtr(new WarpTransform(*warp));
+    } else if (TransformPtr transform = dynamic_pointer_cast<Transform>(node)) {
+        return TransformPtr(new Transform(*transform));
+    } else if (ViewBoxPtr view_box = dynamic_pointer_cast<ViewBox>(node)) {
+        return ViewBoxPtr(new ViewBox(*view_box));
+    } else if (ClipPtr clip = dynamic_pointer_cast<Clip>(node)) {
+        return ClipPtr(new Clip(*clip));
+    } else if (SvgScenePtr svg = dynamic_pointer_cast<SvgScene>(node)) {
+        return SvgScenePtr(new SvgScene(*svg));
+    } else if (GroupPtr group = dynamic_pointer_cast<Group>(node)) {
+        return GroupPtr(new Group(*group));
+    } else if (dynamic_pointer_cast<Text>(node)) {
+        // Not copy constructed; HasRendererState's owner must be the copy.
+        return TextPtr(new Text);
+    }
+    assert(!"unknown node type");
+    return node;
+}
+
+class Unsharer {
+public:
+    NodePtr unshare(NodePtr node);
+
+private:
+    std::set<Node*> nodes;
+    std::set<Path*> paths;
+};
+
+// Returns node, or its copy if node was already reached, with its
+// children unshared.
+NodePtr Unsharer::unshare(NodePtr node)
+{
+    if (!node) {
+        return node;
+    }
+    const bool reached = !nodes.insert(node.get()).second;
+
+    if (ShapePtr shape = dynamic_pointer_cast<Shape>(node)) {
+        PathPtr path = shape->getPath();
+        const bool path_reached = path && !paths.insert(path.get()).second;
+        if (path_reached) {
+            path = PathPtr(new Path(path->style, path->cmd, path->coord));
+            paths.insert(path.get());
+        }
+        if (!reached && !path_reached) {
+            return shape;
+        }
+        ShapePtr copy(new Shape(path, shape->getFillPaint(), shape->getStrokePaint()));
+        copy->net_fill_opacity = shape->net_fill_opacity;
+        copy->net_stroke_opacity = shape->net_stroke_opacity;
+        nodes.insert(copy.get());
+        return copy;
+    }
+
+    if (reached) {
+        node = copyNode(node);
+        nodes.insert(node.get());
+    }
+    if (TransformPtr transform = dynamic_pointer_cast<Transform>(node)) {
+        transform->node = unshare(transform->node);
+    } else if (ClipPtr clip = dynamic_pointer_cast<Clip>(node)) {
+        clip->path = unshare(clip->path);
+        clip->node = unshare(clip->node);
+    } else if (GroupPtr group = dynamic_pointer_cast<Group>(node)) {
+        for (size_t i=0; i<group->list.size(); i++) {
+            group->list[i] = unshare(group->list[i]);
+        }
+    }
+    // Its new children wouldn't know to invalidate its cached bounds.
+    node->invalidateBounds();
+    return node;
+}
+
+void unshareScene(GroupPtr scene)
+{
+    Unsharer unsharer;
+    unsharer.unshare(scene);
+}
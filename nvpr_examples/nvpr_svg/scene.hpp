@@ -61,6 +61,7 @@ using boost::static_pointer_cast;
 #include "ActiveControlPoint.hpp"
 #include "path.hpp"
 #include "path_process.hpp"
+#include "cached_bounds.hpp"
 #include "glmatrix.hpp"
 
 // Grumble, Microsoft (and probably others) define these as macros
@@ -112,19 +113,22 @@ protected:
     bool valid;
 };
 
-struct Node {
+// Nodes cache their bounds (see CachedBounds); getBounds() is O(1) until
+// something under the node is invalidated.
+struct Node : CachedBounds {
     virtual ~Node() {};
 
     virtual void dumpSVGHelper(FILE *file, const float4x4 &transform) { };
     void dumpSVG(FILE *file, const float4x4 &transform);
 
-    virtual float4 getBounds() { return float4(0,0,-1,-1); } // bogus bounds (x>z and y>w);
-
     // Force every subclass to implement a traverse() method
     virtual void traverse(VisitorPtr visitor, Traversal &traversal) = 0;
     
     // Make it easier to traverse by automatically using a generic traversal
     void traverse(VisitorPtr visitor);
+
+protected:
+    float4 computeBounds() { return float4(0,0,-1,-1); } // bogus bounds (x>z and y>w);
 };
 
 struct Shape;
@@ -230,6 +234,10 @@ struct GradientStop {
 
 struct GradientStops {
     vector<GradientStop> stop_array;
+    // Color ramps made from stop_array by getGradientRamp, kept here so
+    // every paint sharing the stops shares them; stop_array must not
+    // change once a ramp is made.
+    vector<shared_ptr<struct GradientRamp> > ramps;
 };
 typedef shared_ptr<GradientStops> GradientStopsPtr;
 
@@ -251,6 +259,7 @@ public:
     {}
 
     inline const vector<GradientStop> &getStopArray() const { return gradient_stops->stop_array; }
+    inline GradientStopsPtr getGradientStops() const { return gradient_stops; }
     inline SpreadMethod getSpreadMethod() const { return spread_method; }
     inline const float3x3 &getGradientTransform() const { return gradient_transform; }
     inline const float3x3 &getInverseGradientTransform() const { return inverse_gradient_transform; }
@@ -422,9 +431,6 @@ public:
     void drawControlPoints();
     void drawReferencePoints();
 
-    float4 getBounds() {
-        return path ? path->getBounds() : Node::getBounds();
-    }
 
     using Node::traverse; // Lame ... Node::traverse(VisitorPtr visitor) gets "shadowed"
     void traverse(VisitorPtr visitor, Traversal &traversal);
@@ -465,6 +471,14 @@ public:
     }
 
     void processSegments(PathSegmentProcessor &processor);
+
+protected:
+    float4 computeBounds() {
+        return path ? boundsOf(*path) : Node::computeBounds();
+    }
+    float4 computeInkBounds(const float4 &bounds) {
+        return path ? inkBoundsOf(*path) : bounds;
+    }
 };
 
 struct Transform : Node, enable_shared_from_this<Transform> {
@@ -489,10 +503,13 @@ public:
     inline float4x4 getMatrix() const { return matrix; }
     inline float4x4 getInverseMatrix() const { return inverse_matrix; }
 
-    float4 getBounds();
-
     using Node::traverse; // Lame ... Node::traverse(VisitorPtr visitor) gets "shadowed"
     void traverse(VisitorPtr visitor, Traversal &traversal);
+
+protected:
+    float4 computeBounds();
+    float4 computeInkBounds(const float4 &bounds);
+    float4 transformBounds(float4 bounds);
 };
 typedef shared_ptr<Transform> TransformPtr;
 
@@ -517,6 +534,10 @@ public:
     inline float4x4 scaledTransform(const float4x4 &m) const {
         return mul(m, scale4x4(scale));
     }
+
+    inline const float2 *getTo() const { return to; }
+    inline const float2 *getFrom() const { return from; }
+    inline float2 getScale() const { return scale; }
 };
 typedef shared_ptr<WarpTransform> WarpTransformPtr;
 
@@ -542,10 +563,13 @@ struct Clip : Node, enable_shared_from_this<Clip> {
         , clip_merge(clip_merge_) {
     }
 
-    float4 getBounds() { return node->getBounds(); }
     RectBounds getClipBounds();
     using Node::traverse; // Lame ... Node::traverse(VisitorPtr visitor) gets "shadowed"
     void traverse(VisitorPtr visitor, Traversal &traversal);
+
+protected:
+    float4 computeBounds() { return boundsOf(*node); }
+    float4 computeInkBounds(const float4 &bounds) { return inkBoundsOf(*node); }
 };
 
 struct ViewBox : Clip {
@@ -556,14 +580,20 @@ typedef shared_ptr<ViewBox> ViewBoxPtr;
 struct Group : public Node, enable_shared_from_this<Group> {
     vector<NodePtr> list;
 
-    void push_back(NodePtr node) { list.push_back(node); }
+    void push_back(NodePtr node) {
+        list.push_back(node);
+        invalidateBounds();
+    }
 
     void dumpSVGHelper(FILE *file, const float4x4 &transform);
 
-    float4 getBounds();
-
     using Node::traverse; // Lame ... Node::traverse(VisitorPtr visitor) gets "shadowed"
     void traverse(VisitorPtr visitor, Traversal &traversal);
+
+protected:
+    float4 computeBounds();
+    float4 computeInkBounds(const float4 &bounds);
+    float4 unionOfChildren(bool ink);
 };
 typedef shared_ptr<Group> GroupPtr;
 
@@ -571,6 +601,11 @@ struct SvgScene : public Group {
     int width, height;
     RectBounds view_box;
     string preserve_aspect_ratio;
+
+    SvgScene()
+        : width(0)
+        , height(0)
+    {}
 };
 typedef shared_ptr<SvgScene> SvgScenePtr;
 
@@ -650,6 +685,7 @@ protected:
 
 public:
     MatrixSaveVisitor();
+    MatrixSaveVisitor(const float4x4 &initial);
     virtual ~MatrixSaveVisitor();
     void apply(TransformPtr transform);
     void unapply(TransformPtr transform);
@@ -675,6 +711,38 @@ public:
     void unapply(ClipPtr clip);
 };
 
+// Skips nodes whose ink bounds, transformed to the surface, are entirely
+// outside the surface rectangle (dilated two pixels for antialiasing).
+// Transform matrices are accumulated with a MatrixSaveVisitor starting
+// from the scene-to-surface matrix, just as drawing visitors do.
+class CullingTraversal : public GenericTraversal
+{
+public:
+    CullingTraversal(const float4x4 &scene_to_surface, const float4 &surface_rect,
+                     bool reverse_order = false);
+
+    void traverse(ShapePtr shape, VisitorPtr visitor);
+    void traverse(TransformPtr transform, VisitorPtr visitor);
+    void traverse(ClipPtr clip, VisitorPtr visitor);
+    void traverse(GroupPtr group, VisitorPtr visitor);
+
+    inline int getCulledCount() const { return culled; }
+
+protected:
+    bool isCulled(Node &node);
+    bool isCulled(const float4 &bounds);  // in the current node's space
+
+    class MatrixTracker : public MatrixSaveVisitor {
+    public:
+        MatrixTracker(const float4x4 &initial) : MatrixSaveVisitor(initial) {}
+        void visit(ShapePtr shape) { }
+        inline const float4x4 &getMatrix() const { return matrix_stack.top(); }
+    } matrices;
+    RectBounds surface;
+    bool reverse_order;
+    int culled;
+};
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Other visitors 
@@ -741,5 +809,16 @@ typedef shared_ptr<CountNonOpaqueObjects> CountNonOpaqueObjectsPtr;
 
 extern float2 clipToSurfaceScales(float w, float h, float scene_ratio);
 extern float4x4 surfaceToClip(float w, float h, float scene_ratio);
+extern float4x4 surfaceToWindow(float w, float h, float scene_ratio);
+
+// Wraps an SVG scene in a WarpTransform fitting its bounds, shrunk to 90%,
+// into the [-1,+1]^2 square and sets scene_ratio to its height/width.
+extern GroupPtr fitSceneToClip(SvgScenePtr svg_scene, float &scene_ratio);
+
+// Gives every node reached more than once under scene, and every path
+// drawn by more than one shape, its own copy, so editing a path changes
+// just one instance.  The loaders share the subtrees and paths of <use>d
+// elements between instances; call this before editing a loaded scene.
+extern void unshareScene(GroupPtr scene);
 
 #endif // __scene_hpp__
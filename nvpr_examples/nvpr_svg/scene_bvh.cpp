@@ -0,0 +1,300 @@
+/* scene_bvh.cpp - bounding volume hierarchy over a scene's shapes */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#include <algorithm>
+#include <float.h>
+
+#include "scene_bvh.hpp"
+
+static inline bool isBogus(const float4 &bounds)
+{
+    return bounds.x > bounds.z || bounds.y > bounds.w;
+}
+
+static inline bool sameMatrix(const float4x4 &a, const float4x4 &b)
+{
+    for (int i=0; i<4; i++) {
+        if (any(a[i] != b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Records every shape along with the innermost transform above it.
+class ShapeBVH::Collector : public Visitor
+{
+public:
+    Collector(vector<Frame> &frames_, vector<Item> &items_, ShapeBVH *bvh_)
+        : frames(frames_)
+        , items(items_)
+        , bvh(bvh_)
+    {
+        frame_stack.push(-1);
+    }
+    void visit(ShapePtr shape) {
+        Item item = { shape, frame_stack.top() };
+        items.push_back(item);
+    }
+    void apply(TransformPtr transform) {
+        frames.push_back(Frame(bvh, transform, frame_stack.top()));
+        frame_stack.push(int(frames.size()-1));
+    }
+    void unapply(TransformPtr transform) {
+        frame_stack.pop();
+    }
+
+protected:
+    vector<Frame> &frames;
+    vector<Item> &items;
+    ShapeBVH *bvh;
+    stack<int> frame_stack;
+};
+
+ShapeBVH::Frame::Frame(ShapeBVH *bvh_, TransformPtr transform_, int parent_)
+    : bvh(bvh_)
+    , transform(transform_)
+    , parent(parent_)
+    , local(transform_->getMatrix())
+{
+    // Parents are always recorded before their children.
+    matrix = parent < 0 ? local : mul(bvh->frames[parent].matrix, local);
+}
+
+float4 ShapeBVH::Frame::computeBounds()
+{
+    if (parent >= 0) {
+        boundsOf(bvh->frames[parent]);
+    }
+    return float4(0,0,-1,-1);
+}
+
+// Root space bounds of a shape's ink and its control points, which may
+// lie outside its filled and stroked bounds.
+static float4 itemBounds(ShapePtr shape, const float4x4 *matrix)
+{
+    RectBounds bounds;
+    const float4 shape_bounds = shape->getInkBounds();
+    if (!isBogus(shape_bounds)) {
+        bounds = shape_bounds;
+    }
+    PathPtr path = shape->getPath();
+    if (path) {
+        const CanonicalPath &canonical = path->getCanonicalPath();
+        // Skip point[0], the implicit origin.
+        for (size_t i=1; i<canonical.point.size(); i++) {
+            bounds = bounds.include(canonical.point[i]);
+        }
+    }
+    if (bounds.isValid() && matrix) {
+        bounds = bounds.transform(*matrix);
+    }
+    return bounds.isValid() ? float4(bounds) : float4(0,0,-1,-1);
+}
+
+float4 ShapeBVH::Volume::computeBounds()
+{
+    if (item >= 0) {
+        const Item &it = bvh->items[item];
+        inkBoundsOf(*it.shape);
+        const float4x4 *matrix = NULL;
+        if (it.frame >= 0) {
+            Frame &frame = bvh->frames[it.frame];
+            boundsOf(frame);
+            matrix = &frame.matrix;
+        }
+        const float4 bounds = itemBounds(it.shape, matrix);
+        // Even unchanged bounds are damaged since what's inside them may
+        // have changed.
+        if (has_prior_bounds && !isBogus(prior_bounds)) {
+            bvh->damage |= prior_bounds;
+        }
+        if (has_prior_bounds && !isBogus(bounds)) {
+            bvh->damage |= bounds;
+        }
+        prior_bounds = bounds;
+        has_prior_bounds = true;
+        return bounds;
+    } else {
+        float4 a = boundsOf(bvh->volumes[left]),
+               b = boundsOf(bvh->volumes[right]);
+        if (isBogus(a)) {
+            return b;
+        }
+        if (isBogus(b)) {
+            return a;
+        }
+        return float4(min(a.xy, b.xy), max(a.zw, b.zw));
+    }
+}
+
+ShapeBVH::ShapeBVH(NodePtr root_)
+    : root(root_)
+{
+    ForEachShapeTraversal traversal;
+    root->traverse(VisitorPtr(new Collector(frames, items, this)), traversal);
+    if (items.size() == 0) {
+        return;
+    }
+
+    // Split on the centers of each shape's initial bounds; shapes with
+    // bogus bounds are never hit so their placement doesn't matter.
+    vector<float4> centers(items.size(), float4(0));
+    vector<int> order(items.size());
+    for (size_t i=0; i<items.size(); i++) {
+        const Item &it = items[i];
+        const float4 bounds = itemBounds(it.shape, it.frame >= 0 ? &frames[it.frame].matrix : NULL);
+        centers[i] = isBogus(bounds) ? float4(0) : float4((bounds.xy + bounds.zw)/2, 0, 0);
+        order[i] = int(i);
+    }
+
+    // A binary tree with one shape per leaf has 2n-1 volumes.  They're
+    // never reallocated since volumes point at each other.
+    volumes.resize(2*items.size()-1);
+    int next_volume = 0;
+    build(order, 0, order.size(), centers, next_volume);
+    volumes[0].getBounds();  // compute everything and record dependencies
+}
+
+namespace {
+struct CenterLess {
+    const vector<float4> &centers;
+    int axis;
+
+    CenterLess(const vector<float4> &c, int a) : centers(c), axis(a) {}
+    bool operator () (int a, int b) const {
+        return centers[a][axis] < centers[b][axis];
+    }
+};
+}
+
+// Builds the subtree for order[begin..end) by splitting at the median
+// center along the axis those centers spread over the most.
+int ShapeBVH::build(vector<int> &order, size_t begin, size_t end,
+                    const vector<float4> &centers, int &next_volume)
+{
+    const int ndx = next_volume++;
+    Volume &volume = volumes[ndx];
+    volume.bvh = this;
+    if (end - begin == 1) {
+        volume.item = order[begin];
+        return ndx;
+    }
+
+    float2 lo = float2(FLT_MAX), hi = float2(-FLT_MAX);
+    for (size_t i=begin; i<end; i++) {
+        lo = min(lo, centers[order[i]].xy);
+        hi = max(hi, centers[order[i]].xy);
+    }
+    const int axis = (hi.x - lo.x) >= (hi.y - lo.y) ? 0 : 1;
+    const size_t mid = (begin + end) / 2;
+    std::nth_element(order.begin()+begin, order.begin()+mid, order.begin()+end,
+                     CenterLess(centers, axis));
+
+    const int left = build(order, begin, mid, centers, next_volume);
+    const int right = build(order, mid, end, centers, next_volume);
+    volume.left = left;
+    volume.right = right;
+    return ndx;
+}
+
+// Transform nodes don't say when their matrix changes, so compare them
+// against the matrices the frames have; this costs one pass over the
+// transforms, not the shapes.
+void ShapeBVH::refreshFrames()
+{
+    vector<bool> changed(frames.size(), false);
+    for (size_t i=0; i<frames.size(); i++) {
+        Frame &frame = frames[i];
+        const float4x4 local = frame.transform->getMatrix();
+        if (!sameMatrix(local, frame.local)) {
+            frame.local = local;
+            changed[i] = true;
+        } else if (frame.parent >= 0 && changed[frame.parent]) {
+            changed[i] = true;
+        }
+        if (changed[i]) {
+            frame.matrix = frame.parent < 0 ? frame.local
+                                            : mul(frames[frame.parent].matrix, frame.local);
+            frame.invalidateBounds();
+        }
+    }
+}
+
+template <typename Overlaps>
+void ShapeBVH::query(const Overlaps &overlaps, vector<Hit> &hits)
+{
+    hits.clear();
+    if (volumes.size() == 0) {
+        return;
+    }
+    refreshFrames();
+
+    vector<int> found;
+    vector<int> todo;
+    todo.push_back(0);
+    while (todo.size() > 0) {
+        Volume &volume = volumes[todo.back()];
+        todo.pop_back();
+        const float4 bounds = volume.getBounds();  // refits dirty volumes
+        if (isBogus(bounds) || !overlaps(bounds)) {
+            continue;
+        }
+        if (volume.item >= 0) {
+            found.push_back(volume.item);
+        } else {
+            todo.push_back(volume.right);
+            todo.push_back(volume.left);
+        }
+    }
+
+    // Report in scene order, which picking relies on to break ties.
+    std::sort(found.begin(), found.end());
+    hits.resize(found.size());
+    for (size_t i=0; i<found.size(); i++) {
+        const Item &it = items[found[i]];
+        hits[i].shape = it.shape;
+        hits[i].matrix = it.frame >= 0 ? frames[it.frame].matrix : identity4x4();
+    }
+}
+
+RectBounds ShapeBVH::takeDamage()
+{
+    RectBounds taken;
+    if (volumes.size() > 0) {
+        refreshFrames();
+        volumes[0].getBounds();  // refit, recording damage
+        taken = damage;
+        damage.invalidate();
+    }
+    return taken;
+}
+
+namespace {
+struct PointOverlaps {
+    float2 p;
+    PointOverlaps(const float2 &p_) : p(p_) {}
+    bool operator () (const float4 &b) const {
+        return p.x >= b.x && p.x <= b.z && p.y >= b.y && p.y <= b.w;
+    }
+};
+
+struct RectOverlaps {
+    float4 r;
+    RectOverlaps(const float4 &r_) : r(r_) {}
+    bool operator () (const float4 &b) const {
+        return b.x <= r.z && r.x <= b.z && b.y <= r.w && r.y <= b.w;
+    }
+};
+}
+
+void ShapeBVH::shapesAt(const float2 &point, vector<Hit> &hits)
+{
+    query(PointOverlaps(point), hits);
+}
+
+void ShapeBVH::shapesIn(const float4 &rect, vector<Hit> &hits)
+{
+    query(RectOverlaps(rect), hits);
+}
@@ -0,0 +1,105 @@
+/* scene_bvh.hpp - bounding volume hierarchy over a scene's shapes */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __scene_bvh_hpp__
+#define __scene_bvh_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include <vector>
+
+#include "scene.hpp"
+
+// Answers "which shapes are under this point" and "which shapes touch this
+// rectangle" in the coordinate space of a scene's root node without visiting
+// every shape.  Each shape contributes the union of its ink bounds and its
+// path's control points, mapped by the transforms above it, so the hierarchy
+// serves both picking and damage tracking.
+//
+// The volumes are CachedBounds computed from their shapes' bounds, so a
+// Path::invalidate() dirties just the volumes above the edited shape and
+// the next query refits them.  Transform matrix changes are noticed by each
+// query comparing the scene's transform matrices against the ones the
+// hierarchy was built with.  Structural edits (adding or removing nodes)
+// need a new ShapeBVH.
+//
+// For damage tracking, every refit of a shape's volume records the
+// shape's bounds before and after; takeDamage() collects them.
+//
+// Shapes are visited in the order ForEachShapeTraversal visits them
+// (including clip paths) and results are always reported in that order.
+class ShapeBVH {
+public:
+    struct Hit {
+        ShapePtr shape;
+        float4x4 matrix;  // maps the shape's coordinates to the root's
+    };
+
+    ShapeBVH(NodePtr root);
+
+    void shapesAt(const float2 &point, vector<Hit> &hits);
+    void shapesIn(const float4 &rect, vector<Hit> &hits);
+
+    // Root space rectangle covering every shape whose bounds were
+    // invalidated since the last call (invalid if none were).
+    RectBounds takeDamage();
+
+    inline NodePtr getRoot() const { return root; }
+    inline size_t getShapeCount() const { return items.size(); }
+
+private:
+    // A transform node above some shapes; matrix maps to root space.
+    struct Frame : CachedBounds {
+        ShapeBVH *bvh;
+        TransformPtr transform;
+        int parent;
+        float4x4 local, matrix;
+
+        Frame(ShapeBVH *bvh_, TransformPtr transform_, int parent_);
+    protected:
+        // Frames have no bounds of their own; they're only CachedBounds
+        // so a matrix change can dirty every volume beneath them.
+        float4 computeBounds();
+    };
+
+    struct Item {
+        ShapePtr shape;
+        int frame;  // -1 means root space
+    };
+
+    struct Volume : CachedBounds {
+        ShapeBVH *bvh;
+        int item;         // leaves only, otherwise -1
+        int left, right;  // children of interior volumes
+        bool has_prior_bounds;  // leaves only
+        float4 prior_bounds;
+
+        Volume() : bvh(NULL), item(-1), left(-1), right(-1), has_prior_bounds(false) {}
+    protected:
+        float4 computeBounds();
+    };
+
+    class Collector;
+
+    NodePtr root;
+    vector<Frame> frames;
+    vector<Item> items;
+    vector<Volume> volumes;  // volumes[0] is the root volume
+    RectBounds damage;
+
+    int build(vector<int> &order, size_t begin, size_t end,
+              const vector<float4> &centers, int &next_volume);
+    void refreshFrames();
+    template <typename Overlaps>
+    void query(const Overlaps &overlaps, vector<Hit> &hits);
+
+    // Volumes point back at their ShapeBVH and each other.
+    ShapeBVH(const ShapeBVH &);
+    ShapeBVH & operator = (const ShapeBVH &);
+};
+typedef shared_ptr<ShapeBVH> ShapeBVHPtr;
+
+#endif // __scene_bvh_hpp__
@@ -0,0 +1,979 @@
+/* scene_cache.cpp - binary pre-parsed SVG scene cache */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "scene_cache.hpp"
+#include "scene_intern.hpp"
+#include "svg_loader.hpp"
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char cache_magic[8] = { 'N','V','S','C','E','N','E','\0' };
+const unsigned int cache_version = 2;
+const unsigned int cache_byte_order = 0x01020304;
+const unsigned int none = ~0U;
+
+enum SectionName {
+    NODES,     // unsigned int words of node records
+    PATHS,     // PathRecord
+    PAINTS,    // PaintRecord
+    STOPS,     // StopRecord
+    CMDS,      // char
+    FLOATS,    // float coordinates, dash arrays and arc parameters
+    SEGMENTS,  // CanonicalPath::Segment
+    POINTS,    // float2
+    SUBPATHS,  // SubpathRecord (CanonicalPath::Subpath has size_ts)
+    PIXELS,    // RasterImage::Pixel
+    STRINGS,   // char
+    NUM_SECTIONS
+};
+
+struct Section {
+    unsigned int offset;  // bytes from the start of the file
+    unsigned int count;   // records
+};
+
+struct Header {
+    char magic[8];
+    unsigned int version;
+    unsigned int byte_order;
+    unsigned int record_sizes;  // catches layout differences between builds
+    unsigned int root;          // node index of the SvgScene
+    float pixels_per_millimeter;  // svg_loader resolved physical units with this
+    unsigned long long svg_size, svg_mtime;  // of the SVG file when cached
+    Section section[NUM_SECTIONS];
+};
+
+struct PathRecord {
+    unsigned char do_fill, fill_rule, do_stroke, line_cap, line_join, dash_phase, pad[2];
+    float stroke_width, miter_limit, dash_offset;
+    unsigned int dash_first, dash_count;        // FLOATS
+    unsigned int cmd_first, cmd_count;          // CMDS
+    unsigned int coord_first, coord_count;      // FLOATS
+    unsigned int segment_first, segment_count;  // SEGMENTS
+    unsigned int point_first, point_count;      // POINTS
+    unsigned int arc_first, arc_count;          // FLOATS
+    unsigned int subpath_first, subpath_count;  // SUBPATHS
+    unsigned int num_drawing_segments;
+};
+
+enum PaintType {
+    SOLID_COLOR_PAINT,
+    LINEAR_GRADIENT_PAINT,
+    RADIAL_GRADIENT_PAINT,
+    IMAGE_PAINT
+};
+
+struct PaintRecord {
+    unsigned int type;
+    float color[4];                  // solid color
+    unsigned int gradient_units, spread_method;
+    float gradient_transform[9];     // row major
+    unsigned int stop_first, stop_count;
+    float v[5];                      // linear: v1, v2; radial: center, focal point, radius
+    unsigned int width, height, pixel_first;  // image
+};
+
+struct SubpathRecord {
+    unsigned int first_segment, first_point;
+};
+
+struct StopRecord {
+    float offset;
+    float color[4];
+};
+
+enum NodeTag {
+    SHAPE_NODE,      // path, fill paint, stroke paint, net fill opacity, net stroke opacity
+    TRANSFORM_NODE,  // child, 16 matrix floats
+    WARP_TRANSFORM_NODE,  // child, 4 "to" and 4 "from" float pairs, scale float pair
+    CLIP_NODE,       // path node, child, clip merge
+    GROUP_NODE,      // child count, children
+    SVG_SCENE_NODE,  // width, height, view box valid, 4 view box floats,
+                     // string first, string length, child count, children
+    TEXT_NODE
+};
+
+inline unsigned int recordSizes()
+{
+    return unsigned(sizeof(PathRecord)) << 24 |
+           unsigned(sizeof(PaintRecord)) << 16 |
+           unsigned(sizeof(CanonicalPath::Segment)) << 8 |
+           unsigned(sizeof(float2) + sizeof(RasterImage::Pixel));
+}
+
+inline unsigned int floatBits(float f)
+{
+    unsigned int u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline float bitsFloat(unsigned int u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Coordinates a path command takes, or -1 if it isn't one.
+inline int commandCoordCount(char c)
+{
+    switch (c) {
+    case 'Z':
+    case 'z':
+        return 0;
+    case 'H':
+    case 'h':
+    case 'V':
+    case 'v':
+        return 1;
+    case 'M':
+    case 'm':
+    case 'L':
+    case 'l':
+    case 'T':
+    case 't':
+        return 2;
+    case 'Q':
+    case 'q':
+    case 'S':
+    case 's':
+        return 4;
+    case 'C':
+    case 'c':
+        return 6;
+    case 'A':
+    case 'a':
+        return 7;
+    default:
+        return -1;
+    }
+}
+
+template <typename T>
+inline unsigned int append(vector<T> &dst, const T *src, size_t count)
+{
+    const unsigned int first = unsigned(dst.size());
+    dst.insert(dst.end(), src, src+count);
+    return first;
+}
+
+template <typename T>
+inline unsigned int append(vector<T> &dst, const vector<T> &src)
+{
+    const unsigned int first = unsigned(dst.size());
+    dst.insert(dst.end(), src.begin(), src.end());
+    return first;
+}
+
+class SceneCacheWriter {
+public:
+    vector<unsigned int> nodes;
+    vector<PathRecord> paths;
+    vector<PaintRecord> paints;
+    vector<StopRecord> stops;
+    vector<char> cmds;
+    vector<float> floats;
+    vector<CanonicalPath::Segment> segments;
+    vector<float2> points;
+    vector<SubpathRecord> subpaths;
+    vector<RasterImage::Pixel> pixels;
+    vector<char> strings;
+
+    bool ok;
+
+    SceneCacheWriter() : ok(true), node_count(0) {}
+
+    unsigned int writeNode(NodePtr node);
+    bool writeFile(const char *filename, unsigned int root, const struct stat &svg_stat);
+
+private:
+    unsigned int node_count;
+    map<Node*,unsigned int> node_index;
+    map<Path*,unsigned int> path_index;
+    map<Paint*,unsigned int> paint_index;
+    map<const vector<GradientStop>*,unsigned int> stops_index;
+
+    unsigned int writePath(PathPtr path);
+    unsigned int writePaint(PaintPtr paint);
+    void writeGradient(GradientPaintPtr gradient, PaintRecord &record);
+    unsigned int writeChildren(const vector<NodePtr> &list, vector<unsigned int> &children);
+
+    template <typename T>
+    void put(const T &word) { nodes.push_back(unsigned(word)); }
+    void putFloat(float f) { nodes.push_back(floatBits(f)); }
+    void putFloat2(const float2 &v) { putFloat(v.x); putFloat(v.y); }
+
+    void fail(const char *why) {
+        if (ok) {
+            printf("scene cache: %s\n", why);
+        }
+        ok = false;
+    }
+};
+
+unsigned int SceneCacheWriter::writePath(PathPtr path)
+{
+    map<Path*,unsigned int>::iterator it = path_index.find(path.get());
+    if (it != path_index.end()) {
+        return it->second;
+    }
+
+    PathRecord r;
+    memset(&r, 0, sizeof(r));
+    const PathStyle &style = *path->style;
+    r.do_fill = style.do_fill;
+    r.fill_rule = style.fill_rule;
+    r.do_stroke = style.do_stroke;
+    r.line_cap = style.line_cap;
+    r.line_join = style.line_join;
+    r.dash_phase = style.dash_phase;
+    r.stroke_width = style.stroke_width;
+    r.miter_limit = style.miter_limit;
+    r.dash_offset = style.dash_offset;
+    r.dash_count = unsigned(style.dash_array.size());
+    r.dash_first = append(floats, style.dash_array);
+    r.cmd_count = unsigned(path->cmd.size());
+    r.cmd_first = append(cmds, path->cmd);
+    r.coord_count = unsigned(path->coord.size());
+    r.coord_first = append(floats, path->coord);
+
+    const CanonicalPath &canonical = path->getCanonicalPath();
+    r.segment_count = unsigned(canonical.segment.size());
+    r.segment_first = append(segments, canonical.segment);
+    r.point_count = unsigned(canonical.point.size());
+    r.point_first = append(points, canonical.point);
+    r.arc_count = unsigned(canonical.arc_param.size());
+    r.arc_first = append(floats, canonical.arc_param);
+    r.subpath_count = unsigned(canonical.subpath.size());
+    r.subpath_first = unsigned(subpaths.size());
+    for (size_t i=0; i<canonical.subpath.size(); i++) {
+        SubpathRecord sp = { unsigned(canonical.subpath[i].first_segment),
+                             unsigned(canonical.subpath[i].first_point) };
+        subpaths.push_back(sp);
+    }
+    r.num_drawing_segments = unsigned(canonical.num_drawing_segments);
+
+    const unsigned int ndx = unsigned(paths.size());
+    paths.push_back(r);
+    path_index[path.get()] = ndx;
+    return ndx;
+}
+
+void SceneCacheWriter::writeGradient(GradientPaintPtr gradient, PaintRecord &r)
+{
+    r.gradient_units = gradient->getGradientUnits();
+    r.spread_method = gradient->getSpreadMethod();
+    const float3x3 &m = gradient->getGradientTransform();
+    for (int i=0; i<3; i++) {
+        for (int j=0; j<3; j++) {
+            r.gradient_transform[3*i+j] = m[i][j];
+        }
+    }
+    const vector<GradientStop> &stop_array = gradient->getStopArray();
+    r.stop_count = unsigned(stop_array.size());
+    // Paints share their stops through a GradientStopsPtr so share them
+    // in the cache too.
+    const vector<GradientStop> *key = &stop_array;
+    map<const vector<GradientStop>*,unsigned int>::iterator it = stops_index.find(key);
+    if (it != stops_index.end()) {
+        r.stop_first = it->second;
+    } else {
+        r.stop_first = unsigned(stops.size());
+        for (size_t i=0; i<stop_array.size(); i++) {
+            StopRecord s;
+            s.offset = stop_array[i].offset;
+            for (int j=0; j<4; j++) {
+                s.color[j] = stop_array[i].color[j];
+            }
+            stops.push_back(s);
+        }
+        stops_index[key] = r.stop_first;
+    }
+}
+
+unsigned int SceneCacheWriter::writePaint(PaintPtr paint)
+{
+    if (!paint) {
+        return none;
+    }
+    map<Paint*,unsigned int>::iterator it = paint_index.find(paint.get());
+    if (it != paint_index.end()) {
+        return it->second;
+    }
+
+    PaintRecord r;
+    memset(&r, 0, sizeof(r));
+    if (SolidColorPaintPtr solid = dynamic_pointer_cast<SolidColorPaint>(paint)) {
+        r.type = SOLID_COLOR_PAINT;
+        const float4 color = solid->getColor();
+        for (int i=0; i<4; i++) {
+            r.color[i] = color[i];
+        }
+    } else if (LinearGradientPaintPtr linear = dynamic_pointer_cast<LinearGradientPaint>(paint)) {
+        r.type = LINEAR_GRADIENT_PAINT;
+        writeGradient(linear, r);
+        const float2 v1 = linear->getV1(),
+                     v2 = linear->getV2();
+        r.v[0] = v1.x;
+        r.v[1] = v1.y;
+        r.v[2] = v2.x;
+        r.v[3] = v2.y;
+    } else if (RadialGradientPaintPtr radial = dynamic_pointer_cast<RadialGradientPaint>(paint)) {
+        r.type = RADIAL_GRADIENT_PAINT;
+        writeGradient(radial, r);
+        const float2 c = radial->getCenter(),
+                     f = radial->getFocalPoint();
+        r.v[0] = c.x;
+        r.v[1] = c.y;
+        r.v[2] = f.x;
+        r.v[3] = f.y;
+        r.v[4] = radial->getRadius();
+    } else if (ImagePaintPtr image = dynamic_pointer_cast<ImagePaint>(paint)) {
+        r.type = IMAGE_PAINT;
+        r.width = image->image->width;
+        r.height = image->image->height;
+        r.pixel_first = append(pixels, image->image->pixels, size_t(r.width)*r.height);
+    } else {
+        fail("unknown paint type");
+        return none;
+    }
+
+    const unsigned int ndx = unsigned(paints.size());
+    paints.push_back(r);
+    paint_index[paint.get()] = ndx;
+    return ndx;
+}
+
+unsigned int SceneCacheWriter::writeChildren(const vector<NodePtr> &list, vector<unsigned int> &children)
+{
+    children.resize(list.size());
+    for (size_t i=0; i<list.size(); i++) {
+        children[i] = writeNode(list[i]);
+    }
+    return unsigned(children.size());
+}
+
+// Nodes are written after their children so loading can build each
+// node from nodes already built; shared nodes are written once.
+unsigned int SceneCacheWriter::writeNode(NodePtr node)
+{
+    if (!node) {
+        fail("null node");  // the reader would reject it
+        return none;
+    }
+    map<Node*,unsigned int>::iterator it = node_index.find(node.get());
+    if (it != node_index.end()) {
+        return it->second;
+    }
+
+    if (ShapePtr shape = dynamic_pointer_cast<Shape>(node)) {
+        const unsigned int path = writePath(shape->getPath()),
+                           fill = writePaint(shape->getFillPaint()),
+                           stroke = writePaint(shape->getStrokePaint());
+        put(SHAPE_NODE);
+        put(path);
+        put(fill);
+        put(stroke);
+        putFloat(shape->net_fill_opacity);
+        putFloat(shape->net_stroke_opacity);
+    } else if (WarpTransformPtr warp = dynamic_pointer_cast<WarpTransform>(node)) {
+        // Its matrix follows from the quadrilaterals and scale.
+        const unsigned int child = writeNode(warp->node);
+        put(WARP_TRANSFORM_NODE);
+        put(child);
+        for (int i=0; i<4; i++) {
+            putFloat2(warp->getTo()[i]);
+        }
+        for (int i=0; i<4; i++) {
+            putFloat2(warp->getFrom()[i]);
+        }
+        putFloat2(warp->getScale());
+    } else if (TransformPtr transform = dynamic_pointer_cast<Transform>(node)) {
+        const unsigned int child = writeNode(transform->node);
+        const float4x4 m = transform->getMatrix();
+        put(TRANSFORM_NODE);
+        put(child);
+        for (int i=0; i<4; i++) {
+            for (int j=0; j<4; j++) {
+                putFloat(m[i][j]);
+            }
+        }
+    } else if (ClipPtr clip = dynamic_pointer_cast<Clip>(node)) {
+        const unsigned int path = writeNode(clip->path),
+                           child = writeNode(clip->node);
+        put(CLIP_NODE);
+        put(path);
+        put(child);
+        put(clip->clip_merge);
+    } else if (SvgScenePtr svg = dynamic_pointer_cast<SvgScene>(node)) {
+        vector<unsigned int> children;
+        writeChildren(svg->list, children);
+        put(SVG_SCENE_NODE);
+        put(svg->width);
+        put(svg->height);
+        put(svg->view_box.isValid());
+        for (int i=0; i<4; i++) {
+            // An invalid view box's coordinates are uninitialized.
+            putFloat(svg->view_box.isValid() ? svg->view_box[i] : 0);
+        }
+        const string &par = svg->preserve_aspect_ratio;
+        put(append(strings, par.c_str(), par.length()));
+        put(par.length());
+        put(children.size());
+        nodes.insert(nodes.end(), children.begin(), children.end());
+    } else if (GroupPtr group = dynamic_pointer_cast<Group>(node)) {
+        vector<unsigned int> children;
+        writeChildren(group->list, children);
+        put(GROUP_NODE);
+        put(children.size());
+        nodes.insert(nodes.end(), children.begin(), children.end());
+    } else if (dynamic_pointer_cast<Text>(node)) {
+        put(TEXT_NODE);
+    } else {
+        fail("unknown node type");
+        return none;
+    }
+
+    const unsigned int ndx = node_count++;
+    node_index[node.get()] = ndx;
+    return ndx;
+}
+
+template <typename T>
+static void writeSection(FILE *file, Section &section, const vector<T> &v, unsigned int count)
+{
+    long offset = ftell(file);
+    static const char zeros[16] = { 0 };
+    fwrite(zeros, 1, (16 - offset%16) % 16, file);
+    section.offset = unsigned(ftell(file));
+    section.count = count;
+    if (v.size() > 0) {
+        fwrite(&v[0], sizeof(T), v.size(), file);
+    }
+}
+
+bool SceneCacheWriter::writeFile(const char *filename, unsigned int root, const struct stat &svg_stat)
+{
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("scene cache: can't write %s\n", filename);
+        return false;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cache_magic, sizeof(header.magic));
+    header.version = cache_version;
+    header.byte_order = cache_byte_order;
+    header.record_sizes = recordSizes();
+    header.root = root;
+    header.pixels_per_millimeter = pixels_per_millimeter;
+    header.svg_size = svg_stat.st_size;
+    header.svg_mtime = svg_stat.st_mtime;
+    fwrite(&header, sizeof(header), 1, file);
+
+    // Node records are variable length; count their words.
+    writeSection(file, header.section[NODES], nodes, unsigned(nodes.size()));
+    writeSection(file, header.section[PATHS], paths, unsigned(paths.size()));
+    writeSection(file, header.section[PAINTS], paints, unsigned(paints.size()));
+    writeSection(file, header.section[STOPS], stops, unsigned(stops.size()));
+    writeSection(file, header.section[CMDS], cmds, unsigned(cmds.size()));
+    writeSection(file, header.section[FLOATS], floats, unsigned(floats.size()));
+    writeSection(file, header.section[SEGMENTS], segments, unsigned(segments.size()));
+    writeSection(file, header.section[POINTS], points, unsigned(points.size()));
+    writeSection(file, header.section[SUBPATHS], subpaths, unsigned(subpaths.size()));
+    writeSection(file, header.section[PIXELS], pixels, unsigned(pixels.size()));
+    writeSection(file, header.section[STRINGS], strings, unsigned(strings.size()));
+
+    // Now the section table is known, rewrite the header.
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    const bool wrote = !ferror(file);
+    fclose(file);
+    if (!wrote) {
+        printf("scene cache: error writing %s\n", filename);
+    }
+    return wrote;
+}
+
+class SceneCacheReader {
+public:
+    SceneCacheReader(const vector<char> &buffer_, float pixels_per_millimeter_)
+        : buffer(buffer_)
+        , pixels_per_millimeter(pixels_per_millimeter_)
+        , ok(true)
+    {}
+
+    SvgScenePtr read();
+
+private:
+    const vector<char> &buffer;
+    const float pixels_per_millimeter;
+    const Header *header;
+    bool ok;
+
+    vector<NodePtr> node;
+    vector<PathPtr> paths;
+    vector<PaintPtr> paints;
+    map<unsigned int,GradientStopsPtr> stops;
+    SceneInterner interner;  // path records each hold their own style
+
+    // Checked pointer to records [first, first+count) of a section.
+    template <typename T>
+    const T *array(SectionName name, unsigned int first, size_t count) {
+        const Section &s = header->section[name];
+        if (first > s.count || count > s.count - first) {
+            ok = false;
+            return NULL;
+        }
+        return reinterpret_cast<const T*>(&buffer[0] + s.offset) + first;
+    }
+
+    PathPtr readPath(unsigned int ndx);
+    PaintPtr readPaint(unsigned int ndx);
+    void readGradient(GradientPaintPtr gradient, const PaintRecord &r);
+    // Every child reference is required: traversals never expect a null
+    // child, so none, a forward reference or a node that failed to load
+    // makes the whole cache invalid.
+    NodePtr nodeAt(unsigned int ndx) {
+        if (ndx >= node.size() || !node[ndx]) {
+            ok = false;
+            return NodePtr();
+        }
+        return node[ndx];
+    }
+};
+
+// Renderers index coord, point and arc_param by walking cmd and the
+// canonical segments without checking, so a path record's arrays must
+// agree with each other as well as fit their sections.
+static bool consistentPath(const PathRecord &r, const char *cmd,
+                           const CanonicalPath::Segment *segment, const SubpathRecord *subpath)
+{
+    size_t coords = 0;
+    for (unsigned int i=0; i<r.cmd_count; i++) {
+        const int count = commandCoordCount(cmd[i]);
+        if (count < 0) {
+            return false;
+        }
+        coords += count;
+    }
+    if (coords != r.coord_count) {
+        return false;
+    }
+
+    size_t points = 1,  // the initial (0,0) current point
+           arcs = 0,
+           drawing_segments = 0;
+    for (unsigned int i=0; i<r.segment_count; i++) {
+        const CanonicalPath::Segment &s = segment[i];
+        const int count = commandCoordCount(s.cmd);
+        if (count < 0 || size_t(s.coord_index) + count > r.coord_count) {
+            return false;
+        }
+        switch (s.type) {
+        case 'A':
+            arcs++;
+            // fall through
+        case 'L':
+        case 'Q':
+        case 'C':
+            drawing_segments++;
+            // fall through
+        case 'M':
+        case 'Z':
+            break;
+        default:
+            return false;
+        }
+        points += CanonicalPath::pointCount(s.type);
+    }
+    if (points != r.point_count || 5*arcs != r.arc_count ||
+        drawing_segments != r.num_drawing_segments) {
+        return false;
+    }
+
+    for (unsigned int i=0; i<r.subpath_count; i++) {
+        if (subpath[i].first_segment >= r.segment_count ||
+            segment[subpath[i].first_segment].type != 'M' ||
+            subpath[i].first_point >= r.point_count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PathPtr SceneCacheReader::readPath(unsigned int ndx)
+{
+    const PathRecord *r = array<PathRecord>(PATHS, ndx, 1);
+    if (!r) {
+        return PathPtr();
+    }
+    if (paths[ndx]) {
+        return paths[ndx];
+    }
+
+    PathStyle style;
+    style.do_fill = r->do_fill != 0;
+    style.fill_rule = PathStyle::FillRule(r->fill_rule);
+    style.do_stroke = r->do_stroke != 0;
+    style.stroke_width = r->stroke_width;
+    style.line_cap = PathStyle::LineCap(r->line_cap);
+    style.line_join = PathStyle::LineJoin(r->line_join);
+    style.miter_limit = r->miter_limit;
+    style.dash_offset = r->dash_offset;
+    style.dash_phase = PathStyle::DashPhase(r->dash_phase);
+
+    const float *dash = array<float>(FLOATS, r->dash_first, r->dash_count);
+    const char *cmd = array<char>(CMDS, r->cmd_first, r->cmd_count);
+    const float *coord = array<float>(FLOATS, r->coord_first, r->coord_count);
+    const CanonicalPath::Segment *segment =
+        array<CanonicalPath::Segment>(SEGMENTS, r->segment_first, r->segment_count);
+    const float2 *point = array<float2>(POINTS, r->point_first, r->point_count);
+    const float *arc_param = array<float>(FLOATS, r->arc_first, r->arc_count);
+    const SubpathRecord *subpath = array<SubpathRecord>(SUBPATHS, r->subpath_first, r->subpath_count);
+    if (!ok || !consistentPath(*r, cmd, segment, subpath)) {
+        ok = false;
+        return PathPtr();
+    }
+
+    style.dash_array.assign(dash, dash + r->dash_count);
+    PathPtr path(new Path(interner.intern(style), vector<char>(cmd, cmd + r->cmd_count),
+                                 vector<float>(coord, coord + r->coord_count)));
+
+    CanonicalPath canonical;
+    canonical.segment.assign(segment, segment + r->segment_count);
+    canonical.point.assign(point, point + r->point_count);
+    canonical.arc_param.assign(arc_param, arc_param + r->arc_count);
+    canonical.subpath.resize(r->subpath_count);
+    for (size_t i=0; i<r->subpath_count; i++) {
+        canonical.subpath[i].first_segment = subpath[i].first_segment;
+        canonical.subpath[i].first_point = subpath[i].first_point;
+    }
+    canonical.num_drawing_segments = r->num_drawing_segments;
+    path->setCanonicalPath(canonical);
+
+    paths[ndx] = path;
+    return path;
+}
+
+void SceneCacheReader::readGradient(GradientPaintPtr gradient, const PaintRecord &r)
+{
+    gradient->setGradientUnits(GradientUnits(r.gradient_units));
+    gradient->setSpreadMethod(SpreadMethod(r.spread_method));
+    const float *m = r.gradient_transform;
+    gradient->setGradientTransform(float3x3(m[0], m[1], m[2],
+                                            m[3], m[4], m[5],
+                                            m[6], m[7], m[8]));
+    GradientStopsPtr &shared_stops = stops[r.stop_first];
+    if (!shared_stops) {
+        const StopRecord *s = array<StopRecord>(STOPS, r.stop_first, r.stop_count);
+        if (!s) {
+            return;
+        }
+        shared_stops = GradientStopsPtr(new GradientStops);
+        shared_stops->stop_array.resize(r.stop_count);
+        for (size_t i=0; i<r.stop_count; i++) {
+            GradientStop &stop = shared_stops->stop_array[i];
+            stop.offset = s[i].offset;
+            stop.color = float4(s[i].color[0], s[i].color[1], s[i].color[2], s[i].color[3]);
+        }
+    }
+    gradient->setGradientStops(shared_stops);
+}
+
+PaintPtr SceneCacheReader::readPaint(unsigned int ndx)
+{
+    if (ndx == none) {
+        return PaintPtr();
+    }
+    const PaintRecord *r = array<PaintRecord>(PAINTS, ndx, 1);
+    if (!r) {
+        return PaintPtr();
+    }
+    if (paints[ndx]) {
+        return paints[ndx];
+    }
+
+    PaintPtr paint;
+    switch (r->type) {
+    case SOLID_COLOR_PAINT:
+        paint = SolidColorPaintPtr(new SolidColorPaint(
+            float4(r->color[0], r->color[1], r->color[2], r->color[3])));
+        break;
+    case LINEAR_GRADIENT_PAINT:
+        {
+            LinearGradientPaintPtr linear(new LinearGradientPaint(
+                float2(r->v[0], r->v[1]), float2(r->v[2], r->v[3])));
+            readGradient(linear, *r);
+            paint = linear;
+        }
+        break;
+    case RADIAL_GRADIENT_PAINT:
+        {
+            RadialGradientPaintPtr radial(new RadialGradientPaint(
+                float2(r->v[0], r->v[1]), float2(r->v[2], r->v[3]), r->v[4]));
+            readGradient(radial, *r);
+            paint = radial;
+        }
+        break;
+    case IMAGE_PAINT:
+        {
+            const size_t count = size_t(r->width)*r->height;
+            const RasterImage::Pixel *src = array<RasterImage::Pixel>(PIXELS, r->pixel_first, count);
+            if (!src) {
+                return PaintPtr();
+            }
+            // RasterImage frees its pixels.
+            RasterImage::Pixel *pixels = (RasterImage::Pixel*) malloc(count*sizeof(RasterImage::Pixel));
+            memcpy(pixels, src, count*sizeof(RasterImage::Pixel));
+            RasterImagePtr image(new RasterImage(pixels, r->width, r->height));
+            paint = ImagePaintPtr(new ImagePaint(image));
+        }
+        break;
+    default:
+        ok = false;
+        return PaintPtr();
+    }
+    paints[ndx] = interner.intern(paint);
+    return paints[ndx];
+}
+
+SvgScenePtr SceneCacheReader::read()
+{
+    if (buffer.size() < sizeof(Header)) {
+        return SvgScenePtr();
+    }
+    header = reinterpret_cast<const Header*>(&buffer[0]);
+    if (memcmp(header->magic, cache_magic, sizeof(cache_magic)) ||
+        header->version != cache_version ||
+        header->byte_order != cache_byte_order ||
+        header->record_sizes != recordSizes() ||
+        header->pixels_per_millimeter != pixels_per_millimeter) {
+        return SvgScenePtr();
+    }
+    static const size_t record_size[NUM_SECTIONS] = {
+        sizeof(unsigned int), sizeof(PathRecord), sizeof(PaintRecord), sizeof(StopRecord),
+        sizeof(char), sizeof(float), sizeof(CanonicalPath::Segment), sizeof(float2),
+        sizeof(SubpathRecord), sizeof(RasterImage::Pixel), sizeof(char)
+    };
+    for (int i=0; i<NUM_SECTIONS; i++) {
+        const Section &s = header->section[i];
+        if (s.offset % 16 || s.offset > buffer.size() ||
+            s.count > (buffer.size() - s.offset) / record_size[i]) {
+            return SvgScenePtr();
+        }
+    }
+    paths.assign(header->section[PATHS].count, PathPtr());
+    paints.assign(header->section[PAINTS].count, PaintPtr());
+
+    const unsigned int *word = array<unsigned int>(NODES, 0, header->section[NODES].count);
+    const unsigned int *end = word + header->section[NODES].count;
+    SvgScenePtr scene;
+    // Every record is at least a tag, and its fixed-size fields are
+    // checked before being read.
+#define NEED(n) if (end - word < (n)) { ok = false; break; }
+    while (ok && word < end) {
+        NodePtr n;
+        switch (*word) {
+        case SHAPE_NODE:
+            {
+                NEED(6);
+                ShapePtr shape(new Shape(readPath(word[1]), readPaint(word[2]), readPaint(word[3])));
+                shape->net_fill_opacity = bitsFloat(word[4]);
+                shape->net_stroke_opacity = bitsFloat(word[5]);
+                if (!shape->getPath()) {
+                    ok = false;
+                }
+                n = shape;
+                word += 6;
+            }
+            break;
+        case TRANSFORM_NODE:
+            {
+                NEED(18);
+                float4x4 m;
+                for (int i=0; i<4; i++) {
+                    for (int j=0; j<4; j++) {
+                        m[i][j] = bitsFloat(word[2+4*i+j]);
+                    }
+                }
+                n = TransformPtr(new Transform(nodeAt(word[1]), m));
+                word += 18;
+            }
+            break;
+        case WARP_TRANSFORM_NODE:
+            {
+                NEED(20);
+                float2 to[4], from[4];
+                for (int i=0; i<4; i++) {
+                    to[i] = float2(bitsFloat(word[2+2*i]), bitsFloat(word[3+2*i]));
+                    from[i] = float2(bitsFloat(word[10+2*i]), bitsFloat(word[11+2*i]));
+                }
+                const float2 scale = float2(bitsFloat(word[18]), bitsFloat(word[19]));
+                n = WarpTransformPtr(new WarpTransform(nodeAt(word[1]), to, from, scale));
+                word += 20;
+            }
+            break;
+        case CLIP_NODE:
+            NEED(4);
+            if (word[3] > CLIP_COVERAGE_UNION) {
+                ok = false;
+                break;
+            }
+            n = ClipPtr(new Clip(nodeAt(word[1]), nodeAt(word[2]), ClipMerge(word[3])));
+            word += 4;
+            break;
+        case GROUP_NODE:
+        case SVG_SCENE_NODE:
+            {
+                GroupPtr group;
+                if (*word == SVG_SCENE_NODE) {
+                    NEED(11);
+                    SvgScenePtr svg(new SvgScene);
+                    svg->width = int(word[1]);
+                    svg->height = int(word[2]);
+                    svg->view_box = RectBounds(bitsFloat(word[4]), bitsFloat(word[5]),
+                                               bitsFloat(word[6]), bitsFloat(word[7]));
+                    if (!word[3]) {
+                        svg->view_box.invalidate();
+                    }
+                    const char *par = array<char>(STRINGS, word[8], word[9]);
+                    if (par) {
+                        svg->preserve_aspect_ratio.assign(par, word[9]);
+                    }
+                    scene = svg;
+                    group = svg;
+                    word += 10;
+                } else {
+                    NEED(2);
+                    group = GroupPtr(new Group);
+                    word += 1;
+                }
+                const unsigned int count = *word++;
+                NEED(count);
+                group->list.resize(count);
+                for (unsigned int i=0; i<count; i++) {
+                    group->list[i] = nodeAt(word[i]);
+                }
+                word += count;
+                n = group;
+            }
+            break;
+        case TEXT_NODE:
+            n = TextPtr(new Text());
+            word += 1;
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        node.push_back(n);
+    }
+#undef NEED
+
+    if (!ok || header->root >= node.size()) {
+        return SvgScenePtr();
+    }
+    return dynamic_pointer_cast<SvgScene>(node[header->root]);
+}
+
+} // namespace
+
+string sceneCacheName(const char *svg_filename)
+{
+    return string(svg_filename) + ".nvsc";
+}
+
+bool saveSceneCache(SvgScenePtr scene, const char *svg_filename)
+{
+    struct stat svg_stat;
+    if (stat(svg_filename, &svg_stat)) {
+        printf("scene cache: can't find %s\n", svg_filename);
+        return false;
+    }
+    SceneCacheWriter writer;
+    const unsigned int root = writer.writeNode(scene);
+    if (!writer.ok) {
+        return false;
+    }
+    return writer.writeFile(sceneCacheName(svg_filename).c_str(), root, svg_stat);
+}
+
+SvgScenePtr loadSceneCache(const char *cache_filename)
+{
+    return loadSceneCache(cache_filename, pixels_per_millimeter);
+}
+
+SvgScenePtr loadSceneCache(const char *cache_filename, float pixels_per_millimeter)
+{
+    FILE *file = fopen(cache_filename, "rb");
+    if (!file) {
+        return SvgScenePtr();
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    vector<char> buffer(size > 0 ? size : 0);
+    const bool read = size > 0 && fread(&buffer[0], 1, size, file) == size_t(size);
+    fclose(file);
+    if (!read) {
+        return SvgScenePtr();
+    }
+
+    SceneCacheReader reader(buffer, pixels_per_millimeter);
+    SvgScenePtr scene = reader.read();
+    if (!scene) {
+        printf("scene cache: ignoring bad or outdated %s\n", cache_filename);
+    }
+    return scene;
+}
+
+bool sceneCacheIsCurrent(const char *svg_filename)
+{
+    struct stat svg_stat;
+    if (stat(svg_filename, &svg_stat)) {
+        return false;
+    }
+    FILE *file = fopen(sceneCacheName(svg_filename).c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    Header header;
+    const bool read = fread(&header, sizeof(header), 1, file) == 1;
+    fclose(file);
+    // As with rasterImageFileKey, the size catches most edits within the
+    // modification time's resolution, and copies of older files.
+    return read &&
+           !memcmp(header.magic, cache_magic, sizeof(cache_magic)) &&
+           header.version == cache_version &&
+           header.svg_size == (unsigned long long)svg_stat.st_size &&
+           header.svg_mtime == (unsigned long long)svg_stat.st_mtime;
+}
+
+SvgScenePtr svg_loader_cached(const char *svg_filename, float pixels_per_millimeter, bool streaming)
+{
+    if (sceneCacheIsCurrent(svg_filename)) {
+        SvgScenePtr scene = loadSceneCache(sceneCacheName(svg_filename).c_str(), pixels_per_millimeter);
+        if (scene) {
+            return scene;
+        }
+    }
+    return streaming ? svg_stream_loader(svg_filename, pixels_per_millimeter)
+                     : svg_loader(svg_filename, pixels_per_millimeter);
+}
@@ -0,0 +1,52 @@
+/* scene_cache.hpp - binary pre-parsed SVG scene cache */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __scene_cache_hpp__
+#define __scene_cache_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include <string>
+
+#include "scene.hpp"
+
+// A scene cache holds an SvgScene as svg_loader built it: the node graph,
+// path styles, path commands and coordinates with their canonical forms,
+// and flattened paints.  Loading one skips XML, style and path data parsing.
+//
+// The file is a header followed by 16-byte aligned arrays of fixed layout
+// records that are read in one gulp (or could be mapped) and then copied
+// straight into the scene's Path vectors.  Caches are for the machine that
+// wrote them; a different format version, record layout or screen
+// resolution (for physical units) fails to load.
+
+// The cache file for an SVG file is its name with ".nvsc" appended.
+extern std::string sceneCacheName(const char *svg_filename);
+
+// Writes the SVG file's scene to its cache, recording the SVG file's size
+// and modification time.  Returns false (after explaining why) if the
+// scene holds node or paint types the cache can't represent or the file
+// can't be written.
+extern bool saveSceneCache(SvgScenePtr scene, const char *svg_filename);
+
+// Returns NULL if the file is missing, malformed (down to path data and
+// canonical forms that disagree) or written by a different version or
+// build or for a different pixels_per_millimeter (the global one unless
+// given).
+extern SvgScenePtr loadSceneCache(const char *cache_filename);
+extern SvgScenePtr loadSceneCache(const char *cache_filename, float pixels_per_millimeter);
+
+// Was the SVG file's cache written for the SVG file's current size and
+// modification time?
+extern bool sceneCacheIsCurrent(const char *svg_filename);
+
+// Loads the SVG file's current cache if it has one, else the SVG file
+// (with svg_stream_loader if streaming).  Safe to call from several
+// threads at once.
+extern SvgScenePtr svg_loader_cached(const char *svg_filename, float pixels_per_millimeter,
+                                     bool streaming = false);
+
+#endif // __scene_cache_hpp__
@@ -0,0 +1,228 @@
+/* scene_gl.cpp - OpenGL drawing of control points for the GL window */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+// Kept apart from path_process.cpp and scene.cpp so programs without a
+// GL window, like svg_render, link the scene without OpenGL.
+
+#include "nvpr_svg_config.h"  // configure path renderers to use
+
+#include "scene.hpp"
+#include "path.hpp"
+
+#include <Cg/mul.hpp>
+
+#define lerp(a,b,t) ((a) + (t)*((b)-(a)))
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+using namespace Cg;
+
+struct DrawControlPointProcessor : PathSegmentProcessor {
+    void beginPath(PathPtr p) { }
+    void moveTo(const float2 p[2], size_t coord_index, char cmd) {
+        glColor3f(1,1,0.66f);  // ???
+        glVertex2f(p[1].x, p[1].y);
+    };
+    void lineTo(const float2 p[2], size_t coord_index, char cmd) {
+        glColor3f(0,0,1);  // blue
+        glVertex2f(p[1].x, p[1].y);
+    }
+    void quadraticCurveTo(const float2 p[3], size_t coord_index, char cmd) {
+        glColor3f(0,1,1);  // cyan
+        glVertex2f(p[1].x, p[1].y);
+        glColor3f(1,0,1); // magenta
+        glVertex2f(p[2].x, p[2].y);
+    }
+    void cubicCurveTo(const float2 p[4], size_t coord_index, char cmd) {
+        glColor3f(1,0.5,0.5);  // red
+        glVertex2f(p[1].x, p[1].y);
+        glColor3f(1,0.5,0.5); // red
+        glVertex2f(p[2].x, p[2].y);
+        glColor3f(0.5,1,0.5); // green
+        glVertex2f(p[3].x, p[3].y);
+    }
+    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
+        // Convert to a center point arc to be able to render the arc center.
+        CenterPointArc center_point_arc(arc);
+        if (center_point_arc.form == CenterPointArc::BEHAVED) {
+            glColor3f(0.33f,0,0);
+            glVertex2f(center_point_arc.p[1].x, center_point_arc.p[1].y);
+            glColor3f(0.66f,0,0);
+        } else {
+            glColor3f(0.66f,0,1);  // hint the control point is for a degenerate arc
+        }
+        glVertex2f(center_point_arc.center.x, center_point_arc.center.y);
+    }
+    void close(char cmd) { }
+    void endPath(PathPtr p) {}
+};
+
+void Path::drawControlPoints()
+{
+    glPointSize(5.0);
+    glBegin(GL_POINTS); {
+        DrawControlPointProcessor processor;
+        processSegments(processor);
+    } glEnd();
+}
+
+// This version also draws tangent offset curve points
+static void draw_cubic_reference_points(const float2 b[4], const int steps)
+{
+    const float2 P0 = b[0],
+                 P1 = b[1],
+                 P2 = b[2],
+                 P3 = b[3];
+
+    for (int i=0; i<=steps; i++) {
+        const float t = float(i) / steps;
+
+        const float2 p = (1-t)*(1-t)*(1-t)*P0 + 3*(1-t)*(1-t)*t*P1 + 3*(1-t)*t*t*P2+ t*t*t*P3;
+
+        glColor3f(1,1,1);
+        glVertex2f(p.x, p.y);
+
+#if 0  // add offset curve points (for stroking)
+        const float2 dpdt = -3*(1-t)*(1-t)*P0-6*(1-t)*t*P1+3*(1-t)*(1-t)*P1-3*t*t*P2+6*(1-t)*t*P2+3*t*t*P3;
+        const float2 tangent = normalize(dpdt);
+        const float2 normal = 30*float2(-tangent.y, tangent.x);
+        glColor3f(1,0,0);
+        glVertex2f(p.x + normal.x, p.y + normal.y);
+        glColor3f(0,1,0);
+        glVertex2f(p.x - normal.x, p.y - normal.y);
+        glColor3f(0,0,1);
+        glVertex2f(p.x + 6*tangent.x, p.y + 6*tangent.y);
+#endif
+    }
+}
+
+static void draw_quadratic_reference_points(const float2 b[3], const int steps)
+{
+    glColor3f(1,1,1);
+    for (int i=0; i<=steps; i++) {
+        float t = float(i) / steps;
+
+        float2 pa = lerp(b[0], b[1], t),
+               pb = lerp(b[1], b[2], t),
+               p  = lerp(pa, pb, t);
+
+        glVertex2f(p.x, p.y);
+    }
+}
+
+static void draw_line_reference_points(const float2 b[2], const int steps)
+{
+    glColor3f(1,1,1);
+    for (int i=0; i<=steps; i++) {
+        float t = float(i) / steps;
+
+        float2 p = lerp(b[0], b[1], t);
+
+        glVertex2f(p.x, p.y);
+    }
+}
+
+static void draw_arc_reference_points(CenterPointArc center_point_arc, const int steps)
+{
+    // "If the endpoints (x1, y1) and (x2, y2) are identical, then this
+    // is equivalent to omitting the elliptical arc segment entirely."
+    if (center_point_arc.form == CenterPointArc::DEGENERATE_POINT) {
+        return;
+    }
+
+    // "If rX = 0 or rY  = 0 then this arc is treated as a straight
+    // line segment (a "lineto") joining the endpoints."
+    if (center_point_arc.form == CenterPointArc::DEGENERATE_LINE) {
+        glColor3f(1,0,0); // red
+        for (int i=1; i<steps; i++) {
+            float t = float(i) / steps;
+
+            float2 p = lerp(center_point_arc.p[0],
+                            center_point_arc.p[1], t);
+
+            glVertex2f(p.x, p.y);
+        }
+        return;
+    }
+
+    const float &theta1 = center_point_arc.theta1,
+                &delta_theta = center_point_arc.delta_theta,
+                theta2 = theta1 + delta_theta,
+                theta_step = delta_theta / steps,
+                &psi = center_point_arc.psi;
+    const float2 &radii = center_point_arc.radii,
+                 &center = center_point_arc.center;
+
+    glColor3ub(255, 140, 0); // dark orange
+    const float2x2 rotate = float2x2(cos(psi), -sin(psi),
+                                     sin(psi), cos(psi));
+    for (int i=0; i<steps; i++) {
+        const float theta = theta1 + i*theta_step;
+        const float2 scale = radii * float2(cos(theta), sin(theta));
+
+        const float2 p = mul(rotate, scale) + center;
+        glVertex2f(p.x, p.y);
+    }
+    const float2 scale = radii * float2(cos(theta2), sin(theta2));
+    const float2 p = mul(rotate, scale) + center;
+    glVertex2f(p.x, p.y);
+}
+
+struct DrawReferencePointProcessor : PathSegmentProcessor {
+    void beginPath(PathPtr p) {}
+    void moveTo(const float2 p[2], size_t coord_index, char cmd) { };
+    void lineTo(const float2 p[2], size_t coord_index, char cmd) {
+        draw_line_reference_points(p, 5);
+    }
+    void quadraticCurveTo(const float2 p[3], size_t coord_index, char cmd) {
+        draw_quadratic_reference_points(p, 8);
+    }
+    void cubicCurveTo(const float2 p[4], size_t coord_index, char cmd) {
+        draw_cubic_reference_points(p, 20);
+    }
+    void arcTo(const EndPointArc &arc, size_t coord_index, char cmd) {
+        CenterPointArc center_point_arc(arc);
+        draw_arc_reference_points(center_point_arc, 12);
+    }
+    void close(char cmd) { }
+    void endPath(PathPtr p) {}
+};
+
+void Path::drawReferencePoints()
+{
+    glPointSize(3.0);
+    glBegin(GL_POINTS); {
+        DrawReferencePointProcessor processor;
+        processSegments(processor);
+    } glEnd();
+}
+
+void Shape::drawControlPoints()
+{
+    path->drawControlPoints();
+}
+
+void Shape::drawReferencePoints()
+{
+    path->drawReferencePoints();
+}
+
+void WarpTransform::drawWarpPoints() {
+    glEnable(GL_LINE_STIPPLE);
+    glColor3f(1,1,0);
+    glBegin(GL_LINE_LOOP); {
+        for (int i=0; i<4; i++) {
+            glVertex2f(from[i].x, from[i].y);
+        }
+    } glEnd();
+    glDisable(GL_LINE_STIPPLE);
+    glColor3f(1,0,1);
+    glPointSize(7);
+    glBegin(GL_POINTS); {
+        for (int i=0; i<4; i++) {
+            glVertex2f(from[i].x, from[i].y);
+        }
+    } glEnd();
+}
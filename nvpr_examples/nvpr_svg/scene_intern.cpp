@@ -0,0 +1,219 @@
+/* scene_intern.cpp - share equal paints and path styles within a scene */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#include <string.h>
+
+#include "scene_intern.hpp"
+
+using std::vector;
+
+namespace {
+
+// FNV-1a over the bytes of each value added.
+struct Hash {
+    size_t value;
+
+    Hash()
+        : value(2166136261u)
+    {}
+
+    void add(const void *data, size_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (size_t i=0; i<size; i++) {
+            value = (value ^ bytes[i]) * 16777619u;
+        }
+    }
+    void add(int v) { add(&v, sizeof(v)); }
+    void add(float v) { add(&v, sizeof(v)); }
+    void add(const float2 &v) { add(float(v.x)); add(float(v.y)); }
+    void add(const float4 &v) { add(float(v.x)); add(float(v.y)); add(float(v.z)); add(float(v.w)); }
+    void add(const float3x3 &m) {
+        for (int i=0; i<3; i++) {
+            for (int j=0; j<3; j++) {
+                add(float(m[i][j]));
+            }
+        }
+    }
+};
+
+// Floats are compared by bits, as they are hashed, so -0 and 0 don't
+// match; that only costs some sharing.
+inline bool same(float a, float b)
+{
+    return !memcmp(&a, &b, sizeof(a));
+}
+
+inline bool same(const float2 &a, const float2 &b)
+{
+    return same(float(a.x), float(b.x)) && same(float(a.y), float(b.y));
+}
+
+inline bool same(const float4 &a, const float4 &b)
+{
+    return same(float(a.x), float(b.x)) && same(float(a.y), float(b.y)) &&
+           same(float(a.z), float(b.z)) && same(float(a.w), float(b.w));
+}
+
+bool same(const float3x3 &a, const float3x3 &b)
+{
+    for (int i=0; i<3; i++) {
+        for (int j=0; j<3; j++) {
+            if (!same(float(a[i][j]), float(b[i][j]))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t hashStyle(const PathStyle &style)
+{
+    Hash h;
+    h.add(int(style.do_fill));
+    h.add(int(style.fill_rule));
+    h.add(int(style.do_stroke));
+    h.add(style.stroke_width);
+    h.add(int(style.line_cap));
+    h.add(int(style.line_join));
+    h.add(style.miter_limit);
+    for (size_t i=0; i<style.dash_array.size(); i++) {
+        h.add(style.dash_array[i]);
+    }
+    h.add(style.dash_offset);
+    h.add(int(style.dash_phase));
+    return h.value;
+}
+
+void hashGradient(Hash &h, const GradientPaint *gradient)
+{
+    h.add(int(gradient->getGradientUnits()));
+    h.add(gradient->getGradientTransform());
+    h.add(int(gradient->getSpreadMethod()));
+    const vector<GradientStop> &stops = gradient->getStopArray();
+    for (size_t i=0; i<stops.size(); i++) {
+        h.add(stops[i].offset);
+        h.add(stops[i].color);
+    }
+}
+
+bool sameGradient(const GradientPaint *a, const GradientPaint *b)
+{
+    if (a->getGradientUnits() != b->getGradientUnits() ||
+        a->getSpreadMethod() != b->getSpreadMethod() ||
+        !same(a->getGradientTransform(), b->getGradientTransform())) {
+        return false;
+    }
+    const vector<GradientStop> &a_stops = a->getStopArray(),
+                               &b_stops = b->getStopArray();
+    if (&a_stops == &b_stops) {
+        return true;
+    }
+    if (a_stops.size() != b_stops.size()) {
+        return false;
+    }
+    for (size_t i=0; i<a_stops.size(); i++) {
+        if (!same(a_stops[i].offset, b_stops[i].offset) ||
+            !same(a_stops[i].color, b_stops[i].color)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns false for paints that aren't interned.
+bool hashPaint(const Paint *paint, size_t &hash)
+{
+    Hash h;
+    if (const SolidColorPaint *solid = dynamic_cast<const SolidColorPaint*>(paint)) {
+        h.add(int(0));
+        h.add(solid->getColor());
+    } else if (const LinearGradientPaint *linear = dynamic_cast<const LinearGradientPaint*>(paint)) {
+        h.add(int(1));
+        h.add(linear->getV1());
+        h.add(linear->getV2());
+        hashGradient(h, linear);
+    } else if (const RadialGradientPaint *radial = dynamic_cast<const RadialGradientPaint*>(paint)) {
+        h.add(int(2));
+        h.add(radial->getCenter());
+        h.add(radial->getFocalPoint());
+        h.add(radial->getRadius());
+        hashGradient(h, radial);
+    } else {
+        return false;
+    }
+    hash = h.value;
+    return true;
+}
+
+bool samePaint(const Paint *a, const Paint *b)
+{
+    if (const SolidColorPaint *solid_a = dynamic_cast<const SolidColorPaint*>(a)) {
+        const SolidColorPaint *solid_b = dynamic_cast<const SolidColorPaint*>(b);
+        return solid_b && same(solid_a->getColor(), solid_b->getColor());
+    }
+    if (const LinearGradientPaint *linear_a = dynamic_cast<const LinearGradientPaint*>(a)) {
+        const LinearGradientPaint *linear_b = dynamic_cast<const LinearGradientPaint*>(b);
+        return linear_b &&
+               same(linear_a->getV1(), linear_b->getV1()) &&
+               same(linear_a->getV2(), linear_b->getV2()) &&
+               sameGradient(linear_a, linear_b);
+    }
+    if (const RadialGradientPaint *radial_a = dynamic_cast<const RadialGradientPaint*>(a)) {
+        const RadialGradientPaint *radial_b = dynamic_cast<const RadialGradientPaint*>(b);
+        return radial_b &&
+               same(radial_a->getCenter(), radial_b->getCenter()) &&
+               same(radial_a->getFocalPoint(), radial_b->getFocalPoint()) &&
+               same(radial_a->getRadius(), radial_b->getRadius()) &&
+               sameGradient(radial_a, radial_b);
+    }
+    return false;
+}
+
+} // namespace
+
+PathStylePtr SceneInterner::intern(const PathStyle &style)
+{
+    vector<PathStylePtr> &bucket = styles[hashStyle(style)];
+    for (size_t i=0; i<bucket.size(); i++) {
+        if (*bucket[i] == style) {
+            return bucket[i];
+        }
+    }
+    PathStylePtr shared(new PathStyle(style));
+    bucket.push_back(shared);
+    return shared;
+}
+
+PaintPtr SceneInterner::intern(PaintPtr paint)
+{
+    size_t hash;
+    if (!paint || !hashPaint(paint.get(), hash)) {
+        return paint;
+    }
+    vector<PaintPtr> &bucket = paints[hash];
+    for (size_t i=0; i<bucket.size(); i++) {
+        if (samePaint(bucket[i].get(), paint.get())) {
+            return bucket[i];
+        }
+    }
+    bucket.push_back(paint);
+    return paint;
+}
+
+PaintPtr SceneInterner::internSolidColor(const float4 &color)
+{
+    Hash h;
+    h.add(int(0));
+    h.add(color);
+    vector<PaintPtr> &bucket = paints[h.value];
+    for (size_t i=0; i<bucket.size(); i++) {
+        const SolidColorPaint *solid = dynamic_cast<const SolidColorPaint*>(bucket[i].get());
+        if (solid && same(solid->getColor(), color)) {
+            return bucket[i];
+        }
+    }
+    PaintPtr paint(new SolidColorPaint(color));
+    bucket.push_back(paint);
+    return paint;
+}
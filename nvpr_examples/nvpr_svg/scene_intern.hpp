@@ -0,0 +1,42 @@
+/* scene_intern.hpp - share equal paints and path styles within a scene */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __scene_intern_hpp__
+#define __scene_intern_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include <map>
+#include <vector>
+
+#include "scene.hpp"
+
+// Hash-conses the paints and path styles a loader makes so shapes with
+// equal ones share one immutable object.  Besides saving the copies, each
+// renderer then builds one paint renderer state per distinct paint rather
+// than per shape.
+//
+// Solid color and gradient paints are compared by value (gradient stops
+// included); other paints are returned unchanged.  Paints and path styles
+// must not be modified once interned.  An interner isn't thread-safe; give
+// each load its own.
+class SceneInterner {
+public:
+    PathStylePtr intern(const PathStyle &style);
+    PaintPtr intern(PaintPtr paint);
+
+    // intern(SolidColorPaint(color)) without making the paint if it exists
+    PaintPtr internSolidColor(const float4 &color);
+
+private:
+    typedef std::map<size_t, std::vector<PathStylePtr> > StyleTable;
+    typedef std::map<size_t, std::vector<PaintPtr> > PaintTable;
+
+    StyleTable styles;
+    PaintTable paints;
+};
+
+#endif // __scene_intern_hpp__
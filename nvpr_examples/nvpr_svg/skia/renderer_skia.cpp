@@ -9,6 +9,10 @@
 
 #if USE_SKIA
 
+#include <string.h>
+
+#include <algorithm>
+
 #include <SkTypes.h>
 #include "renderer_skia.hpp"
 #include "scene.hpp"
@@ -194,7 +198,7 @@ struct SkiaPathCacheProcessor : PathSegmentProcessor {
 
     void beginPath(PathPtr p) {
         path = SkPath();  // reset the path
-        switch (p->style.fill_rule) {
+        switch (p->style->fill_rule) {
         case PathStyle::EVEN_ODD:
             path.setFillType(SkPath::kEvenOdd_FillType);
             break;
@@ -267,11 +271,40 @@ void SkiaRenderer::shutdown()
 {
 }
 
+bool SkiaRenderer::clipToRect(int x, int y, int width, int height)
+{
+    // Bitmap rows go bottom to top in the window so no flip is needed.
+    canvas.resetMatrix();
+    canvas.save(SkCanvas::kClip_SaveFlag);
+    canvas.clipRect(SkRect::MakeXYWH(SkIntToScalar(x), SkIntToScalar(y),
+                                     SkIntToScalar(width), SkIntToScalar(height)));
+    clipped = true;
+    return true;
+}
+
+bool SkiaRenderer::scrollSurface(int dx, int dy)
+{
+    scrollPixels(static_cast<unsigned char*>(bitmap.getPixels()),
+                 bitmap.width(), bitmap.height(), bitmap.rowBytes(),
+                 dx, dy);
+    bitmap.notifyPixelsChanged();
+    return true;
+}
+
 void SkiaRenderer::clear(float3 clear_color)
 {
-    bitmap.eraseRGB(U8CPU(clear_color.r * 255),
-                    U8CPU(clear_color.g * 255),
-                    U8CPU(clear_color.b * 255));
+    if (clipped) {
+        // eraseRGB ignores the clip
+        canvas.drawARGB(255,
+                        U8CPU(clear_color.r * 255),
+                        U8CPU(clear_color.g * 255),
+                        U8CPU(clear_color.b * 255),
+                        SkXfermode::kSrc_Mode);
+    } else {
+        bitmap.eraseRGB(U8CPU(clear_color.r * 255),
+                        U8CPU(clear_color.g * 255),
+                        U8CPU(clear_color.b * 255));
+    }
 }
 
 void SkiaRenderer::setView(float4x4 view)
@@ -298,29 +331,164 @@ void SkiaRenderer::setView(float4x4 view)
     canvas.concat(m);
 }
 
+void SkiaRenderer::endDraw()
+{
+    if (clipped) {
+        canvas.restore();
+        clipped = false;
+    }
+}
+
 VisitorPtr SkiaRenderer::makeVisitor()
 {
     return VisitorPtr(new SkiaVisitors::Draw(
-        dynamic_pointer_cast<SkiaRenderer>(shared_from_this())));
+        dynamic_pointer_cast<SkiaRenderer>(shared_from_this()), canvas));
 }
 
-void SkiaRenderer::copyImageToWindow()
+bool SkiaRenderer::setTileThreads(int threads)
 {
-    glWindowPos2f(0,0);
+    if (threads < 0) {
+        threads = TilePool::processors();
+    }
+    if (threads == getTileThreads()) {
+        return true;
+    }
+    tile_pool = threads > 0 ? TilePoolPtr(new TilePool(threads)) : TilePoolPtr();
+    return true;
+}
+
+int SkiaRenderer::getTileThreads()
+{
+    return tile_pool ? tile_pool->getThreadCount() : 0;
+}
+
+namespace {
+
+// What every tile of a frame draws.
+struct SkiaTiles {
+    SkiaRendererPtr renderer;
+    GroupPtr scene;
+    float4x4 scene_to_surface;
+    bool cull;
+    SkMatrix view;
+    unsigned char *pixels;
+    int width, height, stride;
+    vector<TileRect> rects;
+};
+
+void drawSkiaTile(void *data, int tile)
+{
+    const SkiaTiles &tiles = *static_cast<SkiaTiles*>(data);
+    const TileRect &rect = tiles.rects[tile];
+
+    // As with Cairo, the tile is drawn into a bitmap of its own as large
+    // as the surface, with the same origin and no clip, so it comes out as
+    // it would in an untiled frame; only the tile's pixels are copied in
+    // and back, and the others needn't be initialized.
+    const size_t left = size_t(rect.x)*4,
+                 bytes = size_t(rect.width)*4;
+    unsigned char *scratch = new unsigned char[size_t(tiles.height)*tiles.stride];
+    for (int y=rect.y; y<rect.y+rect.height; y++) {
+        const size_t offset = size_t(y)*tiles.stride + left;
+        memcpy(scratch + offset, tiles.pixels + offset, bytes);
+    }
+
+    SkBitmap scratch_bitmap;
+    scratch_bitmap.setConfig(SkBitmap::kARGB_8888_Config, tiles.width, tiles.height, tiles.stride);
+    scratch_bitmap.setPixels(scratch);
+    SkCanvas canvas(scratch_bitmap);
+    canvas.concat(tiles.view);
+
+    VisitorPtr visitor(new SkiaVisitors::Draw(tiles.renderer, canvas, /*tiled*/true));
+    if (tiles.cull) {
+        CullingTraversal traversal(tiles.scene_to_surface,
+            float4(rect.x, rect.y, rect.x+rect.width, rect.y+rect.height));
+        tiles.scene->traverse(visitor, traversal);
+    } else {
+        tiles.scene->traverse(visitor);
+    }
+
+    for (int y=rect.y; y<rect.y+rect.height; y++) {
+        const size_t offset = size_t(y)*tiles.stride + left;
+        memcpy(tiles.pixels + offset, scratch + offset, bytes);
+    }
+    delete [] scratch;
+}
+
+} // namespace
 
-    //bitmap.lockPixels();
+void SkiaRenderer::drawTiles(GroupPtr scene, const float4x4 &scene_to_surface,
+                             const TileRect &area, bool cull)
+{
+    SkiaRendererPtr self = dynamic_pointer_cast<SkiaRenderer>(shared_from_this());
+    SkiaTiles tiles;
+    tiles.renderer = self;
+    tiles.scene = scene;
+    tiles.scene_to_surface = scene_to_surface;
+    tiles.cull = cull;
+    tiles.view = canvas.getTotalMatrix();
 
+    // Everything the tiles share must be ready before they start: the
+    // node bounds culling reads and the shapes' renderer states.
+    scene->getBounds();
+    VisitorPtr validate(new SkiaVisitors::Validate(self));
+    if (cull) {
+        CullingTraversal traversal(scene_to_surface,
+            float4(area.x, area.y, area.x+area.width, area.y+area.height));
+        scene->traverse(validate, traversal);
+    } else {
+        scene->traverse(validate);
+    }
+
+    // Bitmap rows go bottom to top in the window, as surface rectangles do.
+    tiles.pixels = static_cast<unsigned char*>(bitmap.getPixels());
+    tiles.width = bitmap.width();
+    tiles.height = bitmap.height();
+    tiles.stride = bitmap.rowBytes();
+    if (tile_pool) {
+        tiles.rects = splitRect(area);
+        tile_pool->run(drawSkiaTile, &tiles, int(tiles.rects.size()));
+    } else {
+        tiles.rects.push_back(area);
+        drawSkiaTile(&tiles, 0);
+    }
+}
+
+void SkiaRenderer::drawScene(GroupPtr scene, const float4x4 &scene_to_surface,
+                             const float4 &surface_rect, bool cull)
+{
+    if (!tile_pool) {
+        BlitRenderer::drawScene(scene, scene_to_surface, surface_rect, cull);
+        return;
+    }
+    TileRect area = { 0, 0, bitmap.width(), bitmap.height() };
+    drawTiles(scene, scene_to_surface, area, cull);
+}
+
+void SkiaRenderer::drawSceneRect(GroupPtr scene, const float4x4 &scene_to_surface,
+                                 int x, int y, int width, int height, bool cull)
+{
+    // Drawn as a tile, since the clip would change the pixels.
+    TileRect area = { x, y, width, height };
+    drawTiles(scene, scene_to_surface, area, cull);
+}
+
+bool SkiaRenderer::readPixels(unsigned char *rgba)
+{
     const int w = bitmap.width(),
               h = bitmap.height();
 
-    const void *pixels = bitmap.getPixels();
-
-    assert(bitmap.rowBytes() == w*4);
-    // Skia's RGBA component layout philosophy is "default to OpenGL order (in memory: r,g,b,a)".
-    // See comment and definitions in "SkColorPrive.h".
-    glDrawPixels(w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    const unsigned char *pixels = static_cast<const unsigned char*>(bitmap.getPixels());
 
-    //bitmap.unlockPixels();
+    // Premultiplied r,g,b,a bytes, as copyImageToWindow assumes.
+    for (int y=0; y<h; y++) {
+        const unsigned char *row = pixels + (h-1-y)*bitmap.rowBytes();
+        for (int x=0; x<w; x++, rgba+=4) {
+            const unsigned char *p = row + 4*x;
+            storeUnpremultiplied(rgba, p[0], p[1], p[2], p[3]);
+        }
+    }
+    return true;
 }
 
 const char *SkiaRenderer::getWindowTitle()
@@ -353,6 +521,10 @@ void SkiaPathRendererState::validate()
     SkiaRendererPtr renderer = getRenderer();
     SkiaPathCacheProcessor processor(path);
     owner->processSegments(processor);
+    // SkPath computes these lazily; compute them now so tiles drawing the
+    // path at once only read it.
+    path.updateBoundsCache();
+    path.getConvexity();
     valid = true;
 }
 
@@ -361,46 +533,96 @@ void SkiaPathRendererState::invalidate()
     valid = false;
 }
 
-void SkiaShapeRendererState::validate()
+static SkiaPaintRendererStatePtr getPaintRendererState(PaintPtr paint, SkiaRendererPtr renderer)
 {
-    const Shape *shape = owner;
-
-    PaintPtr fill_paint = shape->getFillPaint();
-    if (fill_paint) {
-        PaintRendererStatePtr renderer_state = fill_paint->getRendererState(getRenderer());
-        SkiaPaintRendererStatePtr paint_renderer_state = dynamic_pointer_cast<SkiaPaintRendererState>(renderer_state);
-        paint_renderer_state->validate(shape->net_fill_opacity);
+    if (!paint) {
+        return SkiaPaintRendererStatePtr();
     }
+    PaintRendererStatePtr renderer_state = paint->getRendererState(renderer);
+    return dynamic_pointer_cast<SkiaPaintRendererState>(renderer_state);
+}
 
-    const PaintPtr stroke_paint = shape->getStrokePaint();
-    if (stroke_paint) {
-        PaintRendererStatePtr renderer_state = stroke_paint->getRendererState(getRenderer());
-        SkiaPaintRendererStatePtr paint_renderer_state = dynamic_pointer_cast<SkiaPaintRendererState>(renderer_state);
-        paint_renderer_state->validate(shape->net_stroke_opacity);
-    }
+bool SkiaShapeRendererState::Brush::isCurrent(SkiaPaintRendererStatePtr state)
+{
+    return paint_state == state && (!state || serial == state->getSerial());
+}
 
-    if (valid) {
-        return;
+void SkiaShapeRendererState::Brush::drawPath(SkCanvas &canvas, const SkPath &path,
+                                             bool private_shader)
+{
+    SkShader *shader = private_shader ? paint_state->createShader(opacity) : NULL;
+    if (shader) {
+        SkPaint private_paint(paint);
+        shader->setLocalMatrix(shader_matrix);
+        private_paint.setShader(shader)->unref();
+        canvas.drawPath(path, private_paint);
+    } else {
+        canvas.drawPath(path, paint);
     }
-    // Nothing about the shape to actually validate.
-    valid = true;
 }
 
-SkPaint& SkiaShapeRendererState::getPaint(PaintPtr paint, float opacity)
+void SkiaShapeRendererState::validate()
 {
-    PaintRendererStatePtr renderer_state = paint->getRendererState(getRenderer());
-    SkiaPaintRendererStatePtr paint_renderer_state = dynamic_pointer_cast<SkiaPaintRendererState>(renderer_state);
-    assert (paint_renderer_state);
-
-    paint_renderer_state->validate(opacity);
-
-    SkPaint& sk_paint = paint_renderer_state->getPaint();
+    SkiaRendererPtr renderer = getRenderer();
+    const PaintPtr fill_paint = owner->getFillPaint(),
+                   stroke_paint = owner->getStrokePaint();
+    const float4 owner_bounds = owner->getBounds();
+
+    // Remake the brushes if a paint was invalidated or, since gradients
+    // and images are fit to them, the bounds moved.
+    if (!valid ||
+        !fill.isCurrent(getPaintRendererState(fill_paint, renderer)) ||
+        !stroke.isCurrent(getPaintRendererState(stroke_paint, renderer)) ||
+        any(owner_bounds != bounds)) {
+        bounds = owner_bounds;
+        setBrush(fill, fill_paint, owner->net_fill_opacity);
+        fill.paint.setStyle(SkPaint::kFill_Style);
+        setBrush(stroke, stroke_paint, owner->net_stroke_opacity);
+        setStrokeStyle(stroke.paint);
+        valid = true;
+    }
+
+    getPathRendererState()->validate();
+}
+
+// Maps [bounds.xy,bounds.zw] to the unit square.
+static SkMatrix boundsToUnitSquare(const float4 &bounds)
+{
+    float2 p1 = bounds.xy,
+           p2 = bounds.zw,
+           diff = p2-p1,
+           sum = p2+p1;
+
+    SkMatrix b;
+    b[0] = 1/diff.x;
+    b[1] = 0;
+    b[2] = -0.5f*sum.x/diff.x+0.5f;
+    b[3] = 0;
+    b[4] = 1/diff.y;
+    b[5] = -0.5f*sum.y/diff.y+0.5f;
+    b[6] = 0;
+    b[7] = 0;
+    b[8] = 1;
+    return b;
+}
+
+void SkiaShapeRendererState::setBrush(Brush &brush, PaintPtr paint, float opacity)
+{
+    brush.paint = SkPaint();
+    brush.paint.setFlags(SkPaint::kAntiAlias_Flag);
+    brush.paint_state = getPaintRendererState(paint, getRenderer());
+    brush.opacity = opacity;
+    brush.shader_matrix.reset();
+    SkiaPaintRendererStatePtr paint_renderer_state = brush.paint_state;
+    if (!paint_renderer_state) {
+        return;
+    }
+    brush.serial = paint_renderer_state->getSerial();
+    paint_renderer_state->setPaint(brush.paint, opacity);
 
+    SkMatrix &matrix = brush.shader_matrix;
     if (paint_renderer_state->needsGradientMatrix()) {
         GradientPaintPtr gradient = dynamic_pointer_cast<GradientPaint>(paint);
-        SkiaGradientPaintRendererStatePtr gradient_state = dynamic_pointer_cast<SkiaGradientPaintRendererState>(paint_renderer_state);
-
-        SkMatrix matrix;
         const float3x3 &gradient_transform = gradient->getGradientTransform();
 
         matrix[0] = gradient_transform[0][0];
@@ -415,62 +637,23 @@ SkPaint& SkiaShapeRendererState::getPaint(PaintPtr paint, float opacity)
         matrix[7] = gradient_transform[2][1];
         matrix[8] = gradient_transform[2][2];
         if (gradient->getGradientUnits() == OBJECT_BOUNDING_BOX) {
-            float4 bounds = owner->getBounds();
-            float2 p1 = bounds.xy,
-                   p2 = bounds.zw,
-                   diff = p2-p1,
-                   sum = p2+p1;
-
-            SkMatrix b;
-            b[0] = 1/diff.x;
-            b[1] = 0;
-            b[2] = -0.5f*sum.x/diff.x+0.5f;
-            b[3] = 0;
-            b[4] = 1/diff.y;
-            b[5] = -0.5f*sum.y/diff.y+0.5f;
-            b[6] = 0;
-            b[7] = 0;
-            b[8] = 1;
-            matrix.preConcat(b);
+            matrix.preConcat(boundsToUnitSquare(bounds));
             matrix.invert(&matrix);
         }
-        gradient_state->gradient->setLocalMatrix(matrix);
     } else {
         ImagePaintPtr image = dynamic_pointer_cast<ImagePaint>(paint);
         if (image) {
-            SkiaImagePaintRendererStatePtr image_state =
-                dynamic_pointer_cast<SkiaImagePaintRendererState>(paint_renderer_state);
-
             float w = image->image->width,
                   h = image->image->height;
 
-            SkMatrix matrix;
             matrix.setScale(w, h);
-            {
-                float4 bounds = owner->getBounds();
-                float2 p1 = bounds.xy,
-                       p2 = bounds.zw,
-                       diff = p2-p1,
-                       sum = p2+p1;
-
-                SkMatrix b;
-                b[0] = 1/diff.x;
-                b[1] = 0;
-                b[2] = -0.5f*sum.x/diff.x+0.5f;
-                b[3] = 0;
-                b[4] = 1/diff.y;
-                b[5] = -0.5f*sum.y/diff.y+0.5f;
-                b[6] = 0;
-                b[7] = 0;
-                b[8] = 1;
-                matrix.preConcat(b);
-                matrix.invert(&matrix);
-            }   
-            image_state->bitmap->setLocalMatrix(matrix);
+            matrix.preConcat(boundsToUnitSquare(bounds));
+            matrix.invert(&matrix);
         }
     }
-
-    return sk_paint;
+    if (brush.paint.getShader()) {
+        brush.paint.getShader()->setLocalMatrix(matrix);
+    }
 }
 
 void SkiaShapeRendererState::invalidate()
@@ -514,84 +697,69 @@ static SkPaint::Join lineJoinConverter(PathStyle::LineJoin join)
     }
 }
 
-void SkiaShapeRendererState::draw()
-{
-    SkiaRendererPtr renderer = getRenderer();
+void SkiaShapeRendererState::setStrokeStyle(SkPaint &sk_paint)
+{
+    // Skia associates stroking properties with the SkPaint rather
+    // than the path.  This is an odd conceptual choice because
+    // "paint" colloquially determines color but not shape.
+    //
+    // Indeed, Skia even associate the rendering mode (stroking or
+    // filling) with the paint.
+    //
+    // SVG more appropriately keeps the path properties (to determine
+    // the styling shape of the path) separate from the filling and
+    // stroking paint.
+    //
+    // To match the Skia model, the shape's stroke brush adopts the
+    // path's shaping properties when it is made.
+    sk_paint.setStyle(SkPaint::kStroke_Style);
+
+    const PathStyle &style = *owner->getPath()->style;
+
+    // Set Skia 
+    sk_paint.setStrokeWidth(style.stroke_width);
+    sk_paint.setStrokeMiter(style.miter_limit);
+    sk_paint.setStrokeCap(lineCapConverter(style.line_cap));
+    sk_paint.setStrokeJoin(lineJoinConverter(style.line_join));
+
+    // Is the path dashed?
+    if (style.dash_array.size() > 0) {
+        // Yes, specify a Skia dash path effect for the paint...
+        size_t count = style.dash_array.size();
+        // Odd dash array sizes requires us to double the dash array to make it even.
+        size_t sk_count = count & 1 ? count*2 : count;
+        vector<SkScalar> dash_array(sk_count);
+        for (size_t i=0; i<count; i++) {
+            dash_array[i] = style.dash_array[i];
+        }
+        // Does dash array have an odd count?
+        if (count & 1) {
+            // Yes, repeat the dash array again for Skia.
+            for (size_t i=0; i<count; i++) {
+                dash_array[i+count] = style.dash_array[i];
+            }
+        }
+        assert(dash_array.size() == sk_count);
+        bool scale_to_fit = false;
+        // Note the Skia idiom of the unref after the new & set.
+        sk_paint.setPathEffect(new SkDashPathEffect(&dash_array[0], int(sk_count),
+                                                    scale_to_fit))->unref();
+    }
+}
 
+void SkiaShapeRendererState::draw(SkCanvas &canvas, bool private_shaders)
+{
     // validate the path
     SkiaPathRendererStatePtr path_state = getPathRendererState();
     path_state->validate();
 
     extern bool doFilling, doStroking;
-    const PathStyle &style = owner->getPath()->style;
-    if (style.do_fill && doFilling) {
-	      PaintPtr fill = owner->getFillPaint();
-        SkPaint &sk_paint = getPaint(fill, owner->net_fill_opacity);
-        // For the SkPaint style to be filled in case the paint was
-        // also used for stroking.
-        sk_paint.setStyle(SkPaint::kFill_Style);
-        renderer->canvas.drawPath(path_state->path, sk_paint);
-    }
-    if (style.do_stroke && doStroking) {
-	    PaintPtr stroke = owner->getStrokePaint();
-        // Skia associates stroking properties with the SkPaint rather
-        // than the path.  This is an odd conceptual choice because
-        // "paint" colloquially determines color but not shape.
-        //
-        // Indeed, Skia even associate the rendering mode (stroking or
-        // filling) with the paint.
-        //
-        // SVG more appropriately keeps the path properties (to determine
-        // the styling shape of the path) separate from the filling and
-        // stroking paint.
-        //
-        // To match the Skia model, we have to force the sk_paint object
-        // to adopt the path's shaping properties everytime since there's
-        // no assurance the paint might not have been used by another path.
-        // Potentially this could be optimized for solid color paints
-        // that won't be shared among paths.
-        //
-        // Fortunately setting these properties in Skia is "cheap".
-        SkPaint &sk_paint = getPaint(stroke, owner->net_stroke_opacity);
-
-        sk_paint.setStyle(SkPaint::kStroke_Style);
-
-        const PathStyle &style = owner->getPath()->style;
-
-        // Set Skia 
-        sk_paint.setStrokeWidth(style.stroke_width);
-        sk_paint.setStrokeMiter(style.miter_limit);
-        sk_paint.setStrokeCap(lineCapConverter(style.line_cap));
-        sk_paint.setStrokeJoin(lineJoinConverter(style.line_join));
-
-        // Is the path dashed?
-        if (style.dash_array.size() > 0) {
-            // Yes, specify a Skia dash path effect for the paint...
-            size_t count = style.dash_array.size();
-            // Odd dash array sizes requires us to double the dash array to make it even.
-            size_t sk_count = count & 1 ? count*2 : count;
-            vector<SkScalar> dash_array(sk_count);
-            for (size_t i=0; i<count; i++) {
-                dash_array[i] = style.dash_array[i];
-            }
-            // Does dash array have an odd count?
-            if (count & 1) {
-                // Yes, repeat the dash array again for Skia.
-                for (size_t i=0; i<count; i++) {
-                    dash_array[i+count] = style.dash_array[i];
-                }
-            }
-            assert(dash_array.size() == sk_count);
-            bool scale_to_fit = false;
-            // Note the Skia idiom of the unref after the new & set.
-            sk_paint.setPathEffect(new SkDashPathEffect(&dash_array[0], int(sk_count),
-                                                        scale_to_fit))->unref();
-        } else {
-            // No, disable the Skia path effect in case prior use had it dashed.
-            sk_paint.setPathEffect(0);
-        }
-
-        renderer->canvas.drawPath(path_state->path, sk_paint);
+    const PathStyle &style = *owner->getPath()->style;
+    if (style.do_fill && doFilling && fill.paint_state) {
+        fill.drawPath(canvas, path_state->path, private_shaders);
+    }
+    if (style.do_stroke && doStroking && stroke.paint_state) {
+        stroke.drawPath(canvas, path_state->path, private_shaders);
     }
 }
 
@@ -632,17 +800,15 @@ shared_ptr<RendererState<Paint> > SkiaRenderer::alloc(Paint *owner)
 
 SkiaPaintRendererState::SkiaPaintRendererState(RendererPtr renderer, Paint *paint, bool is_gradient)
     : SkiaRendererState<Paint>(renderer, paint)
-    , valid(false)
-    , sk_paint()
-    , opacity(1.0)
+    , serial(0)
     , needs_gradient_matrix(is_gradient)
 {
-    sk_paint.setFlags(SkPaint::kAntiAlias_Flag);
 }
 
 void SkiaPaintRendererState::invalidate()
 {
-    valid = false;
+    // Shapes remake their brushes when they see a new serial.
+    serial++;
 }
 
 // SkiaSolidColorPaintRendererState
@@ -653,11 +819,8 @@ SkiaSolidColorPaintRendererState::SkiaSolidColorPaintRendererState(RendererPtr r
 {
 }
 
-void SkiaSolidColorPaintRendererState::validate(float opacity)
+void SkiaSolidColorPaintRendererState::setPaint(SkPaint &sk_paint, float opacity)
 {
-    if (valid && opacity == this->opacity) {
-        return;
-    }
     SolidColorPaint *p = dynamic_cast<SolidColorPaint*>(owner);
     assert(p);
     if (p) {
@@ -669,22 +832,20 @@ void SkiaSolidColorPaintRendererState::validate(float opacity)
                          U8CPU(color.g),
                          U8CPU(color.b));
     }
-    valid = true;
 }
 
 // SkiaGradientPaintRendererState
 
 SkiaGradientPaintRendererState::SkiaGradientPaintRendererState(RendererPtr renderer, GradientPaint *paint)
     : SkiaPaintRendererState(renderer, paint, true)
-    , gradient(0)
 {
-    setOpacity(opacity);
 }
 
-SkiaGradientPaintRendererState::~SkiaGradientPaintRendererState() {
-    if (gradient) {
-        gradient->unref();
-    }
+void SkiaGradientPaintRendererState::setPaint(SkPaint &sk_paint, float opacity)
+{
+    // Skia has no way to update just the color ramp so each opacity gets
+    // an entire gradient shader. :-(
+    sk_paint.setShader(createShader(opacity))->unref();
 }
 
 static SkShader::TileMode spread_method_to_skia_tile_mode(SpreadMethod spread_method)
@@ -705,6 +866,7 @@ static SkShader::TileMode spread_method_to_skia_tile_mode(SpreadMethod spread_me
 }
 
 int SkiaGradientPaintRendererState::allocRampData(const GradientPaint *paint,
+                                                  float opacity,
                                                   SkColor* &colors,
                                                   SkScalar* &pos,
                                                   SkShader::TileMode &mode) {
@@ -740,37 +902,22 @@ void SkiaGradientPaintRendererState::freeRampData(SkColor* &colors, SkScalar* &p
 SkiaLinearGradientPaintRendererState::SkiaLinearGradientPaintRendererState(RendererPtr renderer, LinearGradientPaint *paint)
     : SkiaGradientPaintRendererState(renderer, paint)
 {
-    createShader(paint);
 }
 
-void SkiaLinearGradientPaintRendererState::createShader(const LinearGradientPaint *paint)
+SkShader *SkiaLinearGradientPaintRendererState::createShader(float opacity)
 {
+    const LinearGradientPaint *paint = dynamic_cast<LinearGradientPaint*>(owner);
+    assert(paint);
     SkColor *colors = NULL;
     SkScalar *pos = NULL;
     SkShader::TileMode mode;
-    int count = allocRampData(paint, colors, pos, mode);
+    int count = allocRampData(paint, opacity, colors, pos, mode);
     SkUnitMapper* mapper = 0;
     SkPoint p[2] = { { paint->getV1().x, paint->getV1().y },
                      { paint->getV2().x, paint->getV2().y } };
-    gradient = SkGradientShader::CreateLinear(p, colors, pos, count, mode, mapper);
+    SkShader *gradient = SkGradientShader::CreateLinear(p, colors, pos, count, mode, mapper);
     freeRampData(colors, pos);
-    sk_paint.setShader(gradient);
-}
-
-void SkiaLinearGradientPaintRendererState::validate(float opacity)
-{
-    if (valid && opacity == this->opacity) {
-        return;
-    }
-    const LinearGradientPaint *paint = dynamic_cast<LinearGradientPaint*>(owner);
-    assert(paint);
-    if (paint) {
-        setOpacity(opacity);
-        gradient->unref();
-        // Skia has no way to update just the color ramp so we must update the entire linear gradient shader. :-(
-        createShader(paint);
-    }
-    valid = true;
+    return gradient;
 }
 
 // SkiaGradientPaintRendererState
@@ -778,14 +925,16 @@ void SkiaLinearGradientPaintRendererState::validate(float opacity)
 SkiaRadialGradientPaintRendererState::SkiaRadialGradientPaintRendererState(RendererPtr renderer, RadialGradientPaint *paint)
     : SkiaGradientPaintRendererState(renderer, paint)
 {
-    createShader(paint);
 }
 
-void SkiaRadialGradientPaintRendererState::createShader(const RadialGradientPaint *paint) {
+SkShader *SkiaRadialGradientPaintRendererState::createShader(float opacity)
+{
+    const RadialGradientPaint *paint = dynamic_cast<RadialGradientPaint*>(owner);
+    assert(paint);
     SkColor *colors = NULL;
     SkScalar *pos = NULL;
     SkShader::TileMode mode;
-    int count = allocRampData(paint, colors, pos, mode);
+    int count = allocRampData(paint, opacity, colors, pos, mode);
     SkUnitMapper* mapper = 0;
     SkPoint center = { paint->getCenter().x, paint->getCenter().y },
             focal_point = { paint->getFocalPoint().x, paint->getFocalPoint().y };
@@ -810,26 +959,10 @@ void SkiaRadialGradientPaintRendererState::createShader(const RadialGradientPain
     // endRadius to be < 0, or for startRadius to be equal to endRadius. 
     assert(count >= 2);
     assert(radius > 0);
-    gradient = SkGradientShader::CreateTwoPointRadial(focal_point, 0, center, radius,
+    SkShader *gradient = SkGradientShader::CreateTwoPointRadial(focal_point, 0, center, radius,
       colors, pos, count, mode, mapper);
     freeRampData(colors, pos);
-    sk_paint.setShader(gradient);
-}
-
-void SkiaRadialGradientPaintRendererState::validate(float opacity)
-{
-    if (valid && opacity == this->opacity) {
-        return;
-    }
-    const RadialGradientPaint *paint = dynamic_cast<RadialGradientPaint*>(owner);
-    assert(paint);
-    if (paint) {
-        setOpacity(opacity);
-        gradient->unref();
-        // Skia has no way to update just the color ramp so we must update the entire radial gradient shader. :-(
-        createShader(paint);
-    }
-    valid = true;
+    return gradient;
 }
 
 // SkiaImagePaintRendererState
@@ -837,7 +970,6 @@ void SkiaRadialGradientPaintRendererState::validate(float opacity)
 SkiaImagePaintRendererState::SkiaImagePaintRendererState(RendererPtr renderer, ImagePaint *paint)
     : SkiaPaintRendererState(renderer, paint, false)
 {
-    SkBitmap bitmap_image;
     bitmap_image.setConfig(SkBitmap::kARGB_8888_Config, paint->image->width, paint->image->height);
     bitmap_image.allocPixels();
     SkPixelRef *pixels = bitmap_image.pixelRef();
@@ -851,27 +983,21 @@ SkiaImagePaintRendererState::SkiaImagePaintRendererState(RendererPtr renderer, I
 
     pixels->unlockPixels();
     bitmap_image.buildMipMap();
-    bitmap = SkShader::CreateBitmapShader(bitmap_image,
-                                          SkShader::kClamp_TileMode,
-                                          SkShader::kClamp_TileMode);
+}
 
-    sk_paint.setShader(bitmap);
-    bool yes_filter = true;
-    sk_paint.setFilterBitmap(yes_filter);
+SkShader *SkiaImagePaintRendererState::createShader(float opacity)
+{
+    return SkShader::CreateBitmapShader(bitmap_image,
+                                        SkShader::kClamp_TileMode,
+                                        SkShader::kClamp_TileMode);
 }
 
-void SkiaImagePaintRendererState::validate(float opacity)
+void SkiaImagePaintRendererState::setPaint(SkPaint &sk_paint, float opacity)
 {
-    if (valid && opacity == this->opacity) {
-        return;
-    }
-    const ImagePaint *paint = dynamic_cast<ImagePaint*>(owner);
-    assert(paint);
-    if (paint) {
-        setOpacity(opacity);
-        // XXX should multiply image by opacity here??
-    }
-    valid = true;
+    // XXX should multiply image by opacity here??
+    sk_paint.setShader(createShader(opacity))->unref();
+    bool yes_filter = true;
+    sk_paint.setFilterBitmap(yes_filter);
 }
 
 #endif // USE_SKIA
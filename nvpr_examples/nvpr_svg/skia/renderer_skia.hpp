@@ -14,6 +14,7 @@
 
 #include "path.hpp"
 #include "scene.hpp"
+#include "tile_pool.hpp"
 
 #ifdef _WIN32
 #define GR_WIN32_BUILD 1
@@ -57,8 +58,14 @@ struct SkiaRenderer : GLBlitRenderer {
     SkCanvas canvas;
     bool cache_paths : 1;
 
+    bool clipped : 1;
+
+    // Draws tiles in parallel when it has more than one thread.
+    TilePoolPtr tile_pool;
+
     SkiaRenderer()
         : cache_paths(true)
+        , clipped(false)
     { }
 
     ~SkiaRenderer() {
@@ -69,10 +76,23 @@ struct SkiaRenderer : GLBlitRenderer {
     void configureSurface(int width, int height);
     void shutdown();
 
+    bool clipToRect(int x, int y, int width, int height);
+    bool scrollSurface(int dx, int dy);
     void clear(float3 clear_color);
     void setView(float4x4 view);
+    void endDraw();
     VisitorPtr makeVisitor();
+    void drawScene(GroupPtr scene, const float4x4 &scene_to_surface,
+                   const float4 &surface_rect, bool cull);
+    void drawSceneRect(GroupPtr scene, const float4x4 &scene_to_surface,
+                       int x, int y, int width, int height, bool cull);
+    // Draws the area of the surface in tiles, on the tile threads if any.
+    void drawTiles(GroupPtr scene, const float4x4 &scene_to_surface,
+                   const TileRect &area, bool cull);
+    bool setTileThreads(int threads);
+    int getTileThreads();
     void copyImageToWindow();
+    bool readPixels(unsigned char *rgba);
     const char *getWindowTitle();
     const char *getName();
 
@@ -89,7 +109,35 @@ struct SkiaRendererState : SpecificRendererState<T,SkiaRenderer> {
     {}
 };
 
+typedef shared_ptr<struct SkiaPaintRendererState> SkiaPaintRendererStatePtr;
+
 struct SkiaShapeRendererState : SkiaRendererState<Shape> {
+protected:
+    // A fill or stroke SkPaint of the shape's own, with its stroking
+    // properties and a shader fit to its bounds, so drawing changes no
+    // paint other shapes share.  Skia shaders keep per-draw state, so tiles
+    // drawing the shape at once each need a copy of the shader.
+    struct Brush {
+        SkPaint paint;
+        SkiaPaintRendererStatePtr paint_state;
+        unsigned int serial;  // of paint_state when paint was made
+        float opacity;
+        SkMatrix shader_matrix;  // local matrix of any shader
+
+        Brush()
+            : serial(0)
+            , opacity(1)
+        {}
+        bool isCurrent(SkiaPaintRendererStatePtr state);
+        void drawPath(SkCanvas &canvas, const SkPath &path, bool private_shader);
+    };
+    Brush fill, stroke;
+    float4 bounds;  // the owner's when the brushes were made
+
+    void setBrush(Brush &brush, PaintPtr paint, float opacity);
+    void setStrokeStyle(SkPaint &sk_paint);
+
+public:
     bool valid;
 
     SkiaShapeRendererState(RendererPtr renderer, Shape *shape)
@@ -106,11 +154,14 @@ struct SkiaShapeRendererState : SkiaRendererState<Shape> {
         return skia_path_state;
     }
 
-    void draw();
+    // Draws on canvas; call validate() first.  Tiles drawing at once
+    // need private_shaders.
+    void draw(SkCanvas &canvas, bool private_shaders = false);
     void getPaths(vector<SkPath*>& paths);
+    // Makes the brushes and the path, so tiles may draw a validated shape
+    // at once.
     void validate();
     void invalidate();
-    SkPaint &getPaint(PaintPtr paint, float opacity);
 };
 
 struct SkiaPathRendererState : RendererState<Path> {
@@ -134,29 +185,24 @@ struct SkiaPathRendererState : RendererState<Path> {
     }
 };
 
-typedef shared_ptr<struct SkiaPaintRendererState> SkiaPaintRendererStatePtr;
 struct SkiaPaintRendererState : SkiaRendererState<Paint> {
 protected:
-    bool valid;
-    SkPaint sk_paint;
-    float opacity;
+    unsigned int serial;  // counts invalidations
     const bool needs_gradient_matrix;
 
 public:
     SkiaPaintRendererState(RendererPtr renderer, Paint *paint, bool is_gradient);
     virtual ~SkiaPaintRendererState() {}
-    virtual void validate(float opacity) = 0;
+    // Sets sk_paint's color, or its shader when the paint has one, for
+    // the paint at opacity.
+    virtual void setPaint(SkPaint &sk_paint, float opacity) = 0;
+    // Returns a new shader for the paint at opacity, or NULL if it has
+    // none; unref it when done.
+    virtual SkShader *createShader(float opacity) { return NULL; }
     void invalidate();
 
-    inline void setOpacity(float new_opacity) {
-        if (new_opacity != opacity) {
-            opacity = new_opacity;
-            valid = false;
-        }
-    }
-
-    inline SkPaint &getPaint() {
-        return sk_paint;
+    inline unsigned int getSerial() const {
+        return serial;
     }
 
     inline bool needsGradientMatrix() {
@@ -166,41 +212,41 @@ public:
 
 struct SkiaSolidColorPaintRendererState : SkiaPaintRendererState {
     SkiaSolidColorPaintRendererState(RendererPtr renderer, SolidColorPaint *paint);
-    void validate(float opacity);
+    void setPaint(SkPaint &sk_paint, float opacity);
 };
 
 // Base functionality used by both linear and radial gradeints
 typedef shared_ptr<struct SkiaGradientPaintRendererState> SkiaGradientPaintRendererStatePtr;
 struct SkiaGradientPaintRendererState : SkiaPaintRendererState {
-    SkShader *gradient;
-
 protected:
     SkiaGradientPaintRendererState(RendererPtr renderer, GradientPaint *paint);
-    ~SkiaGradientPaintRendererState();
     int allocRampData(const GradientPaint *paint,
+                      float opacity,
                       SkColor* &colors,
                       SkScalar* &pos,
                       SkShader::TileMode &mode);
     void freeRampData(SkColor* &colors, SkScalar* &pos);
+
+public:
+    void setPaint(SkPaint &sk_paint, float opacity);
 };
 
 struct SkiaLinearGradientPaintRendererState : SkiaGradientPaintRendererState {
     SkiaLinearGradientPaintRendererState(RendererPtr renderer, LinearGradientPaint *paint);
-    void createShader(const LinearGradientPaint *paint);
-    void validate(float opacity);
+    SkShader *createShader(float opacity);
 };
 
 struct SkiaRadialGradientPaintRendererState : SkiaGradientPaintRendererState {
     SkiaRadialGradientPaintRendererState(RendererPtr renderer, RadialGradientPaint *paint);
-    void createShader(const RadialGradientPaint *paint);
-    void validate(float opacity);
+    SkShader *createShader(float opacity);
 };
 
 struct SkiaImagePaintRendererState : SkiaPaintRendererState {
-    SkShader *bitmap;  // SkShader::CreateBitmapShader 
+    SkBitmap bitmap_image;
 
     SkiaImagePaintRendererState(RendererPtr renderer, ImagePaint *paint);
-    void validate(float opacity);
+    void setPaint(SkPaint &sk_paint, float opacity);
+    SkShader *createShader(float opacity);
 };
 
 #endif // USE_SKIA
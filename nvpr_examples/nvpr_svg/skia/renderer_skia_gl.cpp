@@ -0,0 +1,36 @@
+/* renderer_skia_gl.cpp - show the Skia bitmap in the GL window */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+// Kept apart from renderer_skia.cpp so programs without a GL window,
+// like svg_render, link the Skia renderer without OpenGL.
+
+#include "nvpr_svg_config.h"  // configure path renderers to use
+
+#if USE_SKIA
+
+#include <assert.h>
+
+#include <SkTypes.h>
+#include "renderer_skia.hpp"
+
+void SkiaRenderer::copyImageToWindow()
+{
+    glWindowPos2f(0,0);
+
+    //bitmap.lockPixels();
+
+    const int w = bitmap.width(),
+              h = bitmap.height();
+
+    const void *pixels = bitmap.getPixels();
+
+    assert(bitmap.rowBytes() == w*4);
+    // Skia's RGBA component layout philosophy is "default to OpenGL order (in memory: r,g,b,a)".
+    // See comment and definitions in "SkColorPrive.h".
+    glDrawPixels(w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    //bitmap.unlockPixels();
+}
+
+#endif // USE_SKIA
@@ -37,31 +37,34 @@ void Draw::visit(ShapePtr shape)
 {
     ShapeRendererStatePtr renderer_state = shape->getRendererState(renderer);
     SkiaShapeRendererStatePtr shape_renderer = dynamic_pointer_cast<SkiaShapeRendererState>(renderer_state);
-    shape_renderer->draw();
+    if (!tiled) {
+        shape_renderer->validate();
+    }
+    shape_renderer->draw(canvas, tiled);
 }
 
 void Draw::apply(TransformPtr transform)
 {
-    renderer->canvas.save(SkCanvas::kMatrix_SaveFlag);
-    renderer->canvas.concat(gl2skia(transform->getMatrix()));
+    canvas.save(SkCanvas::kMatrix_SaveFlag);
+    canvas.concat(gl2skia(transform->getMatrix()));
 }
 
 void Draw::unapply(TransformPtr transform)
 {
-    renderer->canvas.restore();
+    canvas.restore();
 }
 
 void Draw::apply(ClipPtr clip)
 {
-    renderer->canvas.save(SkCanvas::kClip_SaveFlag);
-    ClipVisitorPtr clip_visitor(new ClipVisitor(renderer));
+    canvas.save(SkCanvas::kClip_SaveFlag);
+    ClipVisitorPtr clip_visitor(new ClipVisitor(renderer, canvas));
     clip->path->traverse(clip_visitor);
     clip_visitor->startClipping(clip->clip_merge);
 }
 
 void Draw::unapply(ClipPtr clip)
 {
-    renderer->canvas.restore();
+    canvas.restore();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -84,7 +87,7 @@ void ClipVisitor::visit(ShapePtr shape)
 
 void ClipVisitor::apply(ClipPtr clip)
 {
-    ClipVisitorPtr clip_visitor(new ClipVisitor(renderer));
+    ClipVisitorPtr clip_visitor(new ClipVisitor(renderer, canvas));
     clip->path->traverse(clip_visitor);
     clip_visitor->startClipping(clip->clip_merge);
 }
@@ -103,7 +106,35 @@ void ClipVisitor::startClipping(ClipMerge clip_merge)
 
     path.setFillType(clip_merge == SUM_WINDING_NUMBERS ? 
         SkPath::kWinding_FillType : SkPath::kEvenOdd_FillType);
-    renderer->canvas.clipPath(path, SkRegion::kIntersect_Op);
+    canvas.clipPath(path, SkRegion::kIntersect_Op);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Validate
+void Validate::visit(ShapePtr shape)
+{
+    ShapeRendererStatePtr renderer_state = shape->getRendererState(renderer);
+    SkiaShapeRendererStatePtr shape_renderer = dynamic_pointer_cast<SkiaShapeRendererState>(renderer_state);
+    shape_renderer->validate();
+}
+
+void Validate::apply(ClipPtr clip)
+{
+    clip->path->traverse(VisitorPtr(new ValidateClip(renderer)));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ValidateClip
+void ValidateClip::visit(ShapePtr shape)
+{
+    ShapeRendererStatePtr renderer_state = shape->getRendererState(renderer);
+    SkiaShapeRendererStatePtr shape_renderer = dynamic_pointer_cast<SkiaShapeRendererState>(renderer_state);
+    shape_renderer->getPathRendererState()->validate();
+}
+
+void ValidateClip::apply(ClipPtr clip)
+{
+    clip->path->traverse(VisitorPtr(new ValidateClip(renderer)));
 }
 
 
@@ -18,9 +18,16 @@
 
 namespace SkiaVisitors {
 
+    // Draws on canvas.  Tiles draw shapes Validate has already
+    // validated, so they pass tiled, which also gives each shader drawn a
+    // private copy.
     class Draw : public Visitor {
     public:
-        Draw(SkiaRendererPtr renderer_) : renderer(renderer_) { }
+        Draw(SkiaRendererPtr renderer_, SkCanvas &canvas_, bool tiled_ = false)
+            : renderer(renderer_)
+            , canvas(canvas_)
+            , tiled(tiled_)
+        { }
 
         void visit(ShapePtr shape);
 
@@ -32,11 +39,16 @@ namespace SkiaVisitors {
 
     protected:
         SkiaRendererPtr renderer;
+        SkCanvas &canvas;
+        bool tiled;
     };
 
     class ClipVisitor : public MatrixSaveVisitor {
     public:
-        ClipVisitor(SkiaRendererPtr renderer_) : renderer(renderer_) { }
+        ClipVisitor(SkiaRendererPtr renderer_, SkCanvas &canvas_)
+            : renderer(renderer_)
+            , canvas(canvas_)
+        { }
 
         void visit(ShapePtr shape);
 
@@ -47,10 +59,38 @@ namespace SkiaVisitors {
 
     protected:
         SkiaRendererPtr renderer;
+        SkCanvas &canvas;
         vector<SkPath> paths;
     };
     typedef shared_ptr<ClipVisitor> ClipVisitorPtr;
 
+    // Validates every shape Draw would visit, so the tiles drawn next
+    // share only read-only renderer states.
+    class Validate : public Visitor {
+    public:
+        Validate(SkiaRendererPtr renderer_) : renderer(renderer_) { }
+
+        void visit(ShapePtr shape);
+
+        void apply(ClipPtr clip);
+
+    protected:
+        SkiaRendererPtr renderer;
+    };
+
+    // Validates the paths a ClipVisitor would get.
+    class ValidateClip : public Visitor {
+    public:
+        ValidateClip(SkiaRendererPtr renderer_) : renderer(renderer_) { }
+
+        void visit(ShapePtr shape);
+
+        void apply(ClipPtr clip);
+
+    protected:
+        SkiaRendererPtr renderer;
+    };
+
 
 };
 
@@ -92,7 +92,7 @@ void StCRenderer::reportFPS()
 static void getStencilInfo(PathPtr path, GLuint stencil_read_mask, GLuint stencil_func, 
                     GLuint &cover_stencil_read_mask, StencilMode &mode)
 {
-    if (path->style.fill_rule == PathStyle::EVEN_ODD) {
+    if (path->style->fill_rule == PathStyle::EVEN_ODD) {
         cover_stencil_read_mask = 0x1;
         mode = INVERT;
     } else {
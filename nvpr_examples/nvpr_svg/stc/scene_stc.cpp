@@ -530,9 +530,19 @@ GatherStats::GatherStats(StCRendererPtr renderer, PathStats &t, PathStats &m)
     : StCVisitor(renderer)
     , total_stats(t)
     , max_stats(m)
+    , paint_uses(0)
+    , path_style_uses(0)
 {
 }
 
+void GatherStats::countPaint(const PaintPtr &paint)
+{
+    if (paint) {
+        paints.insert(paint.get());
+        paint_uses++;
+    }
+}
+
 void GatherStats::visit(ShapePtr shape)
 {
     PathStats stats;
@@ -540,6 +550,11 @@ void GatherStats::visit(ShapePtr shape)
     shape->getPath()->gatherStats(stats);
     total_stats.add(stats);
     max_stats.max(stats);
+
+    countPaint(shape->getFillPaint());
+    countPaint(shape->getStrokePaint());
+    path_styles.insert(shape->getPath()->style.get());
+    path_style_uses++;
 }
 
 }
@@ -7,6 +7,8 @@
 # pragma once
 #endif
 
+#include <set>
+
 #include "scene.hpp"
 #include "renderer_stc.hpp"
 
@@ -214,9 +216,22 @@ namespace StCVisitors {
         GatherStats(StCRendererPtr renderer, PathStats &t, PathStats &m);
         void visit(ShapePtr shape);
 
+        // Distinct paint and path style objects versus how many times
+        // shapes use them (counting fill and stroke paints separately).
+        inline size_t getUniquePaints() const { return paints.size(); }
+        inline size_t getTotalPaints() const { return paint_uses; }
+        inline size_t getUniquePathStyles() const { return path_styles.size(); }
+        inline size_t getTotalPathStyles() const { return path_style_uses; }
+
     protected:
         PathStats &total_stats;
         PathStats &max_stats;
+        std::set<const Paint*> paints;
+        std::set<const PathStyle*> path_styles;
+        size_t paint_uses;
+        size_t path_style_uses;
+
+        void countPaint(const PaintPtr &paint);
     };
 
 };
@@ -19,7 +19,10 @@
 #include <Cg/inverse.hpp>
 
 #include "svg_loader.hpp"
+#include "scene_intern.hpp"
+#include "image_cache.hpp"
 #include "color_names.hpp"
+#include "countof.h"
 
 #include <string>
 #include <map>
@@ -227,8 +230,6 @@ NodePtr ClipInfo::createClip(NodePtr node)
 }
 
 
-static SolidColorPtr blackSolidColor(new SolidColor(float4(0,0,0,1)));
-
 enum TextAnchor {
     START,
     MIDDLE,
@@ -252,7 +253,7 @@ struct StyleInfo {
         : color(float4(0,0,0,1))
         , matrix(identity)
         , opacity(1)
-        , fill(blackSolidColor)
+        , fill(PaintServerPtr())  // see StyleInfoStack
         , stroke(PaintServerPtr())
         , fill_opacity(1)
         , stroke_opacity(1)
@@ -288,12 +289,47 @@ struct StyleInfo {
 
         return child;
     }
+
+    // Would children inheriting from either style parse the same?
+    bool sameInheritedValues(const StyleInfo &other) const;
 };
 
+// Solid colors are compared by value since each fill="color" gets its own.
+static bool samePaintServer(const PaintServerPtr &a, const PaintServerPtr &b)
+{
+    if (a == b) {
+        return true;
+    }
+    SolidColorPtr sa = dynamic_pointer_cast<SolidColor>(a),
+                  sb = dynamic_pointer_cast<SolidColor>(b);
+    if (!sa || !sb) {
+        return false;
+    }
+    return all(sa->color == sb->color);
+}
+
+bool StyleInfo::sameInheritedValues(const StyleInfo &other) const
+{
+    if (!all(color == other.color)) {
+        return false;
+    }
+    return path == other.path &&
+           opacity == other.opacity &&
+           samePaintServer(fill, other.fill) &&
+           samePaintServer(stroke, other.stroke) &&
+           fill_opacity == other.fill_opacity &&
+           stroke_opacity == other.stroke_opacity &&
+           clip_path == other.clip_path &&
+           text_anchor == other.text_anchor &&
+           font_family == other.font_family;
+}
+
 struct StyleInfoStack : vector<StyleInfo> { // Can't use stack because we need access to the second-to-top
     StyleInfoStack() {
-        // Push default values for a pseudo-parent
+        // Push default values for a pseudo-parent.  Each stack gets its own
+        // black so parsers on different threads share nothing.
         push_back(StyleInfo());
+        top().fill = SolidColorPtr(new SolidColor(float4(0,0,0,1)));
     }
 
     inline void pushChild() {
@@ -323,6 +359,28 @@ struct StyleInfoStack : vector<StyleInfo> { // Can't use stack because we need a
     }
 };
 
+// Where an element's markup lies in its file, so the streaming loader can
+// parse it again once everything it refers to has been seen.
+struct SourceRange {
+    long offset;
+    size_t length;
+
+    SourceRange() : offset(0), length(0) {}
+    SourceRange(long o, size_t l) : offset(o), length(l) {}
+};
+typedef map<string,SourceRange> SourceRangeMap;
+
+// A subtree parsed for a <use> along with the style it inherited there;
+// later <use>s of the same element inheriting the same values share it.
+struct SharedUse {
+    StyleInfo inherited;
+    NodePtr node;
+};
+typedef map<string,vector<SharedUse> > SharedUseMap;
+typedef map<string,vector<PathPtr> > SharedPathMap;
+
+struct SVGSource;
+
 struct SVGParser {
     typedef map<string,string> StyleMap;
 
@@ -335,8 +393,28 @@ struct SVGParser {
     TiXmlDocument doc;
     SvgScenePtr scene;
     string root_dir;
+    float pixels_per_millimeter;  // for physical units
+
+    // Streaming loader state; source is NULL when parsing a whole document.
+    SVGSource *source;
+    TiXmlEncoding encoding;
+    SourceRangeMap source_ranges;   // replaces use_map when streaming
+    int unresolved_references;      // failed paint server, clip path and class lookups
+    bool deferring_references;      // don't complain about failed lookups yet
+
+    // <use> resolution state.  Used subtrees are shared by href, and paths
+    // parsed within them by path data, so symbols used many times are
+    // parsed (and cached by renderers) once per distinct inherited style.
+    SharedUseMap shared_uses;
+    SharedPathMap shared_paths;
+    int resolving_uses;             // nesting depth of parseUsedNode
 
-    SVGParser(const char *xmlFile);
+    // Shapes with equal paints or path styles share them.
+    SceneInterner interner;
+
+    SVGParser(float pixels_per_millimeter);
+    SVGParser(const char *xmlFile, float pixels_per_millimeter);
+    void setRootDir(const char *xmlFile);
 
     inline StyleInfo &style() { return style_stack.top(); }
     inline StyleInfo &parentStyle() { return style_stack.secondToTop(); }
@@ -348,16 +426,16 @@ struct SVGParser {
     static const char *parseStrokeLinejoin(const char *s, PathStyle::LineJoin &line_join);
     static const char *parseTextAnchor(const char *s, TextAnchor &text_anchor);
     static const char *parseFontFamily(const char *s, string &font_family);
-    static const char *parseStrokeDashArraySpace(const char *s, vector<float> &dash_array);
-    static const char *parseStrokeDashArray(const char *s, vector<float> &dash_array);
+    const char *parseStrokeDashArraySpace(const char *s, vector<float> &dash_array);
+    const char *parseStrokeDashArray(const char *s, vector<float> &dash_array);
     static int skipProblem(const char *bad_tag, const char *s);
     static void parseTransform(const char *ss, double3x3 &matrix);
     static const char *parseStrokeLineCap(const char *s, PathStyle::LineCap &line_cap);
     static const char *parseStrokeDashPhase(const char *s, PathStyle::DashPhase &dash_phase);
     static const char *parseFillRule(const char *s, PathStyle::FillRule &fill_rule);
-    static const char *parseUnit(const char *s, float &value, bool percentBounds = false);
-    static const char *parseCoordinate(const char *s, float &value, bool percentBounds = false);
-    static const char *parseLength(const char *s, float &value);
+    const char *parseUnit(const char *s, float &value, bool percentBounds = false);
+    const char *parseCoordinate(const char *s, float &value, bool percentBounds = false);
+    const char *parseLength(const char *s, float &value);
     static const char *parseViewBox(const char *s, float4 &viewbox);
     static const char *parseOpacity(const char *s, float &opacity, float current_opacity, float inherit_opacity);
     static const char *parseOpacity(const char *s, float &opacity, float current_opacity) { return parseOpacity(s, opacity, current_opacity, opacity); }
@@ -368,6 +446,39 @@ struct SVGParser {
     ClipInfoPtr parseClipPathReference(const char *name);
     const char *parseStyle(const char *ss, StyleInfo &style);
 
+    // Style properties and presentation attributes
+    enum PropertyUse {
+        IN_STYLE = 0x1,
+        AS_ATTRIBUTE = 0x2
+    };
+    typedef const char *(SVGParser::*PropertyParser)(const char *s, StyleInfo &style);
+    struct Property {
+        const char *name;
+        PropertyParser parse;
+        int uses;  // PropertyUse bits
+    };
+    static const Property properties[];
+    static const Property *findProperty(const char *name, size_t length, PropertyUse use);
+    const char *parseClipPathProperty(const char *s, StyleInfo &style);
+    const char *parseColorProperty(const char *s, StyleInfo &style);
+    const char *parseFillProperty(const char *s, StyleInfo &style);
+    const char *parseFillOpacityProperty(const char *s, StyleInfo &style);
+    const char *parseFillRuleProperty(const char *s, StyleInfo &style);
+    const char *parseFontFamilyProperty(const char *s, StyleInfo &style);
+    const char *parseOpacityProperty(const char *s, StyleInfo &style);
+    const char *parseStopColorProperty(const char *s, StyleInfo &style);
+    const char *parseStopOpacityProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeDashArrayProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeDashOffsetProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeDashPhaseProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeLineCapProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeLinejoinProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeMiterLimitProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeOpacityProperty(const char *s, StyleInfo &style);
+    const char *parseStrokeWidthProperty(const char *s, StyleInfo &style);
+    const char *parseTextAnchorProperty(const char *s, StyleInfo &style);
+
     bool parseGenericShapeProperty(TiXmlAttribute* a, TiXmlElement* elem);
 
     GradientStop parseGradientStop(TiXmlElement *elem);
@@ -386,11 +497,13 @@ struct SVGParser {
     NodePtr parseView(TiXmlElement *elem);
     NodePtr parseImage(TiXmlElement *elem);
 
+    PaintPtr createPaint(PaintServerPtr paint_server);
     NodePtr createShape(PathPtr path, const StyleInfo &style);
 
     NodePtr decorateNode(NodePtr node);
 
     SvgScenePtr parseScene(TiXmlElement *svg);
+    void parseSceneAttributes(TiXmlElement *svg, SvgScenePtr scene);
     
     // Definitions
     void parseSolidColor(TiXmlElement *elem);
@@ -403,9 +516,13 @@ struct SVGParser {
     NodePtr parseUse(TiXmlElement *elem);
     NodePtr parseNode(TiXmlElement *elem);
     NodePtr parseUsedNode(TiXmlElement *elem, const UsePtr &use);
+    bool resolveUse(const UsePtr &use, NodePtr &node);
+    PathPtr createPath(const char *path_string);
+    TiXmlElement *parseSource(const SourceRange &range);
     void parseSymbol(TiXmlElement *elem);
 
     void loadStyles(TiXmlNode* pParent);
+    void loadDocumentStyles(TiXmlNode* pParent);
 
     TiXmlElement* findSVG(TiXmlNode* pParent, unsigned int indent = 0);
 };
@@ -424,6 +541,9 @@ public:
     string href;
     float x, y, width, height;
     StyleInfoStack style_stack;
+    // Set by the streaming loader for an element whose references couldn't
+    // be resolved when it was read; it's parsed again in place of href.
+    SourceRange deferred;
 
     void traverse(VisitorPtr visitor, Traversal &traversal) { /* nop for now */ }
 };
@@ -472,7 +592,8 @@ bool isShapeTextOrPath(NodePtr node)
 
 // It would be difficult to implement this as a visitor since it modifies the
 // actual structure instead of just reading it (it requires a NodePtr& instead
-// of a NodePtr) we'll just do it like this
+// of a NodePtr) we'll just do it like this.  Because children get replaced
+// behind the containers' backs, each container's cached bounds are invalidated.
 template<typename T>
 void foreachUseTraversal(NodePtr &node, T functor = T())
 {
@@ -487,6 +608,7 @@ void foreachUseTraversal(NodePtr &node, T functor = T())
         foreachUseTraversal<T>(transform->node, functor);
         // FIXME node could get null'ed
         assert(transform->node);
+        transform->invalidateBounds();
         return;
     }
 
@@ -499,6 +621,7 @@ void foreachUseTraversal(NodePtr &node, T functor = T())
         std::vector<NodePtr>::iterator where;
         where = std::remove(list.begin(), list.end(), NodePtr());
         group->list.erase(where, list.end());
+        group->invalidateBounds();
 
         return;
     }
@@ -513,6 +636,7 @@ void foreachUseTraversal(NodePtr &node, T functor = T())
 
         foreachUseTraversal<T>(clip->node, functor);
         assert(clip->node);
+        clip->invalidateBounds();
     }
 }
 
@@ -520,9 +644,7 @@ struct ResolveUses {  // used with foreachUseTraversal
     SVGParser *parser;
 
     void operator()(NodePtr &node, const UsePtr &use) {
-        UseMap::const_iterator iter = parser->use_map.find(use->href);
-        if (iter != parser->use_map.end()) {
-            node = parser->parseUsedNode(iter->second, use);
+        if (parser->resolveUse(use, node)) {
             foreachUseTraversal(node, ResolveUses(parser));
         } else {
             printf("could not resolve <use> href \"%s\"\n", use->href.c_str());
@@ -550,7 +672,6 @@ const char * getIndent(unsigned int numIndents)
 }
 
 float pixels_per_viewport_width = 500;
-extern float pixels_per_millimeter;
 
 // same as getIndent but no "+" at the end
 const char * getIndentAlt(unsigned int numIndents)
@@ -752,7 +873,10 @@ const char *SVGParser::parsePaintServer(const char *s, const StyleInfo &style, P
         if (iter != paint_server_map.end()) {
             paint_server = iter->second;
         } else {
-            printf("uri %s used in class attribute doesn't exist!\n", uri);
+            unresolved_references++;
+            if (!deferring_references) {
+                printf("uri %s used in class attribute doesn't exist!\n", uri);
+            }
         }
         return s + count;
     }  else if (strcmp(s, "inherit")) {
@@ -772,7 +896,11 @@ ClipInfoPtr SVGParser::parseClipPathReference(const char *name)
     int count = 0;
     int rc = sscanf(name, " url ( # %[^) \t\n]s)%n", uri, &count);
     if (rc == 1) {
-        return ClipInfoPtr(clipPath_map[uri]);
+        ClipInfoPtr clip_info = clipPath_map[uri];
+        if (!clip_info) {
+            unresolved_references++;
+        }
+        return clip_info;
     }
 
     return ClipInfoPtr();
@@ -846,7 +974,7 @@ const char *SVGParser::parseStrokeDashPhase(const char *s, PathStyle::DashPhase
 {
     int count = 0;
     char value[20];
-    int rc = sscanf(s, " %20[A-Za-z]%n", value, &count);
+    int rc = sscanf(s, " %19[A-Za-z]%n", value, &count);
     if (rc == 1 && count > 0) {
         if (literal_match(value, "movetoResets")) {
             dash_phase = PathStyle::MOVETO_RESETS;
@@ -888,7 +1016,7 @@ const char *SVGParser::parseStrokeLinejoin(const char *s, PathStyle::LineJoin &l
 {
     int count = 0;
     char value[20];
-    int rc = sscanf(s, " %20[A-Za-z-]%n", value, &count);
+    int rc = sscanf(s, " %19[A-Za-z-]%n", value, &count);
     if (rc == 1 && count > 0) {
         if (literal_match(value, "miter-truncate")) {
             line_join = PathStyle::MITER_TRUNCATE_JOIN;
@@ -915,7 +1043,7 @@ const char *SVGParser::parseTextAnchor(const char *s, TextAnchor &text_anchor)
 {
     int count = 0;
     char value[20];
-    int rc = sscanf(s, " %20[A-Za-z-]%n", value, &count);
+    int rc = sscanf(s, " %19[A-Za-z-]%n", value, &count);
     if (rc == 1 && count > 0) {
         if (literal_match(value, "start")) {
             text_anchor = START;
@@ -1048,7 +1176,7 @@ const char *SVGParser::parseStrokeDashArray(const char *s, vector<float> &dash_a
 {
     int count = 0;
     char value[20];
-    int rc = sscanf(s, " %20[A-Za-z-]%n", value, &count);
+    int rc = sscanf(s, " %19[A-Za-z-]%n", value, &count);
     if (rc == 1 && count > 0) {
         if (literal_match(value, "none")) {
             dash_array.clear();
@@ -1076,160 +1204,212 @@ const char *SVGParser::parseStrokeDashArray(const char *s, vector<float> &dash_a
     return s;
 }
 
-const char *SVGParser::parseStyle(const char *ss, StyleInfo &style)
+// Style properties and presentation attributes share one table of
+// parsers, sorted by name for binary search.  Each parser takes the
+// property's value and returns where it stopped.
+const SVGParser::Property SVGParser::properties[] = {
+    { "clip-path",         &SVGParser::parseClipPathProperty,        AS_ATTRIBUTE },
+    { "color",             &SVGParser::parseColorProperty,           IN_STYLE | AS_ATTRIBUTE },
+    { "fill",              &SVGParser::parseFillProperty,            IN_STYLE | AS_ATTRIBUTE },
+    { "fill-opacity",      &SVGParser::parseFillOpacityProperty,     IN_STYLE | AS_ATTRIBUTE },
+    { "fill-rule",         &SVGParser::parseFillRuleProperty,        IN_STYLE | AS_ATTRIBUTE },
+    { "font-family",       &SVGParser::parseFontFamilyProperty,      IN_STYLE },
+    { "opacity",           &SVGParser::parseOpacityProperty,         IN_STYLE | AS_ATTRIBUTE },
+    { "stop-color",        &SVGParser::parseStopColorProperty,       IN_STYLE | AS_ATTRIBUTE },
+    { "stop-opacity",      &SVGParser::parseStopOpacityProperty,     IN_STYLE | AS_ATTRIBUTE },
+    { "stroke",            &SVGParser::parseStrokeProperty,          IN_STYLE | AS_ATTRIBUTE },
+    { "stroke-dasharray",  &SVGParser::parseStrokeDashArrayProperty, IN_STYLE | AS_ATTRIBUTE },
+    { "stroke-dashoffset", &SVGParser::parseStrokeDashOffsetProperty,IN_STYLE | AS_ATTRIBUTE },
+    { "stroke-dashphase",  &SVGParser::parseStrokeDashPhaseProperty, AS_ATTRIBUTE },
+    { "stroke-linecap",    &SVGParser::parseStrokeLineCapProperty,   IN_STYLE | AS_ATTRIBUTE },
+    { "stroke-linejoin",   &SVGParser::parseStrokeLinejoinProperty,  IN_STYLE | AS_ATTRIBUTE },
+    { "stroke-miterlimit", &SVGParser::parseStrokeMiterLimitProperty,IN_STYLE | AS_ATTRIBUTE },
+    { "stroke-opacity",    &SVGParser::parseStrokeOpacityProperty,   IN_STYLE | AS_ATTRIBUTE },
+    { "stroke-width",      &SVGParser::parseStrokeWidthProperty,     IN_STYLE | AS_ATTRIBUTE },
+    { "text-anchor",       &SVGParser::parseTextAnchorProperty,      IN_STYLE },
+};
+
+// Style property names are matched ignoring case for Microsoft content
+// that capitalizes them (piechart.svg is an example); attribute names
+// must match exactly.
+const SVGParser::Property *SVGParser::findProperty(const char *name, size_t length, PropertyUse use)
 {
-    int count=0;
+    size_t lo = 0,
+           hi = countof(properties);
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const char *candidate = properties[mid].name;
+        int order = 0;
+        size_t i = 0;
+        for (; i<length && order == 0; i++) {
+            const int c = use == IN_STYLE ? tolower((unsigned char)name[i]) : name[i];
+            order = c - candidate[i];  // a shorter candidate compares less
+        }
+        if (order == 0 && candidate[i] != '\0') {
+            order = -1;
+        }
+        if (order == 0) {
+            return (properties[mid].uses & use) ? &properties[mid] : NULL;
+        }
+        if (order < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
 
-    while (ss && *ss) {
-        char expecting_colon[2] = { 0, 0 };
+const char *SVGParser::parseClipPathProperty(const char *s, StyleInfo &style)
+{
+    style.clip_path = parseClipPathReference(s);
+    return s + strlen(s);
+}
 
-        ss = skip_semicolons(ss);
-        const char *start = ss;
+const char *SVGParser::parseColorProperty(const char *s, StyleInfo &style)
+{
+    return parseColor(s, style.color);
+}
 
-        // Hack for Microsoft content where attributs can be capitalized in styles
-        // piechart.svg is an example of this
-        char lowered_ss[200];
-        int i;
-        for (i=0; ss[i]!='\0' && ss[i]!=':'; i++) {
-            lowered_ss[i] = tolower(ss[i]);
-        }
-        if (ss[i]!='\0') {
-            lowered_ss[i] = ss[i];
-            i++;
+const char *SVGParser::parseFillProperty(const char *s, StyleInfo &style)
+{
+    return parsePaintServer(s, style, style.fill);
+}
+
+const char *SVGParser::parseFillOpacityProperty(const char *s, StyleInfo &style)
+{
+    return parseOpacity(s, style.fill_opacity);
+}
+
+const char *SVGParser::parseFillRuleProperty(const char *s, StyleInfo &style)
+{
+    return parseFillRule(s, style.path.fill_rule);
+}
+
+const char *SVGParser::parseFontFamilyProperty(const char *s, StyleInfo &style)
+{
+    return parseFontFamily(s, style.font_family);
+}
+
+const char *SVGParser::parseOpacityProperty(const char *s, StyleInfo &style)
+{
+    return parseOpacity(s, style.opacity);
+}
+
+const char *SVGParser::parseStopColorProperty(const char *s, StyleInfo &style)
+{
+    return parseColor(s, style.stop_color, style.color, parentStyle().stop_color);
+}
+
+const char *SVGParser::parseStopOpacityProperty(const char *s, StyleInfo &style)
+{
+    float opacity;
+    s = parseOpacity(s, opacity, style.color.a, parentStyle().stop_color.a);
+    style.stop_color.a = opacity;
+    return s;
+}
+
+const char *SVGParser::parseStrokeProperty(const char *s, StyleInfo &style)
+{
+    return parsePaintServer(s, style, style.stroke);
+}
+
+const char *SVGParser::parseStrokeDashArrayProperty(const char *s, StyleInfo &style)
+{
+    return parseStrokeDashArray(s, style.path.dash_array);
+}
+
+// http://www.w3.org/TR/SVGTiny12/painting.html#StrokeDashOffsetProperty
+const char *SVGParser::parseStrokeDashOffsetProperty(const char *s, StyleInfo &style)
+{
+    float dash_offset;
+    const char *ss = parseLength(s, dash_offset);
+    if (ss != s) {
+        style.path.dash_offset = dash_offset;
+    }
+    return ss;
+}
+
+const char *SVGParser::parseStrokeDashPhaseProperty(const char *s, StyleInfo &style)
+{
+    return parseStrokeDashPhase(s, style.path.dash_phase);
+}
+
+const char *SVGParser::parseStrokeLineCapProperty(const char *s, StyleInfo &style)
+{
+    return parseStrokeLineCap(s, style.path.line_cap);
+}
+
+const char *SVGParser::parseStrokeLinejoinProperty(const char *s, StyleInfo &style)
+{
+    return parseStrokeLinejoin(s, style.path.line_join);
+}
+
+const char *SVGParser::parseStrokeMiterLimitProperty(const char *s, StyleInfo &style)
+{
+    float miter_limit;
+    int count = 0;
+    int rc = sscanf(s, " %f%n", &miter_limit, &count);
+    if (rc == 1 && count > 0) {
+        if (miter_limit >= 1.0) {
+            style.path.miter_limit = miter_limit;
+            s += count;
+        } else {
+            // The value of <miterlimit> must be a number greater than or equal
+            // to 1. Any other value shall be treated as unsupported and processed
+            // as if the property had not been specified. 
         }
-        lowered_ss[i] = '\0';
-
-        if (ss && 1==sscanf(lowered_ss, " opacity %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseOpacity(ss, style.opacity);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " fill-opacity %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseOpacity(ss, style.fill_opacity);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " stroke-opacity %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseOpacity(ss, style.stroke_opacity);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " fill-rule %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseFillRule(ss, style.path.fill_rule);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " fill %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parsePaintServer(ss, style, style.fill);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " color %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseColor(ss, style.color);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " stop-color %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseColor(ss, style.stop_color, style.color, parentStyle().stop_color);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " stop-opacity %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            float opacity;
-
-            ss = parseOpacity(ss, opacity, style.color.a, parentStyle().stop_color.a);
-            style.stop_color.a = opacity;
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " stroke %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parsePaintServer(ss, style, style.stroke);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " stroke-width %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            float stroke_width;
-            const char *sss = parseLength(ss, stroke_width);
-            if (sss != ss) {
-                if (stroke_width < 0) {
-                    printf("SVG error: stroke-width %f is negative\n", stroke_width);
-                } else {
-                    style.path.stroke_width = stroke_width;
-                }
-                ss = sss;
-            }
+    }
+    return s;
+}
+
+const char *SVGParser::parseStrokeOpacityProperty(const char *s, StyleInfo &style)
+{
+    return parseOpacity(s, style.stroke_opacity);
+}
+
+// http://www.w3.org/TR/SVGTiny12/painting.html#StrokeWidthProperty
+const char *SVGParser::parseStrokeWidthProperty(const char *s, StyleInfo &style)
+{
+    float stroke_width;
+    const char *ss = parseLength(s, stroke_width);
+    if (ss != s) {
+        if (stroke_width < 0) {
+            printf("SVG error: stroke-width %f is negative\n", stroke_width);
+        } else {
+            style.path.stroke_width = stroke_width;
         }
-        if (ss && 1==sscanf(lowered_ss, " stroke-linecap %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseStrokeLineCap(ss, style.path.line_cap);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " stroke-linejoin %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseStrokeLinejoin(ss, style.path.line_join);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " text-anchor %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseTextAnchor(ss, style.text_anchor);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " font-family %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseFontFamily(ss, style.font_family);
-            ss = skip_semicolons(ss);
-        }
-        if (ss && 1==sscanf(lowered_ss, " stroke-miterlimit %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            float miter_limit;
-            int rc = sscanf(ss, "%f%n", &miter_limit, &count);
-            if (rc == 1 && count > 0) {
-                if (miter_limit >= 1.0) {
-                    style.path.miter_limit = miter_limit;
-                    ss += count;
-                } else {
-                    // The value of <miterlimit> must be a number greater than or equal
-                    // to 1. Any other value shall be treated as unsupported and processed
-                    // as if the property had not been specified. 
-                }
-            }
+    }
+    return ss;
+}
+
+const char *SVGParser::parseTextAnchorProperty(const char *s, StyleInfo &style)
+{
+    return parseTextAnchor(s, style.text_anchor);
+}
+
+// Parses the declarations of a style attribute or class in one pass,
+// looking each property name up in the properties table.
+const char *SVGParser::parseStyle(const char *ss, StyleInfo &style)
+{
+    while (ss && *ss) {
+        ss = skip_semicolons(ss);
+        const char *name = ss;
+        while (*ss != '\0' && *ss != ':' && *ss != ';' && !isspace(*ss)) {
+            ss++;
         }
-        // http://www.w3.org/TR/SVGTiny12/painting.html#StrokeDashOffsetProperty
-        if (ss && 1==sscanf(lowered_ss, " stroke-dashoffset %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            float dash_offset;
-            const char *sss = parseLength(ss, dash_offset);
-            if (sss != ss) {
-                style.path.dash_offset = dash_offset;
-                ss = sss;
-            }
+        const size_t length = ss - name;
+        while (isspace(*ss)) {
+            ss++;
         }
-        if (ss && 1==sscanf(lowered_ss, " stroke-dasharray %1[:]%n", expecting_colon, &count)) {
-            assert(expecting_colon[0] == ':');
-            ss += count;
-            ss = parseStrokeDashArray(ss, style.path.dash_array);
-            ss = skip_semicolons(ss);
+        const Property *property = NULL;
+        if (*ss == ':' && length > 0) {
+            property = findProperty(name, length, IN_STYLE);
         }
-        // If ss still equals start, no progress was made so...
-        if (ss == start) {
-            ss = skip_past_semicolon(ss);
+        if (property) {
+            ss = (this->*property->parse)(ss+1, style);
+        } else {
+            ss = skip_past_semicolon(name);
         }
     }
     return ss;
@@ -1431,193 +1611,97 @@ void SVGParser::parseTransform(const char *ss, double3x3 &matrix)
 
 bool SVGParser::parseGenericShapeProperty(TiXmlAttribute* a, TiXmlElement* elem)
 {
-    string name(a->Name());
+    const char *name = a->Name();
 
-    if(name == "transform") {
-        string s = a->Value();
-        s = RemoveCommas(s);
-        const char* ss = s.c_str();
-        parseTransform(ss, style().matrix);
+    const Property *property = findProperty(name, strlen(name), AS_ATTRIBUTE);
+    if (property) {
+        (this->*property->parse)(a->Value(), style());
         return true;
     }
-    if(name == "color") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-
-        ss = parseColor(ss, style().color);
-        return true;
-    }
-    if(name == "fill") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-
-        ss = parsePaintServer(ss, style(), style().fill);
-        return true;
-    }
-    if(name == "stroke") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-
-        ss = parsePaintServer(ss, style(), style().stroke);
-        return true;
-    }
-    if (name == "stroke-width") {
-        // http://www.w3.org/TR/SVGTiny12/painting.html#StrokeWidthProperty
-        string s = a->Value();
-        const char* ss = s.c_str();
-        float stroke_width;
-        const char *sss = parseLength(ss, stroke_width);
-        if (sss != ss) {
-            style().path.stroke_width = stroke_width;
-            ss = sss;
-        }
-        return true;
-    }
-    if (name == "stroke-dashoffset") {
-        // http://www.w3.org/TR/SVGTiny12/painting.html#StrokeDashOffsetProperty
-        string s = a->Value();
-        const char* ss = s.c_str();
-        float dash_offset;
-        const char *sss = parseLength(ss, dash_offset);
-        if (sss != ss) {
-            style().path.dash_offset = dash_offset;
-            ss = sss;
-        }
-        return true;
-    }
-    if (name == "stroke-dasharray") {
-        // http://www.w3.org/TR/SVGTiny12/painting.html#StrokeDashOffsetProperty
-        string s = a->Value();
-        const char* ss = s.c_str();
-        ss = parseStrokeDashArray(ss, style().path.dash_array);
-        return true;
-    }
-    if (name == "stroke-dashphase") {
+    if(!strcmp(name, "transform")) {
         string s = a->Value();
+        s = RemoveCommas(s);
         const char* ss = s.c_str();
-
-        ss = parseStrokeDashPhase(ss, style().path.dash_phase);
+        parseTransform(ss, style().matrix);
         return true;
     }
-    if(name == "style") {
-        const string s = a->Value();
-        const char* ss = s.c_str();
-
-        ss = parseStyle(ss, style());
+    if(!strcmp(name, "style")) {
+        parseStyle(a->Value(), style());
         return true;
     }
-    if(name == "class") {
+    if(!strcmp(name, "class")) {
         string s = a->Value();
         StyleMap::iterator iter = style_map.find(s);
         if (iter != style_map.end()) {
             parseStyle(iter->second.c_str(), style());
         } else {
-            printf("style %s used in class attribute doesn't exist!\n", s.c_str());
+            unresolved_references++;
+            if (!deferring_references) {
+                printf("style %s used in class attribute doesn't exist!\n", s.c_str());
+            }
         }
         return true;
     }
-    if(name == "opacity") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-
-        ss = parseOpacity(ss, style().opacity);
-        return true;
-    }
-    if(name == "fill-opacity") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-
-        ss = parseOpacity(ss, style().fill_opacity);
-        return true;
-    }    
-    if (name == "stop-color") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-
-        parseColor(ss, style().stop_color, style().color, parentStyle().stop_color);
-        return true;
-    }
-    if (name == "stop-opacity") {
+    if(!strcmp(name, "id")) {
         string s = a->Value();
-        const char* ss = s.c_str();
-
-        float opacity;
-        parseOpacity(ss, opacity, style().color.a, parentStyle().stop_color.a);
-        style().stop_color.a = opacity;
-        return true;
-    }
-    if(name == "fill-rule") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-
-        ss = parseFillRule(ss, style().path.fill_rule);
-        return true;
-    }
-    if(name == "stroke-opacity") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-
-        ss = parseOpacity(ss, style().stroke_opacity);
+        use_map[s] = elem;
         return true;
     }
-    if (name == "stroke-linecap") {
-        string s = a->Value();
-        const char* ss = s.c_str();
+    return false;
+}
 
-        ss = parseStrokeLineCap(ss, style().path.line_cap);
-        return true;
+// Paths in used subtrees are shared by every instance with the same path
+// data and style, even when their paints differ.
+PathPtr SVGParser::createPath(const char *path_string)
+{
+    if (!resolving_uses) {
+        return PathPtr(new Path(style().path, path_string));
     }
-    if (name == "stroke-linejoin") {
-        string s = a->Value();
-        const char* ss = s.c_str();
 
-        ss = parseStrokeLinejoin(ss, style().path.line_join);
-        return true;
-    }
-    if (name == "stroke-miterlimit") {
-        string s = a->Value();
-        const char* ss = s.c_str();
-        float miter_limit;
-
-        int count = 0;
-        int rc = sscanf(ss, " %f%n", &miter_limit, &count);
-        if (rc == 1 && count > 0) {
-            style().path.miter_limit = miter_limit;
-            ss += count;
+    // Match the style createShape will give the path.
+    PathStyle path_style = style().path;
+    path_style.do_fill = bool(style().fill);
+    path_style.do_stroke = bool(style().stroke);
+    vector<PathPtr> &paths = shared_paths[path_string];
+    for (size_t i=0; i<paths.size(); i++) {
+        if (*paths[i]->style == path_style) {
+            return paths[i];
         }
-        return true;
     }
-    if (name == "clip-path") {
-        style().clip_path = parseClipPathReference(a->Value());
-        return true;
-    }
-    if(name == "id") {
-        string s = a->Value();
-        use_map[s] = elem;
-        return true;
+    PathPtr path = PathPtr(new Path(path_style, path_string));
+    paths.push_back(path);
+    return path;
+}
+
+PaintPtr SVGParser::createPaint(PaintServerPtr paint_server)
+{
+    SolidColorPtr solid_color = dynamic_pointer_cast<SolidColor>(paint_server);
+    if (solid_color) {
+        return interner.internSolidColor(solid_color->color);
     }
-    return false;
+    paint_server->resolve(this->gradient_map);
+    return interner.intern(paint_server->makePaintPtr());
 }
 
 NodePtr SVGParser::createShape(PathPtr path, const StyleInfo &style)
 {
     PaintPtr fill_paint, stroke_paint;
+    PathStyle path_style = *path->style;
     if (style.fill) {
-        style.fill->resolve(this->gradient_map);
-        fill_paint = style.fill->makePaintPtr();
-        path->style.do_fill = true;
+        fill_paint = createPaint(style.fill);
+        path_style.do_fill = true;
     } else {
         fill_paint = PaintPtr();
-        path->style.do_fill = false;
+        path_style.do_fill = false;
     }
     if (style.stroke) {
-        style.stroke->resolve(this->gradient_map);
-        stroke_paint = style.stroke->makePaintPtr();
-        path->style.do_stroke = true;
+        stroke_paint = createPaint(style.stroke);
+        path_style.do_stroke = true;
     } else {
         stroke_paint = PaintPtr();
-        path->style.do_stroke = false;
+        path_style.do_stroke = false;
     }
+    path->style = interner.intern(path_style);
 
     ShapePtr shape = ShapePtr(new Shape(path,
                                         fill_paint,
@@ -2172,7 +2256,7 @@ NodePtr SVGParser::parsePath(TiXmlElement* elem)
             continue;
         }
     }
-    PathPtr path = PathPtr(new Path(style().path, path_string.c_str()));
+    PathPtr path = createPath(path_string.c_str());
     if (!path->isEmpty()) {
         NodePtr shape = createShape(path, style());
         
@@ -2330,14 +2414,26 @@ NodePtr SVGParser::parseView(TiXmlElement *elem)
 
 int base64Decode(unsigned char *s)
 {
-    static unsigned char base64_to_ascii[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    static unsigned char ascii_to_base64[256];
-    if (!ascii_to_base64[int('A')]) {
-        memset(ascii_to_base64, -1, sizeof(ascii_to_base64)); // Mark characters not in the table as such
-        for (int i = 0; i < 64; i++) {
-            ascii_to_base64[base64_to_ascii[i]] = i;
-        }
-    }
+    // Inverse of "A-Za-z0-9+/"; 255 marks characters not in the alphabet.
+    // A constant table so loader threads never build or race on it.
+    static const unsigned char ascii_to_base64[256] = {
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255, 255,  63,
+         52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255, 255, 255, 255,
+        255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+         15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255, 255,
+        255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+         41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+    };
 
     // Base 64 is 6 bits; base 256 is 8
     int idx = 0;
@@ -2364,7 +2460,7 @@ protected:
     virtual NodePtr getBaseImage() = 0;
 
 public:
-    static ImageProviderPtr FromFile(const char* filename);
+    static ImageProviderPtr FromFile(const char* filename, float pixels_per_millimeter);
     virtual ~ImageProvider() { }
     
     // http://www.w3.org/TR/SVG/struct.html#ImageElement
@@ -2503,6 +2599,16 @@ class RasterImageProvider : public ImageProvider
 public:
     static RasterImageProviderPtr FromFile(const char *filename)
     {
+        // A missing file has no key; let stbi_load fail so the caller
+        // reports why.
+        const string key = rasterImageFileKey(filename);
+        if (!key.empty()) {
+            RasterImagePtr image = findRasterImage(key);
+            if (image) {
+                return RasterImageProviderPtr(new RasterImageProvider(image));
+            }
+        }
+
         int original_bpp;
         RasterImageProviderPtr provider(new RasterImageProvider);
         // Force it to resample to 4 bytes/pixel
@@ -2527,6 +2633,9 @@ public:
                 pixels[i].g = GLubyte(g * 255 + 0.5);
                 pixels[i].b = GLubyte(b * 255 + 0.5);
             }
+            if (!key.empty()) {
+                cacheRasterImage(key, provider->image);
+            }
             return provider;
         } else {
             return RasterImageProviderPtr();
@@ -2535,6 +2644,12 @@ public:
 
     static RasterImageProviderPtr FromString(const char *s)
     {
+        const string key = rasterImageDataKey(s);
+        RasterImagePtr image = findRasterImage(key);
+        if (image) {
+            return RasterImageProviderPtr(new RasterImageProvider(image));
+        }
+
         size_t size = 1 + strlen(s);
         unsigned char *data = new unsigned char[size];
         char img_type[32];
@@ -2563,6 +2678,7 @@ public:
                         printf("image promoted from %d componets to RGBA\n", bpp);
                     }
                 }
+                cacheRasterImage(key, provider->image);
                 return provider;
             } else {
 #if USE_LIBJPEG
@@ -2607,6 +2723,7 @@ public:
                     jpeg_finish_decompress(&cinfo);
                     printf("finished decompress!\n\r");
                     jpeg_destroy_decompress(&cinfo);
+                    cacheRasterImage(key, provider->image);
                     return provider;
                 }
 #endif
@@ -2663,6 +2780,7 @@ protected:
 
 private:
     RasterImageProvider() : image(new RasterImage()) { }
+    RasterImageProvider(RasterImagePtr image_) : image(image_) { }
     RasterImagePtr image;
 };
 
@@ -2670,9 +2788,9 @@ typedef shared_ptr<class SvgImageProvider> SvgImageProviderPtr;
 class SvgImageProvider : public ImageProvider
 {
 public:
-    static SvgImageProviderPtr FromFile(const char *filename)
+    static SvgImageProviderPtr FromFile(const char *filename, float pixels_per_millimeter)
     {
-        SVGParser parser(filename);
+        SVGParser parser(filename, pixels_per_millimeter);
         if (parser.scene) {
             return SvgImageProviderPtr(new SvgImageProvider(parser.scene));
         }
@@ -2714,14 +2832,14 @@ private:
     bool deferring_aspect_ratio;
 };
 
-ImageProviderPtr ImageProvider::FromFile(const char* filename)
+ImageProviderPtr ImageProvider::FromFile(const char* filename, float pixels_per_millimeter)
 {
     RasterImageProviderPtr rip = RasterImageProvider::FromFile(filename);
     if (rip) {
         return rip;
     }
 
-    SvgImageProviderPtr sip = SvgImageProvider::FromFile(filename);
+    SvgImageProviderPtr sip = SvgImageProvider::FromFile(filename, pixels_per_millimeter);
     if (sip) {
         return sip;
     }
@@ -2805,8 +2923,8 @@ NodePtr SVGParser::parseImage(TiXmlElement *elem)
                 strcpy(relative, root_dir.c_str());
                 strcat(relative, ss);
 #endif
-                if ((image_provider = ImageProvider::FromFile(relative)) ||
-                    (image_provider = ImageProvider::FromFile(ss))) {
+                if ((image_provider = ImageProvider::FromFile(relative, pixels_per_millimeter)) ||
+                    (image_provider = ImageProvider::FromFile(ss, pixels_per_millimeter))) {
                     continue;
                 }
             }
@@ -3351,7 +3469,11 @@ NodePtr SVGParser::parseNode(TiXmlElement *elem)
         return switch_group;
     }
     if (name == "style") {
-        loadStyles(elem);
+        // A whole document's style sheets are loaded by loadDocumentStyles
+        // before any shape; the streaming loader loads each as it's read.
+        if (source) {
+            loadStyles(elem);
+        }
         return NodePtr();
     }
 
@@ -3390,6 +3512,7 @@ NodePtr SVGParser::parseUsedNode(TiXmlElement *elem, const UsePtr &use)
 {
     StyleInfoStack old_stack = style_stack;
     style_stack = use->style_stack;
+    resolving_uses++;
     NodePtr ret;
 
     string name(elem->Value());
@@ -3401,11 +3524,80 @@ NodePtr SVGParser::parseUsedNode(TiXmlElement *elem, const UsePtr &use)
         ret = parseNode(elem);
     }
 
+    resolving_uses--;
     style_stack = old_stack;
 
     return ret;
 }
 
+// Parse the element a <use> refers to (or the element it stands in for)
+// in the context of the <use>, or share the subtree parsed for an earlier
+// <use> of the element inheriting the same values.  Only the parsed
+// subtree is shared; each <use> keeps its own position, transform and
+// clip path.  Returns false if there's no such element.
+bool SVGParser::resolveUse(const UsePtr &use, NodePtr &node)
+{
+    // A deferred element stands in for itself, so is never used twice.
+    const bool shareable = use->deferred.length == 0;
+    const StyleInfo &inherited = use->style_stack.top();
+    if (shareable) {
+        SharedUseMap::const_iterator iter = shared_uses.find(use->href);
+        if (iter != shared_uses.end()) {
+            const vector<SharedUse> &shared = iter->second;
+            for (size_t i=0; i<shared.size(); i++) {
+                if (shared[i].inherited.sameInheritedValues(inherited)) {
+                    node = shared[i].node;
+                    return true;
+                }
+            }
+        }
+    }
+
+    if (!source) {
+        UseMap::const_iterator iter = use_map.find(use->href);
+        if (iter == use_map.end()) {
+            return false;
+        }
+        node = parseUsedNode(iter->second, use);
+    } else {
+        SourceRange range = use->deferred;
+        if (range.length == 0) {
+            SourceRangeMap::const_iterator iter = source_ranges.find(use->href);
+            if (iter == source_ranges.end()) {
+                return false;
+            }
+            range = iter->second;
+        }
+        TiXmlElement *elem = parseSource(range);
+        if (!elem) {
+            return false;
+        }
+        node = parseUsedNode(elem, use);
+        delete elem;
+        use_map.clear();  // its entries pointed into elem
+    }
+
+    if (shareable) {
+        SharedUse shared = { inherited, node };
+        shared_uses[use->href].push_back(shared);
+    }
+    return true;
+}
+
+// Load every <style> element in the document, in document order, before
+// parsing any shape; the style sheets apply wherever they appear, even
+// prior to the <svg> element.
+void SVGParser::loadDocumentStyles(TiXmlNode* pParent)
+{
+    for (TiXmlElement *elem = pParent->FirstChildElement(); elem; elem = elem->NextSiblingElement()) {
+        if (!strcmp(elem->Value(), "style")) {
+            loadStyles(elem);
+        } else {
+            loadDocumentStyles(elem);
+        }
+    }
+}
+
 // Do a depth first search to find the first <svg> tag in the document.
 TiXmlElement* SVGParser::findSVG(TiXmlNode* pParent, unsigned int indent)
 {
@@ -3429,10 +3621,6 @@ TiXmlElement* SVGParser::findSVG(TiXmlNode* pParent, unsigned int indent)
 
     case TiXmlNode::ELEMENT:
         name = pParent->Value();
-        // Allow styles to be specified prior to the SVG node.
-        if (name == "style") {
-            loadStyles(pParent);
-        }
         if (name == "svg") {
             // Found an SVG element; done!
             return (TiXmlElement*)(pParent);
@@ -3495,31 +3683,7 @@ SvgScenePtr SVGParser::parseScene(TiXmlElement *svg)
 
     SvgScenePtr scene = SvgScenePtr(new SvgScene);
     if (scene) {
-        for(TiXmlAttribute* a = svg->FirstAttribute(); a; a = a->Next()) {
-            string name(a->Name());
-            if (name == "width") {
-                scene->width = atoi(a->Value());
-                continue;
-            }
-            if (name == "height") {
-                scene->height = atoi(a->Value());
-                continue;
-            }
-            if (name == "viewBox") {
-                float4 view_box;
-                parseViewBox(a->Value(), view_box);
-                scene->view_box = view_box;
-                continue;
-            }
-            if (name == "preserveAspectRatio") {
-                scene->preserve_aspect_ratio = a->Value();
-                continue;
-            }
-            bool got_one = parseGenericShapeProperty(a, svg);
-            if (got_one) {
-                continue;
-            }
-        }
+        parseSceneAttributes(svg, scene);
         for(TiXmlElement *elem=svg->FirstChildElement(); elem; elem = elem->NextSiblingElement()) {
             string name(elem->Value());
             NodePtr node = parseNode(elem);
@@ -3535,19 +3699,60 @@ SvgScenePtr SVGParser::parseScene(TiXmlElement *svg)
     return style_stack.popAndReturn(scene);
 }
 
-SVGParser::SVGParser(const char *xmlFile)
+// The root <svg> element's attributes; shared with SVGStreamLoader::openRoot.
+void SVGParser::parseSceneAttributes(TiXmlElement *svg, SvgScenePtr scene)
+{
+    for(TiXmlAttribute* a = svg->FirstAttribute(); a; a = a->Next()) {
+        string name(a->Name());
+        if (name == "width") {
+            scene->width = atoi(a->Value());
+            continue;
+        }
+        if (name == "height") {
+            scene->height = atoi(a->Value());
+            continue;
+        }
+        if (name == "viewBox") {
+            float4 view_box;
+            parseViewBox(a->Value(), view_box);
+            scene->view_box = view_box;
+            continue;
+        }
+        if (name == "preserveAspectRatio") {
+            scene->preserve_aspect_ratio = a->Value();
+            continue;
+        }
+        bool got_one = parseGenericShapeProperty(a, svg);
+        if (got_one) {
+            continue;
+        }
+    }
+}
+
+SVGParser::SVGParser(float pixels_per_millimeter_)
+    : pixels_per_millimeter(pixels_per_millimeter_)
+    , source(NULL)
+    , encoding(TIXML_DEFAULT_ENCODING)
+    , unresolved_references(0)
+    , deferring_references(false)
+    , resolving_uses(0)
+{
+}
+
+SVGParser::SVGParser(const char *xmlFile, float pixels_per_millimeter_)
     : doc(xmlFile)
+    , pixels_per_millimeter(pixels_per_millimeter_)
+    , source(NULL)
+    , encoding(TIXML_DEFAULT_ENCODING)
+    , unresolved_references(0)
+    , deferring_references(false)
+    , resolving_uses(0)
 {
     // Parse the XML file with TinyXML.
     bool loadOkay = doc.LoadFile();
     if (loadOkay) {
-
-        // Compute the path to the svg's containing directory for opening images
-        root_dir = xmlFile;
-        size_t i = root_dir.length()-1;
-        for (; i >= 0 && root_dir[i] != '/' && root_dir[i] != '\\'; i--) {
-            root_dir[i] = 0;
-        }
+        setRootDir(xmlFile);
+        loadDocumentStyles(&doc);
 
         TiXmlElement* svg = findSVG(&doc);
         if (svg) {
@@ -3559,9 +3764,24 @@ SVGParser::SVGParser(const char *xmlFile)
     }
 }
 
+// Compute the path to the svg's containing directory for opening images
+void SVGParser::setRootDir(const char *xmlFile)
+{
+    root_dir = xmlFile;
+    size_t i = root_dir.length()-1;
+    for (; i >= 0 && root_dir[i] != '/' && root_dir[i] != '\\'; i--) {
+        root_dir[i] = 0;
+    }
+}
+
 SvgScenePtr svg_loader(const char *xmlFile)
 {
-    SVGParser parser(xmlFile);
+    return svg_loader(xmlFile, pixels_per_millimeter);
+}
+
+SvgScenePtr svg_loader(const char *xmlFile, float pixels_per_millimeter)
+{
+    SVGParser parser(xmlFile, pixels_per_millimeter);
 
      if (parser.doc.Error()) {
         printf("\n** XML PARSE ERROR **  %s line: %d col: %d ...", parser.doc.ErrorDesc(), parser.doc.ErrorRow(), parser.doc.ErrorCol());
@@ -3569,3 +3789,592 @@ SvgScenePtr svg_loader(const char *xmlFile)
 
     return parser.scene;
 }
+
+// Reads an SVG file a buffer at a time for the streaming loader, turning
+// CR LF and lone CR into LF as TiXmlDocument::LoadFile does.  Offsets are
+// file offsets.
+struct SVGSource {
+    FILE *file;
+    long buffer_offset;  // file offset of buffer[0]
+    size_t begin, end;
+    char buffer[64*1024];
+
+    SVGSource(FILE *f)
+        : file(f)
+        , buffer_offset(0)
+        , begin(0)
+        , end(0)
+    {}
+
+    inline long offset() const {
+        return buffer_offset + long(begin);
+    }
+    inline int peek() {
+        if (begin == end && !fill()) {
+            return EOF;
+        }
+        return (unsigned char) buffer[begin];
+    }
+    inline int get() {
+        int c = peek();
+        if (c != EOF) {
+            begin++;
+            if (c == '\r') {
+                if (peek() == '\n') {
+                    begin++;
+                }
+                c = '\n';
+            }
+        }
+        return c;
+    }
+    bool fill() {
+        buffer_offset += long(end);
+        begin = 0;
+        end = fread(buffer, 1, sizeof(buffer), file);
+        return end > 0;
+    }
+
+    // Continues reading the stream from file offset position.
+    void seek(long position) {
+        fseek(file, position, SEEK_SET);
+        buffer_offset = position;
+        begin = end = 0;
+    }
+
+    // Reads the markup in range without disturbing the stream.
+    bool read(const SourceRange &range, string &text) {
+        const long resume = offset();
+        text.resize(range.length);
+        bool ok = fseek(file, range.offset, SEEK_SET) == 0 &&
+                  fread(&text[0], 1, range.length, file) == range.length;
+        seek(resume);
+        size_t j = 0;
+        for (size_t i=0; i<text.size(); i++) {
+            if (text[i] == '\r') {
+                text[j++] = '\n';
+                if (i+1 < text.size() && text[i+1] == '\n') {
+                    i++;
+                }
+            } else {
+                text[j++] = text[i];
+            }
+        }
+        text.resize(j);
+        return ok;
+    }
+};
+
+TiXmlElement *SVGParser::parseSource(const SourceRange &range)
+{
+    string text;
+    if (!source->read(range, text)) {
+        printf("warning : could not reread SVG markup at offset %ld\n", range.offset);
+        return NULL;
+    }
+    TiXmlElement *elem = new TiXmlElement("");
+    if (!elem->Parse(text.c_str(), NULL, encoding)) {
+        printf("warning : could not reparse SVG markup at offset %ld\n", range.offset);
+        delete elem;
+        return NULL;
+    }
+    return elem;
+}
+
+// Finds the value of attribute name in the raw start tag, without decoding
+// any entity references in it.
+static bool findAttribute(const string &tag, const char *name, string &value)
+{
+    const size_t n = tag.size(),
+                 name_length = strlen(name);
+    size_t i = 1;
+    while (i < n && !isspace(tag[i]) && tag[i] != '/' && tag[i] != '>') {
+        i++;  // skip the element name
+    }
+    for (;;) {
+        while (i < n && (isspace(tag[i]) || tag[i] == '/')) {
+            i++;
+        }
+        if (i >= n || tag[i] == '>') {
+            return false;
+        }
+        const size_t attrib = i;
+        while (i < n && !isspace(tag[i]) && tag[i] != '=' && tag[i] != '>') {
+            i++;
+        }
+        const size_t attrib_end = i;
+        while (i < n && isspace(tag[i])) {
+            i++;
+        }
+        if (i >= n || tag[i] != '=') {
+            continue;
+        }
+        i++;
+        while (i < n && isspace(tag[i])) {
+            i++;
+        }
+        if (i >= n || (tag[i] != '"' && tag[i] != '\'')) {
+            return false;
+        }
+        const char quote = tag[i++];
+        const size_t value_begin = i;
+        while (i < n && tag[i] != quote) {
+            i++;
+        }
+        if (attrib_end - attrib == name_length && !tag.compare(attrib, name_length, name)) {
+            value.assign(tag, value_begin, i - value_begin);
+            return true;
+        }
+        i++;
+    }
+}
+
+static string markupName(const string &markup)
+{
+    size_t i = 1;
+    if (i < markup.size() && markup[i] == '/') {
+        i++;
+    }
+    const size_t begin = i;
+    while (i < markup.size() && !isspace(markup[i]) && markup[i] != '/' && markup[i] != '>') {
+        i++;
+    }
+    return markup.substr(begin, i - begin);
+}
+
+// Builds the scene while reading the file.  The root <svg> element and the
+// <g> and <switch> elements directly inside it (or inside each other) are
+// containers: their attributes are parsed as they open and their children
+// are added to them as each child closes.  Any other element's markup is
+// collected until it closes, parsed as one small TinyXML element the way
+// SVGParser parses a document, and thrown away.  So the XML in memory at
+// once is a single element outside of the containers, not the document.
+//
+// What <use> elements refer to is found through source_ranges, the file
+// offsets of every element with an id, once the root closes.  An element
+// whose paint servers, clip paths or classes aren't defined yet when it
+// closes is replaced by a deferred Use, which is parsed again at that
+// point too.  So a <style> after the shapes using it still applies to
+// them, without reading the file twice.
+struct SVGStreamLoader {
+    enum Markup {
+        TEXT,
+        START_TAG,
+        EMPTY_TAG,
+        END_TAG,
+        OTHER,  // comments, CDATA, processing instructions and DOCTYPEs
+        END_OF_FILE,
+        MALFORMED
+    };
+
+    struct OpenElement {
+        string name;
+        string id;
+        long offset;
+        GroupPtr group;     // containers only
+        double3x3 matrix;   // containers only; maps to the root's space
+    };
+
+    SVGParser &parser;
+    SVGSource &source;
+    SvgStreamListener *listener;
+    vector<OpenElement> open;
+    SvgScenePtr scene;
+    long markup_offset;
+    bool collecting;
+    size_t collect_depth;   // open.size() when the collected element opened
+    string collected;
+
+    SVGStreamLoader(SVGParser &parser_, SVGSource &source_, SvgStreamListener *listener_)
+        : parser(parser_)
+        , source(source_)
+        , listener(listener_)
+        , markup_offset(0)
+        , collecting(false)
+        , collect_depth(0)
+    {}
+
+    bool readUntil(string &markup, const char *terminator) {
+        const size_t length = strlen(terminator);
+        do {
+            int c = source.get();
+            if (c == EOF) {
+                return false;
+            }
+            markup += char(c);
+        } while (markup.size() < length ||
+                 markup.compare(markup.size()-length, length, terminator));
+        return true;
+    }
+
+    // Reads through the '>' ending a DOCTYPE, which may have an internal
+    // subset in brackets; c is the character after "<!".
+    bool readDeclaration(string &markup, int c) {
+        int brackets = 0;
+        char quote = 0;
+        for (;;) {
+            if (quote) {
+                if (c == quote) {
+                    quote = 0;
+                }
+            } else if (c == '"' || c == '\'') {
+                quote = char(c);
+            } else if (c == '[') {
+                brackets++;
+            } else if (c == ']') {
+                brackets--;
+            } else if (c == '>' && brackets <= 0) {
+                return true;
+            }
+            c = source.get();
+            if (c == EOF) {
+                return false;
+            }
+            markup += char(c);
+        }
+    }
+
+    // Reads through the '>' ending a tag; attribute values may hold '>'.
+    // c is the character after '<'.
+    bool readTag(string &markup, int c) {
+        char quote = 0;
+        for (;;) {
+            if (quote) {
+                if (c == quote) {
+                    quote = 0;
+                }
+            } else if (c == '"' || c == '\'') {
+                quote = char(c);
+            } else if (c == '>') {
+                return true;
+            }
+            c = source.get();
+            if (c == EOF) {
+                return false;
+            }
+            markup += char(c);
+        }
+    }
+
+    // Reads the next run of text or piece of markup.  Text is only kept
+    // while collecting.
+    Markup next(string &markup) {
+        markup.clear();
+        markup_offset = source.offset();
+        int c = source.get();
+        if (c == EOF) {
+            return END_OF_FILE;
+        }
+        if (c != '<') {
+            for (;;) {
+                if (collecting) {
+                    markup += char(c);
+                }
+                c = source.peek();
+                if (c == EOF || c == '<') {
+                    return TEXT;
+                }
+                c = source.get();
+            }
+        }
+
+        markup += '<';
+        c = source.get();
+        if (c == EOF) {
+            return MALFORMED;
+        }
+        markup += char(c);
+        switch (c) {
+        case '?':
+            return readUntil(markup, "?>") ? OTHER : MALFORMED;
+        case '/':
+            return readUntil(markup, ">") ? END_TAG : MALFORMED;
+        case '!':
+            c = source.get();
+            if (c == EOF) {
+                return MALFORMED;
+            }
+            markup += char(c);
+            if (c == '-') {
+                return readUntil(markup, "-->") ? OTHER : MALFORMED;
+            }
+            if (c == '[') {
+                return readUntil(markup, "]]>") ? OTHER : MALFORMED;
+            }
+            return readDeclaration(markup, c) ? OTHER : MALFORMED;
+        default:
+            if (!readTag(markup, c)) {
+                return MALFORMED;
+            }
+            return markup[markup.size()-2] == '/' ? EMPTY_TAG : START_TAG;
+        }
+    }
+
+    // Parses a start tag, leaving out the element's content.
+    bool parseTag(const string &markup, Markup kind, TiXmlElement &elem) {
+        string tag = markup;
+        if (kind == START_TAG) {
+            tag.insert(tag.size()-1, "/");
+        }
+        return elem.Parse(tag.c_str(), NULL, parser.encoding) != NULL;
+    }
+
+    // Picks up the document's encoding the way TiXmlDocument::Parse does.
+    void parseDeclaration(const string &markup) {
+        if (parser.encoding == TIXML_ENCODING_UNKNOWN && markup.compare(0, 5, "<?xml") == 0) {
+            TiXmlDeclaration declaration;
+            if (declaration.Parse(markup.c_str(), NULL, parser.encoding)) {
+                string enc = declaration.Encoding();
+                for (size_t i=0; i<enc.size(); i++) {
+                    enc[i] = char(toupper(enc[i]));
+                }
+                if (enc.empty() || enc == "UTF-8" || enc == "UTF8") {
+                    parser.encoding = TIXML_ENCODING_UTF8;
+                } else {
+                    parser.encoding = TIXML_ENCODING_LEGACY;
+                }
+            }
+        }
+    }
+
+    void openRoot(const string &markup, Markup kind) {
+        TiXmlElement svg("");
+        parseTag(markup, kind, svg);
+
+        parser.style_stack.pushChild();
+        scene = SvgScenePtr(new SvgScene);
+        parser.parseSceneAttributes(&svg, scene);
+        parser.use_map.clear();  // its entries pointed into svg
+
+        OpenElement &root = open.back();
+        root.group = scene;
+        root.matrix = identity;
+    }
+
+    // Opens a <g> or <switch> as a container like SVGParser::parseGroup
+    // and parseSwitch would, unless its own attributes refer to something
+    // not defined yet.
+    bool openContainer(const string &markup, Markup kind) {
+        TiXmlElement elem("");
+        if (!parseTag(markup, kind, elem)) {
+            return false;
+        }
+        parser.style_stack.pushChild();
+        const int unresolved = parser.unresolved_references;
+        for(TiXmlAttribute* a = elem.FirstAttribute(); a; a = a->Next()) {
+            parser.parseGenericShapeProperty(a, &elem);
+        }
+        parser.use_map.clear();  // its entries pointed into elem
+        if (parser.unresolved_references != unresolved) {
+            parser.style_stack.pop();
+            return false;
+        }
+
+        OpenElement &container = open.back();
+        container.group = GroupPtr(new Group);
+        container.matrix = mul(open[open.size()-2].matrix, parser.style().matrix);
+        return true;
+    }
+
+    void closeContainer(OpenElement &container) {
+        if (isRoot(container)) {
+            // Now everything any <use> or deferred element could refer to is known.
+            parser.deferring_references = false;
+            NodePtr node(scene);
+            foreachUseTraversal(node, ResolveUses(&parser));
+            parser.style_stack.pop();
+            return;
+        }
+        if (container.name == "g" && parser.style().opacity != 1) {
+            // The group opacity property is complex to implement; it would need a temporary buffer.
+            // http://www.w3.org/TR/SVG11/masking.html#OpacityProperty
+            printf("WARNING: non-1.0 group opacity is NOT properly supported\n");
+        }
+        NodePtr node = parser.style_stack.popAndReturn(parser.decorateNode(container.group));
+        open[open.size()-2].group->push_back(node);
+    }
+
+    void startCollecting(const string &markup) {
+        collecting = true;
+        collect_depth = open.size();
+        collected = markup;
+    }
+
+    void finishCollecting(const OpenElement &element, long end_offset) {
+        collecting = false;
+        TiXmlElement *elem = new TiXmlElement("");
+        if (!elem->Parse(collected.c_str(), NULL, parser.encoding)) {
+            printf("\n** XML PARSE ERROR **  skipping <%s> at offset %ld ...",
+                element.name.c_str(), element.offset);
+            delete elem;
+            collected.clear();
+            return;
+        }
+        collected.clear();
+
+        if (!scene) {
+            // Styles may be specified prior to the SVG node.
+            parser.loadStyles(elem);
+            delete elem;
+            return;
+        }
+
+        const int unresolved = parser.unresolved_references;
+        NodePtr node = parser.parseNode(elem);
+        delete elem;
+        parser.use_map.clear();  // its entries pointed into elem
+
+        OpenElement &parent = open[open.size()-2];
+        if (parser.unresolved_references != unresolved) {
+            UsePtr use(new Use());
+            use->style_stack = parser.style_stack;
+            use->deferred = SourceRange(element.offset, size_t(end_offset - element.offset));
+            node = use;
+        } else if (node && listener) {
+            listener->nodeLoaded(node, parent.matrix);
+        }
+        if (node) {
+            parent.group->push_back(node);
+        }
+    }
+
+    void close(long end_offset) {
+        OpenElement &element = open.back();
+        if (!element.id.empty()) {
+            parser.source_ranges[element.id] =
+                SourceRange(element.offset, size_t(end_offset - element.offset));
+        }
+        if (collecting && open.size() == collect_depth) {
+            finishCollecting(element, end_offset);
+        } else if (element.group) {
+            closeContainer(element);
+        }
+        open.pop_back();
+    }
+
+    inline bool isRoot(const OpenElement &element) const {
+        return element.group && element.group == scene;
+    }
+
+    // Like svg_loader, keep whatever was parsed before an XML error.
+    bool error(const char *problem) {
+        printf("\n** XML PARSE ERROR **  %s at offset %ld ...", problem, markup_offset);
+        if (!scene) {
+            return false;
+        }
+        collecting = false;
+        collected.clear();
+        while (!open.empty()) {
+            if (open.back().group) {
+                closeContainer(open.back());
+            }
+            open.pop_back();
+        }
+        return true;
+    }
+
+    bool load() {
+        string markup;
+        parser.deferring_references = true;
+        for (;;) {
+            Markup kind = next(markup);
+            switch (kind) {
+            case END_OF_FILE:
+                if (!scene) {
+                    printf("\n** XML PARSE ERROR **  Can't find the <svg> tag.\n");
+                    return false;
+                }
+                return error("unexpected end of file");
+            case MALFORMED:
+                return error("malformed markup");
+            case TEXT:
+            case OTHER:
+                if (collecting) {
+                    collected += markup;
+                } else if (kind == OTHER && !scene && open.empty()) {
+                    parseDeclaration(markup);
+                }
+                break;
+            case START_TAG:
+            case EMPTY_TAG:
+                {
+                    OpenElement element;
+                    element.name = markupName(markup);
+                    findAttribute(markup, "id", element.id);
+                    element.offset = markup_offset;
+                    open.push_back(element);
+
+                    if (collecting) {
+                        collected += markup;
+                    } else if (!scene) {
+                        if (element.name == "svg") {
+                            openRoot(markup, kind);
+                        } else if (element.name == "style") {
+                            startCollecting(markup);
+                        }
+                    } else if (open[open.size()-2].group &&
+                               (element.name == "g" || element.name == "switch") &&
+                               openContainer(markup, kind)) {
+                        // streaming its children
+                    } else {
+                        startCollecting(markup);
+                    }
+                    if (kind == EMPTY_TAG) {
+                        const bool root = isRoot(open.back());
+                        close(source.offset());
+                        if (root) {
+                            return true;
+                        }
+                    }
+                }
+                break;
+            case END_TAG:
+                {
+                    if (open.empty() || markupName(markup) != open.back().name) {
+                        return error("mismatched end tag");
+                    }
+                    if (collecting) {
+                        collected += markup;
+                    }
+                    const bool root = isRoot(open.back());
+                    close(source.offset());
+                    if (root) {
+                        return true;
+                    }
+                }
+                break;
+            }
+        }
+    }
+};
+
+SvgScenePtr svg_stream_loader(const char *xmlFile, SvgStreamListener *listener)
+{
+    return svg_stream_loader(xmlFile, pixels_per_millimeter, listener);
+}
+
+SvgScenePtr svg_stream_loader(const char *xmlFile, float pixels_per_millimeter,
+                              SvgStreamListener *listener)
+{
+    FILE *file = fopen(xmlFile, "rb");
+    if (!file) {
+        printf("\n** XML PARSE ERROR **  Failed to open file ...");
+        return SvgScenePtr();
+    }
+    SVGSource *source = new SVGSource(file);
+    SVGParser parser(pixels_per_millimeter);
+    parser.setRootDir(xmlFile);
+    parser.source = source;
+    // Skip a UTF-8 byte order mark.
+    if (source->peek() == 0xEF && source->end >= 3 &&
+        !memcmp(source->buffer, "\xEF\xBB\xBF", 3)) {
+        source->begin = 3;
+        parser.encoding = TIXML_ENCODING_UTF8;
+    }
+    SVGStreamLoader loader(parser, *source, listener);
+    bool ok = loader.load();
+
+    delete source;
+    fclose(file);
+    return ok ? loader.scene : SvgScenePtr();
+}
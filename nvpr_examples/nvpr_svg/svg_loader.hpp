@@ -18,7 +18,26 @@ using std::map;
 
 extern float pixels_per_millimeter;
 
+// The loaders share no state, so separate threads can load separate files
+// at once.  The versions without a pixels_per_millimeter parameter use the
+// global one.
 SvgScenePtr svg_loader(const char *xmlFile);
+SvgScenePtr svg_loader(const char *xmlFile, float pixels_per_millimeter);
+
+// Receives nodes from svg_stream_loader as soon as they're parsed.  matrix
+// maps node into the scene root's space; the clip paths of the groups
+// around node are not applied yet.  Elements referring to paint servers or
+// clip paths defined later in the file are only in the finished scene.
+struct SvgStreamListener {
+    virtual void nodeLoaded(NodePtr node, const double3x3 &matrix) = 0;
+    virtual ~SvgStreamListener() {}
+};
+
+// Builds the same scene as svg_loader while reading the file, without
+// ever holding the whole XML document in memory.
+SvgScenePtr svg_stream_loader(const char *xmlFile, SvgStreamListener *listener = NULL);
+SvgScenePtr svg_stream_loader(const char *xmlFile, float pixels_per_millimeter,
+                              SvgStreamListener *listener = NULL);
 
 struct Gradient;
 typedef shared_ptr<Gradient> GradientPtr;
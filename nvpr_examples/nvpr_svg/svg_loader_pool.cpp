@@ -0,0 +1,220 @@
+/* svg_loader_pool.cpp - load upcoming SVG files on worker threads */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifdef _WIN32
+# ifndef _WIN32_WINNT
+#  define _WIN32_WINNT 0x0600  // Vista for condition variables
+# endif
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#include "svg_loader_pool.hpp"
+
+using std::string;
+using std::vector;
+
+#ifdef _WIN32
+
+struct SvgLoaderPool::Sync {
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE changed;
+
+    Sync() {
+        InitializeCriticalSection(&mutex);
+        InitializeConditionVariable(&changed);
+    }
+    ~Sync() {
+        DeleteCriticalSection(&mutex);
+    }
+    void lock() { EnterCriticalSection(&mutex); }
+    void unlock() { LeaveCriticalSection(&mutex); }
+    void wait() { SleepConditionVariableCS(&changed, &mutex, INFINITE); }
+    void broadcast() { WakeAllConditionVariable(&changed); }
+
+    static DWORD WINAPI start(LPVOID pool) {
+        SvgLoaderPool::work(pool);
+        return 0;
+    }
+    void *spawn(SvgLoaderPool *pool) {
+        return CreateThread(NULL, 0, start, pool, 0, NULL);
+    }
+    void join(void *thread) {
+        WaitForSingleObject(HANDLE(thread), INFINITE);
+        CloseHandle(HANDLE(thread));
+    }
+    static int processors() {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return int(info.dwNumberOfProcessors);
+    }
+};
+
+#else
+
+struct SvgLoaderPool::Sync {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+
+    Sync() {
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&changed, NULL);
+    }
+    ~Sync() {
+        pthread_cond_destroy(&changed);
+        pthread_mutex_destroy(&mutex);
+    }
+    void lock() { pthread_mutex_lock(&mutex); }
+    void unlock() { pthread_mutex_unlock(&mutex); }
+    void wait() { pthread_cond_wait(&changed, &mutex); }
+    void broadcast() { pthread_cond_broadcast(&changed); }
+
+    void *spawn(SvgLoaderPool *pool) {
+        pthread_t *thread = new pthread_t;
+        if (pthread_create(thread, NULL, SvgLoaderPool::work, pool)) {
+            delete thread;
+            return NULL;
+        }
+        return thread;
+    }
+    void join(void *thread) {
+        pthread_join(*static_cast<pthread_t*>(thread), NULL);
+        delete static_cast<pthread_t*>(thread);
+    }
+    static int processors() {
+        return int(sysconf(_SC_NPROCESSORS_ONLN));
+    }
+};
+
+#endif
+
+SvgLoaderPool::SvgLoaderPool(LoadFunction load_, float pixels_per_millimeter_, int thread_count)
+    : load(load_)
+    , pixels_per_millimeter(pixels_per_millimeter_)
+    , sync(new Sync)
+    , stopping(false)
+    , hits(0)
+{
+    if (thread_count <= 0) {
+        thread_count = std::max(1, Sync::processors() - 1);
+    }
+    for (int i=0; i<thread_count; i++) {
+        void *thread = sync->spawn(this);
+        if (thread) {
+            threads.push_back(thread);
+        }
+    }
+}
+
+SvgLoaderPool::~SvgLoaderPool()
+{
+    sync->lock();
+    stopping = true;
+    sync->broadcast();
+    sync->unlock();
+    for (size_t i=0; i<threads.size(); i++) {
+        sync->join(threads[i]);
+    }
+    delete sync;
+}
+
+void *SvgLoaderPool::work(void *pool)
+{
+    static_cast<SvgLoaderPool*>(pool)->workLoop();
+    return NULL;
+}
+
+void SvgLoaderPool::workLoop()
+{
+    sync->lock();
+    for (;;) {
+        while (!stopping && queue.empty()) {
+            sync->wait();
+        }
+        if (stopping) {
+            break;
+        }
+        const string filename = queue.front();
+        queue.pop_front();
+        entries[filename].state = LOADING;
+
+        sync->unlock();
+        SvgScenePtr scene = load(filename.c_str(), pixels_per_millimeter);
+        sync->lock();
+
+        EntryMap::iterator iter = entries.find(filename);
+        if (iter != entries.end()) {
+            if (iter->second.wanted) {
+                iter->second.state = LOADED;
+                iter->second.scene = scene;
+            } else {
+                entries.erase(iter);
+            }
+        }
+        sync->broadcast();
+    }
+    sync->unlock();
+}
+
+void SvgLoaderPool::prefetch(const vector<string> &filenames)
+{
+    sync->lock();
+    // Forget everything but loaded files still wanted, then queue the rest
+    // in the new order.
+    queue.clear();
+    for (EntryMap::iterator iter = entries.begin(); iter != entries.end(); ) {
+        if (iter->second.state == LOADING) {
+            iter->second.wanted = false;
+            ++iter;
+        } else if (iter->second.state == LOADED &&
+                   std::find(filenames.begin(), filenames.end(), iter->first) != filenames.end()) {
+            ++iter;
+        } else {
+            entries.erase(iter++);
+        }
+    }
+    for (size_t i=0; i<filenames.size(); i++) {
+        EntryMap::iterator iter = entries.find(filenames[i]);
+        if (iter == entries.end()) {
+            Entry &entry = entries[filenames[i]];
+            entry.state = QUEUED;
+            entry.wanted = true;
+            queue.push_back(filenames[i]);
+        } else {
+            iter->second.wanted = true;
+        }
+    }
+    sync->broadcast();
+    sync->unlock();
+}
+
+SvgScenePtr SvgLoaderPool::take(const char *filename)
+{
+    sync->lock();
+    EntryMap::iterator iter = entries.find(filename);
+    if (iter != entries.end() && iter->second.state != QUEUED) {
+        hits++;
+        while (iter != entries.end() && iter->second.state == LOADING) {
+            iter->second.wanted = true;
+            sync->wait();
+            iter = entries.find(filename);
+        }
+        if (iter != entries.end()) {
+            SvgScenePtr scene = iter->second.scene;
+            entries.erase(iter);
+            sync->unlock();
+            return scene;
+        }
+    } else if (iter != entries.end()) {
+        // Not started; load it here rather than wait behind the queue.
+        queue.erase(std::find(queue.begin(), queue.end(), string(filename)));
+        entries.erase(iter);
+    }
+    sync->unlock();
+    return load(filename, pixels_per_millimeter);
+}
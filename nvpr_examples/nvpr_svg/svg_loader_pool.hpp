@@ -0,0 +1,81 @@
+/* svg_loader_pool.hpp - load upcoming SVG files on worker threads */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __svg_loader_pool_hpp__
+#define __svg_loader_pool_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "scene.hpp"
+
+// Loads the SVG files a corpus walk will want next on worker threads while
+// the main thread renders the current one.  Loading (XML, style, path data
+// and gradient parsing) touches no OpenGL or other global state, so it
+// needs no window; the main thread still does everything after loading.
+//
+// Typical use is to call take() for the file wanted now and then prefetch()
+// with the files that follow it.
+class SvgLoaderPool {
+public:
+    // Must be safe to call from several threads at once.
+    typedef SvgScenePtr (*LoadFunction)(const char *filename, float pixels_per_millimeter);
+
+    // threads <= 0 means one fewer than the number of processors (at least one).
+    SvgLoaderPool(LoadFunction load, float pixels_per_millimeter, int threads = 0);
+    ~SvgLoaderPool();
+
+    // Queues the files, in the order given, for loading.  Any queued or
+    // loaded file not in the list is forgotten, which keeps the pool from
+    // holding more scenes than the caller expects to take.
+    void prefetch(const std::vector<std::string> &filenames);
+
+    // Returns the file's scene, waiting if a worker is loading it and
+    // loading it on the calling thread if no worker has started it.
+    SvgScenePtr take(const char *filename);
+
+    inline int getThreadCount() const { return int(threads.size()); }
+
+    // How many take() calls found their scene loaded or being loaded.
+    inline int getPrefetchHits() const { return hits; }
+
+private:
+    enum State {
+        QUEUED,
+        LOADING,
+        LOADED
+    };
+    struct Entry {
+        State state;
+        bool wanted;  // false once a LOADING entry is forgotten
+        SvgScenePtr scene;
+    };
+    typedef std::map<std::string,Entry> EntryMap;
+
+    struct Sync;  // platform mutex, condition variable and threads
+
+    LoadFunction load;
+    const float pixels_per_millimeter;
+    Sync *sync;
+    std::vector<void*> threads;
+    std::deque<std::string> queue;  // QUEUED entries, next first
+    EntryMap entries;
+    bool stopping;
+    int hits;
+
+    static void *work(void *pool);
+    void workLoop();
+
+    SvgLoaderPool(const SvgLoaderPool &);
+    SvgLoaderPool & operator = (const SvgLoaderPool &);
+};
+typedef shared_ptr<SvgLoaderPool> SvgLoaderPoolPtr;
+
+#endif // __svg_loader_pool_hpp__
@@ -0,0 +1,605 @@
+/* svg_render.cpp - render SVG files to image files without a window */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+// Renders SVG files through one of the CPU-based BlitRenderer back ends
+// (Cairo, Skia or the OpenVG reference implementation) into a memory
+// surface and writes each image as a PNG or TGA file.  Nothing opens a
+// window or makes a GL context, so it runs on machines without a GPU or
+// display.
+//
+// The renderer and its surface last the whole run.  Upcoming files load
+// on SvgLoaderPool threads while the current one renders, and -frames
+// redraws each scene with its renderer states (converted paths, patterns)
+// kept warm, as the nvpr_svg software window does between frames.
+
+#include "nvpr_svg_config.h"  // configure path renderers to use
+
+#define _USE_MATH_DEFINES  // so <math.h> has M_PI
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <Cg/double.hpp>
+#include <Cg/vector.hpp>
+#include <Cg/matrix.hpp>
+#include <Cg/mul.hpp>
+
+#include "scene.hpp"
+#include "showfps.h"  // for getElapsedTime, from headless_stubs.cpp
+#include "glmatrix.hpp"
+#include "svg_loader.hpp"
+#include "scene_cache.hpp"
+#include "svg_loader_pool.hpp"
+#include "image_cache.hpp"
+
+#include "stb/stb_image_write.h"
+
+#if USE_SKIA
+#include "skia/renderer_skia.hpp"
+#endif
+#if USE_CAIRO
+#include "cairo/renderer_cairo.hpp"
+#endif
+#if USE_OPENVG
+#include "openvg/renderer_openvg.hpp"
+#endif
+
+#if !defined(_WIN32)
+#include <strings.h>
+#define stricmp strcasecmp
+#endif
+
+// Grumble, Microsoft's <windef.h> (and probably other headers) define these as macros
+#undef min
+#undef max
+
+using namespace Cg;
+using std::string;
+using std::vector;
+
+const char *myProgramName = "svg_render";
+
+// Settings the scene and renderer modules share with nvpr_svg.cpp
+int verbose = 0;
+bool makingDlist = false;
+bool doFilling = true, doStroking = true;
+float scene_ratio = 1;
+float pixels_per_millimeter = 96/25.4f;  // CSS's 96 pixels per inch
+
+// Command line defaults
+static int surface_width = 500, surface_height = 500;
+static float zoom = 1;
+static float rotation = 0;  // degrees counterclockwise
+static float2 pan = float2(0,0);  // in units of half the surface
+static float3 clear_color = float3(1,1,1);
+static const char *output_dir = ".";
+static bool write_tga = false;
+static int frames = 1;
+static bool cull_to_view = true;
+static bool use_scene_cache = true;
+static bool use_stream_loader = false;
+static int loader_threads = -1;  // -1 for automatic, 0 for no pool
+static int tile_threads = 0;  // 0 for untiled, -1 for one per processor
+static bool compare_tiles = false;
+static int compare_tile_threads = -1;
+static bool compare_pan = false;
+static int compare_pan_dx = 0, compare_pan_dy = 0;
+
+// Safe to call from SvgLoaderPool threads; only reads settings.
+static SvgScenePtr loadSVGFile(const char *svg_filename, float pixels_per_millimeter)
+{
+    return use_scene_cache ? svg_loader_cached(svg_filename, pixels_per_millimeter, use_stream_loader)
+         : use_stream_loader ? svg_stream_loader(svg_filename, pixels_per_millimeter, NULL)
+                             : svg_loader(svg_filename, pixels_per_millimeter);
+}
+
+static BlitRendererPtr makeRenderer(const char *name)
+{
+#if USE_CAIRO
+    if (!stricmp(name, "cairo")) {
+        return CairoRendererPtr(new CairoRenderer);
+    }
+#endif
+#if USE_SKIA
+    if (!stricmp(name, "skia")) {
+        return SkiaRendererPtr(new SkiaRenderer);
+    }
+#endif
+#if USE_OPENVG
+    if (!stricmp(name, "openvg")) {
+        VGRendererPtr vg_renderer(new VGRenderer);
+        vg_renderer->setOffscreen(true);
+        return vg_renderer;
+    }
+#endif
+    return BlitRendererPtr();
+}
+
+// Zoom, then rotate around the scene's center, then pan.
+static float4x4 makeView()
+{
+    const float a = rotation * M_PI / 180.0;
+    const float c = cos(a),
+                s = sin(a);
+    const float4x4 r = float4x4(c,-s, 0, 0,
+                                s, c, 0, 0,
+                                0, 0, 1, 0,
+                                0, 0, 0, 1);
+    return mul(translate4x4(pan), mul(r, scale4x4(float2(zoom, zoom))));
+}
+
+static void render(BlitRendererPtr renderer, GroupPtr scene, const float4x4 &view)
+{
+    renderer->beginDraw();
+    renderer->clear(clear_color);
+    renderer->setView(view);
+    const float4x4 scene_to_window =
+        mul(surfaceToWindow(surface_width, surface_height, scene_ratio), view);
+    renderer->drawScene(scene, scene_to_window,
+                        float4(0, 0, surface_width, surface_height), cull_to_view);
+    renderer->endDraw();
+}
+
+// Draws the scene again on compare_tile_threads tile threads and counts
+// the pixels that differ from rgba, the image drawn on tile_threads.
+static int countTileDifferences(BlitRendererPtr renderer, GroupPtr scene,
+                                const float4x4 &view, const vector<unsigned char> &rgba)
+{
+    vector<unsigned char> compared(rgba.size());
+    renderer->setTileThreads(compare_tile_threads);
+    render(renderer, scene, view);
+    renderer->readPixels(&compared[0]);
+    renderer->setTileThreads(tile_threads);
+
+    int differ = 0;
+    for (size_t p=0; p<rgba.size(); p+=4) {
+        differ += memcmp(&rgba[p], &compared[p], 4) != 0;
+    }
+    return differ;
+}
+
+// Pans the frame drawn with view compare_pan_dx,dy pixels by scrolling it
+// and redrawing the strips scrolled in, as the software window does, and
+// counts the pixels that differ from a whole frame of the panned view,
+// those in the strips redrawn and those scrolled separately.  Returns
+// false if the renderer can't scroll.
+static bool countPanDifferences(BlitRendererPtr renderer, GroupPtr scene, const float4x4 &view,
+                                int &strip_differ, int &scrolled_differ)
+{
+    const float4x4 surface_to_window = surfaceToWindow(surface_width, surface_height, scene_ratio);
+    const float2 shift = float2(compare_pan_dx / surface_to_window[0][0],
+                                compare_pan_dy / surface_to_window[1][1]);
+    const float4x4 panned = mul(translate4x4(shift), view);
+
+    vector<unsigned char> scrolled(4*surface_width*surface_height),
+                          whole(scrolled.size());
+    if (!scrollSurfaceScene(renderer, scene, panned, mul(surface_to_window, panned),
+                            clear_color, surface_width, surface_height,
+                            compare_pan_dx, compare_pan_dy)) {
+        return false;
+    }
+    renderer->readPixels(&scrolled[0]);
+    render(renderer, scene, panned);
+    renderer->readPixels(&whole[0]);
+
+    // readPixels puts the top row first; surface rows count up from the bottom.
+    strip_differ = scrolled_differ = 0;
+    for (int row=0; row<surface_height; row++) {
+        const int y = surface_height-1 - row;
+        const bool strip_row = compare_pan_dy > 0 ? y < compare_pan_dy
+                                                  : y >= surface_height+compare_pan_dy;
+        for (int x=0; x<surface_width; x++) {
+            const size_t p = 4*(size_t(row)*surface_width + x);
+            if (memcmp(&whole[p], &scrolled[p], 4) != 0) {
+                const bool strip = strip_row ||
+                    (compare_pan_dx > 0 ? x < compare_pan_dx
+                                        : x >= surface_width+compare_pan_dx);
+                (strip ? strip_differ : scrolled_differ)++;
+            }
+        }
+    }
+    return true;
+}
+
+// Names the image after the SVG file, without its directory or extension,
+// adding a number if an earlier file in the run had the same name.
+static string imageFilename(const char *svg_filename)
+{
+    static std::map<string,int> written;
+
+    const char *base = svg_filename;
+    for (const char *s = svg_filename; *s; s++) {
+        if (*s == '/' || *s == '\\') {
+            base = s+1;
+        }
+    }
+    string name(base);
+    const size_t dot = name.rfind('.');
+    if (dot != string::npos && dot > 0) {
+        name.erase(dot);
+    }
+    const int count = written[name]++;
+    if (count > 0) {
+        char suffix[16];
+        sprintf(suffix, "_%d", count+1);
+        name += suffix;
+    }
+    return string(output_dir) + "/" + name + (write_tga ? ".tga" : ".png");
+}
+
+// Writes opaque RGB, like nvpr_svg's gold images.
+static bool writeImage(const string &filename, vector<unsigned char> &rgba)
+{
+    const int pixels = surface_width*surface_height;
+    unsigned char *rgb = &rgba[0];
+    for (int i=0; i<pixels; i++) {
+        rgb[3*i+0] = rgba[4*i+0];
+        rgb[3*i+1] = rgba[4*i+1];
+        rgb[3*i+2] = rgba[4*i+2];
+    }
+    return write_tga ? stbi_write_tga(filename.c_str(), surface_width, surface_height, 3, rgb) != 0
+                     : stbi_write_png(filename.c_str(), surface_width, surface_height, 3, rgb, 3*surface_width) != 0;
+}
+
+static bool readFileList(const char *list_filename, vector<string> &filenames)
+{
+    FILE *file = fopen(list_filename, "r");
+    if (!file) {
+        return false;
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        size_t length = strlen(line);
+        while (length > 0 && (line[length-1] == '\n' || line[length-1] == '\r' || line[length-1] == ' ')) {
+            line[--length] = '\0';
+        }
+        if (length > 0 && line[0] != '#') {
+            filenames.push_back(line);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static void usage()
+{
+    printf("usage: svg_render [options] file.svg ...\n"
+           "  -renderer NAME     :: cairo, skia or openvg (default cairo)\n"
+           "  -size WxH          :: surface size in pixels (default 500x500)\n"
+           "  -zoom #            :: scale the fitted scene by # around its center\n"
+           "  -rotate #          :: rotate the scene # degrees counterclockwise\n"
+           "  -pan X Y           :: move the scene by X,Y half surfaces\n"
+           "  -frames #          :: draw each scene # times, reporting cold and warm frame times\n"
+           "  -o DIR             :: write images into DIR (default .)\n"
+           "  -tga               :: write TGA rather than PNG images\n"
+           "  -black             :: clear to a black background\n"
+           "  -white             :: clear to a white background (the default)\n"
+           "  -list FILE         :: also render the SVG files named one per line in FILE\n"
+           "  -ppmm #            :: pixels per millimeter for physical units (default 96 DPI)\n"
+           "  -noSceneCache      :: always parse SVG files, even when a current scene cache exists\n"
+           "  -streamSVG         :: parse SVG files while reading them\n"
+           "  -imageCacheMB #    :: keep up to # megabytes of decoded <image> pixels for reuse\n"
+           "  -loaderThreads #   :: load upcoming SVG files on # threads (0 for none)\n"
+           "  -tileThreads #     :: draw surface bands on # threads (-1 for one per processor; default 0, untiled)\n"
+           "  -compareTiles #    :: also draw each scene on # tile threads and fail files whose pixels differ (-1 for one per processor)\n"
+           "  -comparePan DX DY  :: also pan each frame DX,DY pixels by scrolling it and fail files whose redrawn strips differ from a whole frame\n"
+           "  -noCull            :: render every scene node, even those outside the surface\n"
+           "  -v                 :: verbose\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *renderer_name = "cairo";
+    vector<string> filenames;
+
+    for (int i=1; i<argc; i++) {
+        if (!stricmp("-renderer", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-renderer expects name argument\n");
+              exit(1);
+            } else {
+              renderer_name = argv[i];
+            }
+        } else
+        if (!stricmp("-size", argv[i])) {
+            i++;
+            if (i >= argc || sscanf(argv[i], "%dx%d", &surface_width, &surface_height) != 2 ||
+                surface_width <= 0 || surface_height <= 0) {
+              printf("-size expects WxH argument\n");
+              exit(1);
+            }
+        } else
+        if (!stricmp("-zoom", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-zoom expects float argument\n");
+              exit(1);
+            } else {
+              zoom = float(atof(argv[i]));
+            }
+        } else
+        if (!stricmp("-rotate", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-rotate expects float argument\n");
+              exit(1);
+            } else {
+              rotation = float(atof(argv[i]));
+            }
+        } else
+        if (!stricmp("-pan", argv[i])) {
+            i += 2;
+            if (i >= argc) {
+              printf("-pan expects two float arguments\n");
+              exit(1);
+            } else {
+              pan = float2(atof(argv[i-1]), atof(argv[i]));
+            }
+        } else
+        if (!stricmp("-frames", argv[i])) {
+            i++;
+            if (i >= argc || atoi(argv[i]) < 1) {
+              printf("-frames expects positive integer argument\n");
+              exit(1);
+            } else {
+              frames = atoi(argv[i]);
+            }
+        } else
+        if (!stricmp("-o", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-o expects directory argument\n");
+              exit(1);
+            } else {
+              output_dir = argv[i];
+            }
+        } else
+        if (!stricmp("-tga", argv[i])) {
+            write_tga = true;
+        } else
+        if (!stricmp("-png", argv[i])) {
+            write_tga = false;
+        } else
+        if (!stricmp("-black", argv[i])) {
+            clear_color = float3(0,0,0);
+        } else
+        if (!stricmp("-white", argv[i])) {
+            clear_color = float3(1,1,1);
+        } else
+        if (!stricmp("-list", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-list expects filename argument\n");
+              exit(1);
+            } else if (!readFileList(argv[i], filenames)) {
+              printf("could not read file list %s\n", argv[i]);
+              exit(1);
+            }
+        } else
+        if (!stricmp("-ppmm", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-ppmm expects float argument\n");
+              exit(1);
+            } else {
+              pixels_per_millimeter = float(atof(argv[i]));
+            }
+        } else
+        if (!stricmp("-noSceneCache", argv[i])) {
+            use_scene_cache = false;
+        } else
+        if (!stricmp("-streamSVG", argv[i])) {
+            use_stream_loader = true;
+        } else
+        if (!stricmp("-imageCacheMB", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-imageCacheMB expects integer argument\n");
+              exit(1);
+            } else {
+              setRasterImageCacheLimit(size_t(atoi(argv[i])) << 20);
+            }
+        } else
+        if (!stricmp("-loaderThreads", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-loaderThreads expects integer argument\n");
+              exit(1);
+            } else {
+              loader_threads = atoi(argv[i]);
+            }
+        } else
+        if (!stricmp("-tileThreads", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-tileThreads expects integer argument\n");
+              exit(1);
+            } else {
+              tile_threads = atoi(argv[i]);
+            }
+        } else
+        if (!stricmp("-compareTiles", argv[i])) {
+            i++;
+            if (i >= argc) {
+              printf("-compareTiles expects integer argument\n");
+              exit(1);
+            } else {
+              compare_tiles = true;
+              compare_tile_threads = atoi(argv[i]);
+            }
+        } else
+        if (!stricmp("-comparePan", argv[i])) {
+            i += 2;
+            if (i >= argc) {
+              printf("-comparePan expects two integer arguments\n");
+              exit(1);
+            } else {
+              compare_pan = true;
+              compare_pan_dx = atoi(argv[i-1]);
+              compare_pan_dy = atoi(argv[i]);
+            }
+        } else
+        if (!stricmp("-noCull", argv[i])) {
+            cull_to_view = false;
+        } else
+        if (!stricmp("-v", argv[i])) {
+            verbose = 1;
+        } else
+        if (!stricmp("-h", argv[i]) || !stricmp("-help", argv[i])) {
+            usage();
+            exit(0);
+        } else
+        if (argv[i][0] == '-') {
+            printf("unknown option %s\n", argv[i]);
+            usage();
+            exit(1);
+        } else {
+            filenames.push_back(argv[i]);
+        }
+    }
+    if (filenames.empty()) {
+        usage();
+        exit(1);
+    }
+
+    BlitRendererPtr renderer = makeRenderer(renderer_name);
+    if (!renderer) {
+        printf("renderer %s is not supported by this build\n", renderer_name);
+        exit(1);
+    }
+    renderer->configureSurface(surface_width, surface_height);
+    if (!renderer->setTileThreads(tile_threads)) {
+        printf("%s can't draw in tiles; drawing untiled\n", renderer->getName());
+        tile_threads = 0;
+        renderer->setTileThreads(0);
+    }
+    if (compare_tiles && !renderer->setTileThreads(compare_tile_threads)) {
+        printf("%s can't draw in tiles; nothing to compare\n", renderer->getName());
+        exit(1);
+    }
+    const int compared_threads = renderer->getTileThreads();
+    renderer->setTileThreads(tile_threads);
+    printf("rendering %d SVG files with %s at %dx%d",
+        int(filenames.size()), renderer->getName(), surface_width, surface_height);
+    if (renderer->getTileThreads() > 0) {
+        printf(" in tiles on %d thread%s", renderer->getTileThreads(),
+            renderer->getTileThreads() == 1 ? "" : "s");
+    }
+    if (compare_tiles) {
+        printf(", comparing with %d tile thread%s",
+            compared_threads, compared_threads == 1 ? "" : "s");
+    }
+    if (compare_pan) {
+        printf(", comparing with a pan of %d,%d pixels", compare_pan_dx, compare_pan_dy);
+    }
+    printf("\n");
+
+    SvgLoaderPoolPtr loader_pool;
+    if (loader_threads != 0) {
+        loader_pool = SvgLoaderPoolPtr(new SvgLoaderPool(loadSVGFile, pixels_per_millimeter, loader_threads));
+    }
+
+    const float4x4 view = makeView();
+    vector<unsigned char> rgba(4*surface_width*surface_height);
+    int failures = 0;
+    double load_seconds = 0,
+           cold_seconds = 0,
+           warm_seconds = 0;
+    const double start_time = getElapsedTime();
+
+    for (size_t i=0; i<filenames.size(); i++) {
+        const char *svg_filename = filenames[i].c_str();
+
+        double t0 = getElapsedTime();
+        SvgScenePtr svg_scene = loader_pool ? loader_pool->take(svg_filename)
+                                            : loadSVGFile(svg_filename, pixels_per_millimeter);
+        if (loader_pool) {
+            vector<string> upcoming;
+            for (size_t j=i+1; j<filenames.size() && int(j-i) <= 2*loader_pool->getThreadCount(); j++) {
+                upcoming.push_back(filenames[j]);
+            }
+            loader_pool->prefetch(upcoming);
+        }
+        if (!svg_scene) {
+            printf("%s: FAILED to load\n", svg_filename);
+            failures++;
+            continue;
+        }
+        GroupPtr scene = fitSceneToClip(svg_scene, scene_ratio);
+        double t1 = getElapsedTime();
+        load_seconds += t1-t0;
+
+        // The first frame builds the renderer states; later ones reuse them.
+        render(renderer, scene, view);
+        double t2 = getElapsedTime();
+        cold_seconds += t2-t1;
+        for (int f=1; f<frames; f++) {
+            render(renderer, scene, view);
+        }
+        double t3 = getElapsedTime();
+        warm_seconds += t3-t2;
+
+        const string image_filename = imageFilename(svg_filename);
+        const bool read = renderer->readPixels(&rgba[0]);
+        // Before writeImage packs rgba into rgb.
+        const int differ = read && compare_tiles ? countTileDifferences(renderer, scene, view, rgba) : 0;
+        // After countTileDifferences, which leaves the surface as it was.
+        int strip_differ = 0, scrolled_differ = 0;
+        const bool panned = !read || !compare_pan ||
+            countPanDifferences(renderer, scene, view, strip_differ, scrolled_differ);
+        if (!read || !writeImage(image_filename, rgba)) {
+            printf("%s: FAILED to write %s\n", svg_filename, image_filename.c_str());
+            failures++;
+            continue;
+        } else if (frames > 1) {
+            printf("%s -> %s: load %.2f ms, first frame %.2f ms, warm frames %.2f ms\n",
+                svg_filename, image_filename.c_str(),
+                1000*(t1-t0), 1000*(t2-t1), 1000*(t3-t2)/(frames-1));
+        } else {
+            printf("%s -> %s: load %.2f ms, frame %.2f ms\n",
+                svg_filename, image_filename.c_str(), 1000*(t1-t0), 1000*(t2-t1));
+        }
+        if (differ) {
+            printf("%s: FAILED, %d pixels differ with %d tile thread%s\n",
+                svg_filename, differ, compared_threads, compared_threads == 1 ? "" : "s");
+            failures++;
+        }
+        if (!panned) {
+            printf("%s: FAILED, %s can't pan %d,%d pixels by scrolling\n",
+                svg_filename, renderer->getName(), compare_pan_dx, compare_pan_dy);
+            failures++;
+        } else if (strip_differ) {
+            printf("%s: FAILED, %d pixels differ in the strips redrawn after panning\n",
+                svg_filename, strip_differ);
+            failures++;
+        }
+        if (scrolled_differ) {
+            // The rasterizers don't give bit-identical pixels for a scene
+            // translated by whole pixels, so reused pixels may be off.
+            printf("%s: %d scrolled pixels differ from a whole frame\n",
+                svg_filename, scrolled_differ);
+        }
+    }
+
+    const int rendered = int(filenames.size()) - failures;
+    printf("rendered %d of %d files in %.3f seconds: load %.3f, first frames %.3f",
+        rendered, int(filenames.size()), getElapsedTime()-start_time,
+        load_seconds, cold_seconds);
+    if (frames > 1) {
+        printf(", warm frames %.3f (%.2f ms/frame)",
+            warm_seconds, rendered ? 1000*warm_seconds/(rendered*(frames-1)) : 0.0);
+    }
+    printf("\n");
+
+    loader_pool = SvgLoaderPoolPtr();
+    renderer->shutdown();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+/* tile_pool.cpp - draw surface tiles on persistent worker threads */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifdef _WIN32
+# ifndef _WIN32_WINNT
+#  define _WIN32_WINNT 0x0600  // Vista for condition variables
+# endif
+# include <windows.h>
+#else
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#include "tile_pool.hpp"
+
+using std::vector;
+
+vector<TileRect> splitSurface(int width, int height, int tile_height)
+{
+    TileRect surface = { 0, 0, width, height };
+    return splitRect(surface, tile_height);
+}
+
+vector<TileRect> splitRect(const TileRect &rect, int tile_height)
+{
+    vector<TileRect> rects;
+    const int y1 = rect.y + rect.height;
+    for (int y=rect.y; y<y1 && rect.width>0; y+=tile_height) {
+        TileRect band = { rect.x, y, rect.width, std::min(tile_height, y1-y) };
+        rects.push_back(band);
+    }
+    return rects;
+}
+
+#ifdef _WIN32
+
+struct TilePool::Sync {
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE changed;
+
+    Sync() {
+        InitializeCriticalSection(&mutex);
+        InitializeConditionVariable(&changed);
+    }
+    ~Sync() {
+        DeleteCriticalSection(&mutex);
+    }
+    void lock() { EnterCriticalSection(&mutex); }
+    void unlock() { LeaveCriticalSection(&mutex); }
+    void wait() { SleepConditionVariableCS(&changed, &mutex, INFINITE); }
+    void broadcast() { WakeAllConditionVariable(&changed); }
+
+    static DWORD WINAPI start(LPVOID pool) {
+        TilePool::work(pool);
+        return 0;
+    }
+    void *spawn(TilePool *pool) {
+        return CreateThread(NULL, 0, start, pool, 0, NULL);
+    }
+    void join(void *thread) {
+        WaitForSingleObject(HANDLE(thread), INFINITE);
+        CloseHandle(HANDLE(thread));
+    }
+    static int processors() {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return int(info.dwNumberOfProcessors);
+    }
+};
+
+#else
+
+struct TilePool::Sync {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+
+    Sync() {
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&changed, NULL);
+    }
+    ~Sync() {
+        pthread_cond_destroy(&changed);
+        pthread_mutex_destroy(&mutex);
+    }
+    void lock() { pthread_mutex_lock(&mutex); }
+    void unlock() { pthread_mutex_unlock(&mutex); }
+    void wait() { pthread_cond_wait(&changed, &mutex); }
+    void broadcast() { pthread_cond_broadcast(&changed); }
+
+    void *spawn(TilePool *pool) {
+        pthread_t *thread = new pthread_t;
+        if (pthread_create(thread, NULL, TilePool::work, pool)) {
+            delete thread;
+            return NULL;
+        }
+        return thread;
+    }
+    void join(void *thread) {
+        pthread_join(*static_cast<pthread_t*>(thread), NULL);
+        delete static_cast<pthread_t*>(thread);
+    }
+    static int processors() {
+        return int(sysconf(_SC_NPROCESSORS_ONLN));
+    }
+};
+
+#endif
+
+int TilePool::processors()
+{
+    return std::max(1, Sync::processors());
+}
+
+TilePool::TilePool(int thread_count)
+    : sync(new Sync)
+    , function(NULL)
+    , data(NULL)
+    , tiles(0)
+    , next_tile(0)
+    , busy(0)
+    , generation(0)
+    , stopping(false)
+{
+    if (thread_count < 0) {
+        thread_count = processors();
+    }
+    // The thread calling run() is one of them.
+    for (int i=1; i<thread_count; i++) {
+        void *thread = sync->spawn(this);
+        if (thread) {
+            threads.push_back(thread);
+        }
+    }
+}
+
+TilePool::~TilePool()
+{
+    sync->lock();
+    stopping = true;
+    sync->broadcast();
+    sync->unlock();
+    for (size_t i=0; i<threads.size(); i++) {
+        sync->join(threads[i]);
+    }
+    delete sync;
+}
+
+void *TilePool::work(void *pool)
+{
+    static_cast<TilePool*>(pool)->workLoop();
+    return NULL;
+}
+
+void TilePool::workLoop()
+{
+    sync->lock();
+    unsigned int seen = generation;
+    for (;;) {
+        while (!stopping && generation == seen) {
+            sync->wait();
+        }
+        if (stopping) {
+            break;
+        }
+        seen = generation;
+        busy++;
+        drawTiles();
+        busy--;
+        sync->broadcast();
+    }
+    sync->unlock();
+}
+
+void TilePool::drawTiles()
+{
+    while (next_tile < tiles) {
+        const int tile = next_tile++;
+        sync->unlock();
+        function(data, tile);
+        sync->lock();
+    }
+}
+
+void TilePool::run(TileFunction function_, void *data_, int tiles_)
+{
+    if (tiles_ <= 0) {
+        return;
+    }
+    sync->lock();
+    function = function_;
+    data = data_;
+    tiles = tiles_;
+    next_tile = 0;
+    generation++;
+    sync->broadcast();
+    drawTiles();
+    // Every tile is taken; wait for the ones workers are still drawing.
+    while (busy > 0) {
+        sync->wait();
+    }
+    sync->unlock();
+}
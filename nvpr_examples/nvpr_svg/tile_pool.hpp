@@ -0,0 +1,80 @@
+/* tile_pool.hpp - draw surface tiles on persistent worker threads */
+
+// Copyright (c) NVIDIA Corporation. All rights reserved.
+
+#ifndef __tile_pool_hpp__
+#define __tile_pool_hpp__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+#include <vector>
+
+#if __cplusplus >= 201103L  // supports C++11
+# include <memory>
+using std::shared_ptr;
+#else
+# include <boost/shared_ptr.hpp>
+using boost::shared_ptr;
+#endif
+
+// A surface rectangle in pixels with a lower-left origin, like clipToRect.
+struct TileRect {
+    int x, y, width, height;
+};
+
+// Splits a width by height surface into full-width bands tile_height
+// rows tall, the last perhaps shorter.  Bands keep each tile's pixels in
+// whole rows, and several bands per thread even out scenes whose detail
+// is bunched in one place.
+extern std::vector<TileRect> splitSurface(int width, int height, int tile_height = 32);
+// Likewise splits a rectangle of the surface into bands as wide as it.
+extern std::vector<TileRect> splitRect(const TileRect &rect, int tile_height = 32);
+
+// Runs a function once for each tile on threads that wait between runs,
+// so a software renderer can draw a frame's tiles in parallel without
+// starting threads every frame.  The thread calling run() draws tiles too.
+class TilePool {
+public:
+    typedef void (*TileFunction)(void *data, int tile);
+
+    // threads counts the calling thread, so 1 runs tiles on it alone;
+    // threads < 0 means one per processor.
+    TilePool(int threads);
+    ~TilePool();
+
+    // Calls function(data, tile) for every tile in [0,tiles), in no
+    // particular order and on any of the threads, returning once all
+    // calls have.
+    void run(TileFunction function, void *data, int tiles);
+
+    // Including the calling thread.
+    inline int getThreadCount() const { return int(threads.size()) + 1; }
+
+    static int processors();
+
+private:
+    struct Sync;  // platform mutex, condition variables and threads
+
+    Sync *sync;
+    std::vector<void*> threads;
+    TileFunction function;
+    void *data;
+    int tiles;
+    int next_tile;  // first tile no thread has taken
+    int busy;       // workers still running a tile of this run
+    unsigned int generation;  // counts runs, so idle workers notice a new one
+    bool stopping;
+
+    static void *work(void *pool);
+    void workLoop();
+    // With the mutex held, runs tiles until there are no more to take.
+    void drawTiles();
+
+    TilePool(const TilePool &);
+    TilePool & operator = (const TilePool &);
+};
+typedef shared_ptr<TilePool> TilePoolPtr;
+
+#endif // __tile_pool_hpp__
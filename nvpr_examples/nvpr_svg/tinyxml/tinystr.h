@@ -218,7 +218,10 @@ class TiXmlString
   private:
 
 	void init(size_type sz) { init(sz, sz); }
-	void set_size(size_type sz) { rep_->str[ rep_->size = sz ] = '\0'; }
+	// NVprSDK change to the vendored tinyxml, keep it when updating tinyxml:
+	// nullrep_ is shared, so never written (even with the zeros it holds)
+	// lest threads parsing separate documents race on it (svg_loader_pool).
+	void set_size(size_type sz) { if (rep_ != &nullrep_) rep_->str[ rep_->size = sz ] = '\0'; }
 	char* start() const { return rep_->str; }
 	char* finish() const { return rep_->str + rep_->size; }
 
@@ -1073,7 +1073,7 @@ void RI_APIENTRY vgSetParameterf(VGHandle object, VGint paramType, VGfloat value
 	else if(isPaint)
 	{
 		RI_ASSERT(!isImage && !isPath && !isMaskLayer && !isFont);
-		setPaintParameterifv(context, (Paint*)object, (VGPaintParamType)paramType, 1, values, true);
+		setPaintParameterifv(context, context->getPaint(object), (VGPaintParamType)paramType, 1, values, true);
 	}
 	else if(isMaskLayer)
 	{
@@ -1123,7 +1123,7 @@ void RI_APIENTRY vgSetParameteri(VGHandle object, VGint paramType, VGint value)
 	else if(isPaint)
 	{
 		RI_ASSERT(!isImage && !isPath && !isMaskLayer && !isFont);
-		setPaintParameterifv(context, (Paint*)object, (VGPaintParamType)paramType, 1, values, false);
+		setPaintParameterifv(context, context->getPaint(object), (VGPaintParamType)paramType, 1, values, false);
 	}
 	else if(isMaskLayer)
 	{
@@ -1171,7 +1171,7 @@ void RI_APIENTRY vgSetParameterfv(VGHandle object, VGint paramType, VGint count,
 	else if(isPaint)
 	{
 		RI_ASSERT(!isImage && !isPath && !isMaskLayer && !isFont);
-		setPaintParameterifv(context, (Paint*)object, (VGPaintParamType)paramType, count, values, true);
+		setPaintParameterifv(context, context->getPaint(object), (VGPaintParamType)paramType, count, values, true);
 	}
 	else if(isMaskLayer)
 	{
@@ -1219,7 +1219,7 @@ void RI_APIENTRY vgSetParameteriv(VGHandle object, VGint paramType, VGint count,
 	else if(isPaint)
 	{
 		RI_ASSERT(!isImage && !isPath && !isMaskLayer && !isFont);
-		setPaintParameterifv(context, (Paint*)object, (VGPaintParamType)paramType, count, values, false);
+		setPaintParameterifv(context, context->getPaint(object), (VGPaintParamType)paramType, count, values, false);
 	}
 	else if(isMaskLayer)
 	{
@@ -1435,22 +1435,22 @@ VGfloat RI_APIENTRY vgGetParameterf(VGHandle object, VGint paramType)
 	if(isImage)
 	{
 		RI_ASSERT(!isPath && !isPaint && !isFont);
-		getImageParameterifv(context, (Image*)object, (VGImageParamType)paramType, 1, &ret, true);
+		getImageParameterifv(context, context->getImage(object), (VGImageParamType)paramType, 1, &ret, true);
 	}
 	else if(isPath)
 	{
 		RI_ASSERT(!isImage && !isPaint && !isFont);
-		getPathParameterifv(context, (Path*)object, (VGPathParamType)paramType, 1, &ret, true);
+		getPathParameterifv(context, context->getPath(object), (VGPathParamType)paramType, 1, &ret, true);
 	}
 	else if(isPaint)
 	{
 		RI_ASSERT(!isImage && !isPath && !isFont);
-		getPaintParameterifv(context, (Paint*)object, (VGPaintParamType)paramType, 1, &ret, true);
+		getPaintParameterifv(context, context->getPaint(object), (VGPaintParamType)paramType, 1, &ret, true);
 	}
 	else
 	{
 		RI_ASSERT(!isImage && !isPath && !isPaint && isFont);
-		getFontParameterifv(context, (Font*)object, (VGFontParamType)paramType, 1, &ret, true);
+		getFontParameterifv(context, context->getFont(object), (VGFontParamType)paramType, 1, &ret, true);
 	}
 	RI_RETURN(ret);
 }
@@ -1476,22 +1476,22 @@ VGint RI_APIENTRY vgGetParameteri(VGHandle object, VGint paramType)
 	if(isImage)
 	{
 		RI_ASSERT(!isPath && !isPaint && !isFont);
-		getImageParameterifv(context, (Image*)object, (VGImageParamType)paramType, 1, &ret, false);
+		getImageParameterifv(context, context->getImage(object), (VGImageParamType)paramType, 1, &ret, false);
 	}
 	else if(isPath)
 	{
 		RI_ASSERT(!isImage && !isPaint && !isFont);
-		getPathParameterifv(context, (Path*)object, (VGPathParamType)paramType, 1, &ret, false);
+		getPathParameterifv(context, context->getPath(object), (VGPathParamType)paramType, 1, &ret, false);
 	}
 	else if(isPaint)
 	{
 		RI_ASSERT(!isImage && !isPath && !isFont);
-		getPaintParameterifv(context, (Paint*)object, (VGPaintParamType)paramType, 1, &ret, false);
+		getPaintParameterifv(context, context->getPaint(object), (VGPaintParamType)paramType, 1, &ret, false);
 	}
 	else
 	{
 		RI_ASSERT(!isImage && !isPath && !isPaint && isFont);
-		getFontParameterifv(context, (Font*)object, (VGFontParamType)paramType, 1, &ret, false);
+		getFontParameterifv(context, context->getFont(object), (VGFontParamType)paramType, 1, &ret, false);
 	}
 	RI_RETURN(ret);
 }
@@ -1515,22 +1515,22 @@ void RI_APIENTRY vgGetParameterfv(VGHandle object, VGint paramType, VGint count,
 	if(isImage)
 	{
 		RI_ASSERT(!isPath && !isPaint && !isFont);
-		getImageParameterifv(context, (Image*)object, (VGImageParamType)paramType, count, values, true);
+		getImageParameterifv(context, context->getImage(object), (VGImageParamType)paramType, count, values, true);
 	}
 	else if(isPath)
 	{
 		RI_ASSERT(!isImage && !isPaint && !isFont);
-		getPathParameterifv(context, (Path*)object, (VGPathParamType)paramType, count, values, true);
+		getPathParameterifv(context, context->getPath(object), (VGPathParamType)paramType, count, values, true);
 	}
 	else if(isPaint)
 	{
 		RI_ASSERT(!isImage && !isPath && !isFont);
-		getPaintParameterifv(context, (Paint*)object, (VGPaintParamType)paramType, count, values, true);
+		getPaintParameterifv(context, context->getPaint(object), (VGPaintParamType)paramType, count, values, true);
 	}
 	else
 	{
 		RI_ASSERT(!isImage && !isPath && !isPaint && isFont);
-		getFontParameterifv(context, (Font*)object, (VGFontParamType)paramType, count, values, true);
+		getFontParameterifv(context, context->getFont(object), (VGFontParamType)paramType, count, values, true);
 	}
 	RI_RETURN(RI_NO_RETVAL);
 }
@@ -1554,22 +1554,22 @@ void RI_APIENTRY vgGetParameteriv(VGHandle object, VGint paramType, VGint count,
 	if(isImage)
 	{
 		RI_ASSERT(!isPath && !isPaint && !isFont);
-		getImageParameterifv(context, (Image*)object, (VGImageParamType)paramType, count, values, false);
+		getImageParameterifv(context, context->getImage(object), (VGImageParamType)paramType, count, values, false);
 	}
 	else if(isPath)
 	{
 		RI_ASSERT(!isImage && !isPaint && !isFont);
-		getPathParameterifv(context, (Path*)object, (VGPathParamType)paramType, count, values, false);
+		getPathParameterifv(context, context->getPath(object), (VGPathParamType)paramType, count, values, false);
 	}
 	else if(isPaint)
 	{
 		RI_ASSERT(!isImage && !isPath && !isFont);
-		getPaintParameterifv(context, (Paint*)object, (VGPaintParamType)paramType, count, values, false);
+		getPaintParameterifv(context, context->getPaint(object), (VGPaintParamType)paramType, count, values, false);
 	}
 	else
 	{
 		RI_ASSERT(!isImage && !isPath && !isPaint && isFont);
-		getFontParameterifv(context, (Font*)object, (VGFontParamType)paramType, count, values, false);
+		getFontParameterifv(context, context->getFont(object), (VGFontParamType)paramType, count, values, false);
 	}
 	RI_RETURN(RI_NO_RETVAL);
 }
@@ -1642,7 +1642,7 @@ VGint RI_APIENTRY vgGetParameterVectorSize(VGHandle object, VGint paramType)
 			break;
 
 		case VG_PAINT_COLOR_RAMP_STOPS:
-			ret = ((Paint*)object)->m_inputColorRampStops.size() * 5;
+			ret = context->getPaint(object)->m_inputColorRampStops.size() * 5;
 			break;
 
 		case VG_PAINT_COLOR_RAMP_PREMULTIPLIED:
@@ -1891,22 +1891,24 @@ void RI_APIENTRY vgRotate(VGfloat angle)
 void RI_APIENTRY vgMask(VGHandle mask, VGMaskOperation operation, VGint x, VGint y, VGint width, VGint height)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
-    bool isImage = context->isValidImage(mask);
-    bool isMaskLayer = context->isValidMaskLayer(mask);
+    Image* image = context->getImage(mask);
+    Surface* layer = context->getMaskLayer(mask);
+    bool isImage = image != NULL;
+    bool isMaskLayer = layer != NULL;
 	RI_IF_ERROR(operation != VG_CLEAR_MASK && operation != VG_FILL_MASK && !isImage && !isMaskLayer, VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	RI_IF_ERROR(operation != VG_CLEAR_MASK && operation != VG_FILL_MASK && isImage && eglvgIsInUse((Image*)mask), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
+	RI_IF_ERROR(operation != VG_CLEAR_MASK && operation != VG_FILL_MASK && isImage && eglvgIsInUse(image), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(operation < VG_CLEAR_MASK || operation > VG_SUBTRACT_MASK, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(width <= 0 || height <= 0, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
     Drawable* drawable = context->getCurrentDrawable();
-	RI_IF_ERROR(isMaskLayer && drawable->getNumSamples() != ((Surface*)mask)->getNumSamples(), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
+	RI_IF_ERROR(isMaskLayer && drawable->getNumSamples() != layer->getNumSamples(), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
     if(!drawable || !drawable->getMaskBuffer())
     {
         RI_RETURN(RI_NO_RETVAL);	//no EGL surface is current at the moment or context has no mask buffer
     }
     if(isImage)
-        drawable->getMaskBuffer()->mask((Image*)mask, operation, x, y, width, height);
+        drawable->getMaskBuffer()->mask(image, operation, x, y, width, height);
     else
-        drawable->getMaskBuffer()->mask((Surface*)mask, operation, x, y, width, height);
+        drawable->getMaskBuffer()->mask(layer, operation, x, y, width, height);
 	RI_RETURN(RI_NO_RETVAL);
 }
 
@@ -1938,9 +1940,12 @@ static void renderStroke(const VGContext* context, int w, int h, int numSamples,
 
     for(int j=sy;j<ey;j++)
     {
-        for(int i=sx;i<ex;i++)
+        for(int i=sx;i<ex;)
         {
             unsigned int c = covBuffer[j*w+i];
+            int e = i+1;    //the end of the run of pixels with the same sample mask
+            while(e < ex && covBuffer[j*w+e] == c)
+                e++;
             if(c)
             {
                 int coverage = 0;
@@ -1949,8 +1954,9 @@ static void renderStroke(const VGContext* context, int w, int h, int numSamples,
                     if(c & (1<<k))
                         coverage++;
                 }
-                pixelPipe->pixelPipe(i, j, (RIfloat)coverage/(RIfloat)numSamples, c);
+                pixelPipe->pixelPipeSpan(i, j, e-i, (RIfloat)coverage/(RIfloat)numSamples, c);
             }
+            i = e;
         }
     }
     RI_DELETE_ARRAY(covBuffer);
@@ -1982,7 +1988,7 @@ void RI_APIENTRY vgRenderToMask(VGPath path, VGbitfield paintModes, VGMaskOperat
         Rasterizer rasterizer;
         if(context->m_scissoring)
             rasterizer.setScissor(context->m_scissor);	//throws bad_alloc
-        int numSamples = rasterizer.setupSamplingPattern(context->m_renderingQuality, drawable.getNumSamples());
+        int numSamples = rasterizer.setupSamplingPattern(context->m_renderingQuality, drawable.getNumSamples(), context->m_areaCoverage);
 
         PixelPipe pixelPipe;
         pixelPipe.setDrawable(&drawable);
@@ -1996,7 +2002,7 @@ void RI_APIENTRY vgRenderToMask(VGPath path, VGbitfield paintModes, VGMaskOperat
         if(paintModes & VG_FILL_PATH)
         {
             drawable.getColorBuffer()->clear(Color(0,0,0,0,drawable.getColorBuffer()->getDescriptor().internalFormat), 0, 0, drawable.getWidth(), drawable.getHeight());
-            ((Path*)path)->fill(userToSurface, rasterizer);	//throws bad_alloc
+            context->getPath(path)->fill(userToSurface, rasterizer);	//throws bad_alloc
             rasterizer.setup(0, 0, drawable.getWidth(), drawable.getHeight(), context->m_fillRule, &pixelPipe, NULL);
             rasterizer.fill();	//throws bad_alloc
             curr->getMaskBuffer()->mask(drawable.getColorBuffer(), operation, 0, 0, drawable.getWidth(), drawable.getHeight());
@@ -2005,7 +2011,7 @@ void RI_APIENTRY vgRenderToMask(VGPath path, VGbitfield paintModes, VGMaskOperat
         if(paintModes & VG_STROKE_PATH && context->m_strokeLineWidth > 0.0f)
         {
             drawable.getColorBuffer()->clear(Color(0,0,0,0,drawable.getColorBuffer()->getDescriptor().internalFormat), 0, 0, drawable.getWidth(), drawable.getHeight());
-            renderStroke(context, drawable.getWidth(), drawable.getHeight(), numSamples, (Path*)path, rasterizer, &pixelPipe, userToSurface);
+            renderStroke(context, drawable.getWidth(), drawable.getHeight(), numSamples, context->getPath(path), rasterizer, &pixelPipe, userToSurface);
             curr->getMaskBuffer()->mask(drawable.getColorBuffer(), operation, 0, 0, drawable.getWidth(), drawable.getHeight());
         }
 	}
@@ -2038,9 +2044,9 @@ VGMaskLayer RI_APIENTRY vgCreateMaskLayer(VGint width, VGint height)
 	{
 		layer = RI_NEW(Surface, (Color::formatToDescriptor(VG_A_8), width, height, curr->getNumSamples()));	//throws bad_alloc
 		RI_ASSERT(layer);
-		context->m_maskLayerManager->addResource(layer, context);	//throws bad_alloc
+		VGMaskLayer handle = context->m_maskLayerManager->addResource(layer, context);	//throws bad_alloc
         layer->clear(Color(1,1,1,1,Color::sRGBA), 0, 0, width, height);
-		RI_RETURN((VGMaskLayer)layer);
+		RI_RETURN(handle);
 	}
 	catch(std::bad_alloc)
 	{
@@ -2062,7 +2068,7 @@ void RI_APIENTRY vgDestroyMaskLayer(VGMaskLayer maskLayer)
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidMaskLayer(maskLayer), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid handle
 
-	context->m_maskLayerManager->removeResource((Surface*)maskLayer);
+	context->m_maskLayerManager->removeResource(maskLayer);
 	RI_RETURN(RI_NO_RETVAL);
 }
 
@@ -2078,7 +2084,7 @@ void RI_APIENTRY vgFillMaskLayer(VGMaskLayer maskLayer, VGint x, VGint y, VGint
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidMaskLayer(maskLayer), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid handle
     RI_IF_ERROR(value < 0.0f || value > 1.0f, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
-    Surface* layer = (Surface*)maskLayer;
+    Surface* layer = context->getMaskLayer(maskLayer);
     RI_IF_ERROR(width <= 0 || height <= 0 || x < 0 || y < 0 || x > layer->getWidth()-width || y > layer->getHeight()-height, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
     layer->clear(Color(1,1,1,value,Color::sRGBA), x, y, width, height);
 	RI_RETURN(RI_NO_RETVAL);
@@ -2100,7 +2106,7 @@ void RI_APIENTRY vgCopyMask(VGMaskLayer maskLayer, VGint dx, VGint dy, VGint sx,
     {
         RI_RETURN(RI_NO_RETVAL);	//no EGL surface is current at the moment or context has no mask buffer
     }
-    Surface* layer = (Surface*)maskLayer;
+    Surface* layer = context->getMaskLayer(maskLayer);
     RI_IF_ERROR(width <= 0 || height <= 0 || drawable->getNumSamples() != layer->getNumSamples(), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
     try
     {   //copy drawing surface mask to mask layer
@@ -2166,8 +2172,8 @@ VGPath RI_APIENTRY vgCreatePath(VGint pathFormat, VGPathDatatype datatype, VGflo
 	{
 		path = RI_NEW(Path, (pathFormat, datatype, s, b, segmentCapacityHint, coordCapacityHint, capabilities));	//throws bad_alloc
 		RI_ASSERT(path);
-		context->m_pathManager->addResource(path, context);	//throws bad_alloc
-		RI_RETURN((VGPath)path);
+		VGPath handle = context->m_pathManager->addResource(path, context);	//throws bad_alloc
+		RI_RETURN(handle);
 	}
 	catch(std::bad_alloc)
 	{
@@ -2189,7 +2195,7 @@ void RI_APIENTRY vgClearPath(VGPath path, VGbitfield capabilities)
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
 	capabilities &= VG_PATH_CAPABILITY_ALL;	//undefined bits are ignored
-	((Path*)path)->clear(capabilities);
+	context->getPath(path)->clear(capabilities);
 	RI_RETURN(RI_NO_RETVAL);
 }
 
@@ -2205,7 +2211,7 @@ void RI_APIENTRY vgDestroyPath(VGPath path)
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
 
-	context->m_pathManager->removeResource((Path*)path);
+	context->m_pathManager->removeResource(path);
 
 	RI_RETURN(RI_NO_RETVAL);
 }
@@ -2223,9 +2229,9 @@ void RI_APIENTRY vgRemovePathCapabilities(VGPath path, VGbitfield capabilities)
 	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
 	capabilities &= VG_PATH_CAPABILITY_ALL;	//undefined bits are ignored
 
-	VGbitfield caps = ((Path*)path)->getCapabilities();
+	VGbitfield caps = context->getPath(path)->getCapabilities();
 	caps &= ~capabilities;
-	((Path*)path)->setCapabilities(caps);
+	context->getPath(path)->setCapabilities(caps);
 	RI_RETURN(RI_NO_RETVAL);
 }
 
@@ -2240,7 +2246,7 @@ VGbitfield RI_APIENTRY vgGetPathCapabilities(VGPath path)
 {
 	RI_GET_CONTEXT(0);
 	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, 0);	//invalid path handle
-	VGbitfield ret = ((Path*)path)->getCapabilities();
+	VGbitfield ret = context->getPath(path)->getCapabilities();
 	RI_RETURN(ret);
 }
 
@@ -2255,7 +2261,7 @@ void RI_APIENTRY vgAppendPathData(VGPath dstPath, VGint numSegments, const VGuby
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPath(dstPath), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
-	Path* p = (Path*)dstPath;
+	Path* p = context->getPath(dstPath);
 	RI_IF_ERROR(!(p->getCapabilities() & VG_PATH_CAPABILITY_APPEND_TO), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//no append cap
 	RI_IF_ERROR(numSegments <= 0 || !pathSegments || !pathData, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);	//no segments or data
 	RI_IF_ERROR((p->getDatatype() == VG_PATH_DATATYPE_S_16 && !isAligned(pathData,2)) ||
@@ -2290,7 +2296,7 @@ void RI_APIENTRY vgModifyPathCoords(VGPath dstPath, VGint startIndex, VGint numS
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPath(dstPath), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
-	Path* p = (Path*)dstPath;
+	Path* p = context->getPath(dstPath);
 	RI_IF_ERROR(!(p->getCapabilities() & VG_PATH_CAPABILITY_MODIFY), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//no modify cap
 	RI_IF_ERROR(!pathData || startIndex < 0 || numSegments <= 0 || RI_INT_ADDSATURATE(startIndex, numSegments) > p->getNumSegments(), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);	//no segments
 	RI_IF_ERROR((p->getDatatype() == VG_PATH_DATATYPE_S_16 && !isAligned(pathData,2)) ||
@@ -2310,13 +2316,15 @@ void RI_APIENTRY vgModifyPathCoords(VGPath dstPath, VGint startIndex, VGint numS
 void RI_APIENTRY vgAppendPath(VGPath dstPath, VGPath srcPath)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
-	RI_IF_ERROR(!context->isValidPath(dstPath) || !context->isValidPath(srcPath), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
-	RI_IF_ERROR(!(((Path*)dstPath)->getCapabilities() & VG_PATH_CAPABILITY_APPEND_TO) ||
-				!(((Path*)srcPath)->getCapabilities() & VG_PATH_CAPABILITY_APPEND_FROM), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
+	Path* dst = context->getPath(dstPath);
+	Path* src = context->getPath(srcPath);
+	RI_IF_ERROR(!dst || !src, VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
+	RI_IF_ERROR(!(dst->getCapabilities() & VG_PATH_CAPABILITY_APPEND_TO) ||
+				!(src->getCapabilities() & VG_PATH_CAPABILITY_APPEND_FROM), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
 
 	try
 	{
-		((Path*)dstPath)->append((Path*)srcPath);	//throws bad_alloc
+		dst->append(src);	//throws bad_alloc
 	}
 	catch(std::bad_alloc)
 	{
@@ -2335,12 +2343,14 @@ void RI_APIENTRY vgAppendPath(VGPath dstPath, VGPath srcPath)
 void RI_APIENTRY vgTransformPath(VGPath dstPath, VGPath srcPath)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
-	RI_IF_ERROR(!context->isValidPath(dstPath) || !context->isValidPath(srcPath), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
-	RI_IF_ERROR(!(((Path*)dstPath)->getCapabilities() & VG_PATH_CAPABILITY_TRANSFORM_TO) ||
-				!(((Path*)srcPath)->getCapabilities() & VG_PATH_CAPABILITY_TRANSFORM_FROM), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
+	Path* dst = context->getPath(dstPath);
+	Path* src = context->getPath(srcPath);
+	RI_IF_ERROR(!dst || !src, VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
+	RI_IF_ERROR(!(dst->getCapabilities() & VG_PATH_CAPABILITY_TRANSFORM_TO) ||
+				!(src->getCapabilities() & VG_PATH_CAPABILITY_TRANSFORM_FROM), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
 	try
 	{
-		((Path*)dstPath)->transform((Path*)srcPath, context->m_pathUserToSurface);	//throws bad_alloc
+		dst->transform(src, context->m_pathUserToSurface);	//throws bad_alloc
 	}
 	catch(std::bad_alloc)
 	{
@@ -2356,7 +2366,7 @@ void RI_APIENTRY vgTransformPath(VGPath dstPath, VGPath srcPath)
 * \note		
 *//*-------------------------------------------------------------------*/
 
-static bool drawPath(VGContext* context, VGPath path, const Matrix3x3& userToSurfaceMatrix, VGbitfield paintModes)
+static bool drawPath(VGContext* context, Path* path, const Matrix3x3& userToSurfaceMatrix, VGbitfield paintModes)
 {
 	//set up rendering surface and mask buffer
     Drawable* drawable = context->getCurrentDrawable();
@@ -2366,7 +2376,7 @@ static bool drawPath(VGContext* context, VGPath path, const Matrix3x3& userToSur
 	Rasterizer rasterizer;
 	if(context->m_scissoring)
 		rasterizer.setScissor(context->m_scissor);	//throws bad_alloc
-	int numSamples = rasterizer.setupSamplingPattern(context->m_renderingQuality, drawable->getNumSamples());
+	int numSamples = rasterizer.setupSamplingPattern(context->m_renderingQuality, drawable->getNumSamples(), context->m_areaCoverage);
 
 	PixelPipe pixelPipe;
 	pixelPipe.setDrawable(drawable);
@@ -2381,7 +2391,7 @@ static bool drawPath(VGContext* context, VGPath path, const Matrix3x3& userToSur
 
 	if(paintModes & VG_FILL_PATH)
 	{
-		pixelPipe.setPaint((Paint*)context->m_fillPaint);
+		pixelPipe.setPaint(context->m_fillPaint);
 
 		Matrix3x3 surfaceToPaintMatrix = userToSurface * context->m_fillPaintToUser;
 		if(surfaceToPaintMatrix.invert())
@@ -2390,14 +2400,14 @@ static bool drawPath(VGContext* context, VGPath path, const Matrix3x3& userToSur
 			pixelPipe.setSurfaceToPaintMatrix(surfaceToPaintMatrix);
 
             rasterizer.setup(0, 0, drawable->getWidth(), drawable->getHeight(), context->m_fillRule, &pixelPipe, NULL);
-			((Path*)path)->fill(userToSurface, rasterizer);	//throws bad_alloc
+			path->fill(userToSurface, rasterizer);	//throws bad_alloc
 			rasterizer.fill();	//throws bad_alloc
 		}
 	}
 
 	if(paintModes & VG_STROKE_PATH && context->m_strokeLineWidth > 0.0f)
 	{
-		pixelPipe.setPaint((Paint*)context->m_strokePaint);
+		pixelPipe.setPaint(context->m_strokePaint);
 
 		Matrix3x3 surfaceToPaintMatrix = userToSurface * context->m_strokePaintToUser;
 		if(surfaceToPaintMatrix.invert())
@@ -2405,7 +2415,7 @@ static bool drawPath(VGContext* context, VGPath path, const Matrix3x3& userToSur
 			surfaceToPaintMatrix[2].set(0,0,1);		//force affinity
 			pixelPipe.setSurfaceToPaintMatrix(surfaceToPaintMatrix);
 
-            renderStroke(context, drawable->getWidth(), drawable->getHeight(), numSamples, (Path*)path, rasterizer, &pixelPipe, userToSurface);
+            renderStroke(context, drawable->getWidth(), drawable->getHeight(), numSamples, path, rasterizer, &pixelPipe, userToSurface);
 		}
 	}
 	return true;
@@ -2414,12 +2424,13 @@ static bool drawPath(VGContext* context, VGPath path, const Matrix3x3& userToSur
 void RI_APIENTRY vgDrawPath(VGPath path, VGbitfield paintModes)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
-	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
+	Path* p = context->getPath(path);
+	RI_IF_ERROR(!p, VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
 	RI_IF_ERROR(!paintModes || (paintModes & ~(VG_FILL_PATH | VG_STROKE_PATH)), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);	//invalid paint mode
 
 	try
 	{
-		if(!drawPath(context, path, context->m_pathUserToSurface, paintModes))
+		if(!drawPath(context, p, context->m_pathUserToSurface, paintModes))
 		{
 			RI_RETURN(RI_NO_RETVAL);
 		}
@@ -2442,7 +2453,7 @@ VGfloat RI_APIENTRY vgPathLength(VGPath path, VGint startSegment, VGint numSegme
 {
 	RI_GET_CONTEXT(-1.0f);
 	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, -1.0f);	//invalid path handle
-	Path* p = (Path*)path;
+	Path* p = context->getPath(path);
 	RI_IF_ERROR(!(p->getCapabilities() & VG_PATH_CAPABILITY_PATH_LENGTH), VG_PATH_CAPABILITY_ERROR, -1.0f);	//invalid caps
 	RI_IF_ERROR(startSegment < 0 || numSegments <= 0 || RI_INT_ADDSATURATE(startSegment, numSegments) > p->getNumSegments(), VG_ILLEGAL_ARGUMENT_ERROR, -1.0f);
 	RIfloat pathLength = -1.0f;
@@ -2468,7 +2479,7 @@ void RI_APIENTRY vgPointAlongPath(VGPath path, VGint startSegment, VGint numSegm
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
-	Path* p = (Path*)path;
+	Path* p = context->getPath(path);
 	RI_IF_ERROR((x && y && !(p->getCapabilities() & VG_PATH_CAPABILITY_POINT_ALONG_PATH)) ||
 				(tangentX && tangentY && !(p->getCapabilities() & VG_PATH_CAPABILITY_TANGENT_ALONG_PATH)), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
 	RI_IF_ERROR(startSegment < 0 || numSegments <= 0 || RI_INT_ADDSATURATE(startSegment, numSegments) > p->getNumSegments(), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
@@ -2507,13 +2518,13 @@ void RI_APIENTRY vgPathBounds(VGPath path, VGfloat * minx, VGfloat * miny, VGflo
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
-	RI_IF_ERROR(!(((Path*)path)->getCapabilities() & VG_PATH_CAPABILITY_PATH_BOUNDS), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
+	RI_IF_ERROR(!(context->getPath(path)->getCapabilities() & VG_PATH_CAPABILITY_PATH_BOUNDS), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
 	RI_IF_ERROR(!minx || !miny || !width || !height, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!isAligned(minx,4) || !isAligned(miny,4) || !isAligned(width,4) || !isAligned(height,4), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	try
 	{
 		RIfloat pminx,pminy,pmaxx,pmaxy;
-		((Path*)path)->getPathBounds(pminx, pminy, pmaxx, pmaxy);	//throws bad_alloc
+		context->getPath(path)->getPathBounds(pminx, pminy, pmaxx, pmaxy);	//throws bad_alloc
 		*minx = pminx;
 		*miny = pminy;
 		*width = pmaxx - pminx;
@@ -2537,13 +2548,13 @@ void RI_APIENTRY vgPathTransformedBounds(VGPath path, VGfloat * minx, VGfloat *
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPath(path), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
-	RI_IF_ERROR(!(((Path*)path)->getCapabilities() & VG_PATH_CAPABILITY_PATH_TRANSFORMED_BOUNDS), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
+	RI_IF_ERROR(!(context->getPath(path)->getCapabilities() & VG_PATH_CAPABILITY_PATH_TRANSFORMED_BOUNDS), VG_PATH_CAPABILITY_ERROR, RI_NO_RETVAL);	//invalid caps
 	RI_IF_ERROR(!minx || !miny || !width || !height, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!isAligned(minx,4) || !isAligned(miny,4) || !isAligned(width,4) || !isAligned(height,4), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	try
 	{
 		RIfloat pminx, pminy, pmaxx, pmaxy;
-		((Path*)path)->getPathTransformedBounds(context->m_pathUserToSurface, pminx, pminy, pmaxx, pmaxy);	//throws bad_alloc
+		context->getPath(path)->getPathTransformedBounds(context->m_pathUserToSurface, pminx, pminy, pmaxx, pmaxy);	//throws bad_alloc
 		*minx = pminx;
 		*miny = pminy;
 		*width = pmaxx - pminx;
@@ -2566,14 +2577,17 @@ void RI_APIENTRY vgPathTransformedBounds(VGPath path, VGfloat * minx, VGfloat *
 VGboolean RI_APIENTRY vgInterpolatePath(VGPath dstPath, VGPath startPath, VGPath endPath, VGfloat amount)
 {
 	RI_GET_CONTEXT(VG_FALSE);
-	RI_IF_ERROR(!context->isValidPath(dstPath) || !context->isValidPath(startPath) || !context->isValidPath(endPath), VG_BAD_HANDLE_ERROR, VG_FALSE);	//invalid path handle
-	RI_IF_ERROR(!(((Path*)dstPath)->getCapabilities() & VG_PATH_CAPABILITY_INTERPOLATE_TO) ||
-				!(((Path*)startPath)->getCapabilities() & VG_PATH_CAPABILITY_INTERPOLATE_FROM) ||
-				!(((Path*)endPath)->getCapabilities() & VG_PATH_CAPABILITY_INTERPOLATE_FROM), VG_PATH_CAPABILITY_ERROR, VG_FALSE);	//invalid caps
+	Path* dst = context->getPath(dstPath);
+	Path* start = context->getPath(startPath);
+	Path* end = context->getPath(endPath);
+	RI_IF_ERROR(!dst || !start || !end, VG_BAD_HANDLE_ERROR, VG_FALSE);	//invalid path handle
+	RI_IF_ERROR(!(dst->getCapabilities() & VG_PATH_CAPABILITY_INTERPOLATE_TO) ||
+				!(start->getCapabilities() & VG_PATH_CAPABILITY_INTERPOLATE_FROM) ||
+				!(end->getCapabilities() & VG_PATH_CAPABILITY_INTERPOLATE_FROM), VG_PATH_CAPABILITY_ERROR, VG_FALSE);	//invalid caps
 	VGboolean ret = VG_FALSE;
 	try
 	{
-		if(((Path*)dstPath)->interpolate((const Path*)startPath, (const Path*)endPath, inputFloat(amount)))	//throws bad_alloc
+		if(dst->interpolate(start, end, inputFloat(amount)))	//throws bad_alloc
 			ret = VG_TRUE;
 	}
 	catch(std::bad_alloc)
@@ -2598,8 +2612,8 @@ VGPaint RI_APIENTRY vgCreatePaint(void)
 	{
 		paint = RI_NEW(Paint, ());	//throws bad_alloc
 		RI_ASSERT(paint);
-		context->m_paintManager->addResource(paint, context);	//throws bad_alloc
-		RI_RETURN((VGPaint)paint);
+		VGPaint handle = context->m_paintManager->addResource(paint, context);	//throws bad_alloc
+		RI_RETURN(handle);
 	}
 	catch(std::bad_alloc)
 	{
@@ -2621,7 +2635,7 @@ void RI_APIENTRY vgDestroyPaint(VGPaint paint)
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPaint(paint), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid paint handle
 
-	context->m_paintManager->removeResource((Paint*)paint);
+	context->m_paintManager->removeResource(paint);
 
 	RI_RETURN(RI_NO_RETVAL);
 }
@@ -2636,22 +2650,23 @@ void RI_APIENTRY vgDestroyPaint(VGPaint paint)
 void RI_APIENTRY vgSetPaint(VGPaint paint, VGbitfield paintModes)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
-	RI_IF_ERROR(paint && !context->isValidPaint(paint), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid paint handle
+	Paint* p = context->getPaint(paint);
+	RI_IF_ERROR(paint && !p, VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid paint handle
 	RI_IF_ERROR(!paintModes || paintModes & ~(VG_FILL_PATH | VG_STROKE_PATH), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);	//invalid paint mode
 
 	context->releasePaint(paintModes);
 
 	if(paintModes & VG_FILL_PATH)
 	{
-		if(paint)
-			((Paint*)paint)->addReference();
-		context->m_fillPaint = paint;
+		if(p)
+			p->addReference();
+		context->m_fillPaint = p;
 	}
 	if(paintModes & VG_STROKE_PATH)
 	{
-		if(paint)
-			((Paint*)paint)->addReference();
-		context->m_strokePaint = paint;
+		if(p)
+			p->addReference();
+		context->m_strokePaint = p;
 	}
 	RI_RETURN(RI_NO_RETVAL);
 }
@@ -2667,7 +2682,7 @@ void RI_APIENTRY vgSetColor(VGPaint paint, VGuint rgba)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPaint(paint), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid paint handle
-	Paint* p = (Paint*)paint;
+	Paint* p = context->getPaint(paint);
 	p->m_inputPaintColor.unpack(rgba, Color::formatToDescriptor(VG_sRGBA_8888));
 	p->m_paintColor = inputColor(p->m_inputPaintColor);
 	p->m_paintColor.clamp();
@@ -2686,7 +2701,7 @@ VGuint RI_APIENTRY vgGetColor(VGPaint paint)
 {
 	RI_GET_CONTEXT(0);
 	RI_IF_ERROR(!context->isValidPaint(paint), VG_BAD_HANDLE_ERROR, 0);	//invalid paint handle
-	unsigned int ret = ((Paint*)paint)->m_inputPaintColor.pack(Color::formatToDescriptor(VG_sRGBA_8888));
+	unsigned int ret = context->getPaint(paint)->m_inputPaintColor.pack(Color::formatToDescriptor(VG_sRGBA_8888));
 	RI_RETURN(ret);
 }
 
@@ -2702,11 +2717,10 @@ VGPaint RI_APIENTRY vgGetPaint(VGPaintMode paintMode)
 	RI_GET_CONTEXT(VG_INVALID_HANDLE);
 	RI_IF_ERROR(paintMode != VG_FILL_PATH && paintMode != VG_STROKE_PATH, VG_ILLEGAL_ARGUMENT_ERROR, VG_INVALID_HANDLE);	//invalid paint mode
 
-	if(paintMode == VG_FILL_PATH)
-	{
-		RI_RETURN(context->m_fillPaint);
-	}
-	RI_RETURN(context->m_strokePaint);
+	//a paint destroyed while set to the context has no handle anymore
+	Paint* p = (paintMode == VG_FILL_PATH) ? context->m_fillPaint : context->m_strokePaint;
+	VGPaint ret = p ? context->m_paintManager->getHandle(p) : VG_INVALID_HANDLE;
+	RI_RETURN(ret);
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -2720,8 +2734,8 @@ void RI_APIENTRY vgPaintPattern(VGPaint paint, VGImage image)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidPaint(paint) || (image != VG_INVALID_HANDLE && !context->isValidImage(image)), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid handle
-	Image* img = (Image*)image;
-	Paint* pnt = (Paint*)paint;
+	Image* img = context->getImage(image);
+	Paint* pnt = context->getPaint(paint);
 	RI_IF_ERROR(image != VG_INVALID_HANDLE && eglvgIsInUse(img), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	Image* pattern = pnt->m_pattern;
 	if(pattern)
@@ -2760,8 +2774,8 @@ VGImage RI_APIENTRY vgCreateImage(VGImageFormat format, VGint width, VGint heigh
 	{
 		image = RI_NEW(Image, (Color::formatToDescriptor(format), width, height, allowedQuality));	//throws bad_alloc
 		RI_ASSERT(image);
-		context->m_imageManager->addResource(image, context);	//throws bad_alloc
-		RI_RETURN((VGImage)image);
+		VGImage handle = context->m_imageManager->addResource(image, context);	//throws bad_alloc
+		RI_RETURN(handle);
 	}
 	catch(std::bad_alloc)
 	{
@@ -2783,7 +2797,7 @@ void RI_APIENTRY vgDestroyImage(VGImage image)
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(image), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid image handle
 
-	context->m_imageManager->removeResource((Image*)image);
+	context->m_imageManager->removeResource(image);
 
 	RI_RETURN(RI_NO_RETVAL);
 }
@@ -2799,7 +2813,7 @@ void RI_APIENTRY vgClearImage(VGImage image, VGint x, VGint y, VGint width, VGin
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(image), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* img = (Image*)image;
+	Image* img = context->getImage(image);
 	RI_IF_ERROR(eglvgIsInUse(img), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(width <= 0 || height <= 0, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	img->clear(context->m_clearColor, x, y, width, height);
@@ -2817,7 +2831,7 @@ void RI_APIENTRY vgImageSubData(VGImage image, const void * data, VGint dataStri
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(image), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* img = (Image*)image;
+	Image* img = context->getImage(image);
 	RI_IF_ERROR(eglvgIsInUse(img), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!isValidImageFormat(dataFormat), VG_UNSUPPORTED_IMAGE_FORMAT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!data || !isAligned(data, dataFormat) || width <= 0 || height <= 0, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
@@ -2847,7 +2861,7 @@ void RI_APIENTRY vgGetImageSubData(VGImage image, void * data, VGint dataStride,
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(image), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* img = (Image*)image;
+	Image* img = context->getImage(image);
 	RI_IF_ERROR(eglvgIsInUse(img), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!isValidImageFormat(dataFormat), VG_UNSUPPORTED_IMAGE_FORMAT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!data || !isAligned(data, dataFormat) || width <= 0 || height <= 0, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
@@ -2877,8 +2891,8 @@ VGImage RI_APIENTRY vgChildImage(VGImage parent, VGint x, VGint y, VGint width,
 {
 	RI_GET_CONTEXT(VG_INVALID_HANDLE);
 	RI_IF_ERROR(!context->isValidImage(parent), VG_BAD_HANDLE_ERROR, VG_INVALID_HANDLE);
-	Image* p = (Image*)parent;
-	RI_IF_ERROR(eglvgIsInUse((Image*)parent), VG_IMAGE_IN_USE_ERROR, VG_INVALID_HANDLE);
+	Image* p = context->getImage(parent);
+	RI_IF_ERROR(eglvgIsInUse(context->getImage(parent)), VG_IMAGE_IN_USE_ERROR, VG_INVALID_HANDLE);
 	RI_IF_ERROR(x < 0 || x >= p->getWidth() || y < 0 || y >= p->getHeight() ||
 				width <= 0 || height <= 0 || RI_INT_ADDSATURATE(x, width) > p->getWidth() || RI_INT_ADDSATURATE(y, height) > p->getHeight(), VG_ILLEGAL_ARGUMENT_ERROR, VG_INVALID_HANDLE);
 
@@ -2887,8 +2901,8 @@ VGImage RI_APIENTRY vgChildImage(VGImage parent, VGint x, VGint y, VGint width,
 	{
 		child = RI_NEW(Image, (p, x, y, width, height));	//throws bad_alloc
 		RI_ASSERT(child);
-		context->m_imageManager->addResource(child, context);	//throws bad_alloc
-		RI_RETURN((VGImage)child);
+		VGImage handle = context->m_imageManager->addResource(child, context);	//throws bad_alloc
+		RI_RETURN(handle);
 	}
 	catch(std::bad_alloc)
 	{
@@ -2913,12 +2927,13 @@ VGImage RI_APIENTRY vgGetParent(VGImage image)
 
     //The vgGetParent function returns the closest valid ancestor (i.e., one that has not been the target of a vgDestroyImage call)
     // of the given image.
-	Image* im = ((Image*)image)->getParent();
+	Image* im = context->getImage(image)->getParent();
     for(;im;im = im->getParent())
     {
-		if(context->isValidImage((VGImage)im))
+		VGImage parent = context->m_imageManager->getHandle(im);
+		if(parent != VG_INVALID_HANDLE)
 		{	//the parent is valid and alive
-			ret = (VGImage)im;
+			ret = parent;
             break;
 		}
 	}
@@ -2936,11 +2951,11 @@ void RI_APIENTRY vgCopyImage(VGImage dst, VGint dx, VGint dy, VGImage src, VGint
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(dst) || !context->isValidImage(src), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	RI_IF_ERROR(eglvgIsInUse((Image*)dst) || eglvgIsInUse((Image*)src), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
+	RI_IF_ERROR(eglvgIsInUse(context->getImage(dst)) || eglvgIsInUse(context->getImage(src)), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(width <= 0 || height <= 0, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	try
 	{
-		((Image*)dst)->blit(*(Image*)src, sx, sy, dx, dy, width, height, dither ? true : false);	//throws bad_alloc
+		context->getImage(dst)->blit(*context->getImage(src), sx, sy, dx, dy, width, height, dither ? true : false);	//throws bad_alloc
 	}
 	catch(std::bad_alloc)
 	{
@@ -2955,13 +2970,12 @@ void RI_APIENTRY vgCopyImage(VGImage dst, VGint dx, VGint dy, VGImage src, VGint
 * \note		
 *//*-------------------------------------------------------------------*/
 
-static bool drawImage(VGContext* context, VGImage image, const Matrix3x3& userToSurfaceMatrix)
+static bool drawImage(VGContext* context, Image* img, const Matrix3x3& userToSurfaceMatrix)
 {
     Drawable* drawable = context->getCurrentDrawable();
     if(!drawable)
         return false;   //no EGL surface is current at the moment
 
-	Image* img = (Image*)image;
 	//transform image corners into the surface space
 	Vector3 p0(0, 0, 1);
 	Vector3 p1(0, (RIfloat)img->getHeight(), 1);
@@ -2983,11 +2997,11 @@ static bool drawImage(VGContext* context, VGImage image, const Matrix3x3& userTo
 	Rasterizer rasterizer;
 	if(context->m_scissoring)
 		rasterizer.setScissor(context->m_scissor);	//throws bad_alloc
-	rasterizer.setupSamplingPattern(context->m_renderingQuality, drawable->getNumSamples());
+	rasterizer.setupSamplingPattern(context->m_renderingQuality, drawable->getNumSamples(), context->m_areaCoverage);
 
 	PixelPipe pixelPipe;
 	pixelPipe.setTileFillColor(context->m_tileFillColor);
-	pixelPipe.setPaint((Paint*)context->m_fillPaint);
+	pixelPipe.setPaint(context->m_fillPaint);
 	pixelPipe.setImageQuality(context->m_imageQuality);
 	pixelPipe.setBlendMode(context->m_blendMode);
 	pixelPipe.setDrawable(drawable);
@@ -3021,12 +3035,12 @@ void RI_APIENTRY vgDrawImage(VGImage image)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(image), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* img = (Image*)image;
+	Image* img = context->getImage(image);
 	RI_IF_ERROR(eglvgIsInUse(img), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 
 	try
 	{
-		if(!drawImage(context, image, context->m_imageUserToSurface))
+		if(!drawImage(context, img, context->m_imageUserToSurface))
 		{
 			RI_RETURN(RI_NO_RETVAL);
 		}
@@ -3049,7 +3063,7 @@ void RI_APIENTRY vgSetPixels(VGint dx, VGint dy, VGImage src, VGint sx, VGint sy
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(src), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	RI_IF_ERROR(eglvgIsInUse((Image*)src), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
+	RI_IF_ERROR(eglvgIsInUse(context->getImage(src)), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(width <= 0 || height <= 0, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
     Drawable* drawable = context->getCurrentDrawable();
     if(!drawable)
@@ -3059,9 +3073,9 @@ void RI_APIENTRY vgSetPixels(VGint dx, VGint dy, VGImage src, VGint sx, VGint sy
 	try
 	{
 		if(context->m_scissoring)
-			drawable->getColorBuffer()->blit(*(Image*)src, sx, sy, dx, dy, width, height, context->m_scissor);	//throws bad_alloc
+			drawable->getColorBuffer()->blit(*context->getImage(src), sx, sy, dx, dy, width, height, context->m_scissor);	//throws bad_alloc
 		else
-			drawable->getColorBuffer()->blit(*(Image*)src, sx, sy, dx, dy, width, height);	//throws bad_alloc
+			drawable->getColorBuffer()->blit(*context->getImage(src), sx, sy, dx, dy, width, height);	//throws bad_alloc
 	}
 	catch(std::bad_alloc)
 	{
@@ -3115,7 +3129,7 @@ void RI_APIENTRY vgGetPixels(VGImage dst, VGint dx, VGint dy, VGint sx, VGint sy
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(dst), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	RI_IF_ERROR(eglvgIsInUse((Image*)dst), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
+	RI_IF_ERROR(eglvgIsInUse(context->getImage(dst)), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(width <= 0 || height <= 0, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
     Drawable* drawable = context->getCurrentDrawable();
     if(!drawable)
@@ -3124,7 +3138,7 @@ void RI_APIENTRY vgGetPixels(VGImage dst, VGint dx, VGint dy, VGint sx, VGint sy
     }
 	try
 	{
-		((Image*)dst)->blit(drawable->getColorBuffer(), sx, sy, dx, dy, width, height);	//throws bad_alloc
+		context->getImage(dst)->blit(drawable->getColorBuffer(), sx, sy, dx, dy, width, height);	//throws bad_alloc
 	}
 	catch(std::bad_alloc)
 	{
@@ -3204,8 +3218,8 @@ void RI_APIENTRY vgColorMatrix(VGImage dst, VGImage src, const VGfloat * matrix)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(dst) || !context->isValidImage(src), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* d = (Image*)dst;
-	Image* s = (Image*)src;
+	Image* d = context->getImage(dst);
+	Image* s = context->getImage(src);
 	RI_IF_ERROR(eglvgIsInUse(d) || eglvgIsInUse(s), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(d->overlaps(s), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!matrix || !isAligned(matrix,4), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
@@ -3237,8 +3251,8 @@ void RI_APIENTRY vgConvolve(VGImage dst, VGImage src, VGint kernelWidth, VGint k
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(dst) || !context->isValidImage(src), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* d = (Image*)dst;
-	Image* s = (Image*)src;
+	Image* d = context->getImage(dst);
+	Image* s = context->getImage(src);
 	RI_IF_ERROR(eglvgIsInUse(d) || eglvgIsInUse(s), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(d->overlaps(s), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!kernel || !isAligned(kernel,2) || kernelWidth <= 0 || kernelHeight <= 0 || kernelWidth > RI_MAX_KERNEL_SIZE || kernelHeight > RI_MAX_KERNEL_SIZE, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
@@ -3265,8 +3279,8 @@ void RI_APIENTRY vgSeparableConvolve(VGImage dst, VGImage src, VGint kernelWidth
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(dst) || !context->isValidImage(src), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* d = (Image*)dst;
-	Image* s = (Image*)src;
+	Image* d = context->getImage(dst);
+	Image* s = context->getImage(src);
 	RI_IF_ERROR(eglvgIsInUse(d) || eglvgIsInUse(s), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(d->overlaps(s), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!kernelX || !kernelY || !isAligned(kernelX,2) || !isAligned(kernelY,2) || kernelWidth <= 0 || kernelHeight <= 0 || kernelWidth > RI_MAX_SEPARABLE_KERNEL_SIZE || kernelHeight > RI_MAX_SEPARABLE_KERNEL_SIZE, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
@@ -3295,8 +3309,8 @@ void RI_APIENTRY vgGaussianBlur(VGImage dst, VGImage src, VGfloat stdDeviationX,
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(dst) || !context->isValidImage(src), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* d = (Image*)dst;
-	Image* s = (Image*)src;
+	Image* d = context->getImage(dst);
+	Image* s = context->getImage(src);
 	RI_IF_ERROR(eglvgIsInUse(d) || eglvgIsInUse(s), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(d->overlaps(s), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RIfloat sx = inputFloat(stdDeviationX);
@@ -3326,8 +3340,8 @@ void RI_APIENTRY vgLookup(VGImage dst, VGImage src, const VGubyte * redLUT, cons
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(dst) || !context->isValidImage(src), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* d = (Image*)dst;
-	Image* s = (Image*)src;
+	Image* d = context->getImage(dst);
+	Image* s = context->getImage(src);
 	RI_IF_ERROR(eglvgIsInUse(d) || eglvgIsInUse(s), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(d->overlaps(s), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!redLUT || !greenLUT || !blueLUT || !alphaLUT, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
@@ -3355,8 +3369,8 @@ void RI_APIENTRY vgLookupSingle(VGImage dst, VGImage src, const VGuint * lookupT
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidImage(dst) || !context->isValidImage(src), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);
-	Image* d = (Image*)dst;
-	Image* s = (Image*)src;
+	Image* d = context->getImage(dst);
+	Image* s = context->getImage(src);
 	RI_IF_ERROR(eglvgIsInUse(d) || eglvgIsInUse(s), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(d->overlaps(s), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(!lookupTable || !isAligned(lookupTable,4), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
@@ -3444,8 +3458,8 @@ VGFont RI_APIENTRY vgCreateFont(VGint glyphCapacityHint)
 	{
 		font = RI_NEW(Font, (glyphCapacityHint));	//throws bad_alloc
 		RI_ASSERT(font);
-		context->m_fontManager->addResource(font, context);	//throws bad_alloc
-		RI_RETURN((VGFont)font);
+		VGFont handle = context->m_fontManager->addResource(font, context);	//throws bad_alloc
+		RI_RETURN(handle);
 	}
 	catch(std::bad_alloc)
 	{
@@ -3467,7 +3481,7 @@ void RI_APIENTRY vgDestroyFont(VGFont font)
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidFont(font), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid font handle
 
-	context->m_fontManager->removeResource((Font*)font);
+	context->m_fontManager->removeResource(font);
 
 	RI_RETURN(RI_NO_RETVAL);
 }
@@ -3485,11 +3499,11 @@ void RI_APIENTRY vgSetGlyphToPath(VGFont font, VGuint glyphIndex, VGPath path, V
 	RI_IF_ERROR(!context->isValidFont(font), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid font handle
 	RI_IF_ERROR(path != VG_INVALID_HANDLE && !context->isValidPath(path), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid path handle
     RI_IF_ERROR(!glyphOrigin || !escapement || !isAligned(glyphOrigin,sizeof(VGfloat)) || !isAligned(escapement,sizeof(VGfloat)), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
-	Font* f = (Font*)font;
+	Font* f = context->getFont(font);
 
 	try
 	{
-        f->setGlyphToPath(glyphIndex, path, isHinted ? true : false, Vector2(inputFloat(glyphOrigin[0]), inputFloat(glyphOrigin[1])), Vector2(inputFloat(escapement[0]), inputFloat(escapement[1])));
+        f->setGlyphToPath(glyphIndex, context->getPath(path), isHinted ? true : false, Vector2(inputFloat(glyphOrigin[0]), inputFloat(glyphOrigin[1])), Vector2(inputFloat(escapement[0]), inputFloat(escapement[1])));
 	}
 	catch(std::bad_alloc)
 	{
@@ -3512,14 +3526,14 @@ void RI_APIENTRY vgSetGlyphToImage(VGFont font, VGuint glyphIndex, VGImage image
     if(image != VG_INVALID_HANDLE)
     {
         RI_IF_ERROR(!context->isValidImage(image), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid image handle
-        RI_IF_ERROR(eglvgIsInUse((Image*)image), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL); //image in use
+        RI_IF_ERROR(eglvgIsInUse(context->getImage(image)), VG_IMAGE_IN_USE_ERROR, RI_NO_RETVAL); //image in use
     }
     RI_IF_ERROR(!glyphOrigin || !escapement || !isAligned(glyphOrigin,sizeof(VGfloat)) || !isAligned(escapement,sizeof(VGfloat)), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
-	Font* f = (Font*)font;
+	Font* f = context->getFont(font);
 
 	try
 	{
-        f->setGlyphToImage(glyphIndex, image, Vector2(inputFloat(glyphOrigin[0]), inputFloat(glyphOrigin[1])), Vector2(inputFloat(escapement[0]), inputFloat(escapement[1])));
+        f->setGlyphToImage(glyphIndex, context->getImage(image), Vector2(inputFloat(glyphOrigin[0]), inputFloat(glyphOrigin[1])), Vector2(inputFloat(escapement[0]), inputFloat(escapement[1])));
 	}
 	catch(std::bad_alloc)
 	{
@@ -3539,7 +3553,7 @@ void RI_APIENTRY vgClearGlyph(VGFont font, VGuint glyphIndex)
 {
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidFont(font), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid font handle
-	Font* f = (Font*)font;
+	Font* f = context->getFont(font);
     Font::Glyph* g = f->findGlyph(glyphIndex);
     RI_IF_ERROR(!g, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);   //glyphIndex not defined
 
@@ -3560,7 +3574,7 @@ void RI_APIENTRY vgDrawGlyph(VGFont font, VGuint glyphIndex, VGbitfield paintMod
 	RI_GET_CONTEXT(RI_NO_RETVAL);
 	RI_IF_ERROR(!context->isValidFont(font), VG_BAD_HANDLE_ERROR, RI_NO_RETVAL);	//invalid font handle
 	RI_IF_ERROR(paintModes & ~(VG_FILL_PATH | VG_STROKE_PATH), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);	//invalid paint mode
-	Font* f = (Font*)font;
+	Font* f = context->getFont(font);
     Font::Glyph* g = f->findGlyph(glyphIndex);
     RI_IF_ERROR(!g, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);   //glyphIndex not defined
     RI_UNREF(allowAutoHinting); //RI doesn't implement autohinting
@@ -3578,9 +3592,9 @@ void RI_APIENTRY vgDrawGlyph(VGFont font, VGuint glyphIndex, VGbitfield paintMod
             userToSurfaceMatrix[2].set(0,0,1);		//force affinity
 
             bool ret = true;
-            if(g->m_image != VG_INVALID_HANDLE)
+            if(g->m_image)
                 ret = drawImage(context, g->m_image, userToSurfaceMatrix);
-            else if(g->m_path != VG_INVALID_HANDLE)
+            else if(g->m_path)
                 ret = drawPath(context, g->m_path, userToSurfaceMatrix, paintModes);
             if(!ret)
             {
@@ -3613,7 +3627,7 @@ void RI_APIENTRY vgDrawGlyphs(VGFont font, VGint glyphCount, VGuint *glyphIndice
 	RI_IF_ERROR(!glyphIndices || !isAligned(glyphIndices, sizeof(VGuint)) || glyphCount <= 0, VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR((adjustments_x && !isAligned(adjustments_x, sizeof(VGfloat))) || (adjustments_y && !isAligned(adjustments_y, sizeof(VGfloat))), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);
 	RI_IF_ERROR(paintModes & ~(VG_FILL_PATH | VG_STROKE_PATH), VG_ILLEGAL_ARGUMENT_ERROR, RI_NO_RETVAL);	//invalid paint mode
-	Font* f = (Font*)font;
+	Font* f = context->getFont(font);
 	for(int i=0;i<glyphCount;i++)
 	{
         Font::Glyph* g = f->findGlyph(glyphIndices[i]);
@@ -3638,9 +3652,9 @@ void RI_APIENTRY vgDrawGlyphs(VGFont font, VGint glyphCount, VGuint *glyphIndice
                 userToSurfaceMatrix[2].set(0,0,1);		//force affinity
 
                 bool ret = true;
-                if(g->m_image != VG_INVALID_HANDLE)
+                if(g->m_image)
                     ret = drawImage(context, g->m_image, userToSurfaceMatrix);
-                else if(g->m_path != VG_INVALID_HANDLE)
+                else if(g->m_path)
                     ret = drawPath(context, g->m_path, userToSurfaceMatrix, paintModes);
                 if(!ret)
                 {
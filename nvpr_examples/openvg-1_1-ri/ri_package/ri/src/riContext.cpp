@@ -30,11 +30,47 @@
  * \note	
  *//*-------------------------------------------------------------------*/
 
+#include <stdlib.h>
 #include "riContext.h"
 
 namespace OpenVGRI
 {
 
+/*-------------------------------------------------------------------*//*!
+* \brief	Returns a new nonzero resource handle.
+* \param	
+* \return	
+* \note		The handles are taken from a counter shared by all the
+*			resource managers so that a handle of one object type is never
+*			a valid handle of another. This function is always called from
+*			a mutexed API function.
+*//*-------------------------------------------------------------------*/
+
+VGHandle newResourceHandle()
+{
+	static RIuint32 lastHandle = 0;
+	if(++lastHandle == 0)
+		lastHandle = 1;		//VG_INVALID_HANDLE
+	return (VGHandle)lastHandle;
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief	Returns whether a new context computes antialiased fill
+*			coverage from pixel areas.
+* \param	
+* \return	
+* \note		An RI_AREA_COVERAGE environment variable overrides the
+*			default of the same name in riDefs.h.
+*//*-------------------------------------------------------------------*/
+
+static bool areaCoverageDefault()
+{
+	const char* value = getenv("RI_AREA_COVERAGE");
+	if(value && *value)
+		return atoi(value) != 0;
+	return RI_AREA_COVERAGE != 0;
+}
+
 /*-------------------------------------------------------------------*//*!
 * \brief	VGContext constructor.
 * \param	
@@ -94,11 +130,13 @@ VGContext::VGContext(VGContext* shareContext) :
 	m_fillPaintToUser(),
 	m_strokePaintToUser(),
 
-	m_fillPaint(VG_INVALID_HANDLE),
-	m_strokePaint(VG_INVALID_HANDLE),
+	m_fillPaint(NULL),
+	m_strokePaint(NULL),
 
     m_colorTransform(VG_FALSE),
 
+	m_areaCoverage(areaCoverageDefault()),
+
 	m_error(VG_NO_ERROR),
 
 	m_imageManager(NULL),
@@ -179,15 +217,15 @@ VGContext::~VGContext()
     setDefaultDrawable(NULL);
 
 	//destroy own images, paths and paints
-	while(Image* i = m_imageManager->getFirstResource(this))
+	while(VGImage i = m_imageManager->getFirstResource(this))
 		m_imageManager->removeResource(i);
-	while(Path* p = m_pathManager->getFirstResource(this))
+	while(VGPath p = m_pathManager->getFirstResource(this))
 		m_pathManager->removeResource(p);
-	while(Paint* t = m_paintManager->getFirstResource(this))
+	while(VGPaint t = m_paintManager->getFirstResource(this))
 		m_paintManager->removeResource(t);
-	while(Font* t = m_fontManager->getFirstResource(this))
+	while(VGFont t = m_fontManager->getFirstResource(this))
 		m_fontManager->removeResource(t);
-	while(Surface* t = m_maskLayerManager->getFirstResource(this))
+	while(VGMaskLayer t = m_maskLayerManager->getFirstResource(this))
 		m_maskLayerManager->removeResource(t);
 
 	//decrease the reference count of resource managers
@@ -234,7 +272,7 @@ void VGContext::setDefaultDrawable(Drawable* drawable)
 
 bool VGContext::isValidImage(VGImage image)
 {
-	return m_imageManager->isValid((Image*)image);
+	return m_imageManager->isValid(image);
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -247,7 +285,7 @@ bool VGContext::isValidImage(VGImage image)
 
 bool VGContext::isValidPath(VGPath path)
 {
-	return m_pathManager->isValid((Path*)path);
+	return m_pathManager->isValid(path);
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -260,7 +298,7 @@ bool VGContext::isValidPath(VGPath path)
 
 bool VGContext::isValidPaint(VGPaint paint)
 {
-	return m_paintManager->isValid((Paint*)paint);
+	return m_paintManager->isValid(paint);
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -273,7 +311,7 @@ bool VGContext::isValidPaint(VGPaint paint)
 
 bool VGContext::isValidFont(VGFont font)
 {
-	return m_fontManager->isValid((Font*)font);
+	return m_fontManager->isValid(font);
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -286,7 +324,7 @@ bool VGContext::isValidFont(VGFont font)
 
 bool VGContext::isValidMaskLayer(VGMaskLayer layer)
 {
-	return m_maskLayerManager->isValid((Surface*)layer);
+	return m_maskLayerManager->isValid(layer);
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -301,24 +339,24 @@ void VGContext::releasePaint(VGbitfield paintModes)
 	if(paintModes & VG_FILL_PATH)
 	{
 		//release previous paint
-		Paint* prev = (Paint*)m_fillPaint;
+		Paint* prev = m_fillPaint;
 		if(prev)
 		{
 			if(!prev->removeReference())
 				RI_DELETE(prev);
 		}
-		m_fillPaint = VG_INVALID_HANDLE;
+		m_fillPaint = NULL;
 	}
 	if(paintModes & VG_STROKE_PATH)
 	{
 		//release previous paint
-		Paint* prev = (Paint*)m_strokePaint;
+		Paint* prev = m_strokePaint;
 		if(prev)
 		{
 			if(!prev->removeReference())
 				RI_DELETE(prev);
 		}
-		m_strokePaint = VG_INVALID_HANDLE;
+		m_strokePaint = NULL;
 	}
 }
 
@@ -68,12 +68,20 @@ namespace OpenVGRI
 
 class VGContext;
 
+VGHandle newResourceHandle();
+
 /*-------------------------------------------------------------------*//*!
 * \brief	A list of resources (Images, Paths, or Paints) shared by a
 *			set of contexts.
 * \param	
 * \return	
-* \note		
+* \note		Handles are validated on every API call that takes one, so
+*			the resources are indexed by a hash table of their handles
+*			(open addressing with linear probing) that makes isValid,
+*			getResource, addResource and removeResource constant time on
+*			average. The handles are 32-bit ids rather than addresses so
+*			that they fit in a VGHandle on 64-bit platforms too. A second
+*			table indexes the same entries by resource for getHandle.
 *//*-------------------------------------------------------------------*/
 
 template <class Resource> class ResourceManager
@@ -81,7 +89,9 @@ template <class Resource> class ResourceManager
 public:
 	ResourceManager() :
 		m_referenceCount(0),
-		m_resources()
+		m_resources(),
+		m_table(),
+		m_resourceTable()
 	{
 	}
 
@@ -103,57 +113,82 @@ public:
 		return m_referenceCount;
 	}
 
-	void			addResource(Resource* resource, VGContext* context)
+	VGHandle		addResource(Resource* resource, VGContext* context)
 	{
+		RI_ASSERT(resource);
+		if((m_resources.size() + 1) * 2 > m_table.size())
+			rehash(RI_INT_MAX(m_table.size() * 2, 16));	//throws bad_alloc
+
 		Entry r;
+		do
+		{
+			r.handle = newResourceHandle();
+		} while(isValid(r.handle));	//the counter has wrapped around
 		r.resource = resource;
 		r.context = context;
 		m_resources.push_back(r);	//throws bad_alloc
+		m_table[findSlot(r.handle)] = m_resources.size() - 1;
+		m_resourceTable[findResourceSlot(resource)] = m_resources.size() - 1;
 		resource->addReference();
+		return r.handle;
 	}
 
-	void			removeResource(Resource* resource)
+	void			removeResource(VGHandle handle)
 	{
+		int slot = findSlot(handle);
+		int i = m_table[slot];
+		RI_ASSERT(i >= 0);
+
+		Resource* resource = m_resources[i].resource;
+		eraseSlot(m_table, slot);
+		eraseSlot(m_resourceTable, findResourceSlot(resource));
 		if(!resource->removeReference())
 			RI_DELETE(resource);
 
-		int i=0;
-		bool found = false;
-		for(;i<m_resources.size();i++)
+		//move the last entry into the hole
+		int last = m_resources.size() - 1;
+		if(i != last)
 		{
-			if(m_resources[i].resource == resource)
-			{
-				found = true;
-				break;
-			}
+			m_resources[i] = m_resources[last];
+			m_table[findSlot(m_resources[i].handle)] = i;
+			m_resourceTable[findResourceSlot(m_resources[i].resource)] = i;
 		}
-		RI_ASSERT(found);
+		m_resources.resize(last);
+	}
 
-		for(;i<m_resources.size()-1;i++)
-		{
-			m_resources[i] = m_resources[i+1];
-		}
-		m_resources.resize(m_resources.size()-1);
+	bool			isValid(VGHandle handle) const
+	{
+		return getResource(handle) != NULL;
 	}
 
-	bool			isValid(Resource* resource)
+	//returns NULL for an invalid handle
+	Resource*		getResource(VGHandle handle) const
 	{
-		for(int i=0;i<m_resources.size();i++)
-		{
-			if(m_resources[i].resource == resource)
-				return true;
-		}
-		return false;
+		if(handle == VG_INVALID_HANDLE || !m_table.size())
+			return NULL;
+		int i = m_table[findSlot(handle)];
+		return i >= 0 ? m_resources[i].resource : NULL;
 	}
 
-	Resource*		getFirstResource(VGContext* context)
+	//returns VG_INVALID_HANDLE if the resource has been removed
+	VGHandle		getHandle(const Resource* resource) const
 	{
-		for(int i=0;i<m_resources.size();i++)
+		if(!resource || !m_resourceTable.size())
+			return VG_INVALID_HANDLE;
+		int i = m_resourceTable[findResourceSlot(resource)];
+		return i >= 0 ? m_resources[i].handle : VG_INVALID_HANDLE;
+	}
+
+	VGHandle		getFirstResource(VGContext* context) const
+	{
+		//search from the end so that removing the resources of a context
+		//one by one doesn't rescan the entries already searched
+		for(int i=m_resources.size()-1;i>=0;i--)
 		{
 			if(m_resources[i].context == context)
-				return m_resources[i].resource;
+				return m_resources[i].handle;
 		}
-		return NULL;
+		return VG_INVALID_HANDLE;
 	}
 
 private:
@@ -162,12 +197,91 @@ private:
 
 	struct Entry
 	{
+		VGHandle	handle;
 		Resource*	resource;
 		VGContext*	context;
 	};
 
+	int				hashSlot(VGHandle handle) const
+	{
+		RIuint32 h = (RIuint32)handle * 0x9e3779b1u;
+		return (int)(h ^ (h >> 16)) & (m_table.size() - 1);
+	}
+
+	int				hashResourceSlot(const Resource* resource) const
+	{
+		RIuintptr p = (RIuintptr)resource;
+		RIuint32 h = (RIuint32)(p ^ (p >> 16 >> 16)) * 0x9e3779b1u;
+		return (int)(h ^ (h >> 16)) & (m_resourceTable.size() - 1);
+	}
+
+	//the slot entry i hashes to in table
+	int				homeSlot(const Array<int>& table, int i) const
+	{
+		return &table == &m_table ? hashSlot(m_resources[i].handle) : hashResourceSlot(m_resources[i].resource);
+	}
+
+	//returns the slot of the handle, or the empty slot it would go to
+	int				findSlot(VGHandle handle) const
+	{
+		RI_ASSERT(m_table.size());
+		int mask = m_table.size() - 1;
+		int slot = hashSlot(handle);
+		while(m_table[slot] >= 0 && m_resources[m_table[slot]].handle != handle)
+			slot = (slot + 1) & mask;
+		return slot;
+	}
+
+	//returns the slot of the resource in m_resourceTable, or the empty slot it would go to
+	int				findResourceSlot(const Resource* resource) const
+	{
+		RI_ASSERT(m_resourceTable.size());
+		int mask = m_resourceTable.size() - 1;
+		int slot = hashResourceSlot(resource);
+		while(m_resourceTable[slot] >= 0 && m_resources[m_resourceTable[slot]].resource != resource)
+			slot = (slot + 1) & mask;
+		return slot;
+	}
+
+	//empties the slot of m_table or m_resourceTable and moves back the entries probed past it
+	void			eraseSlot(Array<int>& table, int slot)
+	{
+		int mask = table.size() - 1;
+		int hole = slot;
+		for(int j=(hole + 1) & mask;table[j] >= 0;j=(j + 1) & mask)
+		{
+			int home = homeSlot(table, table[j]);
+			if(((j - home) & mask) >= ((j - hole) & mask))
+			{
+				table[hole] = table[j];
+				hole = j;
+			}
+		}
+		table[hole] = -1;
+	}
+
+	void			rehash(int tableSize)
+	{
+		RI_ASSERT(tableSize > 0 && !(tableSize & (tableSize - 1)));
+		Array<int> table;
+		Array<int> resourceTable;
+		table.resize(tableSize);	//throws bad_alloc
+		resourceTable.resize(tableSize);	//throws bad_alloc
+		for(int i=0;i<tableSize;i++)
+			table[i] = resourceTable[i] = -1;
+		m_table.swap(table);
+		m_resourceTable.swap(resourceTable);
+		for(int i=0;i<m_resources.size();i++)
+		{
+			m_table[findSlot(m_resources[i].handle)] = i;
+			m_resourceTable[findResourceSlot(m_resources[i].resource)] = i;
+		}
+	}
+
 	int				m_referenceCount;
 	Array<Entry>	m_resources;
+	Array<int>		m_table;			//index to m_resources by handle or -1, the size is a power of two
+	Array<int>		m_resourceTable;	//index to m_resources by resource or -1, the same size as m_table
 };
 
 /*-------------------------------------------------------------------*//*!
@@ -192,6 +306,13 @@ public:
 	bool			isValidFont(VGFont font);
 	bool			isValidMaskLayer(VGMaskLayer layer);
 
+	//return NULL for invalid handles
+	Image*			getImage(VGImage image) const				{ return m_imageManager->getResource(image); }
+	Path*			getPath(VGPath path) const					{ return m_pathManager->getResource(path); }
+	Paint*			getPaint(VGPaint paint) const				{ return m_paintManager->getResource(paint); }
+	Font*			getFont(VGFont font) const					{ return m_fontManager->getResource(font); }
+	Surface*		getMaskLayer(VGMaskLayer layer) const		{ return m_maskLayerManager->getResource(layer); }
+
 	void			releasePaint(VGbitfield paintModes);
 
 	void			setError(VGErrorCode error)		{ if(m_error == VG_NO_ERROR) m_error = error; }
@@ -247,13 +368,16 @@ public:
 	Matrix3x3						m_fillPaintToUser;
 	Matrix3x3						m_strokePaintToUser;
 
-	VGPaint							m_fillPaint;
-	VGPaint							m_strokePaint;
+	Paint*							m_fillPaint;
+	Paint*							m_strokePaint;
 
     VGboolean                       m_colorTransform;
     RIfloat                         m_colorTransformValues[8];
     RIfloat                         m_inputColorTransformValues[8];
 
+	// Fill coverage from pixel areas instead of samples, see RI_AREA_COVERAGE
+	bool							m_areaCoverage;
+
 	VGErrorCode						m_error;
 
 	ResourceManager<Image>*			m_imageManager;
@@ -117,6 +117,24 @@ RI_INLINE float	getFloatMax()
 #define RI_MAX_SAMPLES					32
 #define RI_NUM_TESSELLATED_SEGMENTS		256
 
+//set to 1 for contexts to compute the coverage of antialiased fills of single-sample surfaces
+//as the exact area of the pixel inside the path (a box filter of diameter 1) instead of
+//sampling the filter of the rendering quality. It costs the same for any number of samples,
+//but FASTER and BETTER fills then look the same and differ from the sampled reference output.
+//An RI_AREA_COVERAGE environment variable of 0 or 1, read when a context is created,
+//overrides this default.
+#ifndef RI_AREA_COVERAGE
+#	define RI_AREA_COVERAGE				0
+#endif
+
+//PixelPipe::pixelPipeSpan blends runs of pixels of 8888 surfaces four channels at a time
+//with SSE2 when the compiler targets it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define RI_SSE2						1
+#else
+#	define RI_SSE2						0
+#endif
+
 #define RI_DEBUG
 
 #ifdef RI_DEBUG
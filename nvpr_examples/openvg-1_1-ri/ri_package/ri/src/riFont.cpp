@@ -112,15 +112,15 @@ Font::Glyph* Font::newGlyph()
 void Font::clearGlyph(Glyph* g)
 {
     RI_ASSERT(g);
-	if(g->m_path != VG_INVALID_HANDLE)
+	if(g->m_path)
 	{
-		Path* p = (Path*)g->m_path;
+		Path* p = g->m_path;
 		if(!p->removeReference())
 			RI_DELETE(p);
 	}
-	if(g->m_image != VG_INVALID_HANDLE)
+	if(g->m_image)
 	{
-		Image* p = (Image*)g->m_image;
+		Image* p = g->m_image;
 		p->removeInUse();
 		if(!p->removeReference())
 			RI_DELETE(p);
@@ -136,7 +136,7 @@ void Font::clearGlyph(Glyph* g)
 * \note		
 *//*-------------------------------------------------------------------*/
 
-void Font::setGlyphToPath(unsigned int index, VGPath path, bool isHinted, const Vector2& origin, const Vector2& escapement)
+void Font::setGlyphToPath(unsigned int index, Path* path, bool isHinted, const Vector2& origin, const Vector2& escapement)
 {
     Glyph* g = findGlyph(index);
     if(g)
@@ -151,16 +151,13 @@ void Font::setGlyphToPath(unsigned int index, VGPath path, bool isHinted, const
     g->m_index = index;
     g->m_state = Glyph::GLYPH_PATH;
 	g->m_path = path;
-    g->m_image = VG_INVALID_HANDLE;
+    g->m_image = NULL;
 	g->m_isHinted = isHinted;
 	g->m_origin = origin;
 	g->m_escapement = escapement;
 
-    if(path != VG_INVALID_HANDLE)
-    {
-        Path* p = (Path*)path;
-        p->addReference();
-    }
+    if(path)
+        path->addReference();
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -170,7 +167,7 @@ void Font::setGlyphToPath(unsigned int index, VGPath path, bool isHinted, const
 * \note		
 *//*-------------------------------------------------------------------*/
 
-void Font::setGlyphToImage(unsigned int index, VGImage image, const Vector2& origin, const Vector2& escapement)
+void Font::setGlyphToImage(unsigned int index, Image* image, const Vector2& origin, const Vector2& escapement)
 {
     Glyph* g = findGlyph(index);
     if(g)
@@ -184,17 +181,16 @@ void Font::setGlyphToImage(unsigned int index, VGImage image, const Vector2& ori
 
     g->m_index = index;
     g->m_state = Glyph::GLYPH_IMAGE;
-	g->m_path = VG_INVALID_HANDLE;
+	g->m_path = NULL;
     g->m_image = image;
 	g->m_isHinted = false;
 	g->m_origin = origin;
 	g->m_escapement = escapement;
 
-    if(image != VG_INVALID_HANDLE)
+    if(image)
     {
-        Image* p = (Image*)image;
-        p->addReference();
-        p->addInUse();
+        image->addReference();
+        image->addInUse();
     }
 }
 
@@ -76,11 +76,11 @@ public:
             GLYPH_PATH              = 1,
             GLYPH_IMAGE             = 2
         };
-		Glyph()				{ m_state = GLYPH_UNINITIALIZED; m_path = m_image = VG_INVALID_HANDLE; m_isHinted = false; m_origin.set(0.0f, 0.0f); m_escapement.set(0.0f, 0.0f); }
+		Glyph()				{ m_state = GLYPH_UNINITIALIZED; m_path = NULL; m_image = NULL; m_isHinted = false; m_origin.set(0.0f, 0.0f); m_escapement.set(0.0f, 0.0f); }
         unsigned int m_index;
         State        m_state;
-		VGPath		 m_path;
-		VGImage		 m_image;
+		Path*		 m_path;
+		Image*		 m_image;
 		bool		 m_isHinted;
 		Vector2		 m_origin;
 		Vector2		 m_escapement;
@@ -93,8 +93,8 @@ public:
 	void			addReference()							{ m_referenceCount++; }
 	int				removeReference()						{ m_referenceCount--; RI_ASSERT(m_referenceCount >= 0); return m_referenceCount; }
 
-	void			setGlyphToPath(unsigned int index, VGPath path, bool isHinted, const Vector2& origin, const Vector2& escapement);    //throws bad_alloc
-	void			setGlyphToImage(unsigned int index, VGImage image, const Vector2& origin, const Vector2& escapement);    //throws bad_alloc
+	void			setGlyphToPath(unsigned int index, Path* path, bool isHinted, const Vector2& origin, const Vector2& escapement);    //throws bad_alloc
+	void			setGlyphToImage(unsigned int index, Image* image, const Vector2& origin, const Vector2& escapement);    //throws bad_alloc
     Glyph*          findGlyph(unsigned int index);
     void            clearGlyph(Glyph* g);
 private:
@@ -223,6 +223,7 @@ public:
 	void				removeInUse()						{ RI_ASSERT(m_inUse > 0); m_inUse--; }
 	int					isInUse() const						{ return m_inUse; }
 	RIuint8*			getData() const						{ return m_data; }
+	RIuint8*			getPixelAddress(int x, int y) const	{ RI_ASSERT(m_data && x >= 0 && x < m_width && y >= 0 && y < m_height && !(m_desc.bitsPerPixel & 7)); return m_data + (y + m_storageOffsetY) * m_stride + (x + m_storageOffsetX) * (m_desc.bitsPerPixel >> 3); }
 	void				addReference()						{ m_referenceCount++; }
 	int					removeReference()					{ m_referenceCount--; RI_ASSERT(m_referenceCount >= 0); return m_referenceCount; }
 	bool				overlaps(const Image* src) const;
@@ -305,6 +306,7 @@ public:
 
 	RI_INLINE Color		readSample(int x, int y, int sample) const                   { return m_image->readPixel(x*m_numSamples+sample, y); }
 	RI_INLINE void		writeSample(int x, int y, int sample, const Color& c)        { m_image->writePixel(x*m_numSamples+sample, y, c); }
+	RI_INLINE RIuint8*	getSampleAddress(int x, int y, int sample) const             { return m_image->getPixelAddress(x*m_numSamples+sample, y); }
 
 	RIfloat				readMaskCoverage(int x, int y) const;
 	void				writeMaskCoverage(int x, int y, RIfloat m);
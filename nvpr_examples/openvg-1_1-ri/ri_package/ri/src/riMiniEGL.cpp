@@ -1486,12 +1486,16 @@ EGLSurface eglCreatePbufferFromClientBuffer(EGLDisplay dpy, EGLenum buftype, EGL
 	EGL_GET_DISPLAY(dpy, EGL_NO_SURFACE);
 	EGL_IF_ERROR(!display, EGL_NOT_INITIALIZED, EGL_NO_SURFACE);
 	EGL_IF_ERROR(buftype != EGL_OPENVG_IMAGE, EGL_BAD_PARAMETER, EGL_NO_SURFACE);
-	EGL_IF_ERROR(!buffer, EGL_BAD_PARAMETER, EGL_NO_SURFACE);	//TODO should also check if buffer really is a valid VGImage object (needs VG context for that)
-    Image* image = (Image*)buffer;
+	//buffer is a VGImage handle of the OpenVG context current to the calling thread
+	RIEGLThread* thread = egl->getCurrentThread();
+	RIEGLContext* ctx = thread ? thread->getCurrentContext() : NULL;
+	VGContext* vgctx = ctx ? ctx->getVGContext() : NULL;
+    Image* image = vgctx ? vgctx->getImage((VGImage)(RIuintptr)buffer) : NULL;
+	EGL_IF_ERROR(!image, EGL_BAD_PARAMETER, EGL_NO_SURFACE);
 	EGL_IF_ERROR(image->isInUse(), EGL_BAD_ACCESS, EGL_NO_SURFACE);	//buffer is in use by OpenVG
 	EGL_IF_ERROR(!display->configExists(config), EGL_BAD_CONFIG, EGL_NO_SURFACE);
 	EGL_IF_ERROR(attrib_list && attrib_list[0] != EGL_NONE, EGL_BAD_ATTRIBUTE, EGL_NO_SURFACE);	//there are no valid attribs for OpenVG
-	const Color::Descriptor& bc = ((Image*)buffer)->getDescriptor();
+	const Color::Descriptor& bc = image->getDescriptor();
 	const Color::Descriptor& cc = display->getConfig(config).m_desc;
 	EGL_IF_ERROR(bc.redBits != cc.redBits || bc.greenBits != cc.greenBits || bc.blueBits != cc.blueBits ||
 				 bc.alphaBits != cc.alphaBits || bc.luminanceBits != cc.luminanceBits, EGL_BAD_MATCH, EGL_NO_SURFACE);
@@ -180,7 +180,18 @@ Path::Path(VGint format, VGPathDatatype datatype, RIfloat scale, RIfloat bias, i
 	m_userMinx(0.0f),
 	m_userMiny(0.0f),
 	m_userMaxx(0.0f),
-	m_userMaxy(0.0f)
+	m_userMaxy(0.0f),
+	m_tessellationValid(false),
+	m_strokeVertices(),
+	m_strokePolygonEnds(),
+	m_strokeValid(false),
+	m_strokeDashPattern(),
+	m_strokeDashPhase(0.0f),
+	m_strokeDashPhaseReset(false),
+	m_strokeWidth(0.0f),
+	m_strokeCapStyle(VG_CAP_BUTT),
+	m_strokeJoinStyle(VG_JOIN_MITER),
+	m_strokeMiterLimit(0.0f)
 {
 	RI_ASSERT(format == VG_PATH_FORMAT_STANDARD);
 	RI_ASSERT(datatype >= VG_PATH_DATATYPE_S_8 && datatype <= VG_PATH_DATATYPE_F);
@@ -331,6 +342,7 @@ void Path::clear(VGbitfield capabilities)
 	m_segments.clear();
 	m_data.clear();
 	m_capabilities = capabilities;
+	invalidateTessellation();
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -387,6 +399,7 @@ void Path::appendData(const RIuint8* segments, int numSegments, const RIuint8* d
 	//replace old arrays
 	m_segments.swap(newSegments);
 	m_data.swap(newData);
+	invalidateTessellation();
 
 	int c = 0;
 	for(int i=0;i<m_segments.size();i++)
@@ -438,6 +451,7 @@ void Path::append(const Path* srcPath)
 		//replace old arrays
 		m_segments.swap(newSegments);
 		m_data.swap(newData);
+		invalidateTessellation();
 	}
 }
 
@@ -461,6 +475,7 @@ void Path::modifyCoords(int startIndex, int numSegments, const RIuint8* data)
 		return;
 	int bytesPerCoordinate = getBytesPerCoordinate(m_datatype);
 	RIuint8* dst = &m_data[startCoord * bytesPerCoordinate];
+	invalidateTessellation();
 	if(m_datatype == VG_PATH_DATATYPE_F)
 	{
 		RIfloat32* d = (RIfloat32*)dst;
@@ -823,6 +838,7 @@ void Path::transform(const Path* srcPath, const Matrix3x3& matrix)
 	//replace old arrays
 	m_segments.swap(newSegments);
 	m_data.swap(newData);
+	invalidateTessellation();
 }
 
 /*-------------------------------------------------------------------*//*!
@@ -875,6 +891,7 @@ void Path::normalizeForInterpolation(const Path* srcPath)
 
 	m_segments.resize(srcPath->m_segments.size());	//throws bad_alloc
 	m_data.resize(numDstCoords * getBytesPerCoordinate(VG_PATH_DATATYPE_F));	//throws bad_alloc
+	invalidateTessellation();
 
 	int srcCoord = 0;
 	int dstCoord = 0;
@@ -1149,6 +1166,7 @@ bool Path::interpolate(const Path* startPath, const Path* endPath, RIfloat amoun
 	//replace old arrays
 	m_segments.swap(newSegments);
 	m_data.swap(newData);
+	invalidateTessellation();
 
 	return true;
 }
@@ -1195,20 +1213,17 @@ void Path::fill(const Matrix3x3& pathToSurface, Rasterizer& rasterizer)
 *			are interpolated linearly, while tangents are interpolated
 *			on a unit circle. Stroking is implemented so that overlapping
 *			geometry doesnt cancel itself when filled with nonzero rule.
-*			The resulting polygons are closed.
+*			The resulting polygons are closed and in path coordinates.
 * \param	
 * \return	
 * \note		
 *//*-------------------------------------------------------------------*/
 
-void Path::interpolateStroke(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const StrokeVertex& v0, const StrokeVertex& v1, RIfloat strokeWidth) const
+void Path::interpolateStroke(const StrokeVertex& v0, const StrokeVertex& v1, RIfloat strokeWidth)
 {
-	Vector2 pccw = affineTransform(pathToSurface, v0.ccw);
-	Vector2 pcw = affineTransform(pathToSurface, v0.cw);
-	Vector2 p = affineTransform(pathToSurface, v0.p);
-	Vector2 endccw = affineTransform(pathToSurface, v1.ccw);
-	Vector2 endcw = affineTransform(pathToSurface, v1.cw);
-	Vector2 endp = affineTransform(pathToSurface, v1.p);
+	Vector2 pccw = v0.ccw;
+	Vector2 pcw = v0.cw;
+	Vector2 p = v0.p;
 
 	const RIfloat tessellationAngle = 5.0f;
 
@@ -1222,18 +1237,18 @@ void Path::interpolateStroke(const Matrix3x3& pathToSurface, Rasterizer& rasteri
 		Vector2 tangent = circularLerp(v0.t, v1.t, t);
 		Vector2 normal = normalize(perpendicularCCW(tangent)) * strokeWidth * 0.5f;
 
-		Vector2 nccw = affineTransform(pathToSurface, position + normal);
-		Vector2 ncw = affineTransform(pathToSurface, position - normal);
-		Vector2 n = affineTransform(pathToSurface, position);
+		Vector2 nccw = position + normal;
+		Vector2 ncw = position - normal;
+		Vector2 n = position;
 
-        rasterizer.clear();
-		rasterizer.addEdge(p, pccw);	//throws bad_alloc
-		rasterizer.addEdge(pccw, nccw);	//throws bad_alloc
-		rasterizer.addEdge(nccw, n);	//throws bad_alloc
-		rasterizer.addEdge(n, ncw);     //throws bad_alloc
-		rasterizer.addEdge(ncw, pcw);	//throws bad_alloc
-		rasterizer.addEdge(pcw, p);	    //throws bad_alloc
-        rasterizer.fill();
+		int start = m_strokeVertices.size();
+		addStrokeVertex(p);		//throws bad_alloc
+		addStrokeVertex(pccw);	//throws bad_alloc
+		addStrokeVertex(nccw);	//throws bad_alloc
+		addStrokeVertex(n);		//throws bad_alloc
+		addStrokeVertex(ncw);	//throws bad_alloc
+		addStrokeVertex(pcw);	//throws bad_alloc
+		endStrokePolygon(start);	//throws bad_alloc
 
 		pccw = nccw;
 		pcw = ncw;
@@ -1241,30 +1256,27 @@ void Path::interpolateStroke(const Matrix3x3& pathToSurface, Rasterizer& rasteri
 	}
 
 	//connect the last segment to the end coordinates
-    rasterizer.clear();
-	rasterizer.addEdge(p, pccw);	    //throws bad_alloc
-	rasterizer.addEdge(pccw, endccw);	//throws bad_alloc
-	rasterizer.addEdge(endccw, endp);	//throws bad_alloc
-	rasterizer.addEdge(endp, endcw);	//throws bad_alloc
-	rasterizer.addEdge(endcw, pcw);     //throws bad_alloc
-	rasterizer.addEdge(pcw, p);         //throws bad_alloc
-    rasterizer.fill();
+	int start = m_strokeVertices.size();
+	addStrokeVertex(p);			//throws bad_alloc
+	addStrokeVertex(pccw);		//throws bad_alloc
+	addStrokeVertex(v1.ccw);	//throws bad_alloc
+	addStrokeVertex(v1.p);		//throws bad_alloc
+	addStrokeVertex(v1.cw);		//throws bad_alloc
+	addStrokeVertex(pcw);		//throws bad_alloc
+	endStrokePolygon(start);	//throws bad_alloc
 }
 
 /*-------------------------------------------------------------------*//*!
-* \brief	Generate edges for stroke caps. Resulting polygons are closed.
+* \brief	Generate the outline of a stroke cap in path coordinates.
+*			Resulting polygons are closed.
 * \param	
 * \return	
 * \note		
 *//*-------------------------------------------------------------------*/
 
-void Path::doCap(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const StrokeVertex& v, RIfloat strokeWidth, VGCapStyle capStyle) const
+void Path::doCap(const StrokeVertex& v, RIfloat strokeWidth, VGCapStyle capStyle)
 {
-	Vector2 ccwt = affineTransform(pathToSurface, v.ccw);
-	Vector2 cwt = affineTransform(pathToSurface, v.cw);
-	Vector2 p = affineTransform(pathToSurface, v.p);
-
-    rasterizer.clear();
+	int start = m_strokeVertices.size();
 	switch(capStyle)
 	{
 	case VG_CAP_BUTT:
@@ -1281,19 +1293,15 @@ void Path::doCap(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const S
 		RIfloat t = step;
 		Vector2 u0 = normalize(v.ccw - v.p);
 		Vector2 u1 = normalize(v.cw - v.p);
-		Vector2 prev = ccwt;
-		rasterizer.addEdge(p, ccwt);	//throws bad_alloc
+		addStrokeVertex(v.p);	//throws bad_alloc
+		addStrokeVertex(v.ccw);	//throws bad_alloc
 		for(int j=1;j<samples;j++)
 		{
 			Vector2 next = v.p + circularLerp(u0, u1, t, true) * strokeWidth * 0.5f;
-			next = affineTransform(pathToSurface, next);
-
-			rasterizer.addEdge(prev, next);	//throws bad_alloc
-			prev = next;
+			addStrokeVertex(next);	//throws bad_alloc
 			t += step;
 		}
-		rasterizer.addEdge(prev, cwt);	//throws bad_alloc
-		rasterizer.addEdge(cwt, p);     //throws bad_alloc
+		addStrokeVertex(v.cw);	//throws bad_alloc
 		break;
 	}
 
@@ -1302,66 +1310,57 @@ void Path::doCap(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const S
 		RI_ASSERT(capStyle == VG_CAP_SQUARE);
 		Vector2 t = v.t;
 		t.normalize();
-		Vector2 ccws = affineTransform(pathToSurface, v.ccw + t * strokeWidth * 0.5f);
-		Vector2 cws = affineTransform(pathToSurface, v.cw + t * strokeWidth * 0.5f);
-		rasterizer.addEdge(p, ccwt);	//throws bad_alloc
-		rasterizer.addEdge(ccwt, ccws);	//throws bad_alloc
-		rasterizer.addEdge(ccws, cws);	//throws bad_alloc
-		rasterizer.addEdge(cws, cwt);	//throws bad_alloc
-		rasterizer.addEdge(cwt, p);     //throws bad_alloc
+		addStrokeVertex(v.p);	//throws bad_alloc
+		addStrokeVertex(v.ccw);	//throws bad_alloc
+		addStrokeVertex(v.ccw + t * strokeWidth * 0.5f);	//throws bad_alloc
+		addStrokeVertex(v.cw + t * strokeWidth * 0.5f);	//throws bad_alloc
+		addStrokeVertex(v.cw);	//throws bad_alloc
 		break;
 	}
 	}
-    rasterizer.fill();
+	endStrokePolygon(start);	//throws bad_alloc
 }
 
 /*-------------------------------------------------------------------*//*!
-* \brief	Generate edges for stroke joins. Resulting polygons are closed.
+* \brief	Generate the outline of a stroke join in path coordinates.
+*			Resulting polygons are closed.
 * \param	
 * \return	
 * \note		
 *//*-------------------------------------------------------------------*/
 
-void Path::doJoin(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const StrokeVertex& v0, const StrokeVertex& v1, RIfloat strokeWidth, VGJoinStyle joinStyle, RIfloat miterLimit) const
+void Path::doJoin(const StrokeVertex& v0, const StrokeVertex& v1, RIfloat strokeWidth, VGJoinStyle joinStyle, RIfloat miterLimit)
 {
-	Vector2 ccw0t = affineTransform(pathToSurface, v0.ccw);
-	Vector2 cw0t = affineTransform(pathToSurface, v0.cw);
-	Vector2 m0t = affineTransform(pathToSurface, v0.p);
-	Vector2 ccw1t = affineTransform(pathToSurface, v1.ccw);
-	Vector2 cw1t = affineTransform(pathToSurface, v1.cw);
-	Vector2 m1t = affineTransform(pathToSurface, v1.p);
-
 	Vector2 tccw = v1.ccw - v0.ccw;
 	Vector2 s, e, m, st, et;
 	bool cw;
 
-    rasterizer.clear();
+	//the polygon goes from v0.p to the outer side of the join, around it from s to e,
+	//and back through v1.p
+	int start = m_strokeVertices.size();
+	addStrokeVertex(v0.p);	//throws bad_alloc
 
 	if( dot(tccw, v0.t) > 0.0f )
 	{	//draw ccw miter (draw from point 0 to 1)
-		s = ccw0t;
-		e = ccw1t;
+		s = v0.ccw;
+		e = v1.ccw;
 		st = v0.t;
 		et = v1.t;
 		m = v0.ccw;
 		cw = false;
-		rasterizer.addEdge(m0t, ccw0t);	//throws bad_alloc
-		rasterizer.addEdge(ccw1t, m1t);	//throws bad_alloc
-		rasterizer.addEdge(m1t, m0t);	//throws bad_alloc
 	}
 	else
 	{	//draw cw miter (draw from point 1 to 0)
-		s = cw1t;
-		e = cw0t;
+		s = v1.cw;
+		e = v0.cw;
 		st = v1.t;
 		et = v0.t;
 		m = v0.cw;
 		cw = true;
-		rasterizer.addEdge(cw0t, m0t);	//throws bad_alloc
-		rasterizer.addEdge(m1t, cw1t);	//throws bad_alloc
-		rasterizer.addEdge(m0t, m1t);	//throws bad_alloc
+		addStrokeVertex(v1.p);	//throws bad_alloc
 	}
 
+	addStrokeVertex(s);	//throws bad_alloc
 	switch(joinStyle)
 	{
 	case VG_JOIN_MITER:
@@ -1373,14 +1372,9 @@ void Path::doJoin(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const
 			RIfloat l = (RIfloat)cos(theta*0.5f) * miterLengthPerStrokeWidth * (strokeWidth * 0.5f);
 			l = RI_MIN(l, RI_FLOAT_MAX);	//force finite
 			Vector2 c = m + v0.t * l;
-			c = affineTransform(pathToSurface, c);
-			rasterizer.addEdge(s, c);	//throws bad_alloc
-			rasterizer.addEdge(c, e);	//throws bad_alloc
-		}
-		else
-		{	//bevel
-			rasterizer.addEdge(s, e);	//throws bad_alloc
+			addStrokeVertex(c);	//throws bad_alloc
 		}
+		//else bevel
 		break;
 	}
 
@@ -1388,7 +1382,6 @@ void Path::doJoin(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const
 	{
 		const RIfloat tessellationAngle = 5.0f;
 
-		Vector2 prev = s;
 		RIfloat angle = RI_RAD_TO_DEG((RIfloat)acos(RI_CLAMP(dot(st, et), -1.0f, 1.0f))) / tessellationAngle;
 		int samples = (int)ceil(angle);
 		if( samples )
@@ -1401,47 +1394,78 @@ void Path::doJoin(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const
 				Vector2 tangent = circularLerp(st, et, t, true);
 
 				Vector2 next = position + normalize(perpendicular(tangent, cw)) * strokeWidth * 0.5f;
-				next = affineTransform(pathToSurface, next);
-
-				rasterizer.addEdge(prev, next);	//throws bad_alloc
-				prev = next;
+				addStrokeVertex(next);	//throws bad_alloc
 				t += step;
 			}
 		}
-		rasterizer.addEdge(prev, e);	//throws bad_alloc
 		break;
 	}
 
 	default:
 		RI_ASSERT(joinStyle == VG_JOIN_BEVEL);
-		if(!cw)
-			rasterizer.addEdge(ccw0t, ccw1t);	//throws bad_alloc
-		else
-			rasterizer.addEdge(cw1t, cw0t);		//throws bad_alloc
 		break;
 	}
-    rasterizer.fill();
+	addStrokeVertex(e);	//throws bad_alloc
+
+	if(!cw)
+		addStrokeVertex(v1.p);	//throws bad_alloc
+	endStrokePolygon(start);	//throws bad_alloc
 }
 
 /*-------------------------------------------------------------------*//*!
-* \brief	Tessellate a path, apply stroking, dashing, caps and joins, and
-*			append resulting edges to a rasterizer.
+* \brief	Ends a polygon of the stroke outline started at index start of
+*			m_strokeVertices, unless it has no vertices.
 * \param	
 * \return	
-* \note		if runs out of memory, throws bad_alloc and leaves the path as it was
+* \note		
 *//*-------------------------------------------------------------------*/
 
-void Path::stroke(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const Array<RIfloat>& dashPattern, RIfloat dashPhase, bool dashPhaseReset, RIfloat strokeWidth, VGCapStyle capStyle, VGJoinStyle joinStyle, RIfloat miterLimit)
+void Path::endStrokePolygon(int start)
 {
-	RI_ASSERT(pathToSurface.isAffine());
-	RI_ASSERT(m_referenceCount > 0);
-	RI_ASSERT(strokeWidth >= 0.0f);
-	RI_ASSERT(miterLimit >= 1.0f);
+	if(m_strokeVertices.size() > start)
+		m_strokePolygonEnds.push_back(m_strokeVertices.size());	//throws bad_alloc
+}
 
-	tessellate(pathToSurface, strokeWidth);	//throws bad_alloc
+/*-------------------------------------------------------------------*//*!
+* \brief	Returns true if the stroke outline was made for the given stroke
+*			style.
+* \param	
+* \return	
+* \note		
+*//*-------------------------------------------------------------------*/
 
-	if(!m_vertices.size())
-		return;
+bool Path::isStrokeValid(const Array<RIfloat>& dashPattern, RIfloat dashPhase, bool dashPhaseReset, RIfloat strokeWidth, VGCapStyle capStyle, VGJoinStyle joinStyle, RIfloat miterLimit) const
+{
+	if(!m_strokeValid || !m_tessellationValid)
+		return false;
+	if(strokeWidth != m_strokeWidth || capStyle != m_strokeCapStyle || joinStyle != m_strokeJoinStyle || miterLimit != m_strokeMiterLimit)
+		return false;
+	if(dashPattern.size() != m_strokeDashPattern.size())
+		return false;
+	for(int i=0;i<dashPattern.size();i++)
+	{
+		if(dashPattern[i] != m_strokeDashPattern[i])
+			return false;
+	}
+	if(dashPattern.size() && (dashPhase != m_strokeDashPhase || dashPhaseReset != m_strokeDashPhaseReset))
+		return false;
+	return true;
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief	Apply stroking, dashing, caps and joins to the tessellation, and
+*			store the resulting outline for the stroke style.
+* \param	
+* \return	
+* \note		if runs out of memory, throws bad_alloc and leaves no outline
+*//*-------------------------------------------------------------------*/
+
+void Path::makeStroke(const Array<RIfloat>& dashPattern, RIfloat dashPhase, bool dashPhaseReset, RIfloat strokeWidth, VGCapStyle capStyle, VGJoinStyle joinStyle, RIfloat miterLimit)
+{
+	RI_ASSERT(m_tessellationValid);
+	m_strokeValid = false;
+	m_strokeVertices.clear();
+	m_strokePolygonEnds.clear();
 
 	bool dashing = true;
 	int dashPatternSize = dashPattern.size();
@@ -1519,21 +1543,21 @@ void Path::stroke(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const
 					if( v.flags & IMPLICIT_CLOSE_SUBPATH )
 					{	//do caps for the start and end of the current subpath
 						if( v0.inDash )
-							doCap(pathToSurface, rasterizer, v0, strokeWidth, capStyle);	//end cap	//throws bad_alloc
+							doCap(v0, strokeWidth, capStyle);	//end cap	//throws bad_alloc
 						if( vs.inDash )
 						{
 							StrokeVertex vi = vs;
 							vi.t = -vi.t;
 							RI_SWAP(vi.ccw.x, vi.cw.x);
 							RI_SWAP(vi.ccw.y, vi.cw.y);
-							doCap(pathToSurface, rasterizer, vi, strokeWidth, capStyle);	//start cap	//throws bad_alloc
+							doCap(vi, strokeWidth, capStyle);	//start cap	//throws bad_alloc
 						}
 					}
 					else
 					{	//join two segments
 						RI_ASSERT(v0.inDash == v1.inDash);
 						if( v0.inDash )
-							doJoin(pathToSurface, rasterizer, v0, v1, strokeWidth, joinStyle, miterLimit);	//throws bad_alloc
+							doJoin(v0, v1, strokeWidth, joinStyle, miterLimit);	//throws bad_alloc
 					}
 				}
 			}
@@ -1572,10 +1596,10 @@ void Path::stroke(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const
 									vi.t = -vi.t;
 									RI_SWAP(vi.ccw.x, vi.cw.x);
 									RI_SWAP(vi.ccw.y, vi.cw.y);
-									doCap(pathToSurface, rasterizer, vi, strokeWidth, capStyle);	//throws bad_alloc
+									doCap(vi, strokeWidth, capStyle);	//throws bad_alloc
 								}
-								interpolateStroke(pathToSurface, rasterizer, prevDashVertex, nextDashVertex, strokeWidth);	//throws bad_alloc
-								doCap(pathToSurface, rasterizer, nextDashVertex, strokeWidth, capStyle);	//end cap	//throws bad_alloc
+								interpolateStroke(prevDashVertex, nextDashVertex, strokeWidth);	//throws bad_alloc
+								doCap(nextDashVertex, strokeWidth, capStyle);	//end cap	//throws bad_alloc
 							}
 							prevDashVertex = nextDashVertex;
 
@@ -1602,40 +1626,103 @@ void Path::stroke(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const
 								vi.t = -vi.t;
 								RI_SWAP(vi.ccw.x, vi.cw.x);
 								RI_SWAP(vi.ccw.y, vi.cw.y);
-								doCap(pathToSurface, rasterizer, vi, strokeWidth, capStyle);	//throws bad_alloc
+								doCap(vi, strokeWidth, capStyle);	//throws bad_alloc
 							}
-							interpolateStroke(pathToSurface, rasterizer, prevDashVertex, v1, strokeWidth);	//throws bad_alloc
+							interpolateStroke(prevDashVertex, v1, strokeWidth);	//throws bad_alloc
 							//no cap, leave path open
 						}
 
 						v1.inDash = inDash;	//update inDash status of the segment end point
 					}
 					else	//no dashing, just interpolate segment end points
-						interpolateStroke(pathToSurface, rasterizer, v0, v1, strokeWidth);	//throws bad_alloc
+						interpolateStroke(v0, v1, strokeWidth);	//throws bad_alloc
 				}
 			}
 
 			if((v.flags & END_SEGMENT) && (v.flags & CLOSE_SUBPATH))
 			{	//join start and end of the current subpath
 				if( v1.inDash && vs.inDash )
-					doJoin(pathToSurface, rasterizer, v1, vs, strokeWidth, joinStyle, miterLimit);	//throws bad_alloc
+					doJoin(v1, vs, strokeWidth, joinStyle, miterLimit);	//throws bad_alloc
 				else
 				{	//both start and end are not in dash, cap them
 					if( v1.inDash )
-						doCap(pathToSurface, rasterizer, v1, strokeWidth, capStyle);	//end cap	//throws bad_alloc
+						doCap(v1, strokeWidth, capStyle);	//end cap	//throws bad_alloc
 					if( vs.inDash )
 					{
 						StrokeVertex vi = vs;
 						vi.t = -vi.t;
 						RI_SWAP(vi.ccw.x, vi.cw.x);
 						RI_SWAP(vi.ccw.y, vi.cw.y);
-						doCap(pathToSurface, rasterizer, vi, strokeWidth, capStyle);	//start cap	//throws bad_alloc
+						doCap(vi, strokeWidth, capStyle);	//start cap	//throws bad_alloc
 					}
 				}
 			}
 
 			v0 = v1;
 		}
+
+		m_strokeDashPattern.resize(dashPattern.size());	//throws bad_alloc
+		for(int i=0;i<dashPattern.size();i++)
+			m_strokeDashPattern[i] = dashPattern[i];
+	}
+	catch(std::bad_alloc)
+	{
+		m_strokeVertices.clear();	//remove the unfinished outline
+		m_strokePolygonEnds.clear();
+		throw;
+	}
+	m_strokeDashPhase = dashPhase;
+	m_strokeDashPhaseReset = dashPhaseReset;
+	m_strokeWidth = strokeWidth;
+	m_strokeCapStyle = capStyle;
+	m_strokeJoinStyle = joinStyle;
+	m_strokeMiterLimit = miterLimit;
+	m_strokeValid = true;
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief	Tessellate a path, apply stroking, dashing, caps and joins, and
+*			fill the resulting polygons with a rasterizer one by one.
+* \param	
+* \return	
+* \note		if runs out of memory, throws bad_alloc and leaves the path as it was.
+*			The outline is made once for a stroke style and reused for
+*			any pathToSurface until the path or the stroke style changes.
+*//*-------------------------------------------------------------------*/
+
+void Path::stroke(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const Array<RIfloat>& dashPattern, RIfloat dashPhase, bool dashPhaseReset, RIfloat strokeWidth, VGCapStyle capStyle, VGJoinStyle joinStyle, RIfloat miterLimit)
+{
+	RI_ASSERT(pathToSurface.isAffine());
+	RI_ASSERT(m_referenceCount > 0);
+	RI_ASSERT(strokeWidth >= 0.0f);
+	RI_ASSERT(miterLimit >= 1.0f);
+
+	tessellate(pathToSurface, strokeWidth);	//throws bad_alloc
+
+	if(!m_vertices.size())
+		return;
+
+	if(!isStrokeValid(dashPattern, dashPhase, dashPhaseReset, strokeWidth, capStyle, joinStyle, miterLimit))
+		makeStroke(dashPattern, dashPhase, dashPhaseReset, strokeWidth, capStyle, joinStyle, miterLimit);	//throws bad_alloc
+
+	try
+	{
+		int start = 0;
+		for(int i=0;i<m_strokePolygonEnds.size();i++)
+		{
+			int end = m_strokePolygonEnds[i];
+			RI_ASSERT(end > start);
+			rasterizer.clear();
+			Vector2 p0 = affineTransform(pathToSurface, m_strokeVertices[end-1]);
+			for(int j=start;j<end;j++)
+			{
+				Vector2 p1 = affineTransform(pathToSurface, m_strokeVertices[j]);
+				rasterizer.addEdge(p0, p1);	//throws bad_alloc
+				p0 = p1;
+			}
+			rasterizer.fill();	//throws bad_alloc
+			start = end;
+		}
 	}
 	catch(std::bad_alloc)
 	{
@@ -2276,10 +2363,16 @@ bool Path::addArcTo(const Matrix3x3& pathToSurface, const Vector2& p0, RIfloat r
 *			internal vertices (possibly zero), and an end vertex. The start
 *			and end of segments and subpaths have been flagged, as well as
 *			implicit and explicit close subpath segments.
+*			Curves are tessellated in path coordinates into a fixed number
+*			of segments, so the result doesn't depend on pathToSurface or
+*			strokeWidth, and is kept until the path changes.
 *//*-------------------------------------------------------------------*/
 
 void Path::tessellate(const Matrix3x3& pathToSurface, float strokeWidth)
 {
+	if(m_tessellationValid)
+		return;
+
 	m_vertices.clear();
 
 	m_userMinx = RI_FLOAT_MAX;
@@ -2570,6 +2663,7 @@ void Path::tessellate(const Matrix3x3& pathToSurface, float strokeWidth)
 		m_vertices.clear();
 		throw;
 	}
+	m_tessellationValid = true;
 }
 
 //==============================================================================================
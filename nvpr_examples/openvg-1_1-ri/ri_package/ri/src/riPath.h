@@ -58,7 +58,9 @@ namespace OpenVGRI
 * \brief	Storage and operations for VGPath.
 * \param	
 * \return	
-* \note		
+* \note		The tessellation, and the stroke outline for the last stroke
+*			style, are kept for drawing the path again until its segments
+*			or data change.
 *//*-------------------------------------------------------------------*/
 
 class Path
@@ -147,12 +149,17 @@ private:
 	bool				addArcTo(const Matrix3x3& pathToSurface, const Vector2& p0, RIfloat rh, RIfloat rv, RIfloat rot, const Vector2& p1, const Vector2& p1r, VGPathSegment segment, bool subpathHasGeometry, float strokeWidth);	//throws bad_alloc
 
 	void				tessellate(const Matrix3x3& pathToSurface, float strokeWidth);	//throws bad_alloc
+	void				invalidateTessellation()					{ m_tessellationValid = false; m_strokeValid = false; }
 
 	void				normalizeForInterpolation(const Path* srcPath);	//throws bad_alloc
 
-	void				interpolateStroke(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const StrokeVertex& v0, const StrokeVertex& v1, RIfloat strokeWidth) const;	//throws bad_alloc
-	void				doCap(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const StrokeVertex& v, RIfloat strokeWidth, VGCapStyle capStyle) const;	//throws bad_alloc
-	void				doJoin(const Matrix3x3& pathToSurface, Rasterizer& rasterizer, const StrokeVertex& v0, const StrokeVertex& v1, RIfloat strokeWidth, VGJoinStyle joinStyle, RIfloat miterLimit) const;	//throws bad_alloc
+	bool				isStrokeValid(const Array<RIfloat>& dashPattern, RIfloat dashPhase, bool dashPhaseReset, RIfloat strokeWidth, VGCapStyle capStyle, VGJoinStyle joinStyle, RIfloat miterLimit) const;
+	void				makeStroke(const Array<RIfloat>& dashPattern, RIfloat dashPhase, bool dashPhaseReset, RIfloat strokeWidth, VGCapStyle capStyle, VGJoinStyle joinStyle, RIfloat miterLimit);	//throws bad_alloc
+	void				addStrokeVertex(const Vector2& p)			{ m_strokeVertices.push_back(p); }	//throws bad_alloc
+	void				endStrokePolygon(int start);	//throws bad_alloc
+	void				interpolateStroke(const StrokeVertex& v0, const StrokeVertex& v1, RIfloat strokeWidth);	//throws bad_alloc
+	void				doCap(const StrokeVertex& v, RIfloat strokeWidth, VGCapStyle capStyle);	//throws bad_alloc
+	void				doJoin(const StrokeVertex& v0, const StrokeVertex& v1, RIfloat strokeWidth, VGJoinStyle joinStyle, RIfloat miterLimit);	//throws bad_alloc
 
 	//input data
 	VGint				m_format;
@@ -177,6 +184,19 @@ private:
 	RIfloat				m_userMiny;
 	RIfloat				m_userMaxx;
 	RIfloat				m_userMaxy;
+	bool				m_tessellationValid;	//the data above is for the current segments and data
+
+	//stroke outline produced from the tessellation for the stroke style below
+	Array<Vector2>		m_strokeVertices;		//closed polygons in path coordinates, one after another
+	Array<int>			m_strokePolygonEnds;	//end of each polygon in m_strokeVertices
+	bool				m_strokeValid;
+	Array<RIfloat>		m_strokeDashPattern;
+	RIfloat				m_strokeDashPhase;
+	bool				m_strokeDashPhaseReset;
+	RIfloat				m_strokeWidth;
+	VGCapStyle			m_strokeCapStyle;
+	VGJoinStyle			m_strokeJoinStyle;
+	RIfloat				m_strokeMiterLimit;
 };
 
 //==============================================================================================
@@ -32,6 +32,10 @@
 
 #include "riPixelPipe.h"
 
+#if RI_SSE2
+#include <emmintrin.h>
+#endif
+
 //==============================================================================================
 
 namespace OpenVGRI
@@ -682,22 +686,17 @@ void PixelPipe::colorTransform(Color& c) const
 }
 
 /*-------------------------------------------------------------------*//*!
-* \brief    Applies paint, image drawing, masking and blending at pixel (x,y).
-* \param    
+* \brief    Evaluates the paint and the image at pixel (x,y).
+* \param    s           Returns the color in dstFormat.
+* \param    ar, ag, ab  Return the per channel alphas.
 * \return   
 * \note
 *//*-------------------------------------------------------------------*/
 
-void PixelPipe::pixelPipe(int x, int y, RIfloat coverage, unsigned int sampleMask) const
+void PixelPipe::shade(Color& s, RIfloat& ar, RIfloat& ag, RIfloat& ab, int x, int y, Color::InternalFormat dstFormat) const
 {
-    RI_ASSERT(m_drawable);
-    RI_ASSERT(sampleMask);
-    RI_ASSERT(coverage > 0.0f);
-    Color::InternalFormat dstFormat = (Color::InternalFormat)(m_drawable->getDescriptor().internalFormat | Color::PREMULTIPLIED);
-
     //evaluate paint
     RI_ASSERT(m_paint);
-    Color s;
     switch(m_paint->m_paintType)
     {
     case VG_PAINT_TYPE_COLOR:
@@ -746,7 +745,7 @@ void PixelPipe::pixelPipe(int x, int y, RIfloat coverage, unsigned int sampleMas
     //image multiply => transform paint*image color
     //image stencil => transform paint color
 
-    RIfloat ar = 0.0f, ag = 0.0f, ab = 0.0f;
+    ar = ag = ab = 0.0f;
     if(m_image)
     {
         Color im = m_image->resample(x+0.5f, y+0.5f, m_surfaceToImageMatrix, m_imageQuality, VG_TILE_PAD, Color(0,0,0,0,m_image->getDescriptor().internalFormat));
@@ -823,7 +822,17 @@ void PixelPipe::pixelPipe(int x, int y, RIfloat coverage, unsigned int sampleMas
     }
     RI_ASSERT(s.getInternalFormat() == Color::lRGBA_PRE || s.getInternalFormat() == Color::sRGBA_PRE || s.getInternalFormat() == Color::lLA_PRE || s.getInternalFormat() == Color::sLA_PRE);
     s.assertConsistency();
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief    Applies masking and blending of color s at pixel (x,y).
+* \param    
+* \return   
+* \note
+*//*-------------------------------------------------------------------*/
 
+void PixelPipe::blendPixel(int x, int y, RIfloat coverage, unsigned int sampleMask, const Color& s, RIfloat ar, RIfloat ag, RIfloat ab, Color::InternalFormat dstFormat) const
+{
     Surface* colorBuffer = m_drawable->getColorBuffer();
     Surface* maskBuffer = m_drawable->getMaskBuffer();
     RI_ASSERT(colorBuffer);
@@ -888,6 +897,225 @@ void PixelPipe::pixelPipe(int x, int y, RIfloat coverage, unsigned int sampleMas
     }
 }
 
+/*-------------------------------------------------------------------*//*!
+* \brief    Applies paint, image drawing, masking and blending at pixel (x,y).
+* \param    
+* \return   
+* \note
+*//*-------------------------------------------------------------------*/
+
+void PixelPipe::pixelPipe(int x, int y, RIfloat coverage, unsigned int sampleMask) const
+{
+    RI_ASSERT(m_drawable);
+    RI_ASSERT(sampleMask);
+    RI_ASSERT(coverage > 0.0f);
+    Color::InternalFormat dstFormat = (Color::InternalFormat)(m_drawable->getDescriptor().internalFormat | Color::PREMULTIPLIED);
+
+    Color s;
+    RIfloat ar, ag, ab;
+    shade(s, ar, ag, ab, x, y, dstFormat);
+    blendPixel(x, y, coverage, sampleMask, s, ar, ag, ab, dstFormat);
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief    Blends a run of premultiplied source colors with VG_BLEND_SRC
+*           or VG_BLEND_SRC_OVER at full coverage into an 8888 surface.
+* \param    dst         The first pixel of the run.
+* \param    src         Four components per pixel in the order of the bytes
+*                       of a pixel (component i is stored at bits 8i-8i+7),
+*                       converted to the color space of the surface.
+* \param    srcStride   4, or 0 to blend the same color into every pixel.
+* \return   
+* \note     Computes the same as blendPixel except for skipping the round
+*           trip through linear color space for antialiasing, which at
+*           full coverage changes nothing but rounding.
+*//*-------------------------------------------------------------------*/
+
+void PixelPipe::blendSpan8888(RIuint32* dst, const RIfloat* src, int srcStride, int len, const Color::Descriptor& desc) const
+{
+    RI_ASSERT(dst && src && len > 0);
+    RI_ASSERT(desc.bitsPerPixel == 32 && desc.redBits == 8 && desc.greenBits == 8 && desc.blueBits == 8 && desc.alphaBits == 8);
+    RI_ASSERT(m_blendMode == VG_BLEND_SRC || m_blendMode == VG_BLEND_SRC_OVER);
+    const int alphaShift = desc.alphaShift;
+    const int alphaLane = alphaShift >> 3;
+    const bool srcOver = m_blendMode == VG_BLEND_SRC_OVER;
+    const bool premultiplied = desc.isPremultiplied();
+
+#if RI_SSE2
+    RIfloat laneMask[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    laneMask[alphaLane] = 1.0f;
+    const __m128 alphaOne = _mm_loadu_ps(laneMask);                         //1 in the alpha lane
+    const __m128 colorMask = _mm_cmpeq_ps(alphaOne, _mm_setzero_ps());     //all bits set in the color lanes
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 maxc = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128i zero = _mm_setzero_si128();
+
+    for(int i=0;i<len;i++,src+=srcStride)
+    {
+        __m128 r = _mm_loadu_ps(src);
+        if(srcOver)
+        {
+            //read destination color
+            unsigned int p = (unsigned int)dst[i];
+            __m128i pi = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p), zero), zero);
+            __m128 d = _mm_div_ps(_mm_cvtepi32_ps(pi), maxc);
+            __m128 da = _mm_set1_ps((RIfloat)((p >> alphaShift) & 0xff) / 255.0f);
+            if(premultiplied)
+                d = _mm_min_ps(d, da);  //clamp premultiplied color to alpha to enforce consistency
+            else
+                d = _mm_mul_ps(d, _mm_or_ps(_mm_and_ps(colorMask, da), alphaOne));
+
+            //blend
+            __m128 sa = _mm_set1_ps(src[alphaLane]);
+            r = _mm_add_ps(r, _mm_mul_ps(d, _mm_sub_ps(one, sa)));
+        }
+        if(!premultiplied)
+        {
+            RIfloat rc[4];
+            _mm_storeu_ps(rc, r);
+            RIfloat a = rc[alphaLane];
+            __m128 ooa = _mm_set1_ps((a != 0.0f) ? 1.0f / a : (RIfloat)0.0f);
+            r = _mm_mul_ps(r, _mm_or_ps(_mm_and_ps(colorMask, ooa), alphaOne));
+        }
+
+        //write result to the destination surface
+        __m128i ri = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, maxc), half));
+        ri = _mm_packs_epi32(ri, ri);
+        dst[i] = (RIuint32)_mm_cvtsi128_si32(_mm_packus_epi16(ri, ri));
+    }
+#else
+    for(int i=0;i<len;i++,src+=srcStride)
+    {
+        RIfloat r[4] = { src[0], src[1], src[2], src[3] };
+        if(srcOver)
+        {
+            unsigned int p = (unsigned int)dst[i];
+            RIfloat da = (RIfloat)((p >> alphaShift) & 0xff) / 255.0f;
+            RIfloat oosa = 1.0f - src[alphaLane];
+            for(int k=0;k<4;k++)
+            {
+                RIfloat d = (RIfloat)((p >> (8*k)) & 0xff) / 255.0f;
+                if(k != alphaLane)
+                    d = premultiplied ? RI_MIN(d, da) : d * da;
+                r[k] += d * oosa;
+            }
+        }
+        RIfloat ooa = 1.0f;
+        if(!premultiplied)
+            ooa = (r[alphaLane] != 0.0f) ? 1.0f / r[alphaLane] : (RIfloat)0.0f;
+        unsigned int p = 0;
+        for(int k=0;k<4;k++)
+        {
+            RIfloat c = (k != alphaLane) ? r[k] * ooa : r[k];
+            p |= (unsigned int)RI_INT_MIN(RI_INT_MAX((int)floor(c * 255.0f + 0.5f), 0), 255) << (8*k);
+        }
+        dst[i] = (RIuint32)p;
+    }
+#endif
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief    Applies paint, image drawing, masking and blending to the len
+*           pixels starting from (x,y), which all have the same coverage
+*           and sample mask.
+* \param    
+* \return   
+* \note     Paint that is the same for every pixel is evaluated once per
+*           run. Fully covered runs of a color or a linear gradient blended
+*           with VG_BLEND_SRC or VG_BLEND_SRC_OVER into an 8888 surface
+*           without masking are written directly to its memory, the
+*           gradient only into a premultiplied format. Everything else
+*           goes through blendPixel or pixelPipe.
+*//*-------------------------------------------------------------------*/
+
+void PixelPipe::pixelPipeSpan(int x, int y, int len, RIfloat coverage, unsigned int sampleMask) const
+{
+    RI_ASSERT(m_drawable);
+    RI_ASSERT(m_paint);
+    RI_ASSERT(sampleMask);
+    RI_ASSERT(coverage > 0.0f);
+    RI_ASSERT(len > 0);
+    Color::InternalFormat dstFormat = (Color::InternalFormat)(m_drawable->getDescriptor().internalFormat | Color::PREMULTIPLIED);
+
+    Surface* colorBuffer = m_drawable->getColorBuffer();
+    Surface* maskBuffer = m_drawable->getMaskBuffer();
+    RI_ASSERT(colorBuffer);
+    const Color::Descriptor& desc = colorBuffer->getDescriptor();
+
+    bool constantPaint = !m_image && (m_paint->m_paintType == VG_PAINT_TYPE_COLOR || (m_paint->m_paintType == VG_PAINT_TYPE_PATTERN && !m_paint->m_pattern));
+    bool direct = coverage == 1.0f && m_drawable->getNumSamples() == 1 && !(m_masking && maskBuffer) && !m_image &&
+                  (m_blendMode == VG_BLEND_SRC || m_blendMode == VG_BLEND_SRC_OVER) &&
+                  desc.bitsPerPixel == 32 && desc.redBits == 8 && desc.greenBits == 8 && desc.blueBits == 8 && desc.alphaBits == 8;
+
+    if(direct && constantPaint)
+    {
+        Color s;
+        RIfloat ar, ag, ab;
+        shade(s, ar, ag, ab, x, y, dstFormat);
+        RIuint32* dst = (RIuint32*)colorBuffer->getSampleAddress(x, y, 0);
+        if(m_blendMode == VG_BLEND_SRC || s.a == 1.0f)
+        {   //the result doesn't depend on the destination: write the color blendPixel would
+            Color::InternalFormat aaFormat = (dstFormat & Color::LUMINANCE) ? Color::lLA_PRE : Color::lRGBA_PRE;
+            Color r = s;
+            r.convert(aaFormat);
+            r.convert(desc.internalFormat);
+            RIuint32 p = (RIuint32)r.pack(desc);
+            int i = 0;
+#if RI_SSE2
+            __m128i p4 = _mm_set1_epi32((int)p);
+            for(;i+4<=len;i+=4)
+                _mm_storeu_si128((__m128i*)(dst + i), p4);
+#endif
+            for(;i<len;i++)
+                dst[i] = p;
+        }
+        else
+        {
+            RIfloat c[4];
+            c[desc.redShift >> 3] = s.r;
+            c[desc.greenShift >> 3] = s.g;
+            c[desc.blueShift >> 3] = s.b;
+            c[desc.alphaShift >> 3] = s.a;
+            blendSpan8888(dst, c, 0, len, desc);
+        }
+    }
+    else if(direct && m_paint->m_paintType == VG_PAINT_TYPE_LINEAR_GRADIENT && desc.isPremultiplied())
+    {
+        RIuint32* dst = (RIuint32*)colorBuffer->getSampleAddress(x, y, 0);
+        const int maxRun = 64;
+        RIfloat c[4*maxRun];
+        for(int i=0;i<len;i+=maxRun)
+        {
+            int n = RI_INT_MIN(maxRun, len - i);
+            for(int k=0;k<n;k++)
+            {
+                Color s;
+                RIfloat ar, ag, ab;
+                shade(s, ar, ag, ab, x + i + k, y, dstFormat);
+                c[4*k + (desc.redShift >> 3)] = s.r;
+                c[4*k + (desc.greenShift >> 3)] = s.g;
+                c[4*k + (desc.blueShift >> 3)] = s.b;
+                c[4*k + (desc.alphaShift >> 3)] = s.a;
+            }
+            blendSpan8888(dst + i, c, 4, n, desc);
+        }
+    }
+    else if(constantPaint)
+    {
+        Color s;
+        RIfloat ar, ag, ab;
+        shade(s, ar, ag, ab, x, y, dstFormat);
+        for(int i=0;i<len;i++)
+            blendPixel(x + i, y, coverage, sampleMask, s, ar, ag, ab, dstFormat);
+    }
+    else
+    {
+        for(int i=0;i<len;i++)
+            pixelPipe(x + i, y, coverage, sampleMask);
+    }
+}
+
 //=======================================================================
     
 }   //namespace OpenVGRI
@@ -108,6 +108,7 @@ public:
 	~PixelPipe();
 
 	void	pixelPipe(int x, int y, RIfloat coverage, unsigned int sampleMask) const;	//rasterizer calls this function for each pixel
+	void	pixelPipeSpan(int x, int y, int len, RIfloat coverage, unsigned int sampleMask) const;	//or this for a run of pixels with the same coverage
 
 	void	setDrawable(Drawable* drawable);
 	void	setBlendMode(VGBlendMode blendMode);
@@ -127,6 +128,9 @@ private:
 	Color	colorRamp(RIfloat gradient, RIfloat rho) const;
 	Color	blend(const Color& s, RIfloat ar, RIfloat ag, RIfloat ab, const Color& d, VGBlendMode blendMode) const;
     void    colorTransform(Color& c) const;
+	void	shade(Color& s, RIfloat& ar, RIfloat& ag, RIfloat& ab, int x, int y, Color::InternalFormat dstFormat) const;
+	void	blendPixel(int x, int y, RIfloat coverage, unsigned int sampleMask, const Color& s, RIfloat ar, RIfloat ag, RIfloat ab, Color::InternalFormat dstFormat) const;
+	void	blendSpan8888(RIuint32* dst, const RIfloat* src, int srcStride, int len, const Color::Descriptor& desc) const;
 
 	PixelPipe(const PixelPipe&);						//!< Not allowed.
 	const PixelPipe& operator=(const PixelPipe&);		//!< Not allowed.
@@ -51,6 +51,7 @@ Rasterizer::Rasterizer() :
 	m_samples(),
 	m_numSamples(0),
 	m_numFSAASamples(0),
+	m_areaCoverage(false),
 	m_sumWeights(0.0f),
 	m_sampleRadius(0.0f),
     m_vpx(0),
@@ -225,7 +226,7 @@ static double radicalInverseBase2(unsigned int i)
 * \note		
 *//*-------------------------------------------------------------------*/
 
-int Rasterizer::setupSamplingPattern(VGRenderingQuality renderingQuality, int numFSAASamples)
+int Rasterizer::setupSamplingPattern(VGRenderingQuality renderingQuality, int numFSAASamples, bool areaCoverage)
 {
 	RI_ASSERT(renderingQuality == VG_RENDERING_QUALITY_NONANTIALIASED ||
 			  renderingQuality == VG_RENDERING_QUALITY_FASTER ||
@@ -309,12 +310,121 @@ int Rasterizer::setupSamplingPattern(VGRenderingQuality renderingQuality, int nu
         m_sumWeights = (RScalar)m_numSamples;
         m_sampleRadius = 0.5f;
 	}
+	//antialiased coverage of single-sample surfaces needs no sample mask, so it can be computed from areas
+	m_areaCoverage = areaCoverage && numFSAASamples == 1 && renderingQuality != VG_RENDERING_QUALITY_NONANTIALIASED;
     return m_numSamples;
 }
 
 /*-------------------------------------------------------------------*//*!
-* \brief	Calls PixelPipe::pixelPipe for each pixel with coverage greater
-*			than zero.
+* \brief	Gathers the scissor edges intersecting a scanline, sorted by x.
+* \param	
+* \return	false if scissoring is on and no scissor rectangle intersects
+*			the scanline.
+* \note		
+*//*-------------------------------------------------------------------*/
+
+bool Rasterizer::getScissorEdges(int j, Array<ScissorEdge>& scissorAet) const
+{
+	scissorAet.clear();
+	if(!m_scissor)
+		return true;
+	for(int e=0;e<m_scissorEdges.size();e++)
+	{
+		const ScissorEdge& se = m_scissorEdges[e];
+		if(j >= se.miny && j < se.maxy)
+			scissorAet.push_back(m_scissorEdges[e]);	//throws bad_alloc
+	}
+	if(!scissorAet.size())
+		return false;
+	scissorAet.sort();
+	return true;
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief	Updates the active edge table for a scanline whose pixel
+*			filters span y values [cminy, cmaxy].
+* \param	aet			Edges active on the previous scanline, sorted by
+*						minx. Becomes the edges of this scanline, sorted.
+* \param	nextEdge	The first edge of m_edges (sorted by v0.y) not yet
+*						added to aet.
+* \return	
+* \note		Edges are added once as the scanline reaches them and retired
+*			once it has passed them, so each scanline costs time in the
+*			number of edges it intersects rather than in all the edges.
+*			The x-extents are computed exactly as a rebuilt AET would
+*			compute them so that the coverage doesn't change; the x at
+*			the top of one scanline's filter is reused at the bottom of the
+*			next scanline's when the two coincide.
+*//*-------------------------------------------------------------------*/
+
+void Rasterizer::updateActiveEdges(Array<ActiveEdge>& aet, int& nextEdge, RScalar cminy, RScalar cmaxy)
+{
+	//retire edges that end below the filters, keeping the order
+	int n = 0;
+	for(int e=0;e<aet.size();e++)
+	{
+		if(cminy < aet[e].v1.y)
+			aet[n++] = aet[e];
+	}
+	aet.resize(n);
+
+	//add edges that start within or below the filters
+	for(;nextEdge < m_edges.size() && cmaxy >= m_edges[nextEdge].v0.y;nextEdge++)
+	{
+		const Edge& ed = m_edges[nextEdge];
+		RI_ASSERT(ed.v0.y <= ed.v1.y);	//horizontal edges should have been dropped already
+		if(!(cminy < ed.v1.y))
+			continue;	//the edge ends before this scanline
+
+		ActiveEdge ae;
+		ae.v0 = ed.v0;
+		ae.v1 = ed.v1;
+		ae.direction = ed.direction;
+		ae.n.set(ae.v0.y - ae.v1.y, ae.v1.x - ae.v0.x);	//edge normal
+		ae.cnst = ae.v0.x * ae.n.x + ae.v0.y * ae.n.y;	//distance of v0 from the origin along the edge normal
+		Vector2 vd(ae.v1.x - ae.v0.x, ae.v1.y - ae.v0.y);
+		ae.dx = vd.x;
+		ae.wl = 1.0f / vd.y;
+		ae.bminx = RI_MIN(ae.v0.x, ae.v1.x);
+		ae.bmaxx = RI_MAX(ae.v0.x, ae.v1.x);
+		ae.lasty = RI_FLOAT_MAX;	//no x computed yet
+		aet.push_back(ae);	//throws bad_alloc
+	}
+
+	//compute edge min and max x-coordinates for this scanline
+	for(int e=0;e<aet.size();e++)
+	{
+		ActiveEdge& ae = aet[e];
+		RScalar sx = (cminy == ae.lasty) ? ae.lastx : ae.v0.x + ae.dx * (cminy - ae.v0.y) * ae.wl;
+		RScalar ex = (cmaxy == cminy) ? sx : ae.v0.x + ae.dx * (cmaxy - ae.v0.y) * ae.wl;
+		ae.lasty = cmaxy;
+		ae.lastx = ex;
+		sx = RI_CLAMP(sx, ae.bminx, ae.bmaxx);
+		ex = RI_CLAMP(ex, ae.bminx, ae.bmaxx);
+		ae.minx = RI_MIN(sx,ex);
+		ae.maxx = RI_MAX(sx,ex);
+	}
+
+	//sort AET by edge minx. Edges move little from one scanline to the
+	//next, so an insertion sort takes close to linear time.
+	for(int e=1;e<aet.size();e++)
+	{
+		if(!(aet[e] < aet[e-1]))
+			continue;
+		ActiveEdge ae = aet[e];
+		int k = e;
+		do
+		{
+			aet[k] = aet[k-1];
+			k--;
+		} while(k > 0 && ae < aet[k-1]);
+		aet[k] = ae;
+	}
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief	Calls PixelPipe::pixelPipeSpan for each run of pixels with the
+*			same coverage greater than zero.
 * \param	
 * \return	
 * \note		
@@ -352,67 +462,34 @@ void Rasterizer::fill()
     if(ex > m_covMaxx) m_covMaxx = ex;
     if(ey > m_covMaxy) m_covMaxy = ey;
 
+	if(m_areaCoverage && !m_covBuffer)
+	{
+		fillArea(sx, sy, ex, ey);	//throws bad_alloc
+		return;
+	}
+
+	//sort the edges by their minimum y once, so that they can be
+	//added to the AET in order as the scanline advances
+	m_edges.sort();
+
 	//fill the screen
 	Array<ActiveEdge> aet;
 	Array<ScissorEdge> scissorAet;
+	int nextEdge = 0;
 	for(int j=sy;j<ey;j++)
 	{
-		//gather scissor edges intersecting this scanline
-		scissorAet.clear();
-		if( m_scissor )
-		{
-			for(int e=0;e<m_scissorEdges.size();e++)
-			{
-				const ScissorEdge& se = m_scissorEdges[e];
-				if(j >= se.miny && j < se.maxy)
-					scissorAet.push_back(m_scissorEdges[e]);	//throws bad_alloc
-			}
-			if(!scissorAet.size())
-				continue;	//scissoring is on, but there are no scissor rectangles on this scanline
-		}
-
-		//simple AET: scan through all the edges and pick the ones intersecting this scanline
-		aet.clear();
-		for(int e=0;e<m_edges.size();e++)
-		{
-			RScalar cminy = (RScalar)j - m_sampleRadius + 0.5f;
-			RScalar cmaxy = (RScalar)j + m_sampleRadius + 0.5f;
-			const Edge& ed = m_edges[e];
-			RI_ASSERT(ed.v0.y <= ed.v1.y);	//horizontal edges should have been dropped already
+		//update AET to the edges intersecting the pixel filters of this scanline
+		RScalar cminy = (RScalar)j - m_sampleRadius + 0.5f;
+		RScalar cmaxy = (RScalar)j + m_sampleRadius + 0.5f;
+		updateActiveEdges(aet, nextEdge, cminy, cmaxy);	//throws bad_alloc
 
-			ActiveEdge ae;
-			ae.v0 = ed.v0;
-			ae.v1 = ed.v1;
-			ae.direction = ed.direction;
+		//gather scissor edges intersecting this scanline
+		if(!getScissorEdges(j, scissorAet))	//throws bad_alloc
+			continue;	//scissoring is on, but there are no scissor rectangles on this scanline
 
-			if(cmaxy >= ae.v0.y && cminy < ae.v1.y)
-			{
-				ae.n.set(ae.v0.y - ae.v1.y, ae.v1.x - ae.v0.x);	//edge normal
-				ae.cnst = ae.v0.x * ae.n.x + ae.v0.y * ae.n.y;	//distance of v0 from the origin along the edge normal
-				
-				//compute edge min and max x-coordinates for this scanline
-				Vector2 vd(ae.v1.x - ae.v0.x, ae.v1.y - ae.v0.y);
-				RScalar wl = 1.0f / vd.y;
-				RScalar sx = ae.v0.x + vd.x * (cminy - ae.v0.y) * wl;
-				RScalar ex = ae.v0.x + vd.x * (cmaxy - ae.v0.y) * wl;
-				RScalar bminx = RI_MIN(ae.v0.x, ae.v1.x);
-				RScalar bmaxx = RI_MAX(ae.v0.x, ae.v1.x);
-				sx = RI_CLAMP(sx, bminx, bmaxx);
-				ex = RI_CLAMP(ex, bminx, bmaxx);
-				ae.minx = RI_MIN(sx,ex);
-				ae.maxx = RI_MAX(sx,ex);
-				aet.push_back(ae);	//throws bad_alloc
-			}
-		}
 		if(!aet.size())
 			continue;	//no edges on the whole scanline, skip it
 
-		//sort AET by edge minx
-		aet.sort();
-		
-		//sort scissor AET by edge x
-		scissorAet.sort();
-
 		//fill the scanline
 		int scissorWinding = m_scissor ? 0 : 1;	//if scissoring is off, winding is always 1
 		int scissorIndex = 0;
@@ -472,25 +549,246 @@ void Rasterizer::fill()
 
 			//fill a run of pixels with constant coverage
 			if(sampleMask)
+				fillSpan(i, endSpan, j, coverage, sampleMask, scissorAet, scissorIndex, scissorWinding);
+			i = endSpan;
+		}
+	}
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief	Adds the cells of an edge for area coverage.
+* \param	sx, sy, ex, ey	Pixels to compute coverage for.
+* \return	
+* \note		The signed area coverage of a pixel is the sum of the deltas of
+*			the cells on its row up to and including its own. Within each
+*			row the edge crosses, it adds its direction times its height in
+*			the row to the pixels right of it, and the part of that to the
+*			pixels it passes through. The parts of the edge left of sx add
+*			their whole height to sx and the ones right of ex are dropped,
+*			before any coordinate is converted to int.
+*//*-------------------------------------------------------------------*/
+
+void Rasterizer::addCells(Array<Cell>& cells, const Edge& ed, int sx, int sy, int ex, int ey) const
+{
+	RI_ASSERT(ed.v0.y < ed.v1.y);
+	RScalar dxdy = (ed.v1.x - ed.v0.x) / (ed.v1.y - ed.v0.y);
+	//path coordinates aren't clipped, so clamp in float before converting to int
+	int jmin = (int)RI_MAX((RScalar)floor(ed.v0.y), (RScalar)sy);
+	int jmax = (int)RI_MIN((RScalar)ceil(ed.v1.y), (RScalar)ey);
+	RScalar fsx = (RScalar)sx;
+	RScalar fex = (RScalar)ex;
+	Cell c;
+	for(int j=jmin;j<jmax;j++)
+	{
+		RScalar ya = RI_MAX(ed.v0.y, (RScalar)j);
+		RScalar yb = RI_MIN(ed.v1.y, (RScalar)(j+1));
+		if(yb <= ya)
+			continue;
+		RScalar d = (yb - ya) * (RScalar)ed.direction;
+		RScalar xa = ed.v0.x + (ya - ed.v0.y) * dxdy;
+		RScalar xb = ed.v0.x + (yb - ed.v0.y) * dxdy;
+		c.y = j;
+
+		//clip the edge's segment in the row to [sx,ex]: the part left of sx
+		//covers the whole row from sx on and the part right of ex nothing
+		RScalar left, right;	//fractions of the segment's height
+		if(xa != xb)
+		{
+			RScalar tsx = RI_CLAMP((fsx - xa) / (xb - xa), 0.0f, 1.0f);	//where x = sx
+			RScalar tex = RI_CLAMP((fex - xa) / (xb - xa), 0.0f, 1.0f);	//where x = ex
+			left = (xa < xb) ? tsx : 1.0f - tsx;
+			right = (xa < xb) ? 1.0f - tex : tex;
+		}
+		else
+		{
+			left = (xa < fsx) ? 1.0f : 0.0f;
+			right = (xa > fex) ? 1.0f : 0.0f;
+		}
+		if(left > 0.0f)
+		{
+			c.x = sx;
+			c.delta = d * left;
+			cells.push_back(c);	//throws bad_alloc
+		}
+		RScalar middle = 1.0f - left - right;
+		if(middle <= 0.0f)
+			continue;
+		d *= middle;
+		xa = RI_CLAMP(xa, fsx, fex);
+		xb = RI_CLAMP(xb, fsx, fex);
+
+		RScalar x0 = RI_MIN(xa, xb);
+		RScalar x1 = RI_MAX(xa, xb);
+		RScalar x0floor = (RScalar)floor(x0);
+		RScalar x1ceil = (RScalar)ceil(x1);
+		int x0i = (int)x0floor;
+		int x1i = (int)x1ceil;
+		if(x0i >= ex)
+			continue;	//right of the pixels
+
+		if(x1i <= x0i + 1)
+		{	//within one pixel: it covers the part right of the edge's middle
+			RScalar xmf = 0.5f * (xa + xb) - x0floor;
+			c.x = x0i;
+			c.delta = d - d * xmf;
+			cells.push_back(c);	//throws bad_alloc
+			if(x0i + 1 < ex)
 			{
-				for(;i<endSpan;i++)
-				{
-					//update scissor winding number
-					while(scissorIndex < scissorAet.size() && scissorAet[scissorIndex].x <= i)
-						scissorWinding += scissorAet[scissorIndex++].direction;
-					RI_ASSERT(scissorWinding >= 0);
-
-					if(scissorWinding)
-                    {
-                        if(m_covBuffer)
-                            m_covBuffer[j*m_vpwidth+i] |= (RIuint32)sampleMask;
-                        else
-                            m_pixelPipe->pixelPipe(i, j, coverage, sampleMask);
-                    }
-				}
+				c.x = x0i + 1;
+				c.delta = d * xmf;
+				cells.push_back(c);	//throws bad_alloc
 			}
-			i = endSpan;
+			continue;
+		}
+
+		//across several pixels: each covers the area right of the edge
+		//within it, which grows by s per pixel between the end pixels
+		RScalar s = 1.0f / (x1 - x0);
+		RScalar x0f = x0 - x0floor;
+		RScalar a0 = 0.5f * s * (1.0f - x0f) * (1.0f - x0f);	//of the first pixel
+		RScalar x1f = x1 - x1ceil + 1.0f;
+		RScalar am = 0.5f * s * x1f * x1f;	//left of the edge in the last pixel
+		c.x = x0i;
+		c.delta = d * a0;
+		cells.push_back(c);	//throws bad_alloc
+		if(x1i == x0i + 2)
+		{
+			if(x0i + 1 < ex)
+			{
+				c.x = x0i + 1;
+				c.delta = d * (1.0f - a0 - am);
+				cells.push_back(c);	//throws bad_alloc
+			}
+		}
+		else
+		{
+			RScalar a1 = s * (1.5f - x0f);
+			if(x0i + 1 < ex)
+			{
+				c.x = x0i + 1;
+				c.delta = d * (a1 - a0);
+				cells.push_back(c);	//throws bad_alloc
+			}
+			//pixels strictly inside the edge's x-range
+			int xe = RI_INT_MIN(x1i - 1, ex);
+			c.delta = d * s;
+			for(int xi=x0i + 2;xi<xe;xi++)
+			{
+				c.x = xi;
+				cells.push_back(c);	//throws bad_alloc
+			}
+			if(x1i - 1 < ex)
+			{
+				RScalar a2 = a1 + (RScalar)(x1i - x0i - 3) * s;
+				c.x = x1i - 1;
+				c.delta = d * (1.0f - a2 - am);
+				cells.push_back(c);	//throws bad_alloc
+			}
+		}
+		if(x1i < ex)
+		{
+			c.x = x1i;
+			c.delta = d * am;
+			cells.push_back(c);	//throws bad_alloc
+		}
+	}
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief	Calls PixelPipe::pixelPipeSpan for each run of pixels the edges
+*			cover, with the area of the pixel covered as its coverage.
+* \param	sx, sy, ex, ey	Pixels to fill.
+* \return	
+* \note		Only the cells where edges cross rows are stored. Sorted by row
+*			and x, their running sum gives the coverage of spans of pixels
+*			without any edge, so the cost is in the length of the edges
+*			rather than in the number of samples. The coverage is exact
+*			where a pixel's winding numbers differ by at most one, as for
+*			any pixel crossed by a single edge.
+*//*-------------------------------------------------------------------*/
+
+void Rasterizer::fillArea(int sx, int sy, int ex, int ey)
+{
+	if(sx >= ex || sy >= ey)
+		return;
+
+	Array<Cell> cells;
+	for(int e=0;e<m_edges.size();e++)
+		addCells(cells, m_edges[e], sx, sy, ex, ey);	//throws bad_alloc
+	cells.sort();
+
+	//coverages this close to 0 or 1 are rounding errors of the sums
+	const RScalar epsilon = 1.0f / 4096.0f;
+	Array<ScissorEdge> scissorAet;
+	for(int c=0;c<cells.size();)
+	{
+		int j = cells[c].y;
+		bool visible = getScissorEdges(j, scissorAet);	//throws bad_alloc
+		int scissorWinding = m_scissor ? 0 : 1;	//if scissoring is off, winding is always 1
+		int scissorIndex = 0;
+		RScalar area = 0.0f;
+		while(c < cells.size() && cells[c].y == j)
+		{
+			int i = cells[c].x;
+			for(;c < cells.size() && cells[c].y == j && cells[c].x == i;c++)
+				area += cells[c].delta;
+			int endSpan = (c < cells.size() && cells[c].y == j) ? cells[c].x : ex;	//first pixel NOT part of the span
+
+			//map the signed area to coverage with the fill rule
+			RScalar coverage = RI_ABS(area);
+			if(m_fillRule == VG_EVEN_ODD)
+			{
+				coverage -= 2.0f * (RScalar)floor(coverage * 0.5f);
+				if(coverage > 1.0f)
+					coverage = 2.0f - coverage;
+			}
+			else if(coverage > 1.0f)
+				coverage = 1.0f;
+			if(coverage <= epsilon || !visible)
+				continue;
+			if(coverage >= 1.0f - epsilon)
+				coverage = 1.0f;
+
+			//fill a run of pixels with constant coverage
+			fillSpan(i, endSpan, j, coverage, 1u, scissorAet, scissorIndex, scissorWinding);
+		}
+	}
+}
+
+/*-------------------------------------------------------------------*//*!
+* \brief	Fills pixels [i,endSpan[ of scanline j, which have the same
+*			coverage, in runs between the scissor edges.
+* \param	scissorIndex, scissorWinding	The first scissor edge right of
+*			the pixels filled so far on the scanline, and the winding number
+*			left of it. Updated to endSpan.
+* \return	
+* \note		
+*//*-------------------------------------------------------------------*/
+
+void Rasterizer::fillSpan(int i, int endSpan, int j, RScalar coverage, unsigned int sampleMask, const Array<ScissorEdge>& scissorAet, int& scissorIndex, int& scissorWinding) const
+{
+	while(i < endSpan)
+	{
+		//update scissor winding number
+		while(scissorIndex < scissorAet.size() && scissorAet[scissorIndex].x <= i)
+			scissorWinding += scissorAet[scissorIndex++].direction;
+		RI_ASSERT(scissorWinding >= 0);
+
+		int e = endSpan;	//the next pixel where the scissor winding number may change
+		if(scissorIndex < scissorAet.size())
+			e = RI_INT_MIN(e, scissorAet[scissorIndex].x);
+
+		if(scissorWinding)
+		{
+			if(m_covBuffer)
+			{
+				for(int k=i;k<e;k++)
+					m_covBuffer[j*m_vpwidth+k] |= (RIuint32)sampleMask;
+			}
+			else
+				m_pixelPipe->pixelPipeSpan(i, j, e - i, coverage, sampleMask);
 		}
+		i = e;
 	}
 }
 
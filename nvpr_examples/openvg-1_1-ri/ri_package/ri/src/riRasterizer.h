@@ -71,10 +71,14 @@ struct RVector2
 
 /*-------------------------------------------------------------------*//*!
 * \brief	Converts a set of edges to coverage values for each pixel and
-*			calls PixelPipe::pixelPipe for painting a pixel.
+*			calls PixelPipe::pixelPipeSpan for painting runs of pixels.
 * \param	
 * \return	
-* \note		
+* \note		Coverage is computed by sampling the pixel filter of the
+*			rendering quality, or, for antialiased fills of single-sample
+*			surfaces when setupSamplingPattern is asked to, as the area of
+*			each pixel covered by the path. Sample masks for a coverage buffer are
+*			always sampled.
 *//*-------------------------------------------------------------------*/
 
 class Rasterizer
@@ -89,7 +93,7 @@ public:
 	void		clear();
 	void		addEdge(const Vector2& v0, const Vector2& v1);	//throws bad_alloc
 
-	int         setupSamplingPattern(VGRenderingQuality renderingQuality, int numFSAASamples);
+	int         setupSamplingPattern(VGRenderingQuality renderingQuality, int numFSAASamples, bool areaCoverage);
 	void		fill();	//throws bad_alloc
 
     void        getBBox(int& sx, int& sy, int& ex, int& ey) const       { sx = m_covMinx; sy = m_covMiny; ex = m_covMaxx; ey = m_covMaxy; }
@@ -118,7 +122,7 @@ private:
 
 	struct ActiveEdge
 	{
-		ActiveEdge() : v0(), v1(), direction(0), minx(0.0f), maxx(0.0f), n(), cnst(0.0f) {}
+		ActiveEdge() : v0(), v1(), direction(0), minx(0.0f), maxx(0.0f), n(), cnst(0.0f), dx(0.0f), wl(0.0f), bminx(0.0f), bmaxx(0.0f), lasty(0.0f), lastx(0.0f) {}
 		bool operator<(const ActiveEdge& e) const	{ return minx < e.minx; }
 		RVector2	v0;
 		RVector2	v1;
@@ -127,6 +131,21 @@ private:
 		RScalar		maxx;			//for the current scanline
 		RVector2	n;
 		RScalar		cnst;
+		RScalar		dx;				//v1.x - v0.x
+		RScalar		wl;				//1 / (v1.y - v0.y)
+		RScalar		bminx;			//x-extents of the whole edge
+		RScalar		bmaxx;
+		RScalar		lasty;			//max y of the previous scanline's sampling filter
+		RScalar		lastx;			//x of the edge at lasty
+	};
+
+	struct Cell
+	{
+		Cell() : x(0), y(0), delta(0.0f) {}
+		bool operator<(const Cell& c) const	{ return (y < c.y) || (y == c.y && x < c.x); }
+		int			x;
+		int			y;
+		RScalar		delta;			//change of the signed area coverage from pixel x-1 to pixel x
 	};
 
 	struct Sample
@@ -138,6 +157,11 @@ private:
 	};
 
     void                addBBox(const Vector2& v);
+	void				updateActiveEdges(Array<ActiveEdge>& aet, int& nextEdge, RScalar cminy, RScalar cmaxy);	//throws bad_alloc
+	bool				getScissorEdges(int j, Array<ScissorEdge>& scissorAet) const;	//throws bad_alloc
+	void				addCells(Array<Cell>& cells, const Edge& ed, int sx, int sy, int ex, int ey) const;	//throws bad_alloc
+	void				fillArea(int sx, int sy, int ex, int ey);	//throws bad_alloc
+	void				fillSpan(int i, int endSpan, int j, RScalar coverage, unsigned int sampleMask, const Array<ScissorEdge>& scissorAet, int& scissorIndex, int& scissorWinding) const;
 
 	Array<Edge>				m_edges;
 	Array<ScissorEdge>		m_scissorEdges;
@@ -146,6 +170,7 @@ private:
 	Sample				m_samples[RI_MAX_SAMPLES];
 	int					m_numSamples;
 	int					m_numFSAASamples;
+	bool				m_areaCoverage;
 	RScalar				m_sumWeights;
 	RScalar				m_sampleRadius;
 
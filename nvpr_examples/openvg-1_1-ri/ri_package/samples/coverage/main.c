@@ -0,0 +1,275 @@
+/*------------------------------------------------------------------------
+ *
+ * OpenVG 1.1 Reference Implementation sample code
+ * -----------------------------------------------
+ *
+ * Copyright (c) 2007 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and /or associated documentation files
+ * (the "Materials "), to deal in the Materials without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Materials,
+ * and to permit persons to whom the Materials are furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Materials.
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE MATERIALS OR
+ * THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ *
+ *//**
+ * \file
+ * \brief	Coverage comparison. Fills the same random shapes into a
+ *			pbuffer with the sampled rasterizer, the reference, and with
+ *			the area coverage rasterizer, for each rendering quality, and
+ *			prints how the images differ and what each costs. Both are
+ *			also compared with a 32-sample surface, which approximates the
+ *			exact box-filtered image. Fails if the engines differ without
+ *			antialiasing, where the area engine must not be used.
+ * \note	The RI reads RI_AREA_COVERAGE from the environment when a
+ *			context is created, so each image gets a context of its own.
+ *//*-------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#ifdef HG_FLAT_INCLUDES
+#	include "openvg.h"
+#	include "egl.h"
+#else
+#	include "VG/openvg.h"
+#	include "EGL/egl.h"
+#endif
+
+/*--------------------------------------------------------------*/
+
+#define SURFACE_SIZE	256
+#define NUM_SHAPES		400
+#define NUM_PIXELS		(SURFACE_SIZE * SURFACE_SIZE)
+
+EGLDisplay			egldisplay;
+
+static unsigned int	s_seed;
+
+/*--------------------------------------------------------------*/
+
+static float random01(void)
+{
+	s_seed = s_seed * 1103515245u + 12345u;
+	return (float)((s_seed >> 8) & 0xffff) / 65536.0f;
+}
+
+static float randomCoord(void)
+{
+	return random01() * (SURFACE_SIZE + 32) - 16.0f;
+}
+
+/*--------------------------------------------------------------*/
+
+//draws the same shapes every time: closed paths of lines and
+//curves, some of them thin slivers, in translucent colors
+static void drawShapes(void)
+{
+	static const VGubyte segments[3] = { VG_LINE_TO_ABS, VG_QUAD_TO_ABS, VG_CUBIC_TO_ABS };
+	static const int segmentCoords[3] = { 2, 4, 6 };
+	VGPaint paint = vgCreatePaint();
+	int i, j;
+
+	s_seed = 1;
+	vgSetPaint(paint, VG_FILL_PATH);
+	for(i=0;i<NUM_SHAPES;i++)
+	{
+		VGubyte cmd[8];
+		float coords[2 + 6*6];
+		float color[4];
+		int numCmds = 0, numCoords = 0;
+		int numSegments = 2 + (int)(random01() * 5.0f);
+		VGPath path = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F, 1.0f, 0.0f, 8, 2 + 6*6, (unsigned int)VG_PATH_CAPABILITY_ALL);
+
+		cmd[numCmds++] = VG_MOVE_TO_ABS;
+		coords[numCoords++] = randomCoord();
+		coords[numCoords++] = randomCoord();
+		if(i % 8 == 0)
+		{	//a sliver less than a pixel wide
+			cmd[numCmds++] = VG_LINE_TO_ABS;
+			coords[numCoords++] = randomCoord();
+			coords[numCoords++] = randomCoord();
+			cmd[numCmds++] = VG_LINE_TO_ABS;
+			coords[numCoords++] = coords[2] + random01() - 0.5f;
+			coords[numCoords++] = coords[3] + random01() - 0.5f;
+		}
+		else
+		{
+			for(j=0;j<numSegments;j++)
+			{
+				int type = (int)(random01() * 3.0f);
+				int k;
+				cmd[numCmds++] = segments[type];
+				for(k=0;k<segmentCoords[type];k++)
+					coords[numCoords++] = randomCoord();
+			}
+		}
+		cmd[numCmds++] = VG_CLOSE_PATH;
+		vgAppendPathData(path, numCmds, cmd, coords);
+
+		color[0] = random01();
+		color[1] = random01();
+		color[2] = random01();
+		color[3] = 0.3f + 0.7f * random01();
+		vgSetParameterfv(paint, VG_PAINT_COLOR, 4, color);
+		vgSeti(VG_FILL_RULE, (i & 1) ? VG_EVEN_ODD : VG_NON_ZERO);
+		vgDrawPath(path, VG_FILL_PATH);
+		vgDestroyPath(path);
+	}
+	vgDestroyPaint(paint);
+}
+
+/*--------------------------------------------------------------*/
+
+//draws the shapes on a surface with the given number of samples in a
+//new context and reads the image back; returns the drawing time in ms
+static double render(int areaCoverage, EGLint samples, VGRenderingQuality quality, VGubyte* pixels)
+{
+	EGLint configAttribs[] =
+	{
+		EGL_RED_SIZE,		8,
+		EGL_GREEN_SIZE, 	8,
+		EGL_BLUE_SIZE,		8,
+		EGL_ALPHA_SIZE, 	8,
+		EGL_SAMPLES,		0,
+		EGL_SURFACE_TYPE,	EGL_PBUFFER_BIT,
+		EGL_NONE
+	};
+	static const EGLint s_surfaceAttribs[] =
+	{
+		EGL_WIDTH,			SURFACE_SIZE,
+		EGL_HEIGHT,			SURFACE_SIZE,
+		EGL_NONE
+	};
+	static const float s_clearColor[4] = {1,1,1,1};
+	EGLConfig eglconfig;
+	EGLSurface eglsurface;
+	EGLContext eglcontext;
+	EGLint numconfigs;
+	clock_t start;
+	double ms;
+
+	configAttribs[9] = samples;
+	eglChooseConfig(egldisplay, configAttribs, &eglconfig, 1, &numconfigs);
+	assert(eglGetError() == EGL_SUCCESS);
+	assert(numconfigs == 1);
+	eglsurface = eglCreatePbufferSurface(egldisplay, eglconfig, s_surfaceAttribs);
+	assert(eglGetError() == EGL_SUCCESS);
+
+	putenv(areaCoverage ? "RI_AREA_COVERAGE=1" : "RI_AREA_COVERAGE=0");
+	eglcontext = eglCreateContext(egldisplay, eglconfig, NULL, NULL);
+	assert(eglGetError() == EGL_SUCCESS);
+	eglMakeCurrent(egldisplay, eglsurface, eglsurface, eglcontext);
+	assert(eglGetError() == EGL_SUCCESS);
+
+	vgSetfv(VG_CLEAR_COLOR, 4, s_clearColor);
+	vgClear(0, 0, SURFACE_SIZE, SURFACE_SIZE);
+	vgSeti(VG_BLEND_MODE, VG_BLEND_SRC_OVER);
+	vgSeti(VG_RENDERING_QUALITY, quality);
+	vgLoadIdentity();
+
+	start = clock();
+	drawShapes();
+	vgFinish();
+	ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+	vgReadPixels(pixels, SURFACE_SIZE * 4, VG_sRGBA_8888, 0, 0, SURFACE_SIZE, SURFACE_SIZE);
+	assert(vgGetError() == VG_NO_ERROR);
+
+	eglMakeCurrent(egldisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(egldisplay, eglcontext);
+	eglDestroySurface(egldisplay, eglsurface);
+	assert(eglGetError() == EGL_SUCCESS);
+	return ms;
+}
+
+/*--------------------------------------------------------------*/
+
+//prints how many pixels differ, the largest channel difference and
+//the mean channel difference; returns the number of differing pixels
+static int compare(const char* what, const VGubyte* a, const VGubyte* b)
+{
+	int differ = 0, largest = 0;
+	double sum = 0.0;
+	int i, c;
+	for(i=0;i<NUM_PIXELS;i++)
+	{
+		int pixelDiffers = 0;
+		for(c=0;c<4;c++)
+		{
+			int d = abs((int)a[4*i+c] - (int)b[4*i+c]);
+			if(d)
+				pixelDiffers = 1;
+			if(d > largest)
+				largest = d;
+			sum += d;
+		}
+		differ += pixelDiffers;
+	}
+	printf("  %-28s %6d of %d pixels differ, largest %3d, mean %.3f\n", what, differ, NUM_PIXELS, largest, sum / (4.0 * NUM_PIXELS));
+	return differ;
+}
+
+/*--------------------------------------------------------------*/
+
+int main(void)
+{
+	static const VGRenderingQuality s_qualities[3] = { VG_RENDERING_QUALITY_NONANTIALIASED, VG_RENDERING_QUALITY_FASTER, VG_RENDERING_QUALITY_BETTER };
+	static const char* s_qualityNames[3] = { "NONANTIALIASED", "FASTER", "BETTER" };
+	VGubyte* reference = (VGubyte*)malloc(4 * NUM_PIXELS);
+	VGubyte* sampled = (VGubyte*)malloc(4 * NUM_PIXELS);
+	VGubyte* area = (VGubyte*)malloc(4 * NUM_PIXELS);
+	int failed = 0;
+	int i;
+	assert(reference && sampled && area);
+
+	egldisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	eglInitialize(egldisplay, NULL, NULL);
+	assert(eglGetError() == EGL_SUCCESS);
+	eglBindAPI(EGL_OPENVG_API);
+
+	render(0, 32, VG_RENDERING_QUALITY_BETTER, reference);
+	for(i=0;i<3;i++)
+	{
+		double sampledMs = render(0, 1, s_qualities[i], sampled);
+		double areaMs = render(1, 1, s_qualities[i], area);
+		int differ;
+		printf("%s: sampled %.1f ms, area %.1f ms\n", s_qualityNames[i], sampledMs, areaMs);
+		differ = compare("area vs sampled:", area, sampled);
+		if(s_qualities[i] == VG_RENDERING_QUALITY_NONANTIALIASED)
+		{
+			if(differ)
+			{
+				printf("  FAILED: the area engine changed a nonantialiased fill\n");
+				failed = 1;
+			}
+			continue;
+		}
+		compare("sampled vs 32 samples:", sampled, reference);
+		compare("area vs 32 samples:", area, reference);
+	}
+
+	eglTerminate(egldisplay);
+	assert(eglGetError() == EGL_SUCCESS);
+	eglReleaseThread();
+	free(reference);
+	free(sampled);
+	free(area);
+	return failed;
+}
+
+/*--------------------------------------------------------------*/
@@ -0,0 +1,188 @@
+/*------------------------------------------------------------------------
+ *
+ * OpenVG 1.1 Reference Implementation sample code
+ * -----------------------------------------------
+ *
+ * Copyright (c) 2007 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and /or associated documentation files
+ * (the "Materials "), to deal in the Materials without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Materials,
+ * and to permit persons to whom the Materials are furnished to do so,
+ * subject to the following conditions: 
+ *
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Materials. 
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE MATERIALS OR
+ * THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ *
+ *//**
+ * \file
+ * \brief	Many paths benchmark. Creates N small paths, draws each of
+ *			them once into a pbuffer and destroys them, for N from 1000
+ *			to 100000, and prints the time per path of each step. The
+ *			time per path should stay flat as N grows. Takes the largest
+ *			N as an optional argument.
+ * \note	
+ *//*-------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+
+#ifdef HG_FLAT_INCLUDES
+#	include "openvg.h"
+#	include "egl.h"
+#else
+#	include "VG/openvg.h"
+#	include "EGL/egl.h"
+#endif
+
+/*--------------------------------------------------------------*/
+
+#define SURFACE_SIZE	256
+#define NUM_PAINTS		16
+
+EGLDisplay			egldisplay;
+EGLConfig			eglconfig;
+EGLSurface			eglsurface;
+EGLContext			eglcontext;
+
+/*--------------------------------------------------------------*/
+
+double seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*--------------------------------------------------------------*/
+
+void run(int numPaths, VGPaint* paints)
+{
+	static const VGubyte cmd[5] = { VG_MOVE_TO_ABS, VG_LINE_TO_ABS, VG_LINE_TO_ABS, VG_LINE_TO_ABS, VG_CLOSE_PATH };
+	VGPath* paths = (VGPath*)malloc(numPaths * sizeof(VGPath));
+	double create, draw, destroy;
+	clock_t start;
+	int i;
+	assert(paths);
+
+	//a 3x3 square per path, placed on a grid that wraps around the surface
+	start = clock();
+	for(i=0;i<numPaths;i++)
+	{
+		float x = (float)((i * 4) % SURFACE_SIZE);
+		float y = (float)((i * 4 / SURFACE_SIZE * 4) % SURFACE_SIZE);
+		float coords[8];
+		coords[0] = x;			coords[1] = y;
+		coords[2] = x + 3.0f;	coords[3] = y;
+		coords[4] = x + 3.0f;	coords[5] = y + 3.0f;
+		coords[6] = x;			coords[7] = y + 3.0f;
+		paths[i] = vgCreatePath(VG_PATH_FORMAT_STANDARD, VG_PATH_DATATYPE_F, 1.0f, 0.0f, 5, 8, (unsigned int)VG_PATH_CAPABILITY_ALL);
+		vgAppendPathData(paths[i], 5, cmd, coords);
+	}
+	create = seconds(start);
+
+	start = clock();
+	for(i=0;i<numPaths;i++)
+	{
+		vgSetPaint(paints[i % NUM_PAINTS], VG_FILL_PATH);
+		vgDrawPath(paths[i], VG_FILL_PATH);
+	}
+	vgFinish();
+	draw = seconds(start);
+	assert(vgGetError() == VG_NO_ERROR);
+
+	start = clock();
+	for(i=0;i<numPaths;i++)
+		vgDestroyPath(paths[i]);
+	destroy = seconds(start);
+	assert(vgGetError() == VG_NO_ERROR);
+
+	printf("%7d paths: create %7.3f us, draw %7.3f us, destroy %7.3f us per path\n", numPaths,
+		   create * 1e6 / numPaths, draw * 1e6 / numPaths, destroy * 1e6 / numPaths);
+	free(paths);
+}
+
+/*--------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+	static const EGLint s_configAttribs[] =
+	{
+		EGL_RED_SIZE,		8,
+		EGL_GREEN_SIZE, 	8,
+		EGL_BLUE_SIZE,		8,
+		EGL_ALPHA_SIZE, 	8,
+		EGL_SURFACE_TYPE,	EGL_PBUFFER_BIT,
+		EGL_NONE
+	};
+	static const EGLint s_surfaceAttribs[] =
+	{
+		EGL_WIDTH,			SURFACE_SIZE,
+		EGL_HEIGHT,			SURFACE_SIZE,
+		EGL_NONE
+	};
+	float clearColor[4] = {1,1,1,1};
+	VGPaint paints[NUM_PAINTS];
+	EGLint numconfigs;
+	int maxPaths = argc > 1 ? atoi(argv[1]) : 100000;
+	int i;
+
+	egldisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	eglInitialize(egldisplay, NULL, NULL);
+	assert(eglGetError() == EGL_SUCCESS);
+	eglBindAPI(EGL_OPENVG_API);
+
+	eglChooseConfig(egldisplay, s_configAttribs, &eglconfig, 1, &numconfigs);
+	assert(eglGetError() == EGL_SUCCESS);
+	assert(numconfigs == 1);
+
+	eglsurface = eglCreatePbufferSurface(egldisplay, eglconfig, s_surfaceAttribs);
+	assert(eglGetError() == EGL_SUCCESS);
+	eglcontext = eglCreateContext(egldisplay, eglconfig, NULL, NULL);
+	assert(eglGetError() == EGL_SUCCESS);
+	eglMakeCurrent(egldisplay, eglsurface, eglsurface, eglcontext);
+	assert(eglGetError() == EGL_SUCCESS);
+
+	vgSetfv(VG_CLEAR_COLOR, 4, clearColor);
+	vgClear(0, 0, SURFACE_SIZE, SURFACE_SIZE);
+	vgSeti(VG_BLEND_MODE, VG_BLEND_SRC_OVER);
+	vgLoadIdentity();
+
+	for(i=0;i<NUM_PAINTS;i++)
+	{
+		float color[4];
+		color[0] = (float)(i & 3) / 3.0f;
+		color[1] = (float)(i >> 2) / 3.0f;
+		color[2] = 0.5f;
+		color[3] = 1.0f;
+		paints[i] = vgCreatePaint();
+		vgSetParameteri(paints[i], VG_PAINT_TYPE, VG_PAINT_TYPE_COLOR);
+		vgSetParameterfv(paints[i], VG_PAINT_COLOR, 4, color);
+	}
+
+	for(i=1000;i<maxPaths;i*=10)
+		run(i, paints);
+	run(maxPaths, paints);
+
+	for(i=0;i<NUM_PAINTS;i++)
+		vgDestroyPaint(paints[i]);
+
+	eglMakeCurrent(egldisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	assert(eglGetError() == EGL_SUCCESS);
+	eglTerminate(egldisplay);
+	assert(eglGetError() == EGL_SUCCESS);
+	eglReleaseThread();
+	return 0;
+}
+
+/*--------------------------------------------------------------*/